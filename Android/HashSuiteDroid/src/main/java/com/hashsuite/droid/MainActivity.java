@@ -136,6 +136,7 @@ public class MainActivity extends Activity implements ActionBar.TabListener, OnI
 	private static final int ID_FORMAT_BASE = 32991;
 	private static final int ID_KEY_PROV_BASE = 33101;
 	private static final int ID_WIZARD = 37667;
+	private static final int ID_MEMORY_BUDGET_MB = 69998;
 
 	//private static final int REQUEST_LOAD = 0;
 	static int format_index = 0;
@@ -186,6 +187,15 @@ public class MainActivity extends Activity implements ActionBar.TabListener, OnI
 	{
 		return Math.min(display_width, (int)(dp*display_density));
 	}
+	// Max memory in MB used loading hashes. 0 means no limit
+	static int getMemoryBudget()
+	{
+		return GetSetting(ID_MEMORY_BUDGET_MB, 0);
+	}
+	static void setMemoryBudget(int budget_mb)
+	{
+		SaveSetting(ID_MEMORY_BUDGET_MB, budget_mb);
+	}
 	public static boolean isTabletUI()
 	{
 		return screen_width_dp >= 640;
@@ -853,6 +863,7 @@ public class MainActivity extends Activity implements ActionBar.TabListener, OnI
 	private static final int MESSAGE_FLUSHING_KEYS	      = 8;
 	private static final int MESSAGE_CL_COMPILING	      = 9;
 	private static final int MESSAGE_HARD_STOP	          = 11;
+	private static final int MESSAGE_ATTACK_NO_MEMORY     = 12;
 	private static final int MESSAGE_MASK	  = 0xffff;
 	private static int MESSAGE_GET_DATA(int message) { return message >> 16; }
 	private static Toast lastToast = null;
@@ -899,6 +910,9 @@ public class MainActivity extends Activity implements ActionBar.TabListener, OnI
 					}
 					Toast.makeText(my_activity, "Hard stop. Keys were dropped.", Toast.LENGTH_LONG).show();
 					break;
+				case MESSAGE_ATTACK_NO_MEMORY:
+					Toast.makeText(my_activity, "Not enough memory to load the hashes. Attack stopped.", Toast.LENGTH_LONG).show();
+					break;
 			}
 		});
 	}
@@ -0,0 +1,184 @@
+// This file is part of Hash Suite password cracker,
+// Copyright (c) 2014 by Alain Espinosa. See LICENSE.
+
+package com.hashsuite.droid;
+
+import android.content.Context;
+import android.content.res.TypedArray;
+import android.os.Parcel;
+import android.os.Parcelable;
+import android.preference.DialogPreference;
+import android.util.AttributeSet;
+import android.view.View;
+import android.widget.NumberPicker;
+
+// Max memory used loading hashes. Saved in the native settings, not in SharedPreferences
+public class MemoryBudgetPreference extends DialogPreference
+{
+    // Budget values in MB. 0 means no limit
+    private static final int[] BUDGET_VALUES = { 0, 256, 512, 1024, 1536, 2048, 3072, 4096, 6144, 8192, 12288, 16384 };
+    public static final int DEFAULT_VALUE = 0;
+
+    private int mValue = -1;
+    private NumberPicker mNumberPicker;
+
+    public MemoryBudgetPreference(Context context)
+    {
+        this(context, null);
+    }
+
+    public MemoryBudgetPreference(Context context, AttributeSet attrs)
+    {
+        super(context, attrs);
+
+        // set layout
+        setDialogLayoutResource(R.layout.number_picker_dialog);
+        setDialogIcon(null);
+        setPositiveButtonText("Set");
+        setPersistent(false);
+    }
+
+    @Override
+    protected void onSetInitialValue(boolean restore, Object defaultValue)
+    {
+        setValue(MainActivity.getMemoryBudget());
+    }
+
+    @Override
+    protected Object onGetDefaultValue(TypedArray a, int index)
+    {
+        return a.getInt(index, DEFAULT_VALUE);
+    }
+
+    private static String budgetToString(int value)
+    {
+        if (value == 0)
+            return "No limit";
+        if (value < 1024)
+            return "" + value + " MB";
+        if (value % 1024 == 0)
+            return "" + (value / 1024) + " GB";
+        return "" + (value / 1024) + "." + (value % 1024 * 10 / 1024) + " GB";
+    }
+
+    @Override
+    protected void onBindDialogView(View view)
+    {
+        super.onBindDialogView(view);
+
+        String[] displayed = new String[BUDGET_VALUES.length];
+        int selected = 0;
+        for (int i = 0; i < BUDGET_VALUES.length; i++)
+        {
+            displayed[i] = budgetToString(BUDGET_VALUES[i]);
+            if (BUDGET_VALUES[i] <= mValue)
+                selected = i;
+        }
+
+        mNumberPicker = (NumberPicker) view.findViewById(R.id.number_picker);
+        mNumberPicker.setMinValue(0);
+        mNumberPicker.setMaxValue(BUDGET_VALUES.length - 1);
+        mNumberPicker.setDisplayedValues(displayed);
+        mNumberPicker.setWrapSelectorWheel(false);
+        mNumberPicker.setValue(selected);
+    }
+
+    public void setValue(int value)
+    {
+        value = Math.max(value, 0);
+
+        if (value != mValue)
+        {
+            mValue = value;
+            MainActivity.setMemoryBudget(value);
+            notifyChanged();
+            this.setSummary(value == 0 ? "Use all memory available" : ("Use at most " + budgetToString(value)));
+        }
+    }
+
+    @Override
+    protected void onDialogClosed(boolean positiveResult)
+    {
+        super.onDialogClosed(positiveResult);
+
+        // when the user selects "OK", save the new value
+        if (positiveResult)
+        {
+            int budget = BUDGET_VALUES[mNumberPicker.getValue()];
+            if (callChangeListener(budget))
+            {
+                setValue(budget);
+            }
+        }
+    }
+
+    @Override
+    protected Parcelable onSaveInstanceState()
+    {
+        // save the instance state so that it will survive screen orientation changes and other events that may temporarily destroy it
+        final Parcelable superState = super.onSaveInstanceState();
+
+        // set the state's value with the class member that holds current setting value
+        final SavedState myState = new SavedState(superState);
+        myState.value = mValue;
+
+        return myState;
+    }
+
+    @Override
+    protected void onRestoreInstanceState(Parcelable state)
+    {
+        // check whether we saved the state in onSaveInstanceState()
+        if (state == null || !state.getClass().equals(SavedState.class))
+        {
+            // didn't save the state, so call superclass
+            super.onRestoreInstanceState(state);
+            return;
+        }
+
+        // restore the state
+        SavedState myState = (SavedState) state;
+        setValue(myState.value);
+
+        super.onRestoreInstanceState(myState.getSuperState());
+    }
+
+    private static class SavedState extends BaseSavedState
+    {
+        int value;
+
+        public SavedState(Parcelable superState)
+        {
+            super(superState);
+        }
+
+        public SavedState(Parcel source)
+        {
+            super(source);
+            value = source.readInt();
+        }
+
+        @Override
+        public void writeToParcel(Parcel dest, int flags)
+        {
+            super.writeToParcel(dest, flags);
+            dest.writeInt(value);
+        }
+
+        @SuppressWarnings("unused")
+        public static final Parcelable.Creator<SavedState> CREATOR = new Parcelable.Creator<SavedState>()
+        {
+            @Override
+            public SavedState createFromParcel(Parcel in)
+            {
+                return new SavedState(in);
+            }
+
+            @Override
+            public SavedState[] newArray(int size)
+            {
+                return new SavedState[size];
+            }
+        };
+    }
+}
@@ -135,6 +135,10 @@ typedef struct OpenCL_Param
 	cl_program additional_program;
 	// Needed by rules
 	OCL_Rules rules;
+	// Found hashes to remove from the table copied to the GPU
+	cl_uint* cbg_pos;// Position of each hash in the table or NO_ELEM
+	cl_ushort* cbg_filter_value;
+	cl_uint num_cbg_removed;
 }
 OpenCL_Param;
 typedef void gpu_crypt_funtion(OpenCL_Param*);
@@ -152,6 +156,7 @@ typedef int create_gpu_crypt_funtion(OpenCL_Param*, cl_uint, generate_key_funtio
 #define MESSAGE_CL_COMPILING            9
 #define MESSAGE_TESTING_PROGRESS       10
 #define MESSAGE_HARD_STOP			   11
+#define MESSAGE_ATTACK_NO_MEMORY	   12
 
 #define MESSAGE_MASK                    0xffff
 #define MESSAGE_PUT_DATA(message, data) ((message) | ((data)<<16))
@@ -193,6 +198,7 @@ typedef void callback_funtion(int message);
 #define PROTOCOL_PHRASES_OPENCL				9
 #define PROTOCOL_UTF8_COALESC_LE			10// Little endian
 #define PROTOCOL_UTF8_COALESC_BE			11// Big endian
+#define PROTOCOL_MASK_OPENCL				12
 
 ////////////////////////////////////////////////////////////////////////////////////
 // In-Out
@@ -317,8 +323,9 @@ typedef struct Format
 	sqlite3_int64(*add_hash_from_line)(ImportParam* param, char* username, char* p0, char* p1, char* p2);
 	void(*optimize_hashes)();
 
-	// CPU Implementations. Fast implementation first
-	FormatImplementation impls[3];
+	// CPU Implementations. Fast implementation first. Formats with fewer
+	// implementations repeat the last one to fill all the slots
+	FormatImplementation impls[5];
 #ifdef HS_OPENCL_SUPPORT
 	GPUFormatImplementation opencl_impls[4];
 #endif
@@ -344,6 +351,11 @@ int64_t get_key_space_batch();
 #define LM2NTLM_INDEX	5
 #define FAST_LM_INDEX	6
 #define RULES_INDEX		7
+#define MASK_INDEX		8
+#define MARKOV_INDEX	9
+#define STDIN_INDEX		10
+#define HYBRID_INDEX	11
+#define COMBINATOR_INDEX	12
 
 typedef struct KeyProviderImplementation
 {
@@ -466,6 +478,7 @@ int is_wordlist_supported(const char* file_path, char* error_message);
 uint32_t load_fam(uint64_t pos);
 void save_fam(uint64_t pos, uint32_t value);
 void resize_fam();
+void delete_hashes_snapshots();
 
 ////////////////////////////////////////////////////////////////////////////////////
 // Fingerprint
@@ -530,12 +543,15 @@ extern int is_benchmark;
 extern int use_cpu_as_gpu;
 
 // Settings
+#define ID_MEMORY_BUDGET_MB		69998	// Max memory to use in MB. 0 means no limit
 int get_setting(int id, int default_value);
 void save_setting(int id, int value);
 void save_settings_to_db();
 
 // Number of passwords currently loaded
 extern uint32_t num_passwords_loaded;
+// Elements re-inserted growing the cuckoo table in the last load
+extern uint32_t num_cbg_reinserts;
 // Used to stop the attack
 extern int continue_attack;
 extern int stop_universe;
@@ -570,8 +586,14 @@ void hash_file(void* void_data);
 	#define DEV_CAP_OPENCL			0x0005
 	#define CPU_CAP_AVX2			0x0006
 	#define CPU_CAP_BMI				0x0007
+	#define CPU_CAP_AVX512			0x0008
+	#define CPU_CAP_SHA				0x0009
+	#define CPU_CAP_AVX2_GATHER		0x000A// AVX2 with gathers faster than scalar loads
+	#define CPU_CAP_SHA256			0x000B// SHA-NI faster than the SIMD code for SHA256
+	#define CPU_CAP_SSSE3			0x000C
+	#define CPU_CAP_SSE41			0x000D
 	
-	#define MAX_NUM_CAPS			8
+	#define MAX_NUM_CAPS			14
 
 #elif defined(HS_ARM)
 	#define CPU_CAP_NEON			0x0001
@@ -610,11 +632,18 @@ typedef struct
 	int is_large_page_enable;
 }
 OtherSystemInfo;
+// Linux kinds of large pages in 'is_large_page_enable'
+#define LARGE_PAGE_HUGETLB	1
+#define LARGE_PAGE_THP		2
 
 extern uint32_t app_num_threads;
 extern uint32_t num_threads;
 extern CPUHardware current_cpu;
 extern OtherSystemInfo current_system_info;
+uint64_t get_available_memory();
+#ifdef HS_TESTING
+uint64_t get_process_peak_memory_used();
+#endif
 
 ////////////////////////////////////////////////////////////////////////////////////
 // OpenCL
@@ -17,6 +17,13 @@
 // ammintrin.h : Definitions for AMD-specific intrinsics
 
 // imminitrin.h : AVX2 intrinsics
+
+// Compile one function for a given instruction set without compiling all the file for it
+#ifdef __GNUC__
+	#define HS_TARGET(isa)	__attribute__((target(isa)))
+#else
+	#define HS_TARGET(isa)
+#endif
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // SSE2
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -93,6 +100,76 @@
 #define V128_SR64(elem,shift)	SSE2_SR64(elem,shift)	
 #define V128_ROTATE64(a,rot)	SSE2_ROTATE64(a,rot)	
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include <immintrin.h>
+
+#define AVX2_WORD		__m256i
+
+#define AVX2_AND(a,b)		_mm256_and_si256(a,b)
+#define AVX2_OR(a,b)		_mm256_or_si256(a,b)
+#define AVX2_XOR(a,b)		_mm256_xor_si256(a,b)
+#define AVX2_ADD(a,b)		_mm256_add_epi32(a,b)
+
+#define AVX2_ZERO				_mm256_setzero_si256()
+#define AVX2_CONST(u32_const)	_mm256_set1_epi32(u32_const)
+
+#define AVX2_SL(elem,shift)		_mm256_slli_epi32(elem,shift)
+#define AVX2_SR(elem,shift)		_mm256_srli_epi32(elem,shift)
+#define AVX2_ROTATE(a,rot)		AVX2_OR(AVX2_SL(a, rot), AVX2_SR(a, 32-rot))
+
+#define AVX2_3XOR(a,b,c)		AVX2_XOR(AVX2_XOR(a,b),c)
+#define AVX2_4XOR(a,b,c,d)		AVX2_XOR(AVX2_XOR(a,b),AVX2_XOR(c,d))
+#define AVX2_3ADD(a,b,c)	AVX2_ADD(AVX2_ADD(a,b), c)
+#define AVX2_4ADD(a,b,c,d)	AVX2_ADD(AVX2_ADD(a,b), AVX2_ADD(c,d))
+#define AVX2_5ADD(a,b,c,d,e)	AVX2_ADD(AVX2_ADD(AVX2_ADD(a,b),AVX2_ADD(c,d)),e)
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+#include <immintrin.h>
+
+#define AVX512_WORD		__m512i
+
+#define AVX512_AND(a,b)		_mm512_and_si512(a,b)
+#define AVX512_OR(a,b)		_mm512_or_si512(a,b)
+#define AVX512_XOR(a,b)		_mm512_xor_si512(a,b)
+#define AVX512_NOT(a)		_mm512_xor_si512(AVX512_ALL_ONES, a)
+#define AVX512_ANDN(a,b)	_mm512_andnot_si512(b,a)
+#define AVX512_ADD(a,b)		_mm512_add_epi32(a,b)
+
+#define AVX512_ALL_ONES			_mm512_set1_epi32(0xFFFFFFFFU)
+#define AVX512_ZERO				_mm512_setzero_si512()
+#define AVX512_CONST(u32_const)	_mm512_set1_epi32(u32_const)
+
+#define AVX512_SL(elem,shift)	_mm512_slli_epi32(elem,shift)
+#define AVX512_SR(elem,shift)	_mm512_srli_epi32(elem,shift)
+#define AVX512_ROTATE(a,rot)	_mm512_rol_epi32(a,rot)
+
+// 0x96 is the truth table of a^b^c
+#define AVX512_3XOR(a,b,c)			_mm512_ternarylogic_epi32(a,b,c,0x96)
+// 0xCA is a?b:c and 0xE8 the majority of a,b,c: SHA2 Ch and Maj in one instruction
+#define AVX512_CH(a,b,c)			_mm512_ternarylogic_epi32(a,b,c,0xCA)
+#define AVX512_MAJ(a,b,c)			_mm512_ternarylogic_epi32(a,b,c,0xE8)
+#define AVX512_4XOR(a,b,c,d)		AVX512_XOR(AVX512_3XOR(a,b,c),d)
+#define AVX512_3ADD(a,b,c)			AVX512_ADD(AVX512_ADD(a,b),c)
+#define AVX512_4ADD(a,b,c,d)		AVX512_ADD(AVX512_ADD(a,b),AVX512_ADD(c,d))
+#define AVX512_5ADD(a,b,c,d,e)		AVX512_ADD(AVX512_ADD(AVX512_ADD(a,b),AVX512_ADD(c,d)),e)
+
+// 64bits
+#define AVX512_CONST64(u64_const)	_mm512_set1_epi64(u64_const)
+#define AVX512_ADD64(a,b)			_mm512_add_epi64(a,b)
+#define AVX512_3ADD64(a,b,c)		AVX512_ADD64(AVX512_ADD64(a,b),c)
+#define AVX512_4ADD64(a,b,c,d)		AVX512_ADD64(AVX512_ADD64(a,b),AVX512_ADD64(c,d))
+#define AVX512_5ADD64(a,b,c,d,e)	AVX512_ADD64(AVX512_ADD64(AVX512_ADD64(a,b),AVX512_ADD64(c,d)),e)
+
+#define AVX512_SL64(elem,shift)		_mm512_slli_epi64(elem,shift)
+#define AVX512_SR64(elem,shift)		_mm512_srli_epi64(elem,shift)
+#define AVX512_ROTATE64(a,rot)		_mm512_rol_epi64(a,rot)
+#endif
+
 #endif
 
 #define V128_BIT_LENGHT	128
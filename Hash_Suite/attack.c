@@ -6,10 +6,12 @@
 #include <memory.h>
 #include <stdio.h>
 #include "attack.h"
+#include "xxhash.h"
 
 #ifdef _WIN32
 	#include <windows.h>
 	#include <process.h>
+	#include <io.h>
 #else
 	#include <pthread.h>
 	#include <fcntl.h>
@@ -58,6 +60,8 @@ PUBLIC uint32_t* cbg_table = NULL;
 PUBLIC uint32_t cbg_mask;
 PUBLIC uint32_t cbg_count_unlucky;
 PUBLIC uint32_t cbg_count_moved;
+PUBLIC uint32_t cbg_num_removed = 0;
+PUBLIC uint32_t num_cbg_reinserts = 0;
 
 ////////////////////////////////////////////////////////////////////////////////////
 // Salted hash
@@ -174,9 +178,9 @@ PRIVATE void restore_backup_if_needed()
 	{
 		cache_had_hashes = TRUE;
 
-		free(binary_values);
+		large_page_free(binary_values);
 		free(salts_values);
-		free(hash_ids32);
+		large_page_free(hash_ids32);
 
 		binary_values = backup_binaries;
 		salts_values = backup_salts;
@@ -300,6 +304,9 @@ PRIVATE void generate_keys_for_testing()
 	// Test rule support in the GPUs. Fails: MD5CRYPT (because short key_length support)
 	if (!test_rules_on_gpu && provider_index == RULES_INDEX && get_num_gpus_used())
 		generate = NULL;
+	// The stream can't be read two times
+	if (provider_index == STDIN_INDEX)
+		generate = NULL;
 
 	if (!is_benchmark && test_sleep_time && generate && hash_format[format_index])
 	{
@@ -395,7 +402,7 @@ PRIVATE void free_all_memory(int exclude_cache)
 	_aligned_free(same_hash_next);		same_hash_next = NULL;
 
 	large_page_free(cbg_filter);		cbg_filter = NULL;
-	free(cbg_table);					cbg_table = NULL;
+	large_page_free(cbg_table);			cbg_table = NULL;
 
 	if (exclude_cache)
 	{
@@ -418,8 +425,8 @@ PRIVATE void free_all_memory(int exclude_cache)
 	}
 	else
 	{
-		free(hash_ids32);					hash_ids32 = NULL;
-		_aligned_free(binary_values);		binary_values = NULL;
+		large_page_free(hash_ids32);		hash_ids32 = NULL;
+		large_page_free(binary_values);		binary_values = NULL;
 		_aligned_free(salts_values);		salts_values = NULL;
 	}
 	
@@ -480,11 +487,548 @@ PRIVATE void calculate_table_mask(uint32_t num_elem)
 	size_table_see2[0] = size_table_see2[1] = size_table_see2[2] = size_table_see2[3] = size_table;
 	size_bit_table_see2[0] = size_bit_table_see2[1] = size_bit_table_see2[2] = size_bit_table_see2[3] = size_bit_table;
 }
-PRIVATE void load_hashes(int format_index)
+////////////////////////////////////////////////////////////////////////////////////////////
+// Group hashes by salt
+////////////////////////////////////////////////////////////////////////////////////////////
+// Open addressing table with the different salts found, to find repeated salts fast
+PRIVATE uint32_t* salts_table = NULL;
+PRIVATE uint32_t salts_table_mask;
+// Last hash of each salt, to append to the chain without walking it
+PRIVATE uint32_t* salt_last_index = NULL;
+// Temporary memory used, at most 50% full table
+#define GROUP_SALTS_MEMORY(num_hashes)	(5 * sizeof(uint32_t) * (num_hashes))
+
+PRIVATE void end_group_salts()
+{
+	free(salts_table);		salts_table = NULL;
+	free(salt_last_index);	salt_last_index = NULL;
+}
+// Return FALSE if not enough memory
+PRIVATE int begin_group_salts(uint32_t num_hashes)
+{
+	salts_table_mask = ceil_power_2(__max(2 * num_hashes, 1024)) - 1;
+	salts_table = (uint32_t*)malloc(sizeof(uint32_t) * (salts_table_mask + 1ull));
+	salt_last_index = (uint32_t*)malloc(sizeof(uint32_t) * ((size_t)num_hashes));
+
+	if (!salts_table || !salt_last_index)
+	{
+		end_group_salts();
+		return FALSE;
+	}
+
+	memset(salts_table, 0xff, sizeof(uint32_t) * (salts_table_mask + 1ull));
+	return TRUE;
+}
+// Put hash 'current_index' in the chain of hashes with 'salt'. If the salt is new
+// it became salt number 'num_diff_salts', stored in salts_values by the caller.
+PRIVATE void group_salt_hashed(int format_index, uint32_t current_index, const void* salt, uint32_t salt_hash)
+{
+	uint32_t salt_size = formats[format_index].salt_size;
+	uint32_t pos = salt_hash & salts_table_mask;
+
+	// Check if salt exist
+	for (; salts_table[pos] != NO_ELEM; pos = (pos + 1) & salts_table_mask)
+	{
+		uint32_t salt_num = salts_table[pos];
+		if (!memcmp(salt, (BYTE*)salts_values + ((size_t)salt_num) * salt_size, salt_size))
+		{// salt already exist
+			same_salt_next[salt_last_index[salt_num]] = current_index;
+			salt_last_index[salt_num] = current_index;
+			return;
+		}
+	}
+
+	// salt not exist
+	salts_table[pos] = num_diff_salts;
+	salt_index[num_diff_salts] = current_index;
+	salt_last_index[num_diff_salts] = current_index;
+	num_diff_salts++;
+}
+PRIVATE void group_salt(int format_index, uint32_t current_index, const void* salt)
+{
+	group_salt_hashed(format_index, current_index, salt, XXH32(salt, formats[format_index].salt_size, 0));
+}
+////////////////////////////////////////////////////////////////////////////////////////////
+// Parallel load from DB
+////////////////////////////////////////////////////////////////////////////////////////////
+// Hashes are read by ranges of IDs in many threads, each one with his own DB connection.
+// Ranges are added to the loaded hashes in order, so the result is the same as reading
+// all hashes in one thread.
+#define LOAD_RANGE_SIZE			4096// IDs in each range
+#define LOAD_RANGES_BY_THREAD	4// Ranges read but not added yet, by thread
+#define LOAD_MAX_TRIES			10// Reads of a range with the DB busy before giving up
+#define LOAD_HASHES_FAILED		0xffffffff// Returned by load_hashes_from_db on error
+
+typedef struct LoadRange
+{
+	uint32_t num_hashes;
+	int is_ready;
+	uint32_t* hash_ids;
+	uint32_t* salt_hashes;
+	BYTE* bins;// Binary and salt
+}
+LoadRange;
+
+PRIVATE HS_MUTEX load_mutex;
+PRIVATE LoadRange* load_ranges = NULL;
+PRIVATE uint32_t num_load_ranges_buffered;
+PRIVATE sqlite3_int64 load_min_id;
+PRIVATE uint32_t num_load_ranges;
+PRIVATE uint32_t next_load_range;
+PRIVATE uint32_t next_add_range;
+PRIVATE uint32_t num_hashes_added;
+PRIVATE int is_adding_range;
+PRIVATE uint32_t num_load_threads_running;
+PRIVATE int load_format_index;
+PRIVATE int is_load_failed;
+
+PRIVATE uint32_t remove_found_hashes(uint32_t* hash_ids, BYTE* bins, uint32_t num_hashes, uint32_t bin_size);
+
+// Add a hash read from the DB to the loaded ones
+PRIVATE void add_loaded_hash(int format_index, uint32_t current_index, uint32_t hash_id, const BYTE* bin, uint32_t salt_hash)
+{
+	hash_ids32[current_index] = hash_id;
+
+	memcpy((BYTE*)binary_values + ((size_t)current_index) * formats[format_index].binary_size, bin, formats[format_index].binary_size);
+	memcpy((BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size, bin + formats[format_index].binary_size, formats[format_index].salt_size);
+
+	if (formats[format_index].salt_size)// Salted hash
+	{
+		group_salt_hashed(format_index, current_index, (BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size, salt_hash);
+	}
+	else if (format_index == LM_INDEX)// Non-salted hash
+	{
+		uint32_t value_map = ((uint32_t*)bin)[formats[format_index].value_map_index0];
+
+		bit_table[(value_map & size_bit_table) >> 5] |= 1 << ((value_map & size_bit_table) & 31);
+		// Put the password in the table map
+		if (table[value_map & size_table] == NO_ELEM)
+		{
+			table[value_map & size_table] = current_index;
+		}
+		else
+		{
+			uint32_t last_index = table[value_map & size_table];
+			while (same_hash_next[last_index] != NO_ELEM)
+				last_index = same_hash_next[last_index];
+
+			same_hash_next[last_index] = current_index;
+		}
+	}
+}
+PRIVATE void load_hashes_thread(sqlite3* thread_db)
+{
+	int format_index = load_format_index;
+	uint32_t bin_size = formats[format_index].binary_size + formats[format_index].salt_size;
+
+	sqlite3_stmt* select_range;
+	sqlite3_prepare_v2(thread_db, "SELECT Bin,ID FROM Hash WHERE ID>=? AND ID<? AND Type=?;", -1, &select_range, NULL);
+	sqlite3_bind_int64(select_range, 3, formats[format_index].db_id);
+
+	HS_ENTER_MUTEX(&load_mutex);
+	while (!is_load_failed && next_load_range < num_load_ranges && num_hashes_added < num_passwords_loaded)
+	{
+		// Don't read too far from the ranges added
+		if (next_load_range >= next_add_range + num_load_ranges_buffered)
+		{
+			HS_LEAVE_MUTEX(&load_mutex);
+			Sleep(1);
+			HS_ENTER_MUTEX(&load_mutex);
+			continue;
+		}
+		uint32_t range_index = next_load_range;
+		next_load_range++;
+		HS_LEAVE_MUTEX(&load_mutex);
+
+		// Read the range
+		LoadRange* range = load_ranges + range_index % num_load_ranges_buffered;
+		int step_result, num_tries = 0;
+		do
+		{
+			// DB busy: wait for the writer
+			if (num_tries)
+				Sleep(100);
+			range->num_hashes = 0;
+			sqlite3_reset(select_range);
+			sqlite3_bind_int64(select_range, 1, load_min_id + ((sqlite3_int64)range_index) * LOAD_RANGE_SIZE);
+			sqlite3_bind_int64(select_range, 2, load_min_id + ((sqlite3_int64)range_index + 1) * LOAD_RANGE_SIZE);
+
+			while ((step_result = sqlite3_step(select_range)) == SQLITE_ROW)
+			{
+				range->hash_ids[range->num_hashes] = (uint32_t)sqlite3_column_int64(select_range, 1);
+				memcpy(range->bins + ((size_t)range->num_hashes) * bin_size, sqlite3_column_blob(select_range, 0), bin_size);
+				range->num_hashes++;
+			}
+		}
+		while ((step_result == SQLITE_BUSY || step_result == SQLITE_LOCKED) && ++num_tries < LOAD_MAX_TRIES);
+
+		if (step_result != SQLITE_DONE)
+		{
+			hs_log(HS_LOG_ERROR, "Load hashes", "Error %i reading hashes from DB", step_result);
+			// Stop all threads: the hashes loaded are incomplete
+			HS_ENTER_MUTEX(&load_mutex);
+			is_load_failed = TRUE;
+			HS_LEAVE_MUTEX(&load_mutex);
+		}
+
+		range->num_hashes = remove_found_hashes(range->hash_ids, range->bins, range->num_hashes, bin_size);
+		if (formats[format_index].salt_size)
+			for (uint32_t i = 0; i < range->num_hashes; i++)
+				range->salt_hashes[i] = XXH32(range->bins + ((size_t)i) * bin_size + formats[format_index].binary_size, formats[format_index].salt_size, 0);
+
+		HS_ENTER_MUTEX(&load_mutex);
+		range->is_ready = TRUE;
+		// Add the ready ranges in order, only one thread at a time
+		if (!is_adding_range)
+		{
+			is_adding_range = TRUE;
+			while (next_add_range < num_load_ranges && load_ranges[next_add_range % num_load_ranges_buffered].is_ready)
+			{
+				LoadRange* add_range = load_ranges + next_add_range % num_load_ranges_buffered;
+				uint32_t current_index = num_hashes_added;
+				HS_LEAVE_MUTEX(&load_mutex);
+
+				for (uint32_t i = 0; i < add_range->num_hashes && current_index < num_passwords_loaded; i++, current_index++)
+					add_loaded_hash(format_index, current_index, add_range->hash_ids[i], add_range->bins + ((size_t)i) * bin_size, add_range->salt_hashes[i]);
+
+				HS_ENTER_MUTEX(&load_mutex);
+				add_range->is_ready = FALSE;
+				num_hashes_added = current_index;
+				next_add_range++;
+			}
+			is_adding_range = FALSE;
+		}
+	}
+	HS_LEAVE_MUTEX(&load_mutex);
+
+	sqlite3_finalize(select_range);
+	if (thread_db != db)
+		sqlite3_close(thread_db);
+
+	HS_ENTER_MUTEX(&load_mutex);
+	num_load_threads_running--;
+	HS_LEAVE_MUTEX(&load_mutex);
+}
+// Return the number of hashes loaded or LOAD_HASHES_FAILED
+PRIVATE uint32_t load_hashes_from_db(int format_index)
+{
+	uint32_t bin_size = formats[format_index].binary_size + formats[format_index].salt_size;
+
+	// Range of IDs of the format: each subquery walk the primary key from one end
+	// and stop at the first hash of the format
+	sqlite3_stmt* select_ids;
+	sqlite3_prepare_v2(db, "SELECT (SELECT ID FROM Hash WHERE Type=?1 ORDER BY ID LIMIT 1),(SELECT ID FROM Hash WHERE Type=?1 ORDER BY ID DESC LIMIT 1);", -1, &select_ids, NULL);
+	sqlite3_bind_int64(select_ids, 1, formats[format_index].db_id);
+	num_load_ranges = 0;
+	if (sqlite3_step(select_ids) == SQLITE_ROW && sqlite3_column_type(select_ids, 0) != SQLITE_NULL)
+	{
+		load_min_id = sqlite3_column_int64(select_ids, 0);
+		num_load_ranges = (uint32_t)((sqlite3_column_int64(select_ids, 1) - load_min_id) / LOAD_RANGE_SIZE + 1);
+	}
+	sqlite3_finalize(select_ids);
+
+	uint32_t num_load_threads = __max(1, __min(app_num_threads, num_load_ranges));
+	num_load_ranges_buffered = LOAD_RANGES_BY_THREAD * num_load_threads;
+	load_ranges = (LoadRange*)calloc(num_load_ranges_buffered, sizeof(LoadRange));
+	is_load_failed = !load_ranges;
+	for (uint32_t i = 0; !is_load_failed && i < num_load_ranges_buffered; i++)
+	{
+		load_ranges[i].hash_ids = (uint32_t*)malloc(sizeof(uint32_t) * LOAD_RANGE_SIZE);
+		load_ranges[i].salt_hashes = (uint32_t*)malloc(sizeof(uint32_t) * LOAD_RANGE_SIZE);
+		load_ranges[i].bins = (BYTE*)malloc(bin_size * LOAD_RANGE_SIZE);
+
+		if (!load_ranges[i].hash_ids || !load_ranges[i].salt_hashes || !load_ranges[i].bins)
+			is_load_failed = TRUE;
+	}
+	if (is_load_failed)
+	{
+		hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory to read hashes from DB");
+		num_load_threads = 0;
+	}
+
+	load_format_index = format_index;
+	next_load_range = 0;
+	next_add_range = 0;
+	num_hashes_added = 0;
+	is_adding_range = FALSE;
+	num_load_threads_running = 1;
+	HS_CREATE_MUTEX(&load_mutex);
+
+	// Other threads use his own read-only connection
+	const char* db_filename = sqlite3_db_filename(db, "main");
+	for (uint32_t i = 1; i < num_load_threads; i++)
+	{
+		sqlite3* thread_db = NULL;
+		if (sqlite3_open_v2(db_filename, &thread_db, SQLITE_OPEN_READONLY, NULL) != SQLITE_OK)
+		{
+			sqlite3_close(thread_db);
+			break;
+		}
+		sqlite3_busy_timeout(thread_db, 1000);
+
+		HS_ENTER_MUTEX(&load_mutex);
+		num_load_threads_running++;
+		HS_LEAVE_MUTEX(&load_mutex);
+		HS_NEW_THREAD(load_hashes_thread, thread_db);
+	}
+	load_hashes_thread(db);
+
+	// Wait for other threads
+	HS_ENTER_MUTEX(&load_mutex);
+	while (num_load_threads_running)
+	{
+		HS_LEAVE_MUTEX(&load_mutex);
+		Sleep(1);
+		HS_ENTER_MUTEX(&load_mutex);
+	}
+	HS_LEAVE_MUTEX(&load_mutex);
+	HS_DELETE_MUTEX(&load_mutex);
+
+	for (uint32_t i = 0; load_ranges && i < num_load_ranges_buffered; i++)
+	{
+		free(load_ranges[i].hash_ids);
+		free(load_ranges[i].salt_hashes);
+		free(load_ranges[i].bins);
+	}
+	free(load_ranges);
+	load_ranges = NULL;
+
+	return is_load_failed ? LOAD_HASHES_FAILED : num_hashes_added;
+}
+// Estimate the memory needed to load the hashes, using the densest cuckoo table
+PRIVATE uint64_t load_hashes_memory_needed(int format_index)
+{
+	uint64_t num_hashes = num_passwords_loaded;
+	uint64_t result = sizeof(uint32_t) * (num_hashes / 32 + 1) + sizeof(FoundKey) * __max(num_hashes / 256, 1024);
+
+	if (!cache_had_hashes)
+		result += (formats[format_index].binary_size + formats[format_index].salt_size + sizeof(uint32_t)) * num_hashes;
+
+	if (formats[format_index].salt_size)
+		result += 2 * sizeof(uint32_t) * num_hashes + GROUP_SALTS_MEMORY(num_hashes);// salt_index, same_salt_next
+	else
+	{
+		uint64_t table_size = 2048;
+		while (table_size * 9ull < num_hashes * 10ull)
+			table_size *= 2;
+
+		result += (sizeof(uint16_t) + sizeof(uint32_t)) * table_size;
+	}
+
+	return result;
+}
+////////////////////////////////////////////////////////////////////////////////////////////
+// Snapshot of loaded hashes
+////////////////////////////////////////////////////////////////////////////////////////////
+// After a slow load of non-salted hashes the binaries, ids and cuckoo table are saved
+// to a file. Next attacks map it if the hashes are the same, skipping the DB and build.
+#define SNAPSHOT_MAGIC			0x50414e53// "SNAP"
+#define SNAPSHOT_VERSION		2// Change when the file layout or the table change
+#define SNAPSHOT_ALIGN			(64*1024)// Windows allocation granularity
+#define SNAPSHOT_NUM_ARRAYS		4// binary_values, hash_ids32, cbg_filter, cbg_table
+
+typedef struct SnapshotHeader
+{
+	uint32_t magic;
+	uint32_t version;
+	uint64_t digest;
+	uint32_t binary_size;
+	uint32_t num_hashes;
+	uint32_t cbg_mask;
+	uint32_t cbg_count_unlucky;
+	uint32_t cbg_count_moved;
+	uint32_t reserved;
+}
+SnapshotHeader;
+
+PRIVATE int is_snapshot_supported(int format_index)
+{
+	return format_index != LM_INDEX && formats[format_index].salt_size == 0 && !formats[format_index].optimize_hashes;
+}
+PRIVATE char* get_snapshot_path(int format_index)
+{
+	char file_name[64];
+	sprintf(file_name, "snapshot_%s.raw", formats[format_index].name);
+
+	return get_full_path(file_name);
+}
+// Identify the hashes loaded: the ids in load order. An id always has the same
+// binary: hashes are only deleted all together by clear_db_accounts(), that delete
+// the snapshots.
+PRIVATE uint64_t get_hashes_digest(int format_index, const uint32_t* hash_ids, uint32_t num_hashes)
+{
+	return XXH64(hash_ids, sizeof(uint32_t) * ((size_t)num_hashes), formats[format_index].db_id);
+}
+// Check the hashes that will be loaded from the DB have the digest. Only read
+// the ids, much faster than loading the binaries and building the table.
+PRIVATE int is_db_hashes_digest(int format_index, uint64_t digest)
+{
+	uint32_t* ids = (uint32_t*)malloc(sizeof(uint32_t) * LOAD_RANGE_SIZE);
+	XXH64_state_t* state = XXH64_createState();
+	XXH64_reset(state, formats[format_index].db_id);
+
+	sqlite3_stmt* select_ids;
+	sqlite3_prepare_v2(db, "SELECT ID FROM Hash WHERE Type=? ORDER BY ID;", -1, &select_ids, NULL);
+	sqlite3_bind_int64(select_ids, 1, formats[format_index].db_id);
+
+	uint32_t num_ids = 0, num_hashes = 0;
+	int step_result;
+	do
+	{
+		step_result = sqlite3_step(select_ids);
+		if (step_result == SQLITE_ROW)
+			ids[num_ids++] = (uint32_t)sqlite3_column_int64(select_ids, 0);
+
+		if (num_ids == LOAD_RANGE_SIZE || (step_result != SQLITE_ROW && num_ids))
+		{
+			num_ids = remove_found_hashes(ids, NULL, num_ids, 0);
+			num_ids = __min(num_ids, num_passwords_loaded - num_hashes);
+			XXH64_update(state, ids, sizeof(uint32_t) * num_ids);
+			num_hashes += num_ids;
+			num_ids = 0;
+		}
+	}
+	while (step_result == SQLITE_ROW && num_hashes < num_passwords_loaded);
+	sqlite3_finalize(select_ids);
+
+	// DB busy: not the same
+	int is_same = (step_result == SQLITE_ROW || step_result == SQLITE_DONE) && num_hashes == num_passwords_loaded && XXH64_digest(state) == digest;
+
+	XXH64_freeState(state);
+	free(ids);
+	return is_same;
+}
+// Position and size of each array in the file
+PRIVATE uint64_t snapshot_layout(const SnapshotHeader* header, uint64_t offsets[SNAPSHOT_NUM_ARRAYS], uint64_t sizes[SNAPSHOT_NUM_ARRAYS])
+{
+	sizes[0] = ((uint64_t)header->binary_size) * header->num_hashes;
+	sizes[1] = sizeof(uint32_t) * ((uint64_t)header->num_hashes);
+	sizes[2] = sizeof(uint16_t) * (header->cbg_mask + 1ull);
+	sizes[3] = sizeof(uint32_t) * (header->cbg_mask + 1ull);
+
+	uint64_t offset = SNAPSHOT_ALIGN;
+	for (int i = 0; i < SNAPSHOT_NUM_ARRAYS; i++)
+	{
+		offsets[i] = offset;
+		offset = (offset + LARGE_PAGE_HEADER_SIZE + sizes[i] + SNAPSHOT_ALIGN - 1) / SNAPSHOT_ALIGN * SNAPSHOT_ALIGN;
+	}
+
+	// File size
+	return offsets[SNAPSHOT_NUM_ARRAYS - 1] + LARGE_PAGE_HEADER_SIZE + sizes[SNAPSHOT_NUM_ARRAYS - 1];
+}
+PRIVATE void save_hashes_snapshot(int format_index)
+{
+	if (!is_snapshot_supported(format_index) || !cbg_table)
+		return;
+
+	SnapshotHeader header;
+	memset(&header, 0, sizeof(header));
+	header.magic = SNAPSHOT_MAGIC;
+	header.version = SNAPSHOT_VERSION;
+	header.digest = get_hashes_digest(format_index, hash_ids32, num_passwords_loaded);
+	header.binary_size = formats[format_index].binary_size;
+	header.num_hashes = num_passwords_loaded;
+	header.cbg_mask = cbg_mask;
+	header.cbg_count_unlucky = cbg_count_unlucky;
+	header.cbg_count_moved = cbg_count_moved;
+
+	uint64_t offsets[SNAPSHOT_NUM_ARRAYS], sizes[SNAPSHOT_NUM_ARRAYS];
+	const void* arrays[SNAPSHOT_NUM_ARRAYS] = { binary_values, hash_ids32, cbg_filter, cbg_table };
+	snapshot_layout(&header, offsets, sizes);
+
+	// Write to a temporary file, so a partial write is never used
+	char snapshot_path[FILENAME_MAX], tmp_path[FILENAME_MAX];
+	strcpy(snapshot_path, get_snapshot_path(format_index));
+	strcpy(tmp_path, snapshot_path);
+	strcat(tmp_path, ".tmp");
+
+	FILE* file = fopen(tmp_path, "wb");
+	if (!file)
+		return;
+
+	// Padding and space for the mapping header
+	void* zeros = calloc(SNAPSHOT_ALIGN + LARGE_PAGE_HEADER_SIZE, 1);
+	int is_ok = zeros && fwrite(&header, sizeof(header), 1, file) == 1;
+	uint64_t file_pos = sizeof(header);
+	for (int i = 0; is_ok && i < SNAPSHOT_NUM_ARRAYS; i++)
+	{
+		size_t padding_size = (size_t)(offsets[i] + LARGE_PAGE_HEADER_SIZE - file_pos);
+		is_ok = fwrite(zeros, 1, padding_size, file) == padding_size;
+
+		is_ok = is_ok && fwrite(arrays[i], 1, (size_t)sizes[i], file) == sizes[i];
+		file_pos = offsets[i] + LARGE_PAGE_HEADER_SIZE + sizes[i];
+	}
+	is_ok = !fclose(file) && is_ok;
+	free(zeros);
+
+	remove(snapshot_path);
+	if (!is_ok || rename(tmp_path, snapshot_path))
+	{
+		hs_log(HS_LOG_WARNING, "Load hashes", "Snapshot of hashes not saved");
+		remove(tmp_path);
+	}
+}
+// Map the snapshot if it contains the hashes to load. Return TRUE if loaded.
+PRIVATE int load_hashes_snapshot(int format_index)
+{
+	if (!is_snapshot_supported(format_index))
+		return FALSE;
+
+	char snapshot_path[FILENAME_MAX];
+	strcpy(snapshot_path, get_snapshot_path(format_index));
+
+	FILE* file = fopen(snapshot_path, "rb");
+	if (!file)
+		return FALSE;
+
+	SnapshotHeader header;
+	uint64_t offsets[SNAPSHOT_NUM_ARRAYS], sizes[SNAPSHOT_NUM_ARRAYS];
+	int is_valid = fread(&header, sizeof(header), 1, file) == 1 &&
+		header.magic == SNAPSHOT_MAGIC && header.version == SNAPSHOT_VERSION &&
+		header.binary_size == formats[format_index].binary_size && header.num_hashes == num_passwords_loaded &&
+		snapshot_layout(&header, offsets, sizes) == (uint64_t)_filelengthi64(fileno(file)) &&
+		is_db_hashes_digest(format_index, header.digest);
+	fclose(file);
+
+	if (!is_valid)
+	{
+		// Old snapshot: the hashes changed
+		remove(snapshot_path);
+		return FALSE;
+	}
+
+	void* arrays[SNAPSHOT_NUM_ARRAYS];
+	for (int i = 0; i < SNAPSHOT_NUM_ARRAYS; i++)
+		arrays[i] = large_page_map_file(snapshot_path, offsets[i], (size_t)sizes[i]);
+
+	if (!arrays[0] || !arrays[1] || !arrays[2] || !arrays[3])
+	{
+		for (int i = 0; i < SNAPSHOT_NUM_ARRAYS; i++)
+			large_page_free(arrays[i]);
+		return FALSE;
+	}
+
+	binary_values = arrays[0];
+	hash_ids32 = (uint32_t*)arrays[1];
+	cbg_filter = (uint16_t*)arrays[2];
+	cbg_table = (uint32_t*)arrays[3];
+	cbg_mask = header.cbg_mask;
+	cbg_count_unlucky = header.cbg_count_unlucky;
+	cbg_count_moved = header.cbg_count_moved;
+
+	return TRUE;
+}
+PUBLIC void delete_hashes_snapshots()
+{
+	for (int i = 0; i < num_formats; i++)
+		if (is_snapshot_supported(i))
+			remove(get_snapshot_path(i));
+}
+PRIVATE int load_hashes(int format_index)
 {
 	assert(format_index >= 0 && format_index < num_formats);
 
-	uint32_t current_index = 0, i;
+	uint32_t current_index = 0;
 
 	num_passwords_loaded = num_hashes_by_formats1[format_index] - num_hashes_found_by_format1[format_index];
 
@@ -495,14 +1039,30 @@ PRIVATE void load_hashes(int format_index)
 	num_passwords_loaded = __min(num_passwords_loaded, MAX_NUM_PASWORDS_LOADED);
 	int64_t start_load = get_milliseconds();
 
+	// Check the hashes fit in memory
+	if (load_hashes_memory_needed(format_index) > get_available_memory())
+	{
+		hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory to load %u hashes", num_passwords_loaded);
+		return FALSE;
+	}
+
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////
 	// Load the found hashes
 	/////////////////////////////////////////////////////////////////////////////////////////////////////////
-	if (!cache_had_hashes)
+	int is_snapshot_loaded = FALSE;
+	num_cbg_reinserts = 0;
+	int is_loaded_from_db = FALSE;
+	if (!cache_had_hashes && !(is_snapshot_loaded = load_hashes_snapshot(format_index)))
 	{
 		// Create data structures needed.
-		binary_values = _aligned_malloc(formats[format_index].binary_size * ((size_t)num_passwords_loaded), 4096);
-		hash_ids32    = (uint32_t*)malloc(sizeof(uint32_t) * num_passwords_loaded);
+		binary_values = large_page_alloc(formats[format_index].binary_size * ((size_t)num_passwords_loaded));
+		hash_ids32    = (uint32_t*)large_page_alloc(sizeof(uint32_t) * num_passwords_loaded);
+
+		if (!binary_values || !hash_ids32)
+		{
+			hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory to load %u hashes", num_passwords_loaded);
+			return FALSE;
+		}
 	}
 	is_foundBit = (uint32_t*)malloc(sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
 	memset(is_foundBit, FALSE, sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
@@ -523,6 +1083,11 @@ PRIVATE void load_hashes(int format_index)
 
 		// Initialize table map
 		memset(same_salt_next, 0xff, sizeof(uint32_t) * num_passwords_loaded);
+		if (!begin_group_salts(num_passwords_loaded))
+		{
+			hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory to group the salts of %u hashes", num_passwords_loaded);
+			return FALSE;
+		}
 	}
 	else if(format_index == LM_INDEX)// Non-salted hash
 	{
@@ -543,24 +1108,13 @@ PRIVATE void load_hashes(int format_index)
 		{
 			if (formats[format_index].salt_size)// Salted hash
 			{
-				// Check if salt exist
-				for (i = 0; i < num_diff_salts; i++)
-					if (!memcmp((BYTE*)salts_values + ((size_t)current_index)*formats[format_index].salt_size,
-								(BYTE*)salts_values + ((size_t)i)            *formats[format_index].salt_size, formats[format_index].salt_size))
-					{// salt already exist
-						uint32_t last_index = salt_index[i];
-						while (same_salt_next[last_index] != NO_ELEM)
-							last_index = same_salt_next[last_index];
-
-						same_salt_next[last_index] = current_index;
-						break;
-					}
+				// As loading from DB: salt number i is at position i of salts_values
+				BYTE* salt = (BYTE*)salts_values + ((size_t)current_index) * formats[format_index].salt_size;
+				BYTE* salt_slot = (BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size;
+				if (salt_slot != salt)
+					memmove(salt_slot, salt, formats[format_index].salt_size);
 
-				if (i == num_diff_salts)// salt not exist
-				{
-					salt_index[num_diff_salts] = current_index;
-					num_diff_salts++;
-				}
+				group_salt(format_index, current_index, salt_slot);
 			}
 			else if (format_index == LM_INDEX)// Non-salted hash
 			{
@@ -583,86 +1137,52 @@ PRIVATE void load_hashes(int format_index)
 				}
 			}
 		}
+		// Salts were compacted: the cache isn't valid anymore
+		if (formats[format_index].salt_size && num_diff_salts != num_passwords_loaded)
+			cache_had_hashes = FALSE;
+	}
+	else if (is_snapshot_loaded)
+	{
+		current_index = num_passwords_loaded;
 	}
 	else
 	{
-		sqlite3_stmt* select_not_cracked;
-		sqlite3_prepare_v2(db, "SELECT Bin,ID FROM Hash WHERE Type=?;", -1, &select_not_cracked, NULL);
-		sqlite3_bind_int64(select_not_cracked, 1, formats[format_index].db_id);
-
-		while (sqlite3_step(select_not_cracked) == SQLITE_ROW)
+		is_loaded_from_db = TRUE;
+		current_index = load_hashes_from_db(format_index);
+		if (current_index == LOAD_HASHES_FAILED)
 		{
-			assert(current_index <= num_passwords_loaded);
-			uint32_t hash_id = (uint32_t)sqlite3_column_int64(select_not_cracked, 1);
-			// Check if hash is already found
-			if (load_fam(hash_id) != NO_ELEM) continue;
-			// TODO: If below assert don't work then recalculate FAM
-			assert(current_index < num_passwords_loaded);
-			hash_ids32[current_index] = hash_id;
-
-			// Load binary from database
-			BYTE* bin = (BYTE*)sqlite3_column_blob(select_not_cracked, 0);
-			memcpy((BYTE*)binary_values + ((size_t)current_index) * formats[format_index].binary_size, bin, formats[format_index].binary_size);
-			memcpy((BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size, bin + formats[format_index].binary_size, formats[format_index].salt_size);
-
-			if (formats[format_index].salt_size)// Salted hash
-			{
-				// Check if salt exist
-				for (i = 0; i < num_diff_salts; i++)
-					if (!memcmp((BYTE*)salts_values + ((size_t)num_diff_salts)*formats[format_index].salt_size,
-								(BYTE*)salts_values + ((size_t)i)             *formats[format_index].salt_size, formats[format_index].salt_size))
-					{// salt already exist
-						uint32_t last_index = salt_index[i];
-						while (same_salt_next[last_index] != NO_ELEM)
-							last_index = same_salt_next[last_index];
-
-						same_salt_next[last_index] = current_index;
-						break;
-					}
-
-				if (i == num_diff_salts)// salt not exist
-				{
-					salt_index[num_diff_salts] = current_index;
-					num_diff_salts++;
-				}
-			}
-			else if (format_index == LM_INDEX)// Non-salted hash
-			{
-				uint32_t value_map = ((uint32_t*)bin)[formats[format_index].value_map_index0];
-
-				bit_table[(value_map & size_bit_table) >> 5] |= 1 << ((value_map & size_bit_table) & 31);
-				// Put the password in the table map
-				if (table[value_map & size_table] == NO_ELEM)
-				{
-					table[value_map & size_table] = current_index;
-				}
-				else
-				{
-					uint32_t last_index = table[value_map & size_table];
-					while (same_hash_next[last_index] != NO_ELEM)
-						last_index = same_hash_next[last_index];
-
-					same_hash_next[last_index] = current_index;
-				}
-			}
-
-			current_index++;
-			// Limit to MAX_NUM_PASWORDS_LOADED
-			if (current_index >= num_passwords_loaded)
-				break;
+			end_group_salts();
+			return FALSE;
 		}
+
 		// More than 3 seconds loading
 		if ((get_milliseconds() - start_load) > 3000)
 			set_cache(format_index);
-
-		sqlite3_finalize(select_not_cracked);
 	}
 
-	build_cbg_table(format_index, formats[format_index].value_map_index0, formats[format_index].value_map_index1);
+	end_group_salts();
+
+	if (!is_snapshot_loaded)
+	{
+		num_cbg_reinserts = build_cbg_table(format_index, formats[format_index].value_map_index0, formats[format_index].value_map_index1);
+		if (num_cbg_reinserts == CBG_TABLE_FAILED)
+		{
+			num_cbg_reinserts = 0;
+			return FALSE;
+		}
+		if (num_cbg_reinserts)
+			hs_log(HS_LOG_INFO, "Load hashes", "Cuckoo table grown: %u re-inserts", num_cbg_reinserts);
+
+		// More than 3 seconds loading: save for next attacks
+		if (is_loaded_from_db && (get_milliseconds() - start_load) > 3000)
+			save_hashes_snapshot(format_index);
+	}
 	assert(current_index == num_passwords_loaded);	
 
 	if (formats[format_index].optimize_hashes)
 		formats[format_index].optimize_hashes();
+
+	return TRUE;
 }
 typedef struct
 {
@@ -701,8 +1221,8 @@ PRIVATE void load_hashes_test(int format_index)
 	num_passwords_loaded = test_num_hashes;
 
 	// Create data structures needed.
-	binary_values = _aligned_malloc(formats[format_index].binary_size * num_passwords_loaded, 4096);
-	hash_ids32 = (uint32_t*)malloc(sizeof(uint32_t) * num_passwords_loaded);
+	binary_values = large_page_alloc(formats[format_index].binary_size * num_passwords_loaded);
+	hash_ids32 = (uint32_t*)large_page_alloc(sizeof(uint32_t) * num_passwords_loaded);
 	is_foundBit = (uint32_t*)malloc(sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
 	memset(is_foundBit, FALSE, sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
 	// Data for keys found
@@ -722,6 +1242,7 @@ PRIVATE void load_hashes_test(int format_index)
 		// Initialize table map
 		for (i = 0; i < num_passwords_loaded; i++)
 			same_salt_next[i] = NO_ELEM;
+		begin_group_salts(num_passwords_loaded);
 	}
 	else if (format_index == LM_INDEX)// Non-salted hash
 	{
@@ -753,24 +1274,7 @@ PRIVATE void load_hashes_test(int format_index)
 
 		if (formats[format_index].salt_size)// Salted hash
 		{
-			// Check if salt exist
-			for (i = 0; i < num_diff_salts; i++)
-				if (!memcmp((char*)salts_values + num_diff_salts * formats[format_index].salt_size,
-					(char*)salts_values + i * formats[format_index].salt_size, formats[format_index].salt_size))
-				{// salt already exist
-					uint32_t last_index = salt_index[i];
-					while (same_salt_next[last_index] != NO_ELEM)
-						last_index = same_salt_next[last_index];
-
-					same_salt_next[last_index] = current_index;
-					break;
-				}
-
-			if (i == num_diff_salts)// salt not exist
-			{
-				salt_index[num_diff_salts] = current_index;
-				num_diff_salts++;
-			}
+			group_salt(format_index, current_index, (BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size);
 		}
 		else if (format_index == LM_INDEX)// Non-salted hash
 		{
@@ -792,6 +1296,8 @@ PRIVATE void load_hashes_test(int format_index)
 
 		hash_ids32[current_index] = current_index;
 	}
+	end_group_salts();
+
 	if(format_index != LM_INDEX)
 		build_cbg_table(format_index, formats[format_index].value_map_index0, formats[format_index].value_map_index1);
 
@@ -808,8 +1314,8 @@ PRIVATE void load_hashes_benchmark(int format_index)
 	num_passwords_loaded = MAX_NUM_PASWORDS_LOADED;
 
 	// Create data structures needed.
-	binary_values =                 _aligned_malloc(formats[format_index].binary_size    * num_passwords_loaded, 4096);
-	hash_ids32    = (uint32_t*)malloc(sizeof(uint32_t) * num_passwords_loaded);
+	binary_values =                 large_page_alloc(formats[format_index].binary_size   * num_passwords_loaded);
+	hash_ids32    = (uint32_t*)large_page_alloc(sizeof(uint32_t) * num_passwords_loaded);
 	is_foundBit   = (uint32_t*)malloc(sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
 	memset(is_foundBit, FALSE, sizeof(uint32_t) * (num_passwords_loaded / 32 + 1));
 	// Data for keys found
@@ -829,6 +1335,7 @@ PRIVATE void load_hashes_benchmark(int format_index)
 		// Initialize table map
 		for(i = 0; i < num_passwords_loaded; i++)
 			same_salt_next[i] = NO_ELEM;
+		begin_group_salts(num_passwords_loaded);
 	}
 	else if (format_index == LM_INDEX)// Non-salted hash
 	{
@@ -904,24 +1411,7 @@ PRIVATE void load_hashes_benchmark(int format_index)
 		
 		if(formats[format_index].salt_size)// Salted hash
 		{
-			// Check if salt exist
-			for(i = 0; i < num_diff_salts; i++)
-				if(!memcmp( (char*)salts_values + num_diff_salts*formats[format_index].salt_size,
-							(char*)salts_values +       i       *formats[format_index].salt_size, formats[format_index].salt_size))
-				{// salt already exist
-					uint32_t last_index = salt_index[i];
-					while(same_salt_next[last_index] != NO_ELEM)
-						last_index = same_salt_next[last_index];
-
-					same_salt_next[last_index] = current_index;
-					break;
-				}
-
-			if(i == num_diff_salts)// salt not exist
-			{
-				salt_index[num_diff_salts] = current_index;
-				num_diff_salts++;
-			}
+			group_salt(format_index, current_index, (BYTE*)salts_values + ((size_t)num_diff_salts) * formats[format_index].salt_size);
 		}
 		else if (format_index == LM_INDEX)// Non-salted hash
 		{
@@ -943,6 +1433,7 @@ PRIVATE void load_hashes_benchmark(int format_index)
 
 		hash_ids32[current_index] = current_index;
 	}
+	end_group_salts();
 
 	build_cbg_table(format_index, formats[format_index].value_map_index0, formats[format_index].value_map_index1);
 
@@ -964,6 +1455,7 @@ PUBLIC void password_was_found(uint32_t index, unsigned char* cleartext)
 		if (!((is_foundBit[index >> 5] >> (index & 31)) & 1))
 		{
 			is_foundBit[index >> 5] |= 1 << (index & 31);
+			remove_from_cbg_table(batch[current_attack_index].format_index, index);
 			num_passwords_found++;
 
 			if (num_passwords_found >= num_passwords_loaded)
@@ -975,10 +1467,11 @@ PUBLIC void password_was_found(uint32_t index, unsigned char* cleartext)
 	}
 	else
 	{
-		// TODO: Remove the password from the table
 		if (!((is_foundBit[index >> 5] >> (index & 31)) & 1))
 		{
 			is_foundBit[index >> 5] |= 1 << (index & 31);
+			// Not needed anymore: don't spend lookups on it
+			remove_from_cbg_table(batch[current_attack_index].format_index, index);
 
 			num_passwords_found++;
 			num_hashes_found_by_format1[batch[current_attack_index].format_index]++;
@@ -1039,8 +1532,19 @@ PRIVATE void begin_crack(void* set_start_time)
 		load_hashes_test(batch[current_attack_index].format_index);
 	else if(is_benchmark)
 		load_hashes_benchmark(batch[current_attack_index].format_index);
-	else
-		load_hashes(batch[current_attack_index].format_index);
+	else if (!load_hashes(batch[current_attack_index].format_index))
+	{
+		// Not enough memory: stop cleanly, the attack can be resumed later.
+		// Leave the same state as a batch stopped by the user
+		release_all_cache();
+		num_passwords_loaded = 0;
+		continue_attack = FALSE;
+		stop_universe = TRUE;
+		save_needed = FALSE;
+		send_message_gui(MESSAGE_ATTACK_NO_MEMORY);
+		send_message_gui(MESSAGE_FINISH_BATCH);
+		return;
+	}
 	continue_attack = TRUE;
 	stop_universe = FALSE;
 	save_needed = FALSE;
@@ -1093,6 +1597,10 @@ out_opencl:
 	num_threads += app_num_threads;
 	perform_crypt = NULL;
 	generate = NULL;
+#ifdef HS_X86
+	// Only the first attack pays for the probes
+	calibrate_hardware();
+#endif
 
 	for(j = 0; j < LENGTH(formats[batch[current_attack_index].format_index].impls); j++)
 	{
@@ -1409,6 +1917,130 @@ PUBLIC uint32_t load_fam(uint64_t pos) {
 	HS_LEAVE_MUTEX(&hash2found_id.mutex);
 	return result;
 }
+// Remove the hashes already found, keeping the order. Return the number of hashes left.
+PRIVATE uint32_t remove_found_hashes(uint32_t* hash_ids, BYTE* bins, uint32_t num_hashes, uint32_t bin_size)
+{
+	uint32_t num_left = 0;
+	HS_ENTER_MUTEX(&hash2found_id.mutex);
+
+	for (uint32_t i = 0; i < num_hashes; i++)
+	{
+		ensure_good_fam(hash_ids[i]);
+		if (hash2found_id.data[hash_ids[i] - hash2found_id.offset] == NO_ELEM)
+		{
+			if (num_left != i)
+			{
+				hash_ids[num_left] = hash_ids[i];
+				if (bins)
+					memcpy(bins + ((size_t)num_left) * bin_size, bins + ((size_t)i) * bin_size, bin_size);
+			}
+			num_left++;
+		}
+	}
+
+	HS_LEAVE_MUTEX(&hash2found_id.mutex);
+	return num_left;
+}
+#ifdef HS_TESTING
+// Load NTLM hashes from a temporary DB with one thread and with many threads.
+// Return TRUE if both loads have the same ids and binaries, byte by byte.
+#define TEST_LOAD_MAX_IDS		(48 * LOAD_RANGE_SIZE)
+#define TEST_LOAD_NUM_THREADS	4
+PUBLIC int test_parallel_load_hashes()
+{
+	// IDs must be inside the found hashes map: remove_found_hashes() checks them
+	uint32_t num_ids = (uint32_t)__min(hash2found_id.file_size / sizeof(uint32_t) - 1, TEST_LOAD_MAX_IDS);
+	const uint32_t bin_size = formats[NTLM_INDEX].binary_size;
+	char test_filename[1024];
+	sqlite3* test_db = NULL;
+	int result = TRUE;
+
+	if (num_ids < 2)
+		return TRUE;
+	sprintf(test_filename, "%.1000s-load", sqlite3_db_filename(db, "main"));
+	remove(test_filename);
+	if (sqlite3_open_v2(test_filename, &test_db, SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE, NULL) != SQLITE_OK)
+	{
+		sqlite3_close(test_db);
+		return FALSE;
+	}
+
+	// Hashes of NTLM and other formats mixed, with gaps in the IDs
+	uint8_t bin[64];
+	uint32_t num_hashes = 0;
+	sqlite3_stmt* insert_hash;
+	sqlite3_exec(test_db, "CREATE TABLE Hash (ID INTEGER PRIMARY KEY, Type INTEGER NOT NULL, Bin BLOB NOT NULL);BEGIN TRANSACTION;", NULL, NULL, NULL);
+	sqlite3_prepare_v2(test_db, "INSERT INTO Hash (ID,Type,Bin) VALUES (?,?,?);", -1, &insert_hash, NULL);
+	for (uint32_t id = 1; id <= num_ids; id++)
+	{
+		int type = rand() % 8;
+		if (type == 0)// Gap
+			continue;
+
+		generate_random(bin, bin_size);
+		sqlite3_reset(insert_hash);
+		sqlite3_bind_int64(insert_hash, 1, id);
+		sqlite3_bind_int64(insert_hash, 2, type == 1 ? formats[MD5_INDEX].db_id : formats[NTLM_INDEX].db_id);
+		sqlite3_bind_blob(insert_hash, 3, bin, bin_size, SQLITE_STATIC);
+		sqlite3_step(insert_hash);
+		if (type != 1)
+			num_hashes++;
+	}
+	sqlite3_finalize(insert_hash);
+	sqlite3_exec(test_db, "COMMIT TRANSACTION;", NULL, NULL, NULL);
+
+	// Save the attack state
+	sqlite3* old_db = db;
+	void* old_binary_values = binary_values;
+	uint32_t* old_hash_ids32 = hash_ids32;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint32_t old_app_num_threads = app_num_threads;
+	uint32_t old_num_diff_salts = num_diff_salts;
+
+	db = test_db;
+	num_passwords_loaded = num_hashes;
+	uint32_t* ids[2];
+	void* bins[2];
+	uint32_t num_loaded[2];
+	for (int i = 0; i < 2; i++)
+	{
+		ids[i] = (uint32_t*)malloc(sizeof(uint32_t) * num_hashes);
+		bins[i] = malloc(((size_t)bin_size) * num_hashes);
+		if (ids[i] && bins[i])
+			memset(bins[i], 0, ((size_t)bin_size) * num_hashes);
+		hash_ids32 = ids[i];
+		binary_values = bins[i];
+		num_diff_salts = 0;
+		app_num_threads = i ? TEST_LOAD_NUM_THREADS : 1;
+		num_loaded[i] = (ids[i] && bins[i]) ? load_hashes_from_db(NTLM_INDEX) : LOAD_HASHES_FAILED;
+	}
+
+	if (num_loaded[0] == LOAD_HASHES_FAILED || num_loaded[0] != num_loaded[1] ||
+		memcmp(ids[0], ids[1], sizeof(uint32_t) * num_loaded[0]) || memcmp(bins[0], bins[1], ((size_t)bin_size) * num_loaded[0]))
+	{
+		hs_log(HS_LOG_ERROR, "Test Suite", "Parallel load differs: %u hashes vs %u in one thread", num_loaded[1], num_loaded[0]);
+		result = FALSE;
+	}
+
+	// Restore the attack state
+	db = old_db;
+	binary_values = old_binary_values;
+	hash_ids32 = old_hash_ids32;
+	num_passwords_loaded = old_num_passwords_loaded;
+	app_num_threads = old_app_num_threads;
+	num_diff_salts = old_num_diff_salts;
+
+	for (int i = 0; i < 2; i++)
+	{
+		free(ids[i]);
+		free(bins[i]);
+	}
+	sqlite3_close(test_db);
+	remove(test_filename);
+
+	return result;
+}
+#endif
 ////////////////////////////////////////////////////////////////////////////////////
 
 PRIVATE int qsort_compare(const void *arg1, const void *arg2)
@@ -1567,6 +2199,50 @@ PUBLIC void finish_thread()
 			is_test = FALSE;
 			continue_attack = TRUE;
 
+#ifdef HS_TESTING
+			// Removing found hashes while other threads look them up
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !test_remove_from_cbg_table())
+				test_errors_detected = TRUE;
+			// Filter stage: per-key loop vs cbg_filter_batch() by number of hashes
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !bench_cbg_filter_batch())
+				test_errors_detected = TRUE;
+			// Table build time and peak memory, also growing in place
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !bench_build_cbg_table())
+				test_errors_detected = TRUE;
+			// Table lookups with and without large pages
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !bench_large_page_lookup())
+				test_errors_detected = TRUE;
+			// Hashes loaded by many threads same as by one
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !test_parallel_load_hashes())
+				test_errors_detected = TRUE;
+			// Keys served counters against a mutex by number of threads
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !bench_report_keys_processed())
+				test_errors_detected = TRUE;
+			// All NTLM kernels compiled against hash_ntlm
+			if (batch[current_attack_index].format_index == NTLM_INDEX && !test_ntlm_kernels())
+				test_errors_detected = TRUE;
+			// All LM kernels compiled against hash_lm
+			if (batch[current_attack_index].format_index == LM_INDEX && !test_lm_kernels())
+				test_errors_detected = TRUE;
+			// Mixed-length keys against keys grouped by length
+			if (batch[current_attack_index].format_index == SHA256CRYPT_INDEX && !bench_sha256crypt_grouping())
+				test_errors_detected = TRUE;
+			if (batch[current_attack_index].format_index == SHA512CRYPT_INDEX && !bench_sha512crypt_grouping())
+				test_errors_detected = TRUE;
+#ifdef HS_X86
+			// Key-major against salt-major from 1 to 10^4 salts
+			if (batch[current_attack_index].format_index == DCC_INDEX && !bench_dcc_salts_major())
+				test_errors_detected = TRUE;
+			// All x86 kernels against hash_sha256, with 1 to 10^6 hashes
+			if (batch[current_attack_index].format_index == SHA256_INDEX && !bench_raw_sha256_kernels())
+				test_errors_detected = TRUE;
+#endif
+#ifdef _M_X64
+			// Both x64 engines, not only the selected one
+			if (batch[current_attack_index].format_index == BCRYPT_INDEX && !test_bcrypt_engines())
+				test_errors_detected = TRUE;
+#endif
+#endif
 			send_message_gui((test_errors_detected || num_passwords_found != num_passwords_loaded) ? MESSAGE_TESTING_FAIL : MESSAGE_TESTING_SUCCEED);
 
 #ifndef HS_TESTING
@@ -1877,4 +2553,4 @@ PUBLIC void init_attack_data()
 		if (totalFoundsWithFAM != total_num_hashes_found())
 			load_foundhashes_from_db();
 	}
-}
\ No newline at end of file
+}
\ No newline at end of file
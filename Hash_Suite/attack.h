@@ -15,9 +15,41 @@ extern "C" {  // only need to export C interface if used by C++ source code
 	extern uint32_t cbg_mask;
 	extern uint32_t cbg_count_unlucky;
 	extern uint32_t cbg_count_moved;
-
-	void build_cbg_table(int format_index, uint32_t value_map_index0, uint32_t value_map_index1);
+	extern uint32_t cbg_num_removed;
+
+	// Returned by build_cbg_table when there isn't memory for the table
+#define CBG_TABLE_FAILED	UINT32_MAX
+	uint32_t build_cbg_table(int format_index, uint32_t value_map_index0, uint32_t value_map_index1);
+	void remove_from_cbg_table(int format_index, uint32_t index);
+#ifdef HS_TESTING
+	int test_remove_from_cbg_table();
+	int bench_cbg_filter_batch();
+	int bench_build_cbg_table();
+	int bench_large_page_lookup();
+	int test_parallel_load_hashes();
+	int bench_report_keys_processed();
+	int test_ntlm_kernels();
+	int test_lm_kernels();
+	int bench_sha256crypt_grouping();
+	int bench_sha512crypt_grouping();
+#ifdef HS_X86
+	int bench_dcc_salts_major();
+	int bench_raw_sha256_kernels();
+#endif
+#ifdef _M_X64
+	int test_bcrypt_engines();
+#endif
+#endif
+	uint32_t cbg_filter_batch(const uint32_t* up0, const uint32_t* up1, uint32_t num_keys, uint32_t* candidates);
+	// Below this number of hashes the filter stays in cache: the per-key compare loop is faster
+#define CBG_FILTER_BATCH_MIN_HASHES	100000
+	void* large_page_alloc(size_t size);
+	// Map part of a file. The 'offset' must be 64KB aligned and the data start
+	// LARGE_PAGE_HEADER_SIZE bytes after it
+	void* large_page_map_file(const char* file_path, uint64_t offset, size_t size);
 	void large_page_free(void* ptr);
+// One page: pointers returned stay page aligned, needed by CL_MEM_USE_HOST_PTR
+#define LARGE_PAGE_HEADER_SIZE	4096
 #ifdef __cplusplus
 }
 #endif
@@ -122,6 +154,7 @@ typedef struct oclKernel2Common
 
 extern oclKernel2Common kernels2common[];
 extern uint32_t num_kernels2common;
+oclKernel2Common* ocl_select_kernel2common(oclKernel2Common* ocl_kernel_provider, generate_key_funtion** gen);
 cl_uint ocl_rule_simple_copy_unicode(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size);
 cl_uint ocl_rule_simple_copy_utf8_le(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size);
 //cl_uint ocl_rule_simple_copy_utf8_be(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size);
@@ -174,5 +207,6 @@ void ocl_slow_ordered_found(OpenCL_Param* param, cl_uint* num_found, cl_uint gpu
 #define CHARSET_INDEX_IN_KERNELS	0
 #define PHRASES_INDEX_IN_KERNELS	1
 #define UTF8_INDEX_IN_KERNELS		2
+#define MASK_INDEX_IN_KERNELS		3
 #endif
 
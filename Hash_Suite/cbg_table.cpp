@@ -9,7 +9,7 @@
 #undef max
 
 #ifdef _WIN32
-PRIVATE void* large_page_alloc(size_t size)
+PUBLIC extern "C" void* large_page_alloc(size_t size)
 {
 	void* ptr = NULL;
 
@@ -23,21 +23,149 @@ PRIVATE void* large_page_alloc(size_t size)
 
 	return ptr;
 }
+PUBLIC extern "C" void* large_page_map_file(const char* file_path, uint64_t offset, size_t size)
+{
+	void* ptr = NULL;
+
+	HANDLE h_file = CreateFile(file_path, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (h_file == INVALID_HANDLE_VALUE)
+		return NULL;
+
+	// Copy-on-write: changes are private and never go to the file
+	HANDLE h_map_file = CreateFileMapping(h_file, NULL, PAGE_WRITECOPY, 0, 0, NULL);
+	if (h_map_file)
+	{
+		ptr = MapViewOfFile(h_map_file, FILE_MAP_COPY, (DWORD)(offset >> 32), (DWORD)offset, size + LARGE_PAGE_HEADER_SIZE);
+		CloseHandle(h_map_file);
+	}
+	CloseHandle(h_file);
+
+	return ptr ? ((uint8_t*)ptr) + LARGE_PAGE_HEADER_SIZE : NULL;
+}
 PUBLIC extern "C" void large_page_free(void* ptr)
 {
 	if (ptr)
-		VirtualFree(ptr, 0, MEM_RELEASE);
+	{
+		MEMORY_BASIC_INFORMATION info;
+		// Mapped with large_page_map_file
+		if (VirtualQuery(ptr, &info, sizeof(info)) && info.Type == MEM_MAPPED)
+			UnmapViewOfFile(info.AllocationBase);
+		else
+			VirtualFree(ptr, 0, MEM_RELEASE);
+	}
 }
 #else
-// TODO: Implement this
-PRIVATE void* large_page_alloc(size_t size)
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+// Mapping info saved before the returned pointer
+typedef struct LargePageHeader
+{
+	void* base;
+	size_t map_size;// 0 when allocated with malloc
+}
+LargePageHeader;
+
+PRIVATE void* large_page_mmap(size_t size, LargePageHeader* header)
+{
+	size_t page_size = current_system_info.large_page_size;
+	size_t map_size = (size + page_size - 1) & ~(page_size - 1);
+	void* base;
+
+#ifdef MAP_HUGETLB
+	// Explicit hugetlbfs pages: only when the admin reserved them
+	if (current_system_info.is_large_page_enable & LARGE_PAGE_HUGETLB)
+	{
+		base = mmap(NULL, map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+		if (base != MAP_FAILED)
+		{
+			header->base = base;
+			header->map_size = map_size;
+			return base;
+		}
+	}
+#endif
+
+#ifdef MADV_HUGEPAGE
+	// Transparent huge pages: align to huge page and ask the kernel
+	if (current_system_info.is_large_page_enable & LARGE_PAGE_THP)
+	{
+		base = mmap(NULL, map_size + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (base != MAP_FAILED)
+		{
+			// Trim to alignment
+			size_t offset = (page_size - (((size_t)base) & (page_size - 1))) & (page_size - 1);
+			if (offset)
+				munmap(base, offset);
+			if (page_size - offset)
+				munmap(((uint8_t*)base) + offset + map_size, page_size - offset);
+
+			base = ((uint8_t*)base) + offset;
+			madvise(base, map_size, MADV_HUGEPAGE);
+
+			header->base = base;
+			header->map_size = map_size;
+			return base;
+		}
+	}
+#endif
+
+	return NULL;
+}
+PUBLIC extern "C" void* large_page_alloc(size_t size)
+{
+	LargePageHeader header;
+	uint8_t* ptr = NULL;
+
+	// Check if large page is needed
+	if (current_system_info.is_large_page_enable && size >= current_system_info.large_page_size)
+		ptr = (uint8_t*)large_page_mmap(size + LARGE_PAGE_HEADER_SIZE, &header);
+
+	// Normal allocation
+	if (ptr == NULL)
+	{
+		ptr = (uint8_t*)_aligned_malloc(size + LARGE_PAGE_HEADER_SIZE, 4096);
+		if (ptr == NULL)
+			return NULL;
+
+		header.base = ptr;
+		header.map_size = 0;
+	}
+
+	memcpy(ptr, &header, sizeof(header));
+	return ptr + LARGE_PAGE_HEADER_SIZE;
+}
+PUBLIC extern "C" void* large_page_map_file(const char* file_path, uint64_t offset, size_t size)
 {
-	return _aligned_malloc(size, 64);
+	LargePageHeader header;
+
+	int fd = open(file_path, O_RDONLY);
+	if (fd == -1)
+		return NULL;
+
+	// Copy-on-write: changes are private and never go to the file
+	header.map_size = size + LARGE_PAGE_HEADER_SIZE;
+	header.base = mmap(NULL, header.map_size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, (off_t)offset);
+	close(fd);
+
+	if (header.base == MAP_FAILED)
+		return NULL;
+
+	memcpy(header.base, &header, sizeof(header));
+	return ((uint8_t*)header.base) + LARGE_PAGE_HEADER_SIZE;
 }
 PUBLIC extern "C" void large_page_free(void* ptr)
 {
-	if(ptr)
-		_aligned_free(ptr);
+	if (ptr)
+	{
+		LargePageHeader header;
+		memcpy(&header, ((uint8_t*)ptr) - LARGE_PAGE_HEADER_SIZE, sizeof(header));
+
+		if (header.map_size)
+			munmap(header.base, header.map_size);
+		else
+			_aligned_free(header.base);
+	}
 }
 #endif
 
@@ -331,8 +459,8 @@ public:
 
 	~CuckooBGLinear()
 	{
-		free(data1);
-		free(cache1);
+		large_page_free(data1);
+		large_page_free(cache1);
 
 		data1 = nullptr;
 		cache1 = nullptr;
@@ -340,24 +468,86 @@ public:
 		buckets_mask = 0;
 	}
 
-	void reserve(uint32_t new_capacity_mask) noexcept
+	// Return false if there isn't memory
+	bool reserve(uint32_t new_capacity_mask) noexcept
 	{
-		free(data1);
+		large_page_free(data1);
 		large_page_free(cache1);
 
 		num_elems = 0;
 		buckets_mask = new_capacity_mask;
 		size_t num_buckets = ((size_t)new_capacity_mask) + 1;
 
-		data1 = (T*)malloc(num_buckets * sizeof(T));
+		data1 = (T*)large_page_alloc(num_buckets * sizeof(T));
 		cache1 = (uint16_t*)large_page_alloc(num_buckets * sizeof(uint16_t));
+		if (!data1 || !cache1)
+			return false;
 		memset(cache1, 0, num_buckets * sizeof(uint16_t));
 
 		for (uint32_t i = 1; i < NUM_ELEMS_BUCKET; i++)
 			Set_Reversed(num_buckets-i);
+
+		return true;
 	}
 
-	bool insert(T elem) noexcept
+	// Double the table keeping current placement. Each element stay in the
+	// same slot in the half its new bucket fall into: no full re-insertion.
+	// Old and new arrays are live while copying, so the new ones must fit in
+	// 'available_memory'. Return false if they don't, if there isn't memory
+	// or if the table already have 2^32 buckets. The table is unchanged then.
+	bool grow(uint64_t available_memory) noexcept
+	{
+		if (buckets_mask == UINT32_MAX)
+			return false;
+
+		size_t old_num_buckets = ((size_t)buckets_mask) + 1;
+		uint32_t old_mask = buckets_mask;
+
+		if (2ull * old_num_buckets * (sizeof(T) + sizeof(uint16_t)) > available_memory)
+			return false;
+
+		T* new_data1 = (T*)large_page_alloc(2 * old_num_buckets * sizeof(T));
+		uint16_t* new_cache1 = (uint16_t*)large_page_alloc(2 * old_num_buckets * sizeof(uint16_t));
+		if (!new_data1 || !new_cache1)
+		{
+			large_page_free(new_data1);
+			large_page_free(new_cache1);
+			return false;
+		}
+
+		memcpy(new_data1, data1, old_num_buckets * sizeof(T));
+		memcpy(new_data1 + old_num_buckets, data1, old_num_buckets * sizeof(T));
+		large_page_free(data1);
+		data1 = new_data1;
+		memcpy(new_cache1, cache1, old_num_buckets * sizeof(uint16_t));
+		memcpy(new_cache1 + old_num_buckets, cache1, old_num_buckets * sizeof(uint16_t));
+		large_page_free(cache1);
+		cache1 = new_cache1;
+
+		buckets_mask = (uint32_t)(2 * old_num_buckets - 1);
+
+		// Bucket flags are copied to both halves (unlucky is conservative)
+		for (size_t i = 0; i < 2 * old_num_buckets; i++)
+			if (!Is_Empty(i))
+			{
+				uint64_t hash = hash_elem(data1[i]);
+				size_t bucket = Belong_to_Bucket(i);
+				bool same_old_buckets = ((uint32_t)hash & old_mask) == ((uint32_t)(hash >> 32) & old_mask);
+
+				if (bucket != fastrange32((uint32_t)hash) && (same_old_buckets || bucket != fastrange32(hash >> 32)))
+					Set_Empty(i);
+			}
+
+		return true;
+	}
+
+	uint32_t get_mask() const noexcept
+	{
+		return buckets_mask;
+	}
+
+	// When return false 'elem' is the element without place
+	bool insert(T& elem) noexcept
 	{
 		while (true)
 		{
@@ -521,27 +711,60 @@ public:
 	}
 };
 
-PUBLIC extern "C" void build_cbg_table(int format_index, uint32_t value_map_index0, uint32_t value_map_index1)
+// Put all hashes not found in a table of 'table_size' buckets, growing it when full.
+// Return the number of elements re-inserted because the table was full,
+// or CBG_TABLE_FAILED if there isn't memory for it
+PRIVATE uint32_t fill_cbg_table(int format_index, uint32_t value_map_index0, uint32_t value_map_index1, uint64_t table_size)
 {
-	if (num_passwords_loaded && formats[format_index].salt_size==0)
+	CuckooBGLinear<2, uint32_t> table(formats[format_index].binary_size / 4, value_map_index0, value_map_index1);
+	uint32_t num_reinserts = 0;
+
+	if (!table.reserve((uint32_t)(table_size-1)))
+	{
+		hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory for the cuckoo table");
+		return CBG_TABLE_FAILED;
+	}
+
+	for (uint32_t i = 0; i < num_passwords_loaded; i++)
 	{
-		CuckooBGLinear<2, uint32_t> table(formats[format_index].binary_size / 4, value_map_index0, value_map_index1);
+		// Found hashes are not needed anymore
+		if (is_foundBit && ((is_foundBit[i >> 5] >> (i & 31)) & 1))
+			continue;
 
+		uint32_t elem = i;
+		// Grow in place and put the element left out
+		while (!table.insert(elem))
+		{
+			// The element left out can't be dropped: it would never be found
+			if (!table.grow(get_available_memory()))
+			{
+				hs_log(HS_LOG_ERROR, "Load hashes", "Not enough memory to grow the cuckoo table");
+				return CBG_TABLE_FAILED;
+			}
+			num_reinserts++;
+		}
+	}
+
+	cbg_mask = table.get_mask();
+	std::tie(cbg_filter, cbg_table) = table.generate_fast_data();
+
+	return num_reinserts;
+}
+// Return the number of elements re-inserted because the table was full,
+// or CBG_TABLE_FAILED if there isn't memory for it
+PUBLIC extern "C" uint32_t build_cbg_table(int format_index, uint32_t value_map_index0, uint32_t value_map_index1)
+{
+	uint32_t num_reinserts = 0;
+
+	if (num_passwords_loaded && formats[format_index].salt_size==0)
+	{
 		uint64_t table_size = ceil_power_2(num_passwords_loaded);
 		// Require less than 90% use
 		if(table_size*9ull < num_passwords_loaded*10ull)
 			table_size *= 2;
 
-		// Memory status
-#ifdef _WIN32
-		MEMORYSTATUSEX memx;
-		memx.dwLength = sizeof(memx);
-		GlobalMemoryStatusEx(&memx);
-#else
-		struct {
-			uint64_t ullAvailPhys = UINT64_MAX;
-		} memx;
-#endif
+		// Memory status: RAM, cgroup limits and user budget
+		uint64_t available_memory = get_available_memory();
 
 		while (table_size < num_passwords_loaded*4ull)//25%
 		{
@@ -550,7 +773,7 @@ PUBLIC extern "C" void build_cbg_table(int format_index, uint32_t value_map_inde
 				break;
 
 			// Don't grow if growing surpass RAM size
-			if ((table_size*2+1)*6 > memx.ullAvailPhys)
+			if ((table_size*2+1)*6 > available_memory)
 				break;
 
 			table_size *= 2;
@@ -559,24 +782,141 @@ PUBLIC extern "C" void build_cbg_table(int format_index, uint32_t value_map_inde
 		table_size = __max(2048, table_size);// 4k: one page
 		table_size = __min(0x1'0000'0000ull, table_size);// 32bits max
 
-		bool repeat_generation = true;
-		while (repeat_generation)
+		num_reinserts = fill_cbg_table(format_index, value_map_index0, value_map_index1, table_size);
+	}
+
+	return num_reinserts;
+}
+
+// Remove a found hash from the table while the attack continue.
+// Only the filter tag changes, with one atomic store: bucket flags are preserved
+// so other elements remain reachable, and the table slot keeps a valid index so
+// a lookup racing with this never reads a half-removed slot (the found hash is
+// discarded by is_foundBit). GPUs copy the change with ocl_remove_found_from_cbg_table().
+// Must be called with found_keys_mutex held.
+PUBLIC extern "C" void remove_from_cbg_table(int format_index, uint32_t index)
+{
+	if (!cbg_table || formats[format_index].salt_size)
+		return;
+
+	uint32_t* bin = ((uint32_t*)binary_values) + index * (formats[format_index].binary_size / 4);
+	uint32_t up0 = bin[formats[format_index].value_map_index0];
+	uint32_t up1 = bin[formats[format_index].value_map_index1];
+
+	uint32_t pos[4];
+	uint32_t num_pos = 0;
+
+	pos[num_pos++] = up0 & cbg_mask;
+	uint_fast16_t data = cbg_filter[pos[0]];
+	if (data & 0b110)
+	{
+		pos[num_pos++] = pos[0] + (data & 0b1 ? -1 : 1);
+		// Unluky bucket
+		if (data & 0b10)
+		{
+			pos[num_pos++] = up1 & cbg_mask;
+			pos[num_pos] = pos[num_pos - 1] + (cbg_filter[pos[num_pos - 1]] & 0b1 ? -1 : 1);
+			num_pos++;
+		}
+	}
+
+	for (uint32_t i = 0; i < num_pos; i++)
+		if (cbg_table[pos[i]] == index)
+		{
+			// Change the tag so the filter rejects this hash
+			HS_ATOMIC_STORE16_RELEASE(cbg_filter + pos[i], (uint16_t)(cbg_filter[pos[i]] ^ 0xFFF8));
+			// GPU threads read it without the mutex
+			HS_ATOMIC_STORE32_RELEASE(&cbg_num_removed, cbg_num_removed + 1);
+			break;
+		}
+}
+
+#define CBG_PREFETCH_DISTANCE 16
+template<bool PREFETCH, bool PREFETCH_UNLUCKY> uint32_t cbg_filter_batch_template(const uint32_t* up0, const uint32_t* up1, uint32_t num_keys, uint32_t* candidates)
+{
+	// Local copies: 'candidates' may alias the globals, so the compiler reloads them after each store
+	const uint16_t* filter = cbg_filter;
+	const uint32_t* table = cbg_table;
+	const uint32_t mask = cbg_mask;
+	uint32_t num_candidates = 0;
+
+	if (PREFETCH)
+		for (uint32_t i = 0; i < __min(CBG_PREFETCH_DISTANCE, num_keys); i++)
 		{
-			repeat_generation = false;
-			table.reserve((uint32_t)(table_size-1));
+			HS_PREFETCH(filter + (up0[i] & mask));
+			if (PREFETCH_UNLUCKY)
+				HS_PREFETCH(filter + (up1[i] & mask));
+		}
+
+	for (uint32_t i = 0; i < num_keys; i++)
+	{
+		if (PREFETCH && (i + CBG_PREFETCH_DISTANCE) < num_keys)
+		{
+			HS_PREFETCH(filter + (up0[i + CBG_PREFETCH_DISTANCE] & mask));
+			if (PREFETCH_UNLUCKY)
+				HS_PREFETCH(filter + (up1[i + CBG_PREFETCH_DISTANCE] & mask));
+		}
+
+		uint32_t up_0 = up0[i];
+		uint32_t up_1 = up1[i];
 
-			for (uint32_t i = 0; i < num_passwords_loaded; i++)
-				if (!table.insert(i))
+		uint32_t pos = up_0 & mask;
+		uint_fast16_t data = filter[pos];
+		if (((data ^ up_1) & 0xFFF8) == 0 && table[pos] != NO_ELEM)
+		{
+			candidates[num_candidates++] = i;
+			candidates[num_candidates++] = table[pos];
+		}
+
+		if (data & 0b110)
+		{
+			pos += data & 0b1 ? -1 : 1;
+			uint_fast16_t hash = filter[pos];
+			if (((hash ^ up_1) & 0xFFF8) == 0 && table[pos] != NO_ELEM)
+			{
+				candidates[num_candidates++] = i;
+				candidates[num_candidates++] = table[pos];
+			}
+
+			if (data & 0b10)
+			{
+				pos = up_1 & mask;
+				data = filter[pos];
+				if (((data ^ up_0) & 0xFFF8) == 0 && table[pos] != NO_ELEM)
 				{
-					table_size *= 2;
-					repeat_generation = true;
-					break;
+					candidates[num_candidates++] = i;
+					candidates[num_candidates++] = table[pos];
 				}
-		}
 
-		cbg_mask = (uint32_t)(table_size - 1);
-		std::tie(cbg_filter, cbg_table) = table.generate_fast_data();
+				pos += data & 0b1 ? -1 : 1;
+				hash = filter[pos];
+				if (((hash ^ up_0) & 0xFFF8) == 0 && table[pos] != NO_ELEM)
+				{
+					candidates[num_candidates++] = i;
+					candidates[num_candidates++] = table[pos];
+				}
+			}
+		}
 	}
+
+	return num_candidates;
+}
+
+// Filter a batch of keys against the table, prefetching buckets ahead of use.
+// 'up0' select the primary bucket and 'up1' the unlucky one (same order as
+// value_map_index0/1). Return number of (key_index, table_elem) pairs written
+// to 'candidates' (need capacity for 8*num_keys uint32_t).
+PUBLIC extern "C" uint32_t cbg_filter_batch(const uint32_t* up0, const uint32_t* up1, uint32_t num_keys, uint32_t* candidates)
+{
+	// Small tables stay in cache: prefetch only costs instructions
+	if (cbg_mask < (256*1024 - 1))
+		return cbg_filter_batch_template<false, false>(up0, up1, num_keys, candidates);
+
+	// Prefetch unlucky buckets only when they are common
+	if (cbg_count_unlucky > (cbg_mask >> 4))
+		return cbg_filter_batch_template<true, true>(up0, up1, num_keys, candidates);
+
+	return cbg_filter_batch_template<true, false>(up0, up1, num_keys, candidates);
 }
 
 #include <random>
@@ -598,6 +938,520 @@ PUBLIC extern "C" void generate_random(uint8_t* values, size_t size)
 	}
 }
 
+#ifdef HS_TESTING
+#include <thread>
+#include <atomic>
+// Stress test: remove 90% of 10^6 hashes while other threads keep looking them up.
+// Return TRUE if no lookup missed a hash still in the table or found a removed one.
+#define TEST_CBG_NUM_HASHES		1000000
+#define TEST_CBG_NUM_THREADS	4
+#define TEST_CBG_BATCH			256
+PUBLIC extern "C" int test_remove_from_cbg_table()
+{
+	// Save the attack state
+	void* old_binary_values = binary_values;
+	uint32_t* old_is_foundBit = is_foundBit;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint16_t* old_cbg_filter = cbg_filter;
+	uint32_t* old_cbg_table = cbg_table;
+	uint32_t old_cbg_mask = cbg_mask;
+	uint32_t old_cbg_count_moved = cbg_count_moved;
+	uint32_t old_cbg_count_unlucky = cbg_count_unlucky;
+	uint32_t old_cbg_num_removed = cbg_num_removed;
+
+	const uint32_t bin_size = formats[NTLM_INDEX].binary_size / 4;
+	const uint32_t map0 = formats[NTLM_INDEX].value_map_index0;
+	const uint32_t map1 = formats[NTLM_INDEX].value_map_index1;
+
+	num_passwords_loaded = TEST_CBG_NUM_HASHES;
+	binary_values = malloc(sizeof(uint32_t) * bin_size * TEST_CBG_NUM_HASHES);
+	is_foundBit = (uint32_t*)calloc(TEST_CBG_NUM_HASHES / 32 + 1, sizeof(uint32_t));
+	std::atomic<uint8_t>* removed = new std::atomic<uint8_t>[TEST_CBG_NUM_HASHES];
+	for (uint32_t i = 0; i < TEST_CBG_NUM_HASHES; i++)
+		removed[i] = 0;
+	generate_random((uint8_t*)binary_values, sizeof(uint32_t) * bin_size * TEST_CBG_NUM_HASHES);
+	std::atomic<uint32_t> num_errors(build_cbg_table(NTLM_INDEX, map0, map1) == CBG_TABLE_FAILED ? 1 : 0);
+	if (num_errors)
+	{
+		delete[] removed;
+		free(binary_values);
+		free(is_foundBit);
+		binary_values = old_binary_values;
+		is_foundBit = old_is_foundBit;
+		num_passwords_loaded = old_num_passwords_loaded;
+		return FALSE;
+	}
+
+	const uint32_t* bin = (const uint32_t*)binary_values;
+	std::atomic<int> stop(FALSE);
+
+	// Look up a batch: was_found[i] when hash indexes[i] is in the table
+	auto lookup = [&](const uint32_t* indexes, uint32_t num, uint8_t* was_found)
+	{
+		uint32_t up0[TEST_CBG_BATCH], up1[TEST_CBG_BATCH], candidates[8 * TEST_CBG_BATCH];
+		for (uint32_t i = 0; i < num; i++)
+		{
+			up0[i] = bin[indexes[i] * bin_size + map0];
+			up1[i] = bin[indexes[i] * bin_size + map1];
+			was_found[i] = FALSE;
+		}
+
+		uint32_t num_candidates = cbg_filter_batch(up0, up1, num, candidates);
+		for (uint32_t i = 0; i < num_candidates; i += 2)
+		{
+			if (candidates[i + 1] >= TEST_CBG_NUM_HASHES)
+				num_errors++;
+			else if (candidates[i + 1] == indexes[candidates[i]])
+				was_found[candidates[i]] = TRUE;
+		}
+	};
+
+	std::thread readers[TEST_CBG_NUM_THREADS];
+	for (int t = 0; t < TEST_CBG_NUM_THREADS; t++)
+		readers[t] = std::thread([&, t]()
+		{
+			std::mt19937 r(t + 1);
+			uint32_t indexes[TEST_CBG_BATCH];
+			uint8_t was_found[TEST_CBG_BATCH];
+
+			while (!stop)
+			{
+				for (uint32_t i = 0; i < TEST_CBG_BATCH; i++)
+					indexes[i] = r() % TEST_CBG_NUM_HASHES;
+
+				lookup(indexes, TEST_CBG_BATCH, was_found);
+				std::atomic_thread_fence(std::memory_order_seq_cst);
+
+				// Not removed after the lookup: must be found
+				for (uint32_t i = 0; i < TEST_CBG_BATCH; i++)
+					if (!was_found[i] && !removed[indexes[i]])
+						num_errors++;
+			}
+		});
+
+	// Remove 90% in random order
+	uint32_t* order = (uint32_t*)malloc(sizeof(uint32_t) * TEST_CBG_NUM_HASHES);
+	for (uint32_t i = 0; i < TEST_CBG_NUM_HASHES; i++)
+		order[i] = i;
+	std::shuffle(order, order + TEST_CBG_NUM_HASHES, std::mt19937(0));
+
+	for (uint32_t i = 0; i < TEST_CBG_NUM_HASHES / 10 * 9; i++)
+	{
+		uint32_t index = order[i];
+		removed[index] = 1;
+		is_foundBit[index >> 5] |= 1 << (index & 31);
+		remove_from_cbg_table(NTLM_INDEX, index);
+	}
+
+	stop = TRUE;
+	for (int t = 0; t < TEST_CBG_NUM_THREADS; t++)
+		readers[t].join();
+
+	// Final state: all remaining found, none removed found
+	uint8_t was_found[TEST_CBG_BATCH];
+	for (uint32_t i = 0; i < TEST_CBG_NUM_HASHES; i += TEST_CBG_BATCH)
+	{
+		uint32_t num = std::min<uint32_t>(TEST_CBG_BATCH, TEST_CBG_NUM_HASHES - i);
+		lookup(order + i, num, was_found);
+		for (uint32_t j = 0; j < num; j++)
+			if (was_found[j] != (removed[order[i + j]] ? FALSE : TRUE))
+				num_errors++;
+	}
+
+	free(order);
+	delete[] removed;
+	free(binary_values);
+	free(is_foundBit);
+	large_page_free(cbg_filter);
+	large_page_free(cbg_table);
+
+	// Restore the attack state
+	binary_values = old_binary_values;
+	is_foundBit = old_is_foundBit;
+	num_passwords_loaded = old_num_passwords_loaded;
+	cbg_filter = old_cbg_filter;
+	cbg_table = old_cbg_table;
+	cbg_mask = old_cbg_mask;
+	cbg_count_moved = old_cbg_count_moved;
+	cbg_count_unlucky = old_cbg_count_unlucky;
+	cbg_num_removed = old_cbg_num_removed;
+
+	return num_errors == 0;
+}
+
+// Filter stage alone on random NTLM hashes: the per-key loop used below CBG_FILTER_BATCH_MIN_HASHES
+// against cbg_filter_batch(). Log ns/key for each number of hashes.
+// Return FALSE if both don't find the same matches.
+#include <chrono>
+#define BENCH_CBG_NUM_BATCHES	1024
+#define BENCH_CBG_MIN_TIME		std::chrono::milliseconds(50)// Each variant
+PRIVATE uint32_t bench_cbg_per_key(const uint32_t* up0, const uint32_t* up1, uint32_t num_keys)
+{
+	uint32_t num_found = 0;
+
+	for (uint32_t i = 0; i < num_keys; i++)
+	{
+		uint32_t pos = up0[i] & cbg_mask;
+		uint_fast16_t data = cbg_filter[pos];
+		if (((data ^ up1[i]) & 0xFFF8) == 0 && cbg_table[pos] != NO_ELEM)
+			num_found++;
+
+		// 2nd pos
+		if (data & 0b110)
+		{
+			pos += data & 0b1 ? -1 : 1;
+			uint_fast16_t hash = cbg_filter[pos];
+			if (((hash ^ up1[i]) & 0xFFF8) == 0 && cbg_table[pos] != NO_ELEM)
+				num_found++;
+
+			// Unluky bucket
+			if (data & 0b10)
+			{
+				pos = up1[i] & cbg_mask;
+				data = cbg_filter[pos];
+				if (((data ^ up0[i]) & 0xFFF8) == 0 && cbg_table[pos] != NO_ELEM)
+					num_found++;
+
+				// 2nd pos
+				pos += data & 0b1 ? -1 : 1;
+				hash = cbg_filter[pos];
+				if (((hash ^ up0[i]) & 0xFFF8) == 0 && cbg_table[pos] != NO_ELEM)
+					num_found++;
+			}
+		}
+	}
+
+	return num_found;
+}
+PUBLIC extern "C" int bench_cbg_filter_batch()
+{
+	// Save the attack state
+	void* old_binary_values = binary_values;
+	uint32_t* old_is_foundBit = is_foundBit;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint16_t* old_cbg_filter = cbg_filter;
+	uint32_t* old_cbg_table = cbg_table;
+	uint32_t old_cbg_mask = cbg_mask;
+	uint32_t old_cbg_count_moved = cbg_count_moved;
+	uint32_t old_cbg_count_unlucky = cbg_count_unlucky;
+	uint32_t old_cbg_num_removed = cbg_num_removed;
+
+	const uint32_t bin_size = formats[NTLM_INDEX].binary_size / 4;
+	const uint32_t map0 = formats[NTLM_INDEX].value_map_index0;
+	const uint32_t map1 = formats[NTLM_INDEX].value_map_index1;
+	const uint32_t num_keys = BENCH_CBG_NUM_BATCHES * TEST_CBG_BATCH;
+	int result = TRUE;
+
+	uint32_t* up0 = (uint32_t*)malloc(sizeof(uint32_t) * num_keys);
+	uint32_t* up1 = (uint32_t*)malloc(sizeof(uint32_t) * num_keys);
+	uint32_t* candidates = (uint32_t*)malloc(8 * sizeof(uint32_t) * TEST_CBG_BATCH);
+	std::mt19937 r(0);
+
+	for (uint32_t num_hashes = 1; result && up0 && up1 && candidates && num_hashes <= 1000000; num_hashes *= 10)
+	{
+		num_passwords_loaded = num_hashes;
+		binary_values = malloc(sizeof(uint32_t) * bin_size * num_hashes);
+		is_foundBit = (uint32_t*)calloc(num_hashes / 32 + 1, sizeof(uint32_t));
+		if (!binary_values || !is_foundBit)
+		{
+			free(binary_values);
+			free(is_foundBit);
+			break;
+		}
+		generate_random((uint8_t*)binary_values, sizeof(uint32_t) * bin_size * num_hashes);
+		if (build_cbg_table(NTLM_INDEX, map0, map1) == CBG_TABLE_FAILED)
+		{
+			free(binary_values);
+			free(is_foundBit);
+			result = FALSE;
+			break;
+		}
+
+		// Random keys, 1 in 16 is a loaded hash
+		const uint32_t* bin = (const uint32_t*)binary_values;
+		for (uint32_t i = 0; i < num_keys; i++)
+		{
+			uint32_t index = r() % num_hashes;
+			int is_hash = (r() & 15) == 0;
+			up0[i] = is_hash ? bin[index * bin_size + map0] : r();
+			up1[i] = is_hash ? bin[index * bin_size + map1] : r();
+		}
+
+		uint64_t per_key_found = 0, batch_found = 0, per_key_keys = 0, batch_keys = 0;
+		auto start = std::chrono::steady_clock::now();
+		do
+		{
+			for (uint32_t i = 0; i < num_keys; i += TEST_CBG_BATCH)
+				per_key_found += bench_cbg_per_key(up0 + i, up1 + i, TEST_CBG_BATCH);
+			per_key_keys += num_keys;
+		}
+		while (std::chrono::steady_clock::now() - start < BENCH_CBG_MIN_TIME);
+		double per_key_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / per_key_keys;
+
+		start = std::chrono::steady_clock::now();
+		do
+		{
+			for (uint32_t i = 0; i < num_keys; i += TEST_CBG_BATCH)
+				batch_found += cbg_filter_batch(up0 + i, up1 + i, TEST_CBG_BATCH, candidates) / 2;
+			batch_keys += num_keys;
+		}
+		while (std::chrono::steady_clock::now() - start < BENCH_CBG_MIN_TIME);
+		double batch_ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / batch_keys;
+
+		// Same matches by pass over the keys
+		if (per_key_found / (per_key_keys / num_keys) != batch_found / (batch_keys / num_keys))
+			result = FALSE;
+		hs_log(HS_LOG_INFO, "Test Suite", "CBG filter %u hashes: per-key %.2f ns/key, batch %.2f ns/key", num_hashes, per_key_ns, batch_ns);
+
+		free(binary_values);
+		free(is_foundBit);
+		large_page_free(cbg_filter);
+		large_page_free(cbg_table);
+	}
+
+	free(up0);
+	free(up1);
+	free(candidates);
+
+	// Restore the attack state
+	binary_values = old_binary_values;
+	is_foundBit = old_is_foundBit;
+	num_passwords_loaded = old_num_passwords_loaded;
+	cbg_filter = old_cbg_filter;
+	cbg_table = old_cbg_table;
+	cbg_mask = old_cbg_mask;
+	cbg_count_moved = old_cbg_count_moved;
+	cbg_count_unlucky = old_cbg_count_unlucky;
+	cbg_num_removed = old_cbg_num_removed;
+
+	if (!result)
+		hs_log(HS_LOG_ERROR, "Test Suite", "cbg_filter_batch finds other matches than the per-key loop");
+	return result;
+}
+
+// Build time and peak memory of the table for random NTLM hashes, sized as
+// usual and also starting at 1/64 of the size so it has to grow.
+// Sizes go up, so the process peak is the one of the last build.
+// Return FALSE if a build fails or a hash is not found after it.
+#define BENCH_CBG_GROW_MAX_HASHES	10000000
+PRIVATE int bench_cbg_all_found(uint32_t bin_size, uint32_t map0, uint32_t map1)
+{
+	const uint32_t* bin = (const uint32_t*)binary_values;
+	uint32_t up0[TEST_CBG_BATCH], up1[TEST_CBG_BATCH], candidates[8 * TEST_CBG_BATCH];
+	uint32_t num_found = 0;
+
+	for (uint32_t i = 0; i < num_passwords_loaded; i += TEST_CBG_BATCH)
+	{
+		uint8_t was_found[TEST_CBG_BATCH] = { 0 };
+		uint32_t num = std::min<uint32_t>(TEST_CBG_BATCH, num_passwords_loaded - i);
+		for (uint32_t j = 0; j < num; j++)
+		{
+			up0[j] = bin[(i + j) * bin_size + map0];
+			up1[j] = bin[(i + j) * bin_size + map1];
+		}
+
+		// The same slot may be a candidate twice when both buckets overlap
+		uint32_t num_candidates = cbg_filter_batch(up0, up1, num, candidates);
+		for (uint32_t j = 0; j < num_candidates; j += 2)
+			if (candidates[j + 1] == i + candidates[j] && !was_found[candidates[j]])
+			{
+				was_found[candidates[j]] = TRUE;
+				num_found++;
+			}
+	}
+
+	large_page_free(cbg_filter);
+	large_page_free(cbg_table);
+	return num_found == num_passwords_loaded;
+}
+PUBLIC extern "C" int bench_build_cbg_table()
+{
+	// Save the attack state
+	void* old_binary_values = binary_values;
+	uint32_t* old_is_foundBit = is_foundBit;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint16_t* old_cbg_filter = cbg_filter;
+	uint32_t* old_cbg_table = cbg_table;
+	uint32_t old_cbg_mask = cbg_mask;
+	uint32_t old_cbg_count_moved = cbg_count_moved;
+	uint32_t old_cbg_count_unlucky = cbg_count_unlucky;
+	uint32_t old_cbg_num_removed = cbg_num_removed;
+
+	const uint32_t bin_size = formats[NTLM_INDEX].binary_size / 4;
+	const uint32_t map0 = formats[NTLM_INDEX].value_map_index0;
+	const uint32_t map1 = formats[NTLM_INDEX].value_map_index1;
+	const uint32_t sizes[] = { 100000, 1000000, 10000000, 50000000 };
+	int result = TRUE;
+
+	is_foundBit = NULL;
+	for (uint32_t s = 0; result && s < LENGTH(sizes); s++)
+	{
+		uint32_t num_hashes = sizes[s];
+		// Binaries, up to 4 buckets of 6 bytes by hash and the copy when growing
+		if (num_hashes * (sizeof(uint32_t) * bin_size + 48ull) > get_available_memory())
+		{
+			hs_log(HS_LOG_INFO, "Test Suite", "CBG build %u hashes: skipped, not enough memory", num_hashes);
+			break;
+		}
+
+		num_passwords_loaded = num_hashes;
+		binary_values = malloc(sizeof(uint32_t) * bin_size * num_hashes);
+		if (!binary_values)
+			break;
+		generate_random((uint8_t*)binary_values, sizeof(uint32_t) * bin_size * num_hashes);
+
+		auto start = std::chrono::steady_clock::now();
+		uint32_t num_reinserts = build_cbg_table(NTLM_INDEX, map0, map1);
+		double build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+		uint32_t table_mb = (uint32_t)(((cbg_mask + 1ull) * (sizeof(uint16_t) + sizeof(uint32_t))) >> 20);
+
+		result = num_reinserts != CBG_TABLE_FAILED && bench_cbg_all_found(bin_size, map0, map1);
+		hs_log(HS_LOG_INFO, "Test Suite", "CBG build %u hashes: %.0f ms, %u re-inserts, table %u MB, peak RSS %u MB", num_hashes,
+			build_ms, num_reinserts, table_mb, (uint32_t)(get_process_peak_memory_used() >> 20));
+
+		if (result && num_hashes <= BENCH_CBG_GROW_MAX_HASHES)
+		{
+			start = std::chrono::steady_clock::now();
+			num_reinserts = fill_cbg_table(NTLM_INDEX, map0, map1, __max(2048, ceil_power_2(num_hashes) / 64));
+			build_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+			result = num_reinserts != CBG_TABLE_FAILED && bench_cbg_all_found(bin_size, map0, map1);
+			hs_log(HS_LOG_INFO, "Test Suite", "CBG build %u hashes from 1/64: %.0f ms, %u re-inserts, peak RSS %u MB", num_hashes,
+				build_ms, num_reinserts, (uint32_t)(get_process_peak_memory_used() >> 20));
+		}
+
+		free(binary_values);
+	}
+
+	// Restore the attack state
+	binary_values = old_binary_values;
+	is_foundBit = old_is_foundBit;
+	num_passwords_loaded = old_num_passwords_loaded;
+	cbg_filter = old_cbg_filter;
+	cbg_table = old_cbg_table;
+	cbg_mask = old_cbg_mask;
+	cbg_count_moved = old_cbg_count_moved;
+	cbg_count_unlucky = old_cbg_count_unlucky;
+	cbg_num_removed = old_cbg_num_removed;
+
+	if (!result)
+		hs_log(HS_LOG_ERROR, "Test Suite", "Cuckoo table build fails or misses hashes");
+	return result;
+}
+
+// Lookups in a table of 10^7 random NTLM hashes with normal pages and with
+// the large pages the system gives. Log M lookups/s for each one.
+// Return FALSE if a build fails or both don't find the same matches.
+#define BENCH_LARGE_PAGE_NUM_HASHES	10000000
+#define BENCH_LARGE_PAGE_MIN_TIME	std::chrono::milliseconds(500)// Each variant
+PUBLIC extern "C" int bench_large_page_lookup()
+{
+	// Save the attack state
+	void* old_binary_values = binary_values;
+	uint32_t* old_is_foundBit = is_foundBit;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint16_t* old_cbg_filter = cbg_filter;
+	uint32_t* old_cbg_table = cbg_table;
+	uint32_t old_cbg_mask = cbg_mask;
+	uint32_t old_cbg_count_moved = cbg_count_moved;
+	uint32_t old_cbg_count_unlucky = cbg_count_unlucky;
+	uint32_t old_cbg_num_removed = cbg_num_removed;
+	int old_is_large_page_enable = current_system_info.is_large_page_enable;
+
+	const uint32_t bin_size = formats[NTLM_INDEX].binary_size / 4;
+	const uint32_t map0 = formats[NTLM_INDEX].value_map_index0;
+	const uint32_t map1 = formats[NTLM_INDEX].value_map_index1;
+	const uint32_t num_keys = BENCH_CBG_NUM_BATCHES * TEST_CBG_BATCH;
+	int result = TRUE;
+
+	if (!old_is_large_page_enable)
+		hs_log(HS_LOG_INFO, "Test Suite", "Large pages not available: both lookups use normal pages");
+	// Binaries and up to 4 buckets of 6 bytes by hash
+	if (BENCH_LARGE_PAGE_NUM_HASHES * (sizeof(uint32_t) * bin_size + 24ull) > get_available_memory())
+	{
+		hs_log(HS_LOG_INFO, "Test Suite", "Large page lookup: skipped, not enough memory");
+		return TRUE;
+	}
+
+	num_passwords_loaded = BENCH_LARGE_PAGE_NUM_HASHES;
+	is_foundBit = NULL;
+	binary_values = malloc(sizeof(uint32_t) * bin_size * BENCH_LARGE_PAGE_NUM_HASHES);
+	uint32_t* up0 = (uint32_t*)malloc(sizeof(uint32_t) * num_keys);
+	uint32_t* up1 = (uint32_t*)malloc(sizeof(uint32_t) * num_keys);
+	uint32_t* candidates = (uint32_t*)malloc(8 * sizeof(uint32_t) * TEST_CBG_BATCH);
+	uint64_t num_found[2] = { 0, 0 };
+
+	if (binary_values && up0 && up1 && candidates)
+	{
+		generate_random((uint8_t*)binary_values, sizeof(uint32_t) * bin_size * BENCH_LARGE_PAGE_NUM_HASHES);
+
+		// Random keys, 1 in 16 is a loaded hash
+		const uint32_t* bin = (const uint32_t*)binary_values;
+		std::mt19937 r(0);
+		for (uint32_t i = 0; i < num_keys; i++)
+		{
+			uint32_t index = r() % BENCH_LARGE_PAGE_NUM_HASHES;
+			int is_hash = (r() & 15) == 0;
+			up0[i] = is_hash ? bin[index * bin_size + map0] : r();
+			up1[i] = is_hash ? bin[index * bin_size + map1] : r();
+		}
+
+		// 0: normal pages, 1: large pages
+		for (int use_large_page = 0; result && use_large_page < 2; use_large_page++)
+		{
+			current_system_info.is_large_page_enable = use_large_page ? old_is_large_page_enable : 0;
+			if (build_cbg_table(NTLM_INDEX, map0, map1) == CBG_TABLE_FAILED)
+			{
+				result = FALSE;
+				break;
+			}
+
+			uint64_t num_lookups = 0;
+			auto start = std::chrono::steady_clock::now();
+			do
+			{
+				for (uint32_t i = 0; i < num_keys; i += TEST_CBG_BATCH)
+					num_found[use_large_page] += cbg_filter_batch(up0 + i, up1 + i, TEST_CBG_BATCH, candidates) / 2;
+				num_lookups += num_keys;
+			}
+			while (std::chrono::steady_clock::now() - start < BENCH_LARGE_PAGE_MIN_TIME);
+			double lookups_s = num_lookups / std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+			// Same matches by pass over the keys
+			num_found[use_large_page] /= num_lookups / num_keys;
+
+			hs_log(HS_LOG_INFO, "Test Suite", "CBG lookup %u hashes, %s pages: %.1f M lookups/s", BENCH_LARGE_PAGE_NUM_HASHES,
+				use_large_page ? "large" : "normal", lookups_s / 1000000);
+
+			large_page_free(cbg_filter);
+			large_page_free(cbg_table);
+		}
+		if (result && num_found[0] != num_found[1])
+			result = FALSE;
+	}
+
+	free(binary_values);
+	free(up0);
+	free(up1);
+	free(candidates);
+
+	// Restore the attack state
+	current_system_info.is_large_page_enable = old_is_large_page_enable;
+	binary_values = old_binary_values;
+	is_foundBit = old_is_foundBit;
+	num_passwords_loaded = old_num_passwords_loaded;
+	cbg_filter = old_cbg_filter;
+	cbg_table = old_cbg_table;
+	cbg_mask = old_cbg_mask;
+	cbg_count_moved = old_cbg_count_moved;
+	cbg_count_unlucky = old_cbg_count_unlucky;
+	cbg_num_removed = old_cbg_num_removed;
+
+	if (!result)
+		hs_log(HS_LOG_ERROR, "Test Suite", "Cuckoo table lookups fail with large pages");
+	return result;
+}
+#endif
+
 // Support for a set of strings in C
 #include <unordered_set>
 #include "xxhash.h"
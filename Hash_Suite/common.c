@@ -34,11 +34,16 @@ extern Format raw_sha256_format;
 extern Format raw_sha512_format;
 
 extern Format dcc_format;
+#ifdef HS_X86
+void dcc_salts_major_init();
+#endif
 extern Format dcc2_format;
 extern Format wpa_format;
 
 extern Format bcrypt_format;
 extern Format ssha_format;
+int ssha_upgrade_db_salts();
+#define ID_SSHA_SALTS_UPGRADED 69997
 extern Format md5crypt_format;
 
 extern Format sha256crypt_format;
@@ -123,15 +128,19 @@ PUBLIC long long _filelengthi64(int file)
     return 0;//-1
 }
 
+// On x86 x86intrin.h defines it as a macro
+#ifndef _rotl
 PUBLIC inline __attribute__((always_inline)) uint32_t _rotl(uint32_t v, uint32_t sh)
 {
   return ((v<<sh) | (v>>(32-sh)));
 }
-
+#endif
+#ifndef _rotl64
 PUBLIC inline __attribute__((always_inline)) uint64_t _rotl64(uint64_t v, uint32_t sh)
 {
   return ((v<<sh) | (v>>(64-sh)));
 }
+#endif
 PUBLIC void _BitScanReverse(uint32_t* index, uint32_t v)
 {
 	uint32_t r = 0; // r will be lg(v)
@@ -621,6 +630,9 @@ PRIVATE void formats_init(int db_already_initialize)
 	formats[SHA512_INDEX] = raw_sha512_format;
 
 	formats[DCC_INDEX] = dcc_format;
+#ifdef HS_X86
+	dcc_salts_major_init();
+#endif
 	formats[DCC2_INDEX] = dcc2_format;
 	formats[WPA_INDEX] = wpa_format;
 
@@ -688,13 +700,13 @@ PUBLIC void init_all(const char* program_exe_path)
 	char* db_path = NULL;
 	FILE* db_file = NULL;
 	int db_already_exits = FALSE;
-	detect_hardware();
 
-	// Windows high-resolution clock support
+	// Windows high-resolution clock support. Needed before detect_hardware
 #ifdef _WIN32
 	QueryPerformanceFrequency(&clock_freq);
 	clock_freq.QuadPart = (clock_freq.QuadPart + 500) / 1000;
 #endif
+	detect_hardware();
 
 	// Save path of program
 	if (program_exe_path)
@@ -733,6 +745,9 @@ PUBLIC void init_all(const char* program_exe_path)
 	load_settings_from_db();
 	load_cache();
 	init_attack_data();
+	// Only once: hashes imported before the SSHA 16 bytes salts fix
+	if (!get_setting(ID_SSHA_SALTS_UPGRADED, FALSE) && ssha_upgrade_db_salts())
+		save_setting(ID_SSHA_SALTS_UPGRADED, TRUE);
 
 	END_TRANSACTION;
 
@@ -1063,6 +1078,7 @@ PUBLIC void clear_db_accounts()
 
 	save_num_hashes_cache();
 	resize_fam();
+	delete_hashes_snapshots();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -27,8 +27,12 @@
 	unsigned char* _strupr(unsigned char *string);
 	unsigned char* _strlwr(unsigned char *string);
 	long long _filelengthi64(int file);
+#ifndef _rotl
 	uint32_t _rotl(uint32_t v, uint32_t sh);
+#endif
+#ifndef _rotl64
 	uint64_t _rotl64(uint64_t, uint32_t sh);
+#endif
 	void _BitScanReverse(uint32_t* index, uint32_t v);
 	void _BitScanForward(uint32_t* index, uint32_t v);
 #endif
@@ -97,6 +101,25 @@ void add_num_keys_from_save_to_start();
 void set_num_keys_zero();
 void set_num_keys_save_add_start(int64_t from_save_val, int64_t to_add_start);
 
+// Wordlist keys reserved by a thread. Stored in 'thread_params' after the positions saved by thread
+// Four batches of the biggest CPU formats: ~33KB by thread
+#define WORDLIST_CHUNK_KEYS		1024
+typedef struct WordlistChunk
+{
+	uint32_t num_keys;
+	uint32_t current;
+	unsigned char lenghts[WORDLIST_CHUNK_KEYS];
+	unsigned char keys[WORDLIST_CHUNK_KEYS][MAX_KEY_LENGHT_BIG];
+}
+WordlistChunk;
+// Block of lines owned by a thread in the STDIN key-provider. Stored in 'thread_params' after the lines saved by thread
+typedef struct StdinChunk
+{
+	int64_t ticket;
+	int has_block;
+}
+StdinChunk;
+
 // DB related----------------------------------------------------------------------
 void register_key_providers(int db_already_initialize);
 
@@ -121,4 +144,18 @@ int crypto_scalarmult_curve25519_base(unsigned char *public_key, const unsigned
 
 void salsa20_crypt_block(unsigned char* message, const uint32_t* nonce, const uint32_t* key, uint32_t counter);
 
+///////////////////////////////////////////////////////////////////////////////////////////
+// Hardware probes. Run by calibrate_hardware
+///////////////////////////////////////////////////////////////////////////////////////////
+#ifdef HS_X86
+void calibrate_hardware();
+// CPUID flag. CPU_CAP_SHA and CPU_CAP_SHA256 are only set if SHA-NI is also faster
+extern int has_sha_ni;
+int is_sha_ni_faster();
+int is_sha256_ni_faster();
+#ifdef _M_X64
+int is_avx2_gather_faster();
+#endif
+#endif
+
 #endif
@@ -4,7 +4,7 @@
 #ifndef __7Z_FILE_H
 #define __7Z_FILE_H
 
-#include "..\..\system.h"
+#include "../../system.h"
 
 #ifdef HS_X86
 #ifdef _WIN32
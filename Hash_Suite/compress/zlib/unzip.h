@@ -56,7 +56,7 @@ extern "C" {
 #endif
 
 #ifdef HAVE_BZIP2
-#include "..\libbz2\bzlib.h"
+#include "../libbz2/bzlib.h"
 #endif
 
 #define Z_BZIP2ED 12
@@ -869,11 +869,7 @@ PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 	L2 = ts2 ^ subkeys[53];
 
 // More expensive funtion: the one to optimize
-#ifdef _M_X64
-	void blowfish_body_asm_x64(uint32_t* subkeys, uint32_t* Sboxs);
-	#define blowfish_body blowfish_body_asm_x64
-#else
-	#define blowfish_body blowfish_body_c_code
+#define blowfish_body blowfish_body_c_code
 PRIVATE void blowfish_body_c_code(uint32_t* subkeys, uint32_t* sboxs)
 {
 	uint32_t L0 = 0, R0 = 0, L1 = 0, R1 = 0, L2 = 0, R2 = 0;
@@ -901,7 +897,6 @@ PRIVATE void blowfish_body_c_code(uint32_t* subkeys, uint32_t* sboxs)
 		sboxs[i+1+2048] = R2;
 	}
 }
-#endif
 
 PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 {
@@ -1023,239 +1018,355 @@ PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 }
 #endif
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// BMI
+// Interleaved C code
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #ifdef _M_X64
+// Each S-box lookup depends on the previous round, so one instance leaves the core waiting on load latency.
+// More independent instances than BF_IN_PARALLEL keep the load ports busy, even with some spills.
+#define BF_INTERLEAVED		8
+#define BF_FOR_EACH_INSTANCE(code) code(0) code(1) code(2) code(3) code(4) code(5) code(6) code(7)
+
+// Offsets on the pointer, not the index: the compiler folds them into the addressing
+#define BF_F(sbox, x)		((((sbox)[BYTE_3(x)] + ((sbox)+256)[BYTE_2(x)]) ^ ((sbox)+512)[BYTE_1(x)]) + ((sbox)+768)[BYTE_0(x)])
+
+#define BF_DECLARE(k)		uint32_t L##k = 0, R##k = 0;
+#define BF_XOR_P0(k)		L##k ^= subkeys[k];
+#define BF_ROUND_R(k)		R##k ^= p[k] ^ BF_F(sboxs + (k)*1024, L##k);
+#define BF_ROUND_L(k)		L##k ^= p[k+BF_INTERLEAVED] ^ BF_F(sboxs + (k)*1024, R##k);
+#define BF_SWAP(k)			ts = R##k; R##k = L##k; L##k = ts ^ subkeys[17*BF_INTERLEAVED+k];
+#define BF_XOR_SALT(k)		L##k ^= salt_L; R##k ^= salt_R;
+#define BF_LOAD_MAGIC(k)	L##k = BF_magic_w[i]; R##k = BF_magic_w[i+1];
+#define BF_STORE_SUBKEYS(k)	subkeys[i*BF_INTERLEAVED+k] = L##k; subkeys[(i+1)*BF_INTERLEAVED+k] = R##k;
+#define BF_STORE_SBOXS(k)	sboxs[i+(k)*1024] = L##k; sboxs[i+1+(k)*1024] = R##k;
+#define BF_STORE_RESULT(k)	crypt_result[i+(k)*6] = L##k; crypt_result[i+1+(k)*6] = R##k;
 
-#undef BF_IN_PARALLEL
-#undef NT_NUM_KEYS
-#undef BF_ENCRYPT
-
-#define BF_IN_PARALLEL	4
-#define NT_NUM_KEYS		BF_IN_PARALLEL
 // Encrypt one block
-#define BF_ENCRYPT \
-	L0 ^= subkeys[0 ]; \
-	L1 ^= subkeys[1 ]; \
-	L2 ^= subkeys[2 ]; \
-	L3 ^= subkeys[3 ]; \
-	R0 ^= subkeys[4 ] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[5 ] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[6 ] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[7 ] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[8 ] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[9 ] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[10] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[11] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[12] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[13] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[14] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[15] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[16] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[17] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[18] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[19] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[20] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[21] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[22] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[23] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[24] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[25] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[26] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[27] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[28] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[29] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[30] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[31] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[32] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[33] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[34] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[35] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[36] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[37] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[38] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[39] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[40] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[41] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[42] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[43] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[44] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[45] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[46] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[47] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[48] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[49] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[50] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[51] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[52] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[53] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[54] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[55] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[56] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[57] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[58] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[59] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	R0 ^= subkeys[60] ^ (((sboxs[BYTE_3(L0)+0   ] + sboxs[BYTE_2(L0)+256+0   ]) ^ sboxs[BYTE_1(L0)+512+0   ]) + sboxs[BYTE_0(L0)+768+0   ]);\
-	R1 ^= subkeys[61] ^ (((sboxs[BYTE_3(L1)+1024] + sboxs[BYTE_2(L1)+256+1024]) ^ sboxs[BYTE_1(L1)+512+1024]) + sboxs[BYTE_0(L1)+768+1024]);\
-	R2 ^= subkeys[62] ^ (((sboxs[BYTE_3(L2)+2048] + sboxs[BYTE_2(L2)+256+2048]) ^ sboxs[BYTE_1(L2)+512+2048]) + sboxs[BYTE_0(L2)+768+2048]);\
-	R3 ^= subkeys[63] ^ (((sboxs[BYTE_3(L3)+3072] + sboxs[BYTE_2(L3)+256+3072]) ^ sboxs[BYTE_1(L3)+512+3072]) + sboxs[BYTE_0(L3)+768+3072]);\
-	L0 ^= subkeys[64] ^ (((sboxs[BYTE_3(R0)+0   ] + sboxs[BYTE_2(R0)+256+0   ]) ^ sboxs[BYTE_1(R0)+512+0   ]) + sboxs[BYTE_0(R0)+768+0   ]);\
-	L1 ^= subkeys[65] ^ (((sboxs[BYTE_3(R1)+1024] + sboxs[BYTE_2(R1)+256+1024]) ^ sboxs[BYTE_1(R1)+512+1024]) + sboxs[BYTE_0(R1)+768+1024]);\
-	L2 ^= subkeys[66] ^ (((sboxs[BYTE_3(R2)+2048] + sboxs[BYTE_2(R2)+256+2048]) ^ sboxs[BYTE_1(R2)+512+2048]) + sboxs[BYTE_0(R2)+768+2048]);\
-	L3 ^= subkeys[67] ^ (((sboxs[BYTE_3(R3)+3072] + sboxs[BYTE_2(R3)+256+3072]) ^ sboxs[BYTE_1(R3)+512+3072]) + sboxs[BYTE_0(R3)+768+3072]);\
-	ts0 = R0;\
-	ts1 = R1;\
-	ts2 = R2;\
-	ts3 = R3;\
-	R0 = L0;\
-	R1 = L1;\
-	R2 = L2;\
-	R3 = L3;\
-	L0 = ts0 ^ subkeys[68];\
-	L1 = ts1 ^ subkeys[69];\
-	L2 = ts2 ^ subkeys[70];\
-	L3 = ts3 ^ subkeys[71];
+#define BF_ENCRYPT_INTERLEAVED \
+	BF_FOR_EACH_INSTANCE(BF_XOR_P0)\
+	for (const uint32_t* p = subkeys + BF_INTERLEAVED; p < subkeys + 17*BF_INTERLEAVED; p += 2*BF_INTERLEAVED)\
+	{\
+		BF_FOR_EACH_INSTANCE(BF_ROUND_R)\
+		BF_FOR_EACH_INSTANCE(BF_ROUND_L)\
+	}\
+	BF_FOR_EACH_INSTANCE(BF_SWAP)
 
 // More expensive funtion: the one to optimize
-void blowfish_body_asm_bmi(uint32_t* Sboxs, uint32_t* subkeys);
-//PRIVATE void blowfish_body_asm_bmi(uint32_t* sboxs, uint32_t* subkeys)
-//{
-//	uint32_t L0 = 0, R0 = 0, L1 = 0, R1 = 0, L2 = 0, R2 = 0, L3 = 0, R3 = 0;
-//	uint32_t ts0, ts1, ts2, ts3;
-//	for (int i = 0; i < 18; i += 2)
-//	{
-//		BF_ENCRYPT;
-//
-//		subkeys[(i  )*BF_IN_PARALLEL  ] = L0;
-//		subkeys[(i+1)*BF_IN_PARALLEL  ] = R0;
-//		subkeys[(i  )*BF_IN_PARALLEL+1] = L1;
-//		subkeys[(i+1)*BF_IN_PARALLEL+1] = R1;
-//		subkeys[(i  )*BF_IN_PARALLEL+2] = L2;
-//		subkeys[(i+1)*BF_IN_PARALLEL+2] = R2;
-//		subkeys[(i  )*BF_IN_PARALLEL+3] = L3;
-//		subkeys[(i+1)*BF_IN_PARALLEL+3] = R3;
-//	}
-//	for (int i = 0; i < 256 * 4; i += 2)
-//	{
-//		BF_ENCRYPT;
-//
-//		sboxs[i       ] = L0;
-//		sboxs[i+1     ] = R0;
-//		sboxs[i  +1024] = L1;
-//		sboxs[i+1+1024] = R1;
-//		sboxs[i  +2048] = L2;
-//		sboxs[i+1+2048] = R2;
-//		sboxs[i  +3072] = L3;
-//		sboxs[i+1+3072] = R3;
-//	}
-//}
-
-PRIVATE void crypt_utf8_coalesc_protocol_bmi(CryptParam* param)
+PRIVATE void blowfish_body_interleaved(uint32_t* subkeys, uint32_t* sboxs)
+{
+	uint32_t ts;
+	BF_FOR_EACH_INSTANCE(BF_DECLARE)
+
+	for (int i = 0; i < 18; i += 2)
+	{
+		BF_ENCRYPT_INTERLEAVED;
+		BF_FOR_EACH_INSTANCE(BF_STORE_SUBKEYS)
+	}
+	for (int i = 0; i < 256 * 4; i += 2)
+	{
+		BF_ENCRYPT_INTERLEAVED;
+		BF_FOR_EACH_INSTANCE(BF_STORE_SBOXS)
+	}
+}
+
+// Buffer layout: keys (8 words per key) | sboxs | subkeys | expanded_key | crypt_result
+#define BF_INTERLEAVED_BUFFER_SIZE	((8 + 4 * 256 + 18 + 18 + 6) * sizeof(uint32_t) * BF_INTERLEAVED)
+
+// Hash the BF_INTERLEAVED keys in 'buffer' with one salt. Results are in crypt_result, 6 words per key.
+PRIVATE void bcrypt_interleaved(uint32_t* buffer, const BF_salt* salt)
+{
+	uint32_t* sboxs   = buffer + 8 * BF_INTERLEAVED;
+	uint32_t* subkeys = sboxs + 4 * 256 * BF_INTERLEAVED;
+	uint32_t* expanded_key = subkeys + 18 * BF_INTERLEAVED;
+	uint32_t* crypt_result = expanded_key + 18 * BF_INTERLEAVED;
+
+	uint32_t ts;
+	BF_FOR_EACH_INSTANCE(BF_DECLARE)
+
+	blowfish_set_key(buffer, subkeys, expanded_key, BF_INTERLEAVED, salt->sign_extension_bug, BF_INTERLEAVED);
+	for (int i = 0; i < BF_INTERLEAVED; i++)
+		memcpy(sboxs+i*sizeof(BF_init_state.S)/4, BF_init_state.S, sizeof(BF_init_state.S));
+
+	for (int i = 0; i < 18; i+=2)
+	{
+		uint32_t salt_L = salt->salt[(i & 2)];
+		uint32_t salt_R = salt->salt[(i & 2) + 1];
+		BF_FOR_EACH_INSTANCE(BF_XOR_SALT)
+		BF_ENCRYPT_INTERLEAVED;
+		BF_FOR_EACH_INSTANCE(BF_STORE_SUBKEYS)
+	}
+	for (int i = 0; i < 256*4; i+=2)
+	{
+		uint32_t salt_L = salt->salt[(i + 2) & 3];
+		uint32_t salt_R = salt->salt[(i + 3) & 3];
+		BF_FOR_EACH_INSTANCE(BF_XOR_SALT)
+		BF_ENCRYPT_INTERLEAVED;
+		BF_FOR_EACH_INSTANCE(BF_STORE_SBOXS)
+	}
+
+	// Expensive key schedule
+	for (uint32_t round = 0; round < salt->rounds; round++)
+	{
+		// Key part
+		for (int i = 0; i < 18*BF_INTERLEAVED; i++)
+			subkeys[i] ^= expanded_key[i];
+
+		blowfish_body_interleaved(subkeys, sboxs);
+
+		// Salt part
+		for (int i = 0; i < 18*BF_INTERLEAVED; i++)
+			subkeys[i] ^= salt->salt[(i/BF_INTERLEAVED)&3];
+
+		blowfish_body_interleaved(subkeys, sboxs);
+	}
+
+	// Final part: Encrypt
+	for (int i = 0; i < 6; i += 2)
+	{
+		BF_FOR_EACH_INSTANCE(BF_LOAD_MAGIC)
+
+		for (int j = 0; j < 64; j++)
+		{
+			BF_ENCRYPT_INTERLEAVED;
+		}
+
+		BF_FOR_EACH_INSTANCE(BF_STORE_RESULT)
+	}
+
+	/* This has to be bug-compatible with the original implementation, so only encode 23 of the 24 bytes. :-) */
+	for (int k = 0; k < BF_INTERLEAVED; k++)
+		crypt_result[5+k*6] &= 0xFFFFFF00;
+}
+
+PRIVATE void crypt_utf8_coalesc_protocol_interleaved(CryptParam* param)
 {
 	unsigned char key[MAX_KEY_LENGHT_SMALL];
-	uint32_t* buffer = (uint32_t*)malloc(8 * NT_NUM_KEYS* sizeof(uint32_t)+(4 * 256 + 18 + 18 + 6) * sizeof(uint32_t)*BF_IN_PARALLEL);
-	memset(buffer, 0, 8*NT_NUM_KEYS*sizeof(uint32_t));
+	uint32_t* buffer = (uint32_t*)malloc(BF_INTERLEAVED_BUFFER_SIZE);
+	memset(buffer, 0, 8 * BF_INTERLEAVED * sizeof(uint32_t));
 
-	uint32_t* sboxs   = buffer + 8 * NT_NUM_KEYS;
-	uint32_t* subkeys = sboxs + 4 * 256 * BF_IN_PARALLEL;
-	uint32_t* expanded_key = subkeys + 18* BF_IN_PARALLEL;
-	uint32_t* crypt_result = expanded_key + 18* BF_IN_PARALLEL;
+	uint32_t* crypt_result = buffer + (8 + 4 * 256 + 18 + 18) * BF_INTERLEAVED;
 
-	while(continue_attack && param->gen(buffer, NT_NUM_KEYS, param->thread_id))
+	while(continue_attack && param->gen(buffer, BF_INTERLEAVED, param->thread_id))
 	{
 		BF_salt* salt = (BF_salt*)salts_values;
 		// For all salts
 		for(uint32_t current_salt_index = 0; continue_attack && current_salt_index < num_diff_salts; current_salt_index++, salt++)
 		{
-			uint32_t L0, R0, ts0, L1, R1, ts1, L2, R2, ts2, L3, R3, ts3;
+			bcrypt_interleaved(buffer, salt);
 
-			blowfish_set_key(buffer, subkeys, expanded_key, NT_NUM_KEYS, salt->sign_extension_bug, NT_NUM_KEYS);
-			for (int i = 0; i < NT_NUM_KEYS; i++)
-				memcpy(sboxs+i*sizeof(BF_init_state.S)/4, BF_init_state.S, sizeof(BF_init_state.S));
-
-			L0 = R0 = L1 = R1 = L2 = R2 = L3 = R3 = 0;
-			for (int i = 0; i < 18; i+=2)
-			{
-				L0 ^= salt->salt[(i & 2)];
-				R0 ^= salt->salt[(i & 2) + 1];
-				L1 ^= salt->salt[(i & 2)];
-				R1 ^= salt->salt[(i & 2) + 1];
-				L2 ^= salt->salt[(i & 2)];
-				R2 ^= salt->salt[(i & 2) + 1];
-				L3 ^= salt->salt[(i & 2)];
-				R3 ^= salt->salt[(i & 2) + 1];
-				BF_ENCRYPT;
-				subkeys[(i  )*BF_IN_PARALLEL  ] = L0;
-				subkeys[(i+1)*BF_IN_PARALLEL  ] = R0;
-				subkeys[(i  )*BF_IN_PARALLEL+1] = L1;
-				subkeys[(i+1)*BF_IN_PARALLEL+1] = R1;
-				subkeys[(i  )*BF_IN_PARALLEL+2] = L2;
-				subkeys[(i+1)*BF_IN_PARALLEL+2] = R2;
-				subkeys[(i  )*BF_IN_PARALLEL+3] = L3;
-				subkeys[(i+1)*BF_IN_PARALLEL+3] = R3;
-			}
-			for (int i = 0; i < 256*4; i+=2)
+			for (int k = 0; k < BF_INTERLEAVED; k++)
 			{
-				L0 ^= salt->salt[(i + 2) & 3];
-				R0 ^= salt->salt[(i + 3) & 3];
-				L1 ^= salt->salt[(i + 2) & 3];
-				R1 ^= salt->salt[(i + 3) & 3];
-				L2 ^= salt->salt[(i + 2) & 3];
-				R2 ^= salt->salt[(i + 3) & 3];
-				L3 ^= salt->salt[(i + 2) & 3];
-				R3 ^= salt->salt[(i + 3) & 3];
-				BF_ENCRYPT;
-				sboxs[i       ] = L0;
-				sboxs[i+1     ] = R0;
-				sboxs[i  +1024] = L1;
-				sboxs[i+1+1024] = R1;
-				sboxs[i  +2048] = L2;
-				sboxs[i+1+2048] = R2;
-				sboxs[i  +3072] = L3;
-				sboxs[i+1+3072] = R3;
+				// Search for a match
+				uint32_t hash_index = salt_index[current_salt_index];
+
+				// Partial match
+				while (hash_index != NO_ELEM)
+				{
+					// Total match
+					if (!memcmp(crypt_result+k*6, ((uint32_t*)binary_values) + hash_index * 6, BINARY_SIZE))
+						password_was_found(hash_index, utf8_coalesc2utf8_key(buffer, key, BF_INTERLEAVED, k));
+
+					hash_index = same_salt_next[hash_index];
+				}
 			}
+		}
 
-			// Expensive key schedule
-			for (uint32_t round = 0; round < salt->rounds; round++)
-			{
-				// Key part
-				for (int i = 0; i < 18*BF_IN_PARALLEL; i++)
-					subkeys[i] ^= expanded_key[i];
+		report_keys_processed(BF_INTERLEAVED);
+	}
 
-				blowfish_body_asm_bmi(sboxs, subkeys);
+	free(buffer);
+	finish_thread();
+}
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX2
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#include "arch_simd.h"
+#include <immintrin.h>
+
+// Each vector is 8 independent instances. Two vectors to hide the latency of the gathers.
+// S-boxes and subkeys are interleaved by key: one aligned store writes the same entry of all instances.
+#define BF_AVX2_VECTORS		2
+#define BF_AVX2_NUM_KEYS	(8*BF_AVX2_VECTORS)
+#define BF_AVX2_SHIFT		4// log2(BF_AVX2_NUM_KEYS)
+#define BF_FOR_EACH_VECTOR(code) code(0) code(1)
+
+#define BF_AVX2_GATHER(sbox, index, v) _mm256_i32gather_epi32((const int*)(sbox), _mm256_or_si256(_mm256_and_si256(index, byte_mask), lane_index##v), 4)
+#define BF_AVX2_F(x, v) _mm256_add_epi32(_mm256_xor_si256(_mm256_add_epi32(\
+	BF_AVX2_GATHER(sboxs                         , _mm256_srli_epi32(x, 24 - BF_AVX2_SHIFT), v),\
+	BF_AVX2_GATHER(sboxs + 256 * BF_AVX2_NUM_KEYS, _mm256_srli_epi32(x, 16 - BF_AVX2_SHIFT), v)),\
+	BF_AVX2_GATHER(sboxs + 512 * BF_AVX2_NUM_KEYS, _mm256_srli_epi32(x,  8 - BF_AVX2_SHIFT), v)),\
+	BF_AVX2_GATHER(sboxs + 768 * BF_AVX2_NUM_KEYS, _mm256_slli_epi32(x,      BF_AVX2_SHIFT), v))
+
+#define BF_AVX2_P(i, v)			_mm256_load_si256((const __m256i*)(subkeys + (i)*BF_AVX2_NUM_KEYS + (v)*8))
+#define BF_AVX2_DECLARE(v)		__m256i L##v = _mm256_setzero_si256(), R##v = _mm256_setzero_si256();\
+								const __m256i lane_index##v = _mm256_setr_epi32(8*(v)+0, 8*(v)+1, 8*(v)+2, 8*(v)+3, 8*(v)+4, 8*(v)+5, 8*(v)+6, 8*(v)+7);
+#define BF_AVX2_XOR_P0(v)		L##v = _mm256_xor_si256(L##v, BF_AVX2_P(0, v));
+#define BF_AVX2_ROUND_R(v)		R##v = _mm256_xor_si256(R##v, _mm256_xor_si256(BF_AVX2_P(r  , v), BF_AVX2_F(L##v, v)));
+#define BF_AVX2_ROUND_L(v)		L##v = _mm256_xor_si256(L##v, _mm256_xor_si256(BF_AVX2_P(r+1, v), BF_AVX2_F(R##v, v)));
+#define BF_AVX2_SWAP(v)			ts = R##v; R##v = L##v; L##v = _mm256_xor_si256(ts, BF_AVX2_P(17, v));
+#define BF_AVX2_XOR_SALT(v)		L##v = _mm256_xor_si256(L##v, salt_L); R##v = _mm256_xor_si256(R##v, salt_R);
+#define BF_AVX2_LOAD_MAGIC(v)	L##v = _mm256_set1_epi32(BF_magic_w[i]); R##v = _mm256_set1_epi32(BF_magic_w[i+1]);
+#define BF_AVX2_STORE(v, ptr, i)	_mm256_store_si256((__m256i*)((ptr) + (i)*BF_AVX2_NUM_KEYS + (v)*8), L##v); _mm256_store_si256((__m256i*)((ptr) + ((i)+1)*BF_AVX2_NUM_KEYS + (v)*8), R##v);
+#define BF_AVX2_STORE_SUBKEYS(v)	BF_AVX2_STORE(v, subkeys, i)
+#define BF_AVX2_STORE_SBOXS(v)		BF_AVX2_STORE(v, sboxs, i)
+#define BF_AVX2_STORE_RESULT(v)		BF_AVX2_STORE(v, crypt_result, i)
 
-				// Salt part
-				for (int i = 0; i < 18*BF_IN_PARALLEL; i ++)
-					subkeys[i] ^= salt->salt[(i/BF_IN_PARALLEL)&3];
+// Encrypt one block
+#define BF_AVX2_ENCRYPT \
+	BF_FOR_EACH_VECTOR(BF_AVX2_XOR_P0)\
+	for (int r = 1; r < 17; r += 2)\
+	{\
+		BF_FOR_EACH_VECTOR(BF_AVX2_ROUND_R)\
+		BF_FOR_EACH_VECTOR(BF_AVX2_ROUND_L)\
+	}\
+	BF_FOR_EACH_VECTOR(BF_AVX2_SWAP)
+
+PRIVATE HS_TARGET("avx2") void blowfish_body_avx2(uint32_t* subkeys, uint32_t* sboxs)
+{
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF << BF_AVX2_SHIFT);
+	__m256i ts;
+	BF_FOR_EACH_VECTOR(BF_AVX2_DECLARE)
 
-				blowfish_body_asm_bmi(sboxs, subkeys);
-			}
+	for (int i = 0; i < 18; i += 2)
+	{
+		BF_AVX2_ENCRYPT;
+		BF_FOR_EACH_VECTOR(BF_AVX2_STORE_SUBKEYS)
+	}
+	for (int i = 0; i < 256 * 4; i += 2)
+	{
+		BF_AVX2_ENCRYPT;
+		BF_FOR_EACH_VECTOR(BF_AVX2_STORE_SBOXS)
+	}
+}
 
-			// Final part: Encrypt
-			for (int i = 0; i < 6; i += 2)
-			{
-				L0 = L1 = L2 = L3 = BF_magic_w[i];
-				R0 = R1 = R2 = R3 = BF_magic_w[i+1];
+// Gathers are slow on many CPUs: only use them when faster than the interleaved scalar code.
+// Run once by calibrate_hardware to set CPU_CAP_AVX2_GATHER
+#define BF_GATHER_CALIBRATION_MS	8
+PUBLIC int is_avx2_gather_faster()
+{
+	uint32_t* buffer = (uint32_t*)_aligned_malloc((4 * 256 + 18) * sizeof(uint32_t) * BF_AVX2_NUM_KEYS, 32);
+	int64_t gather_keys = 0, interleaved_keys = 0;
 
-				for (int j = 0; j < 64; j++)
-				{
-					BF_ENCRYPT;
-				}
+	// Realistic S-boxes: with all zeros every lookup hits the same cache line
+	for (int i = 0; i < (4 * 256 + 18) * BF_AVX2_NUM_KEYS; i++)
+		buffer[i] = ((uint32_t*)BF_init_state.S)[i % (4 * 256)];
 
-				crypt_result[i     ] = L0;
-				crypt_result[i+1   ] = R0;
-				crypt_result[i  + 6] = L1;
-				crypt_result[i+1+ 6] = R1;
-				crypt_result[i  +12] = L2;
-				crypt_result[i+1+12] = R2;
-				crypt_result[i  +18] = L3;
-				crypt_result[i+1+18] = R3;
-			}
-			
-			for (int k = 0; k < NT_NUM_KEYS; k++)
+	// Alternate both engines so a noisy moment doesn't favor one of them
+	for (int i = 0; i < 2; i++)
+	{
+		int64_t start = get_milliseconds();
+		while ((get_milliseconds() - start) < BF_GATHER_CALIBRATION_MS)
+		{
+			blowfish_body_avx2(buffer + 4 * 256 * BF_AVX2_NUM_KEYS, buffer);
+			gather_keys += BF_AVX2_NUM_KEYS;
+		}
+
+		start = get_milliseconds();
+		while ((get_milliseconds() - start) < BF_GATHER_CALIBRATION_MS)
+		{
+			blowfish_body_interleaved(buffer + 4 * 256 * BF_INTERLEAVED, buffer);
+			interleaved_keys += BF_INTERLEAVED;
+		}
+	}
+
+	_aligned_free(buffer);
+	return gather_keys > interleaved_keys;
+}
+
+// Buffer layout: keys (8 words per key) | sboxs | subkeys | expanded_key | crypt_result
+#define BF_AVX2_BUFFER_SIZE	((8 + 4 * 256 + 18 + 18 + 6) * sizeof(uint32_t) * BF_AVX2_NUM_KEYS)
+
+// Hash the BF_AVX2_NUM_KEYS keys in 'buffer' with one salt. Word i of key k is in crypt_result[i*BF_AVX2_NUM_KEYS+k].
+PRIVATE HS_TARGET("avx2") void bcrypt_avx2(uint32_t* buffer, const BF_salt* salt)
+{
+	uint32_t* sboxs   = buffer + 8 * BF_AVX2_NUM_KEYS;
+	uint32_t* subkeys = sboxs + 4 * 256 * BF_AVX2_NUM_KEYS;
+	uint32_t* expanded_key = subkeys + 18 * BF_AVX2_NUM_KEYS;
+	uint32_t* crypt_result = expanded_key + 18 * BF_AVX2_NUM_KEYS;
+	const __m256i byte_mask = _mm256_set1_epi32(0xFF << BF_AVX2_SHIFT);
+
+	__m256i ts;
+	BF_FOR_EACH_VECTOR(BF_AVX2_DECLARE)
+
+	blowfish_set_key(buffer, subkeys, expanded_key, BF_AVX2_NUM_KEYS, salt->sign_extension_bug, BF_AVX2_NUM_KEYS);
+	for (int i = 0; i < 4 * 256; i++)
+	{
+		__m256i value = _mm256_set1_epi32(((uint32_t*)BF_init_state.S)[i]);
+		for (int v = 0; v < BF_AVX2_VECTORS; v++)
+			_mm256_store_si256((__m256i*)(sboxs + i*BF_AVX2_NUM_KEYS + v*8), value);
+	}
+
+	for (int i = 0; i < 18; i+=2)
+	{
+		__m256i salt_L = _mm256_set1_epi32(salt->salt[(i & 2)]);
+		__m256i salt_R = _mm256_set1_epi32(salt->salt[(i & 2) + 1]);
+		BF_FOR_EACH_VECTOR(BF_AVX2_XOR_SALT)
+		BF_AVX2_ENCRYPT;
+		BF_FOR_EACH_VECTOR(BF_AVX2_STORE_SUBKEYS)
+	}
+	for (int i = 0; i < 256*4; i+=2)
+	{
+		__m256i salt_L = _mm256_set1_epi32(salt->salt[(i + 2) & 3]);
+		__m256i salt_R = _mm256_set1_epi32(salt->salt[(i + 3) & 3]);
+		BF_FOR_EACH_VECTOR(BF_AVX2_XOR_SALT)
+		BF_AVX2_ENCRYPT;
+		BF_FOR_EACH_VECTOR(BF_AVX2_STORE_SBOXS)
+	}
+
+	// Expensive key schedule
+	for (uint32_t round = 0; round < salt->rounds; round++)
+	{
+		// Key part
+		for (int i = 0; i < 18*BF_AVX2_NUM_KEYS; i++)
+			subkeys[i] ^= expanded_key[i];
+
+		blowfish_body_avx2(subkeys, sboxs);
+
+		// Salt part
+		for (int i = 0; i < 18*BF_AVX2_NUM_KEYS; i++)
+			subkeys[i] ^= salt->salt[(i/BF_AVX2_NUM_KEYS)&3];
+
+		blowfish_body_avx2(subkeys, sboxs);
+	}
+
+	// Final part: Encrypt
+	for (int i = 0; i < 6; i += 2)
+	{
+		BF_FOR_EACH_VECTOR(BF_AVX2_LOAD_MAGIC)
+
+		for (int j = 0; j < 64; j++)
+		{
+			BF_AVX2_ENCRYPT;
+		}
+
+		BF_FOR_EACH_VECTOR(BF_AVX2_STORE_RESULT)
+	}
+
+	/* This has to be bug-compatible with the original implementation, so only encode 23 of the 24 bytes. :-) */
+	for (int k = 0; k < BF_AVX2_NUM_KEYS; k++)
+		crypt_result[5*BF_AVX2_NUM_KEYS+k] &= 0xFFFFFF00;
+}
+
+PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
+{
+	unsigned char key[MAX_KEY_LENGHT_SMALL];
+	uint32_t* buffer = (uint32_t*)_aligned_malloc(BF_AVX2_BUFFER_SIZE, 32);
+	memset(buffer, 0, 8 * BF_AVX2_NUM_KEYS * sizeof(uint32_t));
+
+	uint32_t* crypt_result = buffer + (8 + 4 * 256 + 18 + 18) * BF_AVX2_NUM_KEYS;
+
+	while(continue_attack && param->gen(buffer, BF_AVX2_NUM_KEYS, param->thread_id))
+	{
+		BF_salt* salt = (BF_salt*)salts_values;
+		// For all salts
+		for(uint32_t current_salt_index = 0; continue_attack && current_salt_index < num_diff_salts; current_salt_index++, salt++)
+		{
+			bcrypt_avx2(buffer, salt);
+
+			for (int k = 0; k < BF_AVX2_NUM_KEYS; k++)
 			{
-				/* This has to be bug-compatible with the original implementation, so only encode 23 of the 24 bytes. :-) */
-				crypt_result[5+k*6] &= 0xFFFFFF00;
+				uint32_t result[6];
+				for (int i = 0; i < 6; i++)
+					result[i] = crypt_result[i*BF_AVX2_NUM_KEYS+k];
 
 				// Search for a match
 				uint32_t hash_index = salt_index[current_salt_index];
@@ -1264,20 +1375,133 @@ PRIVATE void crypt_utf8_coalesc_protocol_bmi(CryptParam* param)
 				while (hash_index != NO_ELEM)
 				{
 					// Total match
-					if (!memcmp(crypt_result+k*6, ((uint32_t*)binary_values) + hash_index * 6, BINARY_SIZE))
-						password_was_found(hash_index, utf8_coalesc2utf8_key(buffer, key, NT_NUM_KEYS, k));
+					if (!memcmp(result, ((uint32_t*)binary_values) + hash_index * 6, BINARY_SIZE))
+						password_was_found(hash_index, utf8_coalesc2utf8_key(buffer, key, BF_AVX2_NUM_KEYS, k));
 
 					hash_index = same_salt_next[hash_index];
 				}
 			}
 		}
 
-		report_keys_processed(NT_NUM_KEYS);
+		report_keys_processed(BF_AVX2_NUM_KEYS);
 	}
 
-	free(buffer);
+	_aligned_free(buffer);
 	finish_thread();
 }
+
+#ifdef HS_TESTING
+// Generated with the reference crypt_blowfish: all sub-types and costs 5 to 12.
+// Consecutive hashes with the same salt are tested in the same call.
+PRIVATE const char* bcrypt_test_vectors[][2] = {
+	{"$2a$05$CCCCCCCCCCCCCCCCCCCCC.E5YPO9kmyuRGyh0XouQYb4YMJKvyOeW", "U*U"},
+	{"$2x$05$/OK.fbVrR/bpIqNJ5ianF.CE5elHaaO4EbggVDjb8P19RukzXSM3e", "\xa3"},
+	{"$2y$05$/OK.fbVrR/bpIqNJ5ianF.Sa7shbm4.OzKpvFnX1pQLmQW96oUlCq", "\xa3"},
+	{"$2a$05$6gqQu/t7h4b.Q2tSpYFXHe1GlF0JakhJFe4U42sdcIK6nGPIh.KP2", "U*U"},
+	{"$2b$05$6gqQu/t7h4b.Q2tSpYFXHePhSNEvOEzk1Dkwinhw0DyHJDkrRxs9O", "password"},
+	{"$2y$05$6gqQu/t7h4b.Q2tSpYFXHe10XDnrWeWYcTYBkPQ2aFCw/pCtsL30y", "\xa3"},
+	{"$2x$05$V1sUBY828UFp4cnKa.sshO/Pg.QYL3TIEGLiIvqrFpRNcZU7ITgDS", "\xa3"},
+	{"$2x$05$V1sUBY828UFp4cnKa.sshOuEj8uuDNA6zvZ93n4AW1qdCZduiDk8y", "\xff\xa3""345"},
+	{"$2x$05$V1sUBY828UFp4cnKa.sshO4Iv4nd0xz0VCjE5OofWPx5WT.JK7Lfi", "\xd1\x91"},
+	{"$2a$06$xJAFaJ02M0PmSETIxz67v.GZHpXgC3U.QBmZISan.GJ0r0PsqoA46", "\xff\xa3""345"},
+	{"$2b$06$xJAFaJ02M0PmSETIxz67v.VuBYZJOJeket7G60uch9uctUlHKaTja", "0123456789abcdefghijklmnopq"},
+	{"$2y$06$xJAFaJ02M0PmSETIxz67v.quFweNVQk/q8vGZQgqVh2cDucOkXY/W", "\xd1\x91"},
+	{"$2a$07$IWfrsvlMecostUBu1CBa0.9AyCgX5XDl2zIMvgqtLwU.vyruSlz6e", "hash suite"},
+	{"$2b$07$IWfrsvlMecostUBu1CBa0.zlJdjjlVFT/HqGq7mjM07neVb1IRHSi", "~!@#$%^&*()_+"},
+	{"$2y$07$IWfrsvlMecostUBu1CBa0.ZQBhoqFPugmk9UoC5kIa/Z0omvQ1O2S", "U*U"},
+	{"$2a$08$vYLaUHhC1h9qE4tYpi467OICAC8ts6eqqGzy8Uicu33cDzBB4FZyG", "password"},
+	{"$2b$08$vYLaUHhC1h9qE4tYpi467OUgxHC0op/h/uKthrlx4mP.pSj.A7GL2", "\xa3"},
+	{"$2y$08$vYLaUHhC1h9qE4tYpi467Oz23./yij2cXhC0lx8IdI2cZnmkSo2YC", "\xff\xa3""345"},
+	{"$2a$09$T5sVWa.gpUc/DdMsRBnhNODD9Pq.d3pfJD9gAkivOUQvO73QcBmkW", "0123456789abcdefghijklmnopq"},
+	{"$2b$09$T5sVWa.gpUc/DdMsRBnhNOPXO3uhQ1Pkjg6DJ9iyT1Vq5uKuZta6i", "\xd1\x91"},
+	{"$2y$09$T5sVWa.gpUc/DdMsRBnhNOaVCjUhJdU6Q9dVuX5zQgMKrwCCfyDG6", "hash suite"},
+	{"$2a$10$78rf2S3jDho2ZieB.BOgzOEYs3sm8efeIBqHDZXgk2RzhzjA9Gc1S", "~!@#$%^&*()_+"},
+	{"$2b$10$78rf2S3jDho2ZieB.BOgzOkbSxUp/R6U7Xo58yVuzttgVHV9rir7q", "U*U"},
+	{"$2y$10$78rf2S3jDho2ZieB.BOgzODzDS.RfvNaVkyqZFSqI8efKYzOcnLgO", "password"},
+	{"$2a$11$cX16FfDz1JxXqtvSARBCHuU.AfIV0sX4TbiQS7n6Ao35A.wsouWW2", "\xa3"},
+	{"$2b$11$cX16FfDz1JxXqtvSARBCHu/GA4YLujeavk961iPRoX5AhnDYdcvfG", "\xff\xa3""345"},
+	{"$2y$11$cX16FfDz1JxXqtvSARBCHu9kMoqv4vX2EFi6Q4OjbMex/Jze5JmiK", "0123456789abcdefghijklmnopq"},
+	{"$2a$12$XuKrWlg8NZwdHyrnIoQJleQJkfSJbeK4JGNhXUISX/Ms9GT1u1kRi", "\xd1\x91"},
+	{"$2b$12$XuKrWlg8NZwdHyrnIoQJleBRelMmtMkjH3QnxfVDxpS//5F34jM0a", "hash suite"},
+	{"$2y$12$XuKrWlg8NZwdHyrnIoQJledRJgGnAivQVkzjDm7wt3P18hi798epG", "~!@#$%^&*()_+"}
+};
+#define BF_TEST_MAX_SAME_SALT	3
+
+// Fill the NUM_KEYS keys of the coalesced 'buffer' repeating 'keys'
+PRIVATE void test_put_keys(uint32_t* buffer, uint32_t NUM_KEYS, const char** keys, uint32_t num_keys)
+{
+	for (uint32_t k = 0; k < NUM_KEYS; k++)
+	{
+		uint32_t key[7];
+		uint32_t len = (uint32_t)strlen(keys[k % num_keys]);
+		memset(key, 0, sizeof(key));
+		memcpy(key, keys[k % num_keys], len);
+
+		for (uint32_t j = 0; j < 7; j++)
+			buffer[j * NUM_KEYS + k] = key[j];
+		buffer[7 * NUM_KEYS + k] = len << 3;
+	}
+}
+
+// Check both x64 engines with known hashes, whatever engine the attack will select.
+// The AVX2 one is tested on all AVX2 CPUs, not only when CPU_CAP_AVX2_GATHER.
+PUBLIC int test_bcrypt_engines()
+{
+	uint32_t* buffer = (uint32_t*)_aligned_malloc(__max(BF_INTERLEAVED_BUFFER_SIZE, BF_AVX2_BUFFER_SIZE), 32);
+	const uint32_t* interleaved_result = buffer + (8 + 4 * 256 + 18 + 18) * BF_INTERLEAVED;
+	const uint32_t* avx2_result = buffer + (8 + 4 * 256 + 18 + 18) * BF_AVX2_NUM_KEYS;
+	int result = TRUE;
+
+	for (uint32_t first = 0, last; first < LENGTH(bcrypt_test_vectors); first = last)
+	{
+		uint32_t binary[BF_TEST_MAX_SAME_SALT][6];
+		const char* keys[BF_TEST_MAX_SAME_SALT];
+		BF_salt salt, other_salt;
+
+		// Group the hashes with the same salt
+		get_binary((const unsigned char*)bcrypt_test_vectors[first][0], binary[0], &salt);
+		keys[0] = bcrypt_test_vectors[first][1];
+		for (last = first + 1; last < LENGTH(bcrypt_test_vectors) && (last - first) < BF_TEST_MAX_SAME_SALT; last++)
+		{
+			get_binary((const unsigned char*)bcrypt_test_vectors[last][0], binary[last - first], &other_salt);
+			if (memcmp(&salt, &other_salt, sizeof(BF_salt)))
+				break;
+			keys[last - first] = bcrypt_test_vectors[last][1];
+		}
+		uint32_t num_keys = last - first;
+
+		test_put_keys(buffer, BF_INTERLEAVED, keys, num_keys);
+		bcrypt_interleaved(buffer, &salt);
+		for (uint32_t k = 0; k < BF_INTERLEAVED; k++)
+			if (memcmp(interleaved_result + k * 6, binary[k % num_keys], BINARY_SIZE))
+			{
+				hs_log(HS_LOG_ERROR, "Test Suite", "BCRYPT interleaved engine fails: %s", bcrypt_test_vectors[first + k % num_keys][0]);
+				result = FALSE;
+			}
+
+		if (current_cpu.capabilites[CPU_CAP_AVX2])
+		{
+			test_put_keys(buffer, BF_AVX2_NUM_KEYS, keys, num_keys);
+			bcrypt_avx2(buffer, &salt);
+			for (uint32_t k = 0; k < BF_AVX2_NUM_KEYS; k++)
+			{
+				uint32_t avx2_binary[6];
+				for (int i = 0; i < 6; i++)
+					avx2_binary[i] = avx2_result[i*BF_AVX2_NUM_KEYS+k];
+
+				if (memcmp(avx2_binary, binary[k % num_keys], BINARY_SIZE))
+				{
+					hs_log(HS_LOG_ERROR, "Test Suite", "BCRYPT AVX2 engine fails: %s", bcrypt_test_vectors[first + k % num_keys][0]);
+					result = FALSE;
+				}
+			}
+		}
+	}
+
+	_aligned_free(buffer);
+	return result;
+}
+#endif
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2512,12 +2736,12 @@ Format bcrypt_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_BMI, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_bmi}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_AVX2_GATHER, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_interleaved}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_interleaved}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+		{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+		{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 	#endif
 #endif
 
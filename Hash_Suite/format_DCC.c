@@ -147,94 +147,99 @@ PRIVATE void binary2hex(const void* binary, const uint32_t* salt, unsigned char*
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 typedef void dcc_ntlm_part_func(void* nt_buffer, uint32_t* crypt_result);
 typedef void dcc_salt_part_func(void* salt_buffer, uint32_t* crypt_result);
-PRIVATE void crypt_ntlm_protocol_body(CryptParam* param, int NUM_KEYS, uint32_t uint_in_parallel, dcc_ntlm_part_func* dcc_ntlm_part, dcc_salt_part_func** dcc_salt_part)
+typedef void dcc_found_func(uint32_t index, unsigned char* cleartext);
+// Compares the uint_in_parallel keys of crypt_result against all salts
+PRIVATE void dcc_compare_key_major(uint32_t* nt_buffer, uint32_t NUM_KEYS, uint32_t first_key, uint32_t uint_in_parallel, dcc_salt_part_func** dcc_salt_part, uint32_t* crypt_result, unsigned char* key, dcc_found_func* found)
 {
-	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * sizeof(uint32_t)* NUM_KEYS, 32);
-	uint32_t* crypt_result = (uint32_t*)_aligned_malloc(uint_in_parallel*sizeof(uint32_t)* 12, 32);
-
-	unsigned char* key = (unsigned char*)calloc(MAX_KEY_LENGHT_SMALL, sizeof(unsigned char));
-
-	memset(nt_buffer, 0, 16 * sizeof(uint32_t)* NUM_KEYS);
-
-	while (continue_attack && param->gen(nt_buffer, NUM_KEYS, param->thread_id))
+	uint32_t* salt_buffer = (uint32_t*)salts_values;
+	//Another MD4_crypt for the salt
+	// For all salts
+	for(uint32_t j = 0; j < num_diff_salts; j++, salt_buffer += 11)
 	{
-		for (uint32_t i = 0; i < NUM_KEYS / uint_in_parallel; i++)
+		dcc_salt_part[salt_buffer[10] >> 4](salt_buffer, crypt_result);
+
+		// All salts differents
+		if (num_passwords_loaded == num_diff_salts)
 		{
-			uint32_t* salt_buffer = (uint32_t*)salts_values;
-			dcc_ntlm_part(nt_buffer + uint_in_parallel*i, crypt_result);
+			uint32_t* bin = ((uint32_t*)binary_values) + j * 4;
 
-			//Another MD4_crypt for the salt
-			// For all salts
-			for(uint32_t j = 0; j < num_diff_salts; j++, salt_buffer += 11)
+			for (uint32_t k = 0; k < uint_in_parallel; k++)
 			{
-				dcc_salt_part[salt_buffer[10] >> 4](salt_buffer, crypt_result);
+				// Search for a match
+				uint32_t a, b, c, d = crypt_result[(8 + 3)*uint_in_parallel + k];
 
-				// All salts differents
-				if (num_passwords_loaded == num_diff_salts)
-				{
-					uint32_t* bin = ((uint32_t*)binary_values) + j * 4;
+				if (d != bin[3]) continue;
+				d = ROTATE(d + SQRT_3, 9);
 
-					for (uint32_t k = 0; k < uint_in_parallel; k++)
-					{
-						// Search for a match
-						uint32_t a, b, c, d = crypt_result[(8 + 3)*uint_in_parallel + k];
+				c = crypt_result[(8 + 2)*uint_in_parallel + k];
+				b = crypt_result[(8 + 1)*uint_in_parallel + k];
+				a = crypt_result[(8 + 0)*uint_in_parallel + k];
 
-						if (d != bin[3]) continue;
-						d = ROTATE(d + SQRT_3, 9);
+				c += (d ^ a ^ b) + salt_buffer[1] + SQRT_3; c = ROTATE(c, 11);
+				if (c != bin[2]) continue;
 
-						c = crypt_result[(8 + 2)*uint_in_parallel + k];
-						b = crypt_result[(8 + 1)*uint_in_parallel + k];
-						a = crypt_result[(8 + 0)*uint_in_parallel + k];
+				b += (c ^ d ^ a) + salt_buffer[9] + SQRT_3; b = ROTATE(b, 15);
+				if (b != bin[1]) continue;
 
-						c += (d ^ a ^ b) + salt_buffer[1] + SQRT_3; c = ROTATE(c, 11);
-						if (c != bin[2]) continue;
+				a += (b ^ c ^ d) + crypt_result[3 * uint_in_parallel + k] + SQRT_3; a = ROTATE(a, 3);
+				if (a != bin[0]) continue;
 
-						b += (c ^ d ^ a) + salt_buffer[9] + SQRT_3; b = ROTATE(b, 15);
-						if (b != bin[1]) continue;
+				// Total match
+				found(j, ntlm2utf8_key(nt_buffer, key, NUM_KEYS, first_key + k));
+			}
+		}
+		else
+			for (uint32_t k = 0; k < uint_in_parallel; k++)
+			{
+				// Search for a match
+				uint32_t index = salt_index[j];
 
-						a += (b ^ c ^ d) + crypt_result[3 * uint_in_parallel + k] + SQRT_3; a = ROTATE(a, 3);
-						if (a != bin[0]) continue;
+				// Partial match
+				while(index != NO_ELEM)
+				{
+					uint32_t a, b, c, d = crypt_result[(8 + 3)*uint_in_parallel + k];
+					uint32_t* bin = ((uint32_t*)binary_values) + index * 4;
 
-						// Total match
-						password_was_found(j, ntlm2utf8_key(nt_buffer, key, NUM_KEYS, uint_in_parallel * i + k));
-					}
-				}
-				else
-					for (uint32_t k = 0; k < uint_in_parallel; k++)
-					{
-						// Search for a match
-						uint32_t index = salt_index[j];
+					if(d != bin[3]) goto next_iteration;
+					d = ROTATE(d + SQRT_3, 9);
 
-						// Partial match
-						while(index != NO_ELEM)
-						{
-							uint32_t a, b, c, d = crypt_result[(8 + 3)*uint_in_parallel + k];
-							uint32_t* bin = ((uint32_t*)binary_values) + index * 4;
+					c = crypt_result[(8+2)*uint_in_parallel+k];
+					b = crypt_result[(8+1)*uint_in_parallel+k];
+					a = crypt_result[(8+0)*uint_in_parallel+k];
 
-							if(d != bin[3]) goto next_iteration;
-							d = ROTATE(d + SQRT_3, 9);
+					c += (d ^ a ^ b) + salt_buffer[1] + SQRT_3; c = ROTATE(c, 11);
+					if(c != bin[2]) goto next_iteration;
 
-							c = crypt_result[(8+2)*uint_in_parallel+k];
-							b = crypt_result[(8+1)*uint_in_parallel+k];
-							a = crypt_result[(8+0)*uint_in_parallel+k];
+					b += (c ^ d ^ a) + salt_buffer[9] + SQRT_3; b = ROTATE(b, 15);
+					if(b != bin[1]) goto next_iteration;
 
-							c += (d ^ a ^ b) + salt_buffer[1] + SQRT_3; c = ROTATE(c, 11);
-							if(c != bin[2]) goto next_iteration;
+					a += (b ^ c ^ d) + crypt_result[3 * uint_in_parallel + k] + SQRT_3; a = ROTATE(a, 3);
+					if(a != bin[0]) goto next_iteration;
 
-							b += (c ^ d ^ a) + salt_buffer[9] + SQRT_3; b = ROTATE(b, 15);
-							if(b != bin[1]) goto next_iteration;
+					// Total match
+					found(index, ntlm2utf8_key(nt_buffer, key, NUM_KEYS, first_key + k));
 
-							a += (b ^ c ^ d) + crypt_result[3 * uint_in_parallel + k] + SQRT_3; a = ROTATE(a, 3);
-							if(a != bin[0]) goto next_iteration;
+				next_iteration:
+					index = same_salt_next[index];
+				}
+			}
+	}
+}
+PRIVATE void crypt_ntlm_protocol_body(CryptParam* param, int NUM_KEYS, uint32_t uint_in_parallel, dcc_ntlm_part_func* dcc_ntlm_part, dcc_salt_part_func** dcc_salt_part)
+{
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * sizeof(uint32_t)* NUM_KEYS, 32);
+	uint32_t* crypt_result = (uint32_t*)_aligned_malloc(uint_in_parallel*sizeof(uint32_t)* 12, 32);
 
-							// Total match
-							password_was_found(index, ntlm2utf8_key(nt_buffer, key, NUM_KEYS, uint_in_parallel * i + k));
+	unsigned char* key = (unsigned char*)calloc(MAX_KEY_LENGHT_SMALL, sizeof(unsigned char));
 
-						next_iteration:
-							index = same_salt_next[index];
-						}
-					}
-			}
+	memset(nt_buffer, 0, 16 * sizeof(uint32_t)* NUM_KEYS);
+
+	while (continue_attack && param->gen(nt_buffer, NUM_KEYS, param->thread_id))
+	{
+		for (uint32_t i = 0; i < NUM_KEYS / uint_in_parallel; i++)
+		{
+			dcc_ntlm_part(nt_buffer + uint_in_parallel*i, crypt_result);
+			dcc_compare_key_major(nt_buffer, NUM_KEYS, uint_in_parallel * i, uint_in_parallel, dcc_salt_part, crypt_result, key, password_was_found);
 		}
 
 		report_keys_processed(NUM_KEYS);
@@ -696,6 +701,482 @@ PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
 }
 #endif
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Salt-major Implementation
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// With many salts the salt part dominates. Here each lane is one (salt, hash) pair and one key
+// is broadcast, so all lanes are compared at once. Lanes carry their own salt words, so salts
+// of different lenght share a group. A group of num_lanes pairs are SALTS_NUM_ROWS rows of
+// num_lanes uint32: the 11 salt words, bin[3] and the hash index.
+#ifdef HS_X86
+#define SALTS_ROW_BIN3			11
+#define SALTS_ROW_INDEX			12
+#define SALTS_NUM_ROWS			16
+// With less salts the key-major code is faster
+#define SALT_MAJOR_MIN_SALTS	32
+
+typedef uint32_t dcc_salts_part_func(const void* salts, const uint32_t* crypt_result, uint32_t* abcd);
+
+PRIVATE uint32_t* create_salts_major(uint32_t num_lanes, uint32_t* num_groups)
+{
+	uint32_t num_pairs = 0;
+	*num_groups = (num_passwords_loaded + num_lanes - 1) / num_lanes;
+
+	uint32_t* salts = (uint32_t*)_aligned_malloc(*num_groups * SALTS_NUM_ROWS * num_lanes * sizeof(uint32_t), 64);
+	if (!salts) return NULL;
+	memset(salts, 0, *num_groups * SALTS_NUM_ROWS * num_lanes * sizeof(uint32_t));
+
+	uint32_t* salt_buffer = (uint32_t*)salts_values;
+	for (uint32_t j = 0; j < num_diff_salts; j++, salt_buffer += 11)
+	{
+		// All salts differents
+		uint32_t index = (num_passwords_loaded == num_diff_salts) ? j : salt_index[j];
+
+		while (index != NO_ELEM)
+		{
+			uint32_t* group = salts + (num_pairs / num_lanes) * SALTS_NUM_ROWS * num_lanes + (num_pairs % num_lanes);
+
+			for (uint32_t i = 0; i < 11; i++)
+				group[i*num_lanes] = salt_buffer[i];
+			group[SALTS_ROW_BIN3*num_lanes] = ((uint32_t*)binary_values)[index * 4 + 3];
+			group[SALTS_ROW_INDEX*num_lanes] = index;
+			num_pairs++;
+
+			index = (num_passwords_loaded == num_diff_salts) ? NO_ELEM : same_salt_next[index];
+		}
+	}
+	// Unused lanes
+	for (; num_pairs < *num_groups * num_lanes; num_pairs++)
+		salts[(num_pairs / num_lanes) * SALTS_NUM_ROWS * num_lanes + SALTS_ROW_INDEX * num_lanes + (num_pairs % num_lanes)] = NO_ELEM;
+
+	return salts;
+}
+// The lanes layout is the same for all threads of the attack: build it once
+PRIVATE HS_MUTEX salts_major_mutex;
+PRIVATE uint32_t* salts_major = NULL;
+PRIVATE uint32_t salts_major_lanes, salts_major_groups, salts_major_users = 0;
+PUBLIC void dcc_salts_major_init()
+{
+	HS_CREATE_MUTEX(&salts_major_mutex);
+}
+PRIVATE uint32_t* acquire_salts_major(uint32_t num_lanes, uint32_t* num_groups)
+{
+	uint32_t* result = NULL;
+	HS_ENTER_MUTEX(&salts_major_mutex);
+
+	if (!salts_major)
+	{
+		salts_major = create_salts_major(num_lanes, &salts_major_groups);
+		salts_major_lanes = num_lanes;
+	}
+	if (salts_major && salts_major_lanes == num_lanes)
+	{
+		salts_major_users++;
+		*num_groups = salts_major_groups;
+		result = salts_major;
+	}
+
+	HS_LEAVE_MUTEX(&salts_major_mutex);
+	return result;
+}
+PRIVATE void release_salts_major()
+{
+	HS_ENTER_MUTEX(&salts_major_mutex);
+
+	salts_major_users--;
+	if (!salts_major_users)
+	{
+		_aligned_free(salts_major);
+		salts_major = NULL;
+	}
+
+	HS_LEAVE_MUTEX(&salts_major_mutex);
+}
+// Compares the 4 keys of crypt_result against all (salt, hash) pairs
+PRIVATE void dcc_compare_salts_major(const uint32_t* salts, uint32_t num_groups, uint32_t num_lanes, dcc_salts_part_func* dcc_salts_part, const uint32_t* crypt_result, uint32_t* abcd, uint32_t* nt_buffer, uint32_t first_key, unsigned char* key, dcc_found_func* found)
+{
+	uint32_t key_values[4][8];
+
+	for (uint32_t k = 0; k < 4; k++)
+		for (uint32_t w = 0; w < 8; w++)
+			key_values[k][w] = crypt_result[w * 4 + k];
+
+	// For all salts
+	const uint32_t* group = salts;
+	for (uint32_t g = 0; g < num_groups; g++, group += SALTS_NUM_ROWS * num_lanes)
+		for (uint32_t k = 0; k < 4; k++)
+		{
+			uint32_t mask = dcc_salts_part(group, key_values[k], abcd);
+
+			for (uint32_t lane = 0; mask; lane++, mask >>= 1)
+				if (mask & 1)
+				{
+					uint32_t index = group[SALTS_ROW_INDEX*num_lanes + lane];
+					if (index == NO_ELEM) continue;
+
+					// Search for a match
+					uint32_t* bin = ((uint32_t*)binary_values) + index * 4;
+					uint32_t a = abcd[0 * num_lanes + lane];
+					uint32_t b = abcd[1 * num_lanes + lane];
+					uint32_t c = abcd[2 * num_lanes + lane];
+					uint32_t d = abcd[3 * num_lanes + lane];
+
+					d = ROTATE(d + SQRT_3, 9);
+
+					c += (d ^ a ^ b) + group[1 * num_lanes + lane] + SQRT_3; c = ROTATE(c, 11);
+					if (c != bin[2]) continue;
+
+					b += (c ^ d ^ a) + group[9 * num_lanes + lane] + SQRT_3; b = ROTATE(b, 15);
+					if (b != bin[1]) continue;
+
+					a += (b ^ c ^ d) + key_values[k][3] + SQRT_3; a = ROTATE(a, 3);
+					if (a != bin[0]) continue;
+
+					// Total match
+					found(index, ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, first_key + k));
+				}
+		}
+}
+PRIVATE void crypt_ntlm_protocol_salts_body(CryptParam* param, uint32_t num_lanes, dcc_salts_part_func* dcc_salts_part, perform_crypt_funtion* key_major_protocol)
+{
+	uint32_t num_groups;
+	uint32_t* salts = acquire_salts_major(num_lanes, &num_groups);
+	// Not enough memory: use the key-major code
+	if (!salts)
+	{
+		key_major_protocol(param);
+		return;
+	}
+
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * sizeof(uint32_t)* NT_NUM_KEYS, 32);
+	uint32_t* crypt_result = (uint32_t*)_aligned_malloc(4 * sizeof(uint32_t)* 12, 32);
+	uint32_t* abcd = (uint32_t*)_aligned_malloc(4 * sizeof(uint32_t)* num_lanes, 64);
+
+	unsigned char* key = (unsigned char*)calloc(MAX_KEY_LENGHT_SMALL, sizeof(unsigned char));
+
+	memset(nt_buffer, 0, 16 * sizeof(uint32_t)* NT_NUM_KEYS);
+
+	while (continue_attack && param->gen(nt_buffer, NT_NUM_KEYS, param->thread_id))
+	{
+		for (uint32_t i = 0; i < NT_NUM_KEYS / 4; i++)
+		{
+			dcc_ntlm_part_sse2((__m128i*)(nt_buffer + 4 * i), (__m128i*)crypt_result);
+
+			dcc_compare_salts_major(salts, num_groups, num_lanes, dcc_salts_part, crypt_result, abcd, nt_buffer, 4 * i, key, password_was_found);
+		}
+
+		report_keys_processed(NT_NUM_KEYS);
+	}
+
+	// Release resources
+	free(key);
+	release_salts_major();
+	_aligned_free(nt_buffer);
+	_aligned_free(crypt_result);
+	_aligned_free(abcd);
+
+	finish_thread();
+}
+
+// Same steps of dcc_salt_part_c_code with salt words in lanes and the key broadcast
+#define SALTS_STEP1(V,a,b,c,d,value,rot) a = V##_ADD(a, V##_ADD(value, V##_XOR(d, V##_AND(b, V##_XOR(c, d))))); a = V##_ROTATE(a, rot);
+#define SALTS_STEP2(V,a,b,c,d,value,rot) a = V##_ADD(a, V##_ADD(sqrt_2, V##_ADD(value, V##_OR(V##_AND(b, V##_OR(c, d)), V##_AND(c, d))))); a = V##_ROTATE(a, rot);
+#define SALTS_STEP3(V,a,b,c,d,value,rot) a = V##_ADD(a, V##_ADD(sqrt_3, V##_ADD(value, V##_3XOR(d, c, b)))); a = V##_ROTATE(a, rot);
+
+#define SALTS_PART_BODY(V)																	\
+	V##_WORD sqrt_2 = V##_CONST(SQRT_2);													\
+	V##_WORD sqrt_3 = V##_CONST(SQRT_3);													\
+	V##_WORD cr0 = V##_CONST(crypt_result[0]);												\
+	V##_WORD cr1 = V##_CONST(crypt_result[1]);												\
+	V##_WORD cr2 = V##_CONST(crypt_result[2]);												\
+	V##_WORD cr3 = V##_CONST(crypt_result[3]);												\
+																							\
+	/* Round 1 */																			\
+	V##_WORD a = V##_CONST(crypt_result[4+0]);												\
+	V##_WORD b = V##_CONST(crypt_result[4+1]);												\
+	V##_WORD c = V##_CONST(crypt_result[4+2]);												\
+	V##_WORD d = V##_CONST(crypt_result[4+3]);												\
+																							\
+	SALTS_STEP1(V, a, b, c, d, salts[0] , 3 );												\
+	SALTS_STEP1(V, d, a, b, c, salts[1] , 7 );												\
+	SALTS_STEP1(V, c, d, a, b, salts[2] , 11);												\
+	SALTS_STEP1(V, b, c, d, a, salts[3] , 19);												\
+	SALTS_STEP1(V, a, b, c, d, salts[4] , 3 );												\
+	SALTS_STEP1(V, d, a, b, c, salts[5] , 7 );												\
+	SALTS_STEP1(V, c, d, a, b, salts[6] , 11);												\
+	SALTS_STEP1(V, b, c, d, a, salts[7] , 19);												\
+	SALTS_STEP1(V, a, b, c, d, salts[8] , 3 );												\
+	SALTS_STEP1(V, d, a, b, c, salts[9] , 7 );												\
+	SALTS_STEP1(V, c, d, a, b, salts[10], 11);												\
+	SALTS_STEP1(V, b, c, d, a, V##_ZERO , 19);												\
+																							\
+	/* Round 2 */																			\
+	SALTS_STEP2(V, a, b, c, d, cr0      , 3 );												\
+	SALTS_STEP2(V, d, a, b, c, salts[0] , 5 );												\
+	SALTS_STEP2(V, c, d, a, b, salts[4] , 9 );												\
+	SALTS_STEP2(V, b, c, d, a, salts[8] , 13);												\
+	SALTS_STEP2(V, a, b, c, d, cr1      , 3 );												\
+	SALTS_STEP2(V, d, a, b, c, salts[1] , 5 );												\
+	SALTS_STEP2(V, c, d, a, b, salts[5] , 9 );												\
+	SALTS_STEP2(V, b, c, d, a, salts[9] , 13);												\
+	SALTS_STEP2(V, a, b, c, d, cr2      , 3 );												\
+	SALTS_STEP2(V, d, a, b, c, salts[2] , 5 );												\
+	SALTS_STEP2(V, c, d, a, b, salts[6] , 9 );												\
+	SALTS_STEP2(V, b, c, d, a, salts[10], 13);												\
+	SALTS_STEP2(V, a, b, c, d, cr3      , 3 );												\
+	SALTS_STEP2(V, d, a, b, c, salts[3] , 5 );												\
+	SALTS_STEP2(V, c, d, a, b, salts[7] , 9 );												\
+	SALTS_STEP2(V, b, c, d, a, V##_ZERO , 13);												\
+																							\
+	/* Round 3 */																			\
+	SALTS_STEP3(V, a, b, c, d, cr0      , 3 );												\
+	SALTS_STEP3(V, d, a, b, c, salts[4] , 9 );												\
+	SALTS_STEP3(V, c, d, a, b, salts[0] , 11);												\
+	SALTS_STEP3(V, b, c, d, a, salts[8] , 15);												\
+	SALTS_STEP3(V, a, b, c, d, cr2      , 3 );												\
+	SALTS_STEP3(V, d, a, b, c, salts[6] , 9 );												\
+	SALTS_STEP3(V, c, d, a, b, salts[2] , 11);												\
+	SALTS_STEP3(V, b, c, d, a, salts[10], 15);												\
+	SALTS_STEP3(V, a, b, c, d, cr1      , 3 );												\
+	d = V##_ADD(d, V##_ADD(salts[5], V##_3XOR(a, b, c)));
+
+PRIVATE uint32_t dcc_salts_part_sse2(const SSE2_WORD* salts, const uint32_t* crypt_result, uint32_t* abcd)
+{
+	SALTS_PART_BODY(SSE2);
+
+	uint32_t mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpeq_epi32(d, salts[SALTS_ROW_BIN3])));
+	if (mask)
+	{
+		((SSE2_WORD*)abcd)[0] = a;
+		((SSE2_WORD*)abcd)[1] = b;
+		((SSE2_WORD*)abcd)[2] = c;
+		((SSE2_WORD*)abcd)[3] = d;
+	}
+	return mask;
+}
+PRIVATE HS_TARGET("avx2") uint32_t dcc_salts_part_avx2(const AVX2_WORD* salts, const uint32_t* crypt_result, uint32_t* abcd)
+{
+	SALTS_PART_BODY(AVX2);
+
+	uint32_t mask = _mm256_movemask_ps(_mm256_castsi256_ps(_mm256_cmpeq_epi32(d, salts[SALTS_ROW_BIN3])));
+	if (mask)
+	{
+		((AVX2_WORD*)abcd)[0] = a;
+		((AVX2_WORD*)abcd)[1] = b;
+		((AVX2_WORD*)abcd)[2] = c;
+		((AVX2_WORD*)abcd)[3] = d;
+	}
+	return mask;
+}
+#ifdef _M_X64
+PRIVATE HS_TARGET("avx512f") uint32_t dcc_salts_part_avx512(const AVX512_WORD* salts, const uint32_t* crypt_result, uint32_t* abcd)
+{
+	SALTS_PART_BODY(AVX512);
+
+	uint32_t mask = _mm512_cmpeq_epi32_mask(d, salts[SALTS_ROW_BIN3]);
+	if (mask)
+	{
+		((AVX512_WORD*)abcd)[0] = a;
+		((AVX512_WORD*)abcd)[1] = b;
+		((AVX512_WORD*)abcd)[2] = c;
+		((AVX512_WORD*)abcd)[3] = d;
+	}
+	return mask;
+}
+PRIVATE void crypt_ntlm_protocol_salts_avx512(CryptParam* param)
+{
+	if (num_diff_salts >= SALT_MAJOR_MIN_SALTS)
+		crypt_ntlm_protocol_salts_body(param, 16, (dcc_salts_part_func*)dcc_salts_part_avx512, crypt_ntlm_protocol_avx2);
+	else
+		crypt_ntlm_protocol_avx2(param);
+}
+#endif
+PRIVATE void crypt_ntlm_protocol_salts_avx2(CryptParam* param)
+{
+	if (num_diff_salts >= SALT_MAJOR_MIN_SALTS)
+		crypt_ntlm_protocol_salts_body(param, 8, (dcc_salts_part_func*)dcc_salts_part_avx2, crypt_ntlm_protocol_avx2);
+	else
+		crypt_ntlm_protocol_avx2(param);
+}
+PRIVATE void crypt_ntlm_protocol_salts_sse2(CryptParam* param)
+{
+	if (num_diff_salts >= SALT_MAJOR_MIN_SALTS)
+		crypt_ntlm_protocol_salts_body(param, 4, (dcc_salts_part_func*)dcc_salts_part_sse2, crypt_ntlm_protocol_sse2);
+	else
+		crypt_ntlm_protocol_sse2(param);
+}
+#ifdef HS_TESTING
+#define DCC_BENCH_MAX_SALTS		10000
+#define DCC_BENCH_KEY_LENGHT	10
+// Work of each measure in (salt, key) pairs, the same for all numbers of salts
+#define DCC_BENCH_SALT_KEYS		(1 << 22)
+PRIVATE const struct {
+	uint32_t needed_cap;
+	uint32_t num_lanes;
+	dcc_salts_part_func* salts_part;
+	const char* name;
+} dcc_salts_engines[] = {
+	{ CPU_CAP_SSE2  ,  4, (dcc_salts_part_func*)dcc_salts_part_sse2  , "SSE2"    },
+	{ CPU_CAP_AVX2  ,  8, (dcc_salts_part_func*)dcc_salts_part_avx2  , "AVX2"    },
+#ifdef _M_X64
+	{ CPU_CAP_AVX512, 16, (dcc_salts_part_func*)dcc_salts_part_avx512, "AVX-512" },
+#endif
+};
+// The hash of each salt is of the key with the same index
+PRIVATE const char* dcc_bench_keys;
+PRIVATE uint32_t dcc_bench_found, dcc_bench_wrong;
+PRIVATE void dcc_bench_password_found(uint32_t index, unsigned char* cleartext)
+{
+	if (strcmp((const char*)cleartext, dcc_bench_keys + index * (DCC_BENCH_KEY_LENGHT + 1)))
+		dcc_bench_wrong++;
+	else
+		dcc_bench_found++;
+}
+// Keys/s of the key-major SSE2 code and the salt-major engines from 1 to DCC_BENCH_MAX_SALTS salts
+PUBLIC int bench_dcc_salts_major()
+{
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * sizeof(uint32_t) * NT_NUM_KEYS, 32);
+	uint32_t* crypt_result = (uint32_t*)_aligned_malloc(4 * sizeof(uint32_t) * 12, 32);
+	uint32_t* abcd = (uint32_t*)_aligned_malloc(4 * sizeof(uint32_t) * 16, 64);
+	char* keys = (char*)malloc(DCC_BENCH_MAX_SALTS * (DCC_BENCH_KEY_LENGHT + 1));
+	uint32_t* bench_salts = (uint32_t*)malloc(DCC_BENCH_MAX_SALTS * SALT_SIZE);
+	uint32_t* bench_binaries = (uint32_t*)malloc(DCC_BENCH_MAX_SALTS * BINARY_SIZE);
+	unsigned char key[MAX_KEY_LENGHT_SMALL];
+	dcc_salt_part_func* dcc_salt_parts[28];
+	int result = TRUE;
+
+	if (!nt_buffer || !crypt_result || !abcd || !keys || !bench_salts || !bench_binaries)
+	{
+		hs_log(HS_LOG_ERROR, "Test Suite", "DCC salt-major benchmark: not enough memory");
+		if (nt_buffer) _aligned_free(nt_buffer);
+		if (crypt_result) _aligned_free(crypt_result);
+		if (abcd) _aligned_free(abcd);
+		free(keys);
+		free(bench_salts);
+		free(bench_binaries);
+		return FALSE;
+	}
+
+	// Save the attack state
+	void* old_salts_values = salts_values;
+	void* old_binary_values = binary_values;
+	uint32_t old_num_diff_salts = num_diff_salts;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+
+	// One hash by salt, all with different keys
+	for (uint32_t i = 0; i < DCC_BENCH_MAX_SALTS; i++)
+	{
+		char hash[64];
+		char* salt_key = keys + i * (DCC_BENCH_KEY_LENGHT + 1);
+
+		generate_random((uint8_t*)salt_key, DCC_BENCH_KEY_LENGHT);
+		for (uint32_t j = 0; j < DCC_BENCH_KEY_LENGHT; j++)
+			salt_key[j] = 'a' + ((uint8_t)salt_key[j]) % 26;
+		salt_key[DCC_BENCH_KEY_LENGHT] = 0;
+
+		hash_dcc((const unsigned char*)salt_key, hash);
+		get_binary((const unsigned char*)hash, bench_binaries + i * 4, bench_salts + i * 11);
+	}
+	dcc_bench_keys = keys;
+	salts_values = bench_salts;
+	binary_values = bench_binaries;
+	for (int i = 0; i < LENGTH(dcc_salt_parts); i++)
+		dcc_salt_parts[i] = (dcc_salt_part_func*)dcc_salt_part_sse2;
+
+	for (uint32_t num_salts = 1; num_salts <= DCC_BENCH_MAX_SALTS; num_salts *= 10)
+	{
+		uint32_t num_passes = __max(1, DCC_BENCH_SALT_KEYS / (num_salts * NT_NUM_KEYS));
+		uint32_t num_found_by_pass = __min(num_salts, NT_NUM_KEYS);
+		num_diff_salts = num_passwords_loaded = num_salts;
+
+		// Keys spread over the salts. With less salts than keys, the others don't match
+		memset(nt_buffer, 0, 16 * sizeof(uint32_t) * NT_NUM_KEYS);
+		for (uint32_t k = 0; k < NT_NUM_KEYS; k++)
+		{
+			const unsigned char* nt_key = key;
+			if (k < num_found_by_pass)
+				nt_key = (const unsigned char*)keys + (k * num_salts / num_found_by_pass) * (DCC_BENCH_KEY_LENGHT + 1);
+			else
+			{
+				generate_random(key, DCC_BENCH_KEY_LENGHT);
+				for (uint32_t j = 0; j < DCC_BENCH_KEY_LENGHT; j++)
+					key[j] = 'A' + key[j] % 26;
+			}
+
+			uint32_t i = 0;
+			for (; i < DCC_BENCH_KEY_LENGHT / 2; i++)
+				nt_buffer[i * NT_NUM_KEYS + k] = nt_key[2 * i] | (nt_key[2 * i + 1] << 16);
+			nt_buffer[i * NT_NUM_KEYS + k] = 0x80;
+			nt_buffer[14 * NT_NUM_KEYS + k] = DCC_BENCH_KEY_LENGHT << 4;
+		}
+
+		// Key-major
+		dcc_bench_found = dcc_bench_wrong = 0;
+		int64_t start = get_milliseconds();
+		for (uint32_t pass = 0; pass < num_passes; pass++)
+			for (uint32_t i = 0; i < NT_NUM_KEYS / 4; i++)
+			{
+				dcc_ntlm_part_sse2((__m128i*)(nt_buffer + 4 * i), (__m128i*)crypt_result);
+				dcc_compare_key_major(nt_buffer, NT_NUM_KEYS, 4 * i, 4, dcc_salt_parts, crypt_result, key, dcc_bench_password_found);
+			}
+		int64_t ms = get_milliseconds() - start;
+		if (dcc_bench_wrong || dcc_bench_found != num_found_by_pass * num_passes)
+		{
+			hs_log(HS_LOG_ERROR, "Test Suite", "DCC key-major SSE2 fails with %u salts", num_salts);
+			result = FALSE;
+		}
+		hs_log(HS_LOG_INFO, "Test Suite", "DCC %u salts, key-major SSE2: %.0f keys/s", num_salts, num_passes * NT_NUM_KEYS * 1000. / __max(ms, 1));
+
+		// Salt-major
+		for (uint32_t e = 0; e < LENGTH(dcc_salts_engines); e++)
+			if (current_cpu.capabilites[dcc_salts_engines[e].needed_cap])
+			{
+				uint32_t num_groups;
+				uint32_t* salts = create_salts_major(dcc_salts_engines[e].num_lanes, &num_groups);
+				if (!salts)
+				{
+					hs_log(HS_LOG_ERROR, "Test Suite", "DCC salt-major benchmark: not enough memory");
+					result = FALSE;
+					continue;
+				}
+
+				dcc_bench_found = dcc_bench_wrong = 0;
+				start = get_milliseconds();
+				for (uint32_t pass = 0; pass < num_passes; pass++)
+					for (uint32_t i = 0; i < NT_NUM_KEYS / 4; i++)
+					{
+						dcc_ntlm_part_sse2((__m128i*)(nt_buffer + 4 * i), (__m128i*)crypt_result);
+						dcc_compare_salts_major(salts, num_groups, dcc_salts_engines[e].num_lanes, dcc_salts_engines[e].salts_part, crypt_result, abcd, nt_buffer, 4 * i, key, dcc_bench_password_found);
+					}
+				ms = get_milliseconds() - start;
+				_aligned_free(salts);
+
+				if (dcc_bench_wrong || dcc_bench_found != num_found_by_pass * num_passes)
+				{
+					hs_log(HS_LOG_ERROR, "Test Suite", "DCC salt-major %s fails with %u salts", dcc_salts_engines[e].name, num_salts);
+					result = FALSE;
+				}
+				hs_log(HS_LOG_INFO, "Test Suite", "DCC %u salts, salt-major %s: %.0f keys/s", num_salts, dcc_salts_engines[e].name, num_passes * NT_NUM_KEYS * 1000. / __max(ms, 1));
+			}
+	}
+
+	// Restore the attack state
+	salts_values = old_salts_values;
+	binary_values = old_binary_values;
+	num_diff_salts = old_num_diff_salts;
+	num_passwords_loaded = old_num_passwords_loaded;
+
+	_aligned_free(nt_buffer);
+	_aligned_free(crypt_result);
+	_aligned_free(abcd);
+	free(keys);
+	free(bench_salts);
+	free(bench_binaries);
+	return result;
+}
+#endif
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementation
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2308,12 +2789,12 @@ Format dcc_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_avx512}, {CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_sse2}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_salts_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#endif
 #endif
 
@@ -429,10 +429,126 @@ PUBLIC void sha1_process_sha1_sse2(const __m128i* state, __m128i* sha1_hash, __m
     sha1_hash[4] = SSE2_ADD(state[4], E);
 }
 
+// PBKDF2 cycle for the 4 keys of a SSE2 group: sha1_hash have the first iteration result
+PUBLIC void pbkdf2_sha1_sse2(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations)
+{
+	for (uint32_t k = 1; k < num_iterations; k++)
+	{
+		sha1_process_sha1_sse2(ipad_state, sha1_hash, W);
+		sha1_process_sha1_sse2(opad_state, sha1_hash, W);
+
+		for (uint32_t i = 0; i < num_words; i++)
+			crypt_result[i] = SSE2_XOR(crypt_result[i], sha1_hash[i]);
+	}
+}
+
+// SHA-NI: one key by register and the 4 keys interleaved to hide the latency of the sha1 instructions.
+// The message is always the 20 bytes hash of the previous HMAC: ABCD of the last hash is directly the first
+// 4 message words (the instructions use the big-endian order with A in the upper element).
+#include <immintrin.h>
+
+#define SHA_NI_KEYS		4
+#define SHA_NI_FOR_KEYS(code)					for (int k = 0; k < SHA_NI_KEYS; k++) { code }
+#define SHA_NI_ROUNDS(E_IN, E_OUT, MSG, FUNC)	E_IN[k] = _mm_sha1nexte_epu32(E_IN[k], MSG[k]); E_OUT[k] = abcd[k]; abcd[k] = _mm_sha1rnds4_epu32(abcd[k], E_IN[k], FUNC);
+#define SHA_NI_MSG1(M0, M1)						M0[k] = _mm_sha1msg1_epu32(M0[k], M1[k]);
+#define SHA_NI_MSG2(M0, M1)						M0[k] = _mm_sha1msg2_epu32(M0[k], M1[k]);
+#define SHA_NI_XOR(M0, M1)						M0[k] = _mm_xor_si128(M0[k], M1[k]);
+// 4 rounds calculating message words 16-79
+#define SHA_NI_STEP(E_IN, E_OUT, M0, M1, M2, M3, FUNC) SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(E_IN, E_OUT, M0, FUNC) SHA_NI_MSG2(M1, M0) SHA_NI_MSG1(M3, M0) SHA_NI_XOR(M2, M0))
+
+PRIVATE HS_TARGET("sha") void sha1_process_sha1_sha_ni(const __m128i* state_abcd, const __m128i* state_e, __m128i* hash_abcd, __m128i* hash_e)
+{
+	__m128i abcd[SHA_NI_KEYS], e0[SHA_NI_KEYS], e1[SHA_NI_KEYS];
+	__m128i msg0[SHA_NI_KEYS], msg1[SHA_NI_KEYS], msg2[SHA_NI_KEYS], msg3[SHA_NI_KEYS];
+
+	SHA_NI_FOR_KEYS(
+		msg0[k] = hash_abcd[k];
+		msg1[k] = _mm_or_si128(hash_e[k], _mm_set_epi32(0, 0x80000000, 0, 0));
+		msg2[k] = _mm_setzero_si128();
+		msg3[k] = _mm_set_epi32(0, 0, 0, (64 + 20) << 3);
+
+		e0[k] = _mm_add_epi32(state_e[k], msg0[k]);
+		e1[k] = state_abcd[k];
+		abcd[k] = _mm_sha1rnds4_epu32(state_abcd[k], e0[k], 0);
+	)
+	SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(e1, e0, msg1, 0) SHA_NI_MSG1(msg0, msg1))
+	SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(e0, e1, msg2, 0) SHA_NI_MSG1(msg1, msg2) SHA_NI_XOR(msg0, msg2))
+	SHA_NI_STEP(e1, e0, msg3, msg0, msg1, msg2, 0)
+	SHA_NI_STEP(e0, e1, msg0, msg1, msg2, msg3, 0)
+	SHA_NI_STEP(e1, e0, msg1, msg2, msg3, msg0, 1)
+	SHA_NI_STEP(e0, e1, msg2, msg3, msg0, msg1, 1)
+	SHA_NI_STEP(e1, e0, msg3, msg0, msg1, msg2, 1)
+	SHA_NI_STEP(e0, e1, msg0, msg1, msg2, msg3, 1)
+	SHA_NI_STEP(e1, e0, msg1, msg2, msg3, msg0, 1)
+	SHA_NI_STEP(e0, e1, msg2, msg3, msg0, msg1, 2)
+	SHA_NI_STEP(e1, e0, msg3, msg0, msg1, msg2, 2)
+	SHA_NI_STEP(e0, e1, msg0, msg1, msg2, msg3, 2)
+	SHA_NI_STEP(e1, e0, msg1, msg2, msg3, msg0, 2)
+	SHA_NI_STEP(e0, e1, msg2, msg3, msg0, msg1, 2)
+	SHA_NI_STEP(e1, e0, msg3, msg0, msg1, msg2, 3)
+	SHA_NI_STEP(e0, e1, msg0, msg1, msg2, msg3, 3)
+	SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(e1, e0, msg1, 3) SHA_NI_MSG2(msg2, msg1) SHA_NI_XOR(msg3, msg1))
+	SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(e0, e1, msg2, 3) SHA_NI_MSG2(msg3, msg2))
+	SHA_NI_FOR_KEYS(SHA_NI_ROUNDS(e1, e0, msg3, 3))
+
+	SHA_NI_FOR_KEYS(
+		hash_e[k] = _mm_sha1nexte_epu32(e0[k], state_e[k]);
+		hash_abcd[k] = _mm_add_epi32(abcd[k], state_abcd[k]);
+	)
+}
+// Same as pbkdf2_sha1_sse2 but with the SHA extensions
+PUBLIC HS_TARGET("sha") void pbkdf2_sha1_sha_ni(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations)
+{
+	__m128i ipad_abcd[SHA_NI_KEYS], ipad_e[SHA_NI_KEYS], opad_abcd[SHA_NI_KEYS], opad_e[SHA_NI_KEYS];
+	__m128i hash_abcd[SHA_NI_KEYS], hash_e[SHA_NI_KEYS], result_abcd[SHA_NI_KEYS], result_e[SHA_NI_KEYS];
+
+	// From SSE2 layout to one key by register
+	for (int k = 0; k < SHA_NI_KEYS; k++)
+	{
+		const uint32_t* ipad = (const uint32_t*)ipad_state;
+		const uint32_t* opad = (const uint32_t*)opad_state;
+		const uint32_t* hash = (const uint32_t*)sha1_hash;
+
+		ipad_abcd[k] = _mm_set_epi32(ipad[0 * 4 + k], ipad[1 * 4 + k], ipad[2 * 4 + k], ipad[3 * 4 + k]);
+		ipad_e[k]    = _mm_set_epi32(ipad[4 * 4 + k], 0, 0, 0);
+		opad_abcd[k] = _mm_set_epi32(opad[0 * 4 + k], opad[1 * 4 + k], opad[2 * 4 + k], opad[3 * 4 + k]);
+		opad_e[k]    = _mm_set_epi32(opad[4 * 4 + k], 0, 0, 0);
+		hash_abcd[k] = _mm_set_epi32(hash[0 * 4 + k], hash[1 * 4 + k], hash[2 * 4 + k], hash[3 * 4 + k]);
+		hash_e[k]    = _mm_set_epi32(hash[4 * 4 + k], 0, 0, 0);
+
+		result_abcd[k] = hash_abcd[k];
+		result_e[k]    = hash_e[k];
+	}
+
+	for (uint32_t i = 1; i < num_iterations; i++)
+	{
+		sha1_process_sha1_sha_ni(ipad_abcd, ipad_e, hash_abcd, hash_e);
+		sha1_process_sha1_sha_ni(opad_abcd, opad_e, hash_abcd, hash_e);
+
+		SHA_NI_FOR_KEYS(
+			result_abcd[k] = _mm_xor_si128(result_abcd[k], hash_abcd[k]);
+			result_e[k]    = _mm_xor_si128(result_e[k], hash_e[k]);
+		)
+	}
+
+	// Back to SSE2 layout
+	for (int k = 0; k < SHA_NI_KEYS; k++)
+	{
+		const uint32_t* abcd = (const uint32_t*)(result_abcd + k);
+
+		for (uint32_t i = 0; i < 4 && i < num_words; i++)
+			((uint32_t*)(crypt_result + i))[k] = abcd[3 - i];
+		if (num_words > 4)
+			((uint32_t*)(crypt_result + 4))[k] = ((const uint32_t*)(result_e + k))[3];
+	}
+}
+
+
+typedef void pbkdf2_sha1_func(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
 void dcc_ntlm_part_sse2(__m128i* nt_buffer, __m128i* crypt_result);
 void dcc_salt_part_sse2(uint32_t* salt_buffer, __m128i* crypt_result);
 
-PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
+PRIVATE void crypt_ntlm_protocol_sse2_body(CryptParam* param, pbkdf2_sha1_func* pbkdf2_sha1)
 {
 	__m128i* nt_buffer = (__m128i*)_aligned_malloc(16*4*NT_NUM_KEYS, 16);
 	unsigned char* key = (unsigned char*)calloc(MAX_KEY_LENGHT_SMALL, sizeof(unsigned char));
@@ -465,17 +581,7 @@ PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
 				crypt_result[(8 + 2)*1 + 0] = sha1_hash[2];
 				crypt_result[(8 + 3)*1 + 0] = sha1_hash[3];
 
-				for(uint32_t k = 1; k < 10240; k++)
-				{
-					sha1_process_sha1_sse2( ipad_state, sha1_hash, W);
-					sha1_process_sha1_sse2( opad_state, sha1_hash, W);
-
-					// Only XOR first 16 bytes, since that is ALL this format uses
-					crypt_result[8+0] = SSE2_XOR(crypt_result[8+0], sha1_hash[0]);
-					crypt_result[8+1] = SSE2_XOR(crypt_result[8+1], sha1_hash[1]);
-					crypt_result[8+2] = SSE2_XOR(crypt_result[8+2], sha1_hash[2]);
-					crypt_result[8+3] = SSE2_XOR(crypt_result[8+3], sha1_hash[3]);
-				}
+				pbkdf2_sha1(ipad_state, opad_state, sha1_hash, crypt_result + 8, W, 4, 10240);
 
 				// Search for a match
 				for (uint32_t k = 0; k < 4; k++)
@@ -505,6 +611,14 @@ PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
 	_aligned_free(crypt_result);
 	finish_thread();
 }
+PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
+{
+	crypt_ntlm_protocol_sse2_body(param, pbkdf2_sha1_sse2);
+}
+PRIVATE void crypt_ntlm_protocol_sha_ni(CryptParam* param)
+{
+	crypt_ntlm_protocol_sse2_body(param, pbkdf2_sha1_sha_ni);
+}
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -635,14 +749,6 @@ void dcc_ntlm_part_avx2(void* nt_buffer, void* crypt_result);
 void dcc_salt_part_avx2(void* salt_buffer, void* crypt_result);
 void sha1_process_sha1_avx2(const void* state, void* sha1_hash, void* W);
 
-#define AVX2_AND(a,b)		_mm256_and_si256(a,b)
-#define AVX2_XOR(a,b)		_mm256_xor_si256(a,b)
-#define AVX2_ADD(a,b)		_mm256_add_epi32(a,b)
-#define AVX2_ROTATE(a,rot)	AVX2_XOR(_mm256_slli_epi32(a,rot), _mm256_srli_epi32(a,32-rot))
-#define AVX2_4ADD(a,b,c,d)	AVX2_ADD(AVX2_ADD(a,b), AVX2_ADD(c,d))
-#define AVX2_3ADD(a,b,c)	AVX2_ADD(AVX2_ADD(a,b), c)
-#define AVX2_3XOR(a,b,c)	AVX2_XOR(AVX2_XOR(a,b), c)
-
 #define LOAD_BIG_ENDIAN_AVX2(x) x = AVX2_XOR(_mm256_slli_epi32(x, 16), _mm256_srli_epi32(x, 16)); x = AVX2_ADD(_mm256_slli_epi32(AVX2_AND(x, _mm256_broadcastd_epi32(_mm_set1_epi32(0x00FF00FF))), 8), AVX2_AND(_mm256_srli_epi32(x, 8), _mm256_broadcastd_epi32(_mm_set1_epi32(0x00FF00FF))));
 
 PRIVATE void dcc2_body_avx2(__m256i* crypt_result, uint32_t* salt_buffer, int index)
@@ -1786,12 +1892,12 @@ Format dcc2_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}},
+	{{CPU_CAP_SHA, PROTOCOL_NTLM, crypt_ntlm_protocol_sha_ni}, {CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_SHA, PROTOCOL_NTLM, crypt_ntlm_protocol_sha_ni}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#endif
 #endif
 
@@ -1234,9 +1234,9 @@ PRIVATE void convert_key_to_input_v128(uint32_t* keys_ptr, V128_WORD* transpose_
 
 PRIVATE void crypt_lm_body(CryptParam* param, lm_eval_kernel_func* lm_eval_kernel, calculate_hash_func* calculate_hash, calculate_lm_indexs_func* calculate_lm_indexs, int is_utf8)
 {
-	V128_WORD* lm_buffer_key	= (V128_WORD*)_aligned_malloc(56 * sizeof(V128_WORD)*MAX_REPEAT, 32);
-	V128_WORD* lm_buffer_crypt	= (V128_WORD*)_aligned_malloc(64 * sizeof(V128_WORD)*MAX_REPEAT, 32);
-	V128_WORD* tmp_stor			= (V128_WORD*)_aligned_malloc(8 * sizeof(V128_WORD), 32);
+	V128_WORD* lm_buffer_key	= (V128_WORD*)_aligned_malloc(56 * sizeof(V128_WORD)*MAX_REPEAT, 64);
+	V128_WORD* lm_buffer_crypt	= (V128_WORD*)_aligned_malloc(64 * sizeof(V128_WORD)*MAX_REPEAT, 64);
+	V128_WORD* tmp_stor			= (V128_WORD*)_aligned_malloc(8 * sizeof(V128_WORD), 64);
 
 	unsigned char* keys = (unsigned char*)lm_buffer_key;
 	if (is_utf8)
@@ -1267,6 +1267,22 @@ PRIVATE void crypt_lm_body(CryptParam* param, lm_eval_kernel_func* lm_eval_kerne
 	finish_thread();
 }
 
+PRIVATE void calculate_lm_indexs_c(uint32_t* hash_values, uint32_t* indexs)
+{
+	for(uint32_t j4 = 0; j4 < V128_BIT_LENGHT*MAX_REPEAT/4; j4++)
+	{
+		uint32_t val4 = 0;
+
+		for (int i = 0; i < 4; i++)
+		{
+			uint32_t val = hash_values[j4*4+i] & size_bit_table;
+			val4 += ((bit_table[val >> 5] >> (val & 31)) & 1) << (8*i);
+		}
+
+		indexs[j4] = val4;
+	}
+}
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Neon Implementation
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1823,30 +1839,14 @@ void s8_sse2(V128_WORD a0, V128_WORD a1, V128_WORD a2, V128_WORD a3, V128_WORD a
 	//{out0, op_xor, q4, out0, a4}
 }
 
-PRIVATE void calculate_lm_indexs_neon(uint32_t* hash_values, uint32_t* indexs)
-{
-	for(uint32_t j4 = 0; j4 < V128_BIT_LENGHT*MAX_REPEAT/4; j4++)
-	{
-		uint32_t val4 = 0;
-
-		for (int i = 0; i < 4; i++)
-		{
-			uint32_t val = hash_values[j4*4+i] & size_bit_table;
-			val4 += ((bit_table[val >> 5] >> (val & 31)) & 1) << (8*i);
-		}
-
-		indexs[j4] = val4;
-	}
-}
-
 void lm_eval_neon_kernel(void* lm_buffer_key, void* lm_buffer_crypt, void* tmp_stor);
 PRIVATE void crypt_utf8_lm_protocol_neon(CryptParam* param)
 {
-	crypt_lm_body(param, lm_eval_neon_kernel, calculate_hash_v128, calculate_lm_indexs_neon, TRUE);
+	crypt_lm_body(param, lm_eval_neon_kernel, calculate_hash_v128, calculate_lm_indexs_c, TRUE);
 }
 PRIVATE void crypt_fast_lm_protocol_neon(CryptParam* param)
 {
-	crypt_lm_body(param, lm_eval_neon_kernel, calculate_hash_v128, calculate_lm_indexs_neon, FALSE);
+	crypt_lm_body(param, lm_eval_neon_kernel, calculate_hash_v128, calculate_lm_indexs_c, FALSE);
 }
 #endif
 
@@ -2423,6 +2423,526 @@ PRIVATE void crypt_fast_lm_protocol_avx2(CryptParam* param)
 {
 	crypt_lm_body(param, lm_eval_avx2_kernel, calculate_hash_avx, calculate_lm_indexs_avx, FALSE);
 }
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 Implementation
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Same bit layout as V128: the MAX_REPEAT words of each bit are MAX_REPEAT/4 AVX512 words
+#define MAX_REPEAT_AVX512	(MAX_REPEAT/4)
+#define REPEAT_AVX512		for(repeat=0;repeat<MAX_REPEAT_AVX512;repeat++,c++,k++)
+
+// Sboxs using lop3 (the ones of OpenCL): each gate is one vpternlogd
+PRIVATE HS_TARGET("avx512f") void s1_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8, x9;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a3, a5, 0xC1);
+	x1 = _mm512_ternarylogic_epi32(a2, a5, x0, 0x9E);
+	x2 = _mm512_ternarylogic_epi32(a0, a2, a5, 0xD6);
+	x3 = _mm512_ternarylogic_epi32(a3, x0, x2, 0x56);
+	x4 = _mm512_ternarylogic_epi32(a1, x1, x3, 0x6C);
+	x5 = _mm512_ternarylogic_epi32(a5, x0, x2, 0x7B);
+	x5 = _mm512_ternarylogic_epi32(a1, x3, x5, 0xD6);
+	x7 = _mm512_ternarylogic_epi32(a4, x4, x5, 0x6A);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x7);
+	x6 = _mm512_ternarylogic_epi32(a0, a1, a3, 0x7A);
+	x3 = _mm512_ternarylogic_epi32(a1, a5, x3, 0xC9);
+	x7 = _mm512_ternarylogic_epi32(x4, x6, x3, 0x72);
+	x8 = _mm512_ternarylogic_epi32(a2, a5, x6, 0x29);
+	x9 = _mm512_ternarylogic_epi32(a1, x4, x8, 0x95);
+	a3 = _mm512_ternarylogic_epi32(a4, x7, x9, 0xC6);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], a3);
+	x7 = _mm512_ternarylogic_epi32(a0, a1, x7, 0xD2);
+	x6 = _mm512_ternarylogic_epi32(x4, x6, x3, 0x90);
+	a3 = _mm512_ternarylogic_epi32(x8, x7, x6, 0x76);
+	x7 = _mm512_ternarylogic_epi32(a2, x0, x7, 0x80);
+	x5 = _mm512_ternarylogic_epi32(x5, x9, x7, 0xA6);
+	x5 = _mm512_ternarylogic_epi32(a4, a3, x5, 0xA6);
+	x0 = _mm512_ternarylogic_epi32(a0, x0, x4, 0x21);
+	x0 = _mm512_ternarylogic_epi32(x1, x6, x0, 0x6A);
+	x4 = _mm512_ternarylogic_epi32(a0, a5, x3, 0x70);
+	x4 = _mm512_ternarylogic_epi32(x2, x8, x4, 0x97);
+	x0 = _mm512_ternarylogic_epi32(a4, x0, x4, 0x6C);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x0);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x5);
+}
+
+PRIVATE HS_TARGET("avx512f") void s2_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a1, a5, 0x97);
+	x1 = _mm512_ternarylogic_epi32(a4, a5, x0, 0x67);
+	x2 = _mm512_ternarylogic_epi32(a0, a4, a5, 0x76);
+	x3 = _mm512_ternarylogic_epi32(a1, x1, x2, 0x69);
+	x4 = _mm512_ternarylogic_epi32(a2, x1, x3, 0x6A);
+	x5 = _mm512_ternarylogic_epi32(a1, a2, a4, 0x65);
+	x0 = _mm512_ternarylogic_epi32(a2, x0, x2, 0x8D);
+	x2 = _mm512_ternarylogic_epi32(a0, x5, x0, 0xCA);
+	x7 = _mm512_ternarylogic_epi32(a3, x4, x2, 0xC6);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x7);
+	x6 = _mm512_ternarylogic_epi32(a1, a4, a5, 0x14);
+	x7 = _mm512_ternarylogic_epi32(a4, x0, x6, 0xB5);
+	x8 = _mm512_ternarylogic_epi32(a2, a5, x1, 0x1C);
+	x8 = _mm512_ternarylogic_epi32(a0, x5, x8, 0x96);
+	x7 = _mm512_ternarylogic_epi32(a3, x7, x8, 0x6A);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x7);
+	x5 = _mm512_ternarylogic_epi32(a0, a1, x3, 0xDE);
+	x7 = _mm512_ternarylogic_epi32(a0, a2, x0, 0x90);
+	x3 = _mm512_ternarylogic_epi32(x4, x8, x5, 0x79);
+	x4 = _mm512_ternarylogic_epi32(a4, x7, x3, 0x29);
+	x5 = _mm512_ternarylogic_epi32(a3, x5, x4, 0xA6);
+	x0 = _mm512_ternarylogic_epi32(a0, a0, x0, 0x4A);
+	x6 = _mm512_ternarylogic_epi32(a1, x6, x8, 0xEF);
+	x0 = _mm512_ternarylogic_epi32(x2, x0, x6, 0x8D);
+	x1 = _mm512_ternarylogic_epi32(a1, a4, x1, 0x2B);
+	x0 = _mm512_ternarylogic_epi32(a3, x0, x1, 0x6C);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x5);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x0);
+}
+
+PRIVATE HS_TARGET("avx512f") void s3_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a2, a3, 0xC9);
+	x1 = _mm512_ternarylogic_epi32(a2, a4, a5, 0x4B);
+	x2 = _mm512_ternarylogic_epi32(a0, x0, x1, 0x4D);
+	x1 = _mm512_ternarylogic_epi32(a0, a3, x1, 0x69);
+	x3 = _mm512_ternarylogic_epi32(a2, a4, x0, 0xD6);
+	x4 = _mm512_ternarylogic_epi32(a5, x1, x3, 0x9C);
+	x2 = _mm512_ternarylogic_epi32(a1, x2, x4, 0xA6);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x2);
+	x2 = _mm512_ternarylogic_epi32(a0, a3, a5, 0x49);
+	x5 = _mm512_ternarylogic_epi32(a0, a4, x0, 0x9B);
+	x6 = AVX512_XOR(x2, x5);
+	x7 = _mm512_ternarylogic_epi32(a0, a2, a5, 0x6F);
+	x8 = _mm512_ternarylogic_epi32(a3, x6, x7, 0xEB);
+	x8 = _mm512_ternarylogic_epi32(a1, x6, x8, 0x6C);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x8);
+	x6 = _mm512_ternarylogic_epi32(a0, a2, a3, 0x98);
+	x8 = _mm512_ternarylogic_epi32(x4, x2, x7, 0x1D);
+	x6 = _mm512_ternarylogic_epi32(a5, x6, x8, 0x9A);
+	x4 = _mm512_ternarylogic_epi32(a0, a3, x3, 0xB2);
+	x2 = _mm512_ternarylogic_epi32(a4, x0, x1, 0x3D);
+	x2 = _mm512_ternarylogic_epi32(a5, x4, x2, 0xA6);
+	x2 = _mm512_ternarylogic_epi32(a1, x6, x2, 0xA6);
+	x0 = _mm512_ternarylogic_epi32(a0, a2, a5, 0xC6);
+	x1 = _mm512_ternarylogic_epi32(x1, x7, x0, 0xDB);
+	x5 = _mm512_ternarylogic_epi32(a4, x5, x8, 0xB9);
+	x6 = _mm512_ternarylogic_epi32(x6, x0, x5, 0x9B);
+	x6 = _mm512_ternarylogic_epi32(a1, x1, x6, 0xA6);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x6);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x2);
+}
+
+PRIVATE HS_TARGET("avx512f") void s4_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a2, a3, 0x72);
+	x1 = _mm512_ternarylogic_epi32(a2, a4, x0, 0xAD);
+	x2 = _mm512_ternarylogic_epi32(a0, a2, a3, 0x59);
+	x3 = _mm512_ternarylogic_epi32(a2, a4, x2, 0xE7);
+	x1 = _mm512_ternarylogic_epi32(a1, x1, x3, 0xC6);
+	x4 = _mm512_ternarylogic_epi32(a0, a1, a4, 0x69);
+	x0 = _mm512_ternarylogic_epi32(a1, a3, x0, 0x18);
+	x0 = _mm512_ternarylogic_epi32(x3, x4, x0, 0x63);
+	x8 = _mm512_ternarylogic_epi32(a5, x1, x0, 0x6A);
+	x5 = _mm512_ternarylogic_epi32(a0, a1, a2, 0x12);
+	x6 = _mm512_ternarylogic_epi32(a0, a4, x3, 0x28);
+	x7 = _mm512_ternarylogic_epi32(x1, x5, x6, 0x1E);
+	x4 = _mm512_ternarylogic_epi32(a0, x4, x5, 0x14);
+	x5 = _mm512_ternarylogic_epi32(x2, x3, x0, 0x78);
+	x5 = _mm512_ternarylogic_epi32(x6, x4, x5, 0xD6);
+	x2 = _mm512_ternarylogic_epi32(a5, x7, x5, 0x6A);
+	x3 = _mm512_ternarylogic_epi32(a5, x7, x5, 0xA9);
+	x0 = _mm512_ternarylogic_epi32(a5, x1, x0, 0x56);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x3);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x2);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x0);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x8);
+}
+
+PRIVATE HS_TARGET("avx512f") void s5_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a2, a5, 0xAB);
+	x1 = _mm512_ternarylogic_epi32(a0, a4, a5, 0xB9);
+	x2 = _mm512_ternarylogic_epi32(a1, x0, x1, 0xE8);
+	x3 = _mm512_ternarylogic_epi32(a0, a2, x1, 0x34);
+	x4 = _mm512_ternarylogic_epi32(a0, a4, x2, 0xCE);
+	x5 = _mm512_ternarylogic_epi32(a1, x3, x4, 0x29);
+	x2 = _mm512_ternarylogic_epi32(a3, x2, x5, 0xA6);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x2);
+	x2 = _mm512_ternarylogic_epi32(a0, a2, a4, 0x49);
+	x6 = _mm512_ternarylogic_epi32(a1, a5, x2, 0x96);
+	x7 = _mm512_ternarylogic_epi32(a0, a1, a2, 0xCA);
+	x0 = _mm512_ternarylogic_epi32(a2, x0, x6, 0x7E);
+	x7 = _mm512_ternarylogic_epi32(x1, x7, x0, 0x96);
+	x7 = _mm512_ternarylogic_epi32(a3, x6, x7, 0xCA);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x7);
+	x7 = _mm512_ternarylogic_epi32(a0, a1, x1, 0xE5);
+	x3 = _mm512_ternarylogic_epi32(x3, x4, x6, 0x97);
+	x7 = _mm512_ternarylogic_epi32(x2, x7, x3, 0x47);
+	x8 = _mm512_ternarylogic_epi32(a2, x1, x2, 0x3B);
+	x3 = _mm512_ternarylogic_epi32(x6, x3, x8, 0xD9);
+	x7 = _mm512_ternarylogic_epi32(a3, x7, x3, 0xCA);
+	x1 = _mm512_ternarylogic_epi32(a0, a2, x1, 0xB1);
+	x2 = _mm512_ternarylogic_epi32(x4, x2, x6, 0x47);
+	x0 = _mm512_ternarylogic_epi32(x0, x1, x2, 0x6E);
+	x3 = _mm512_ternarylogic_epi32(a1, x4, x3, 0x94);
+	x5 = _mm512_ternarylogic_epi32(a0, x5, x3, 0xD9);
+	x0 = _mm512_ternarylogic_epi32(a3, x0, x5, 0xC6);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x7);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x0);
+}
+
+PRIVATE HS_TARGET("avx512f") void s6_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a2, a4, 0xB2);
+	x1 = AVX512_XOR(a1, x0);
+	x2 = _mm512_ternarylogic_epi32(a0, a0, a4, 0xA9);
+	x3 = _mm512_ternarylogic_epi32(a2, x1, x2, 0xA9);
+	x4 = _mm512_ternarylogic_epi32(a3, x1, x3, 0xC6);
+	x5 = _mm512_ternarylogic_epi32(a4, x1, x3, 0xAD);
+	x6 = _mm512_ternarylogic_epi32(a0, a3, x5, 0xE4);
+	x8 = _mm512_ternarylogic_epi32(a5, x4, x6, 0x6C);
+	x2 = _mm512_ternarylogic_epi32(a1, x2, x4, 0x20);
+	x7 = _mm512_ternarylogic_epi32(a2, a3, a4, 0x69);
+	x5 = _mm512_ternarylogic_epi32(x5, x2, x7, 0x9E);
+	x7 = _mm512_ternarylogic_epi32(a0, a1, x7, 0x49);
+	x7 = _mm512_ternarylogic_epi32(a4, x0, x7, 0x93);
+	x0 = _mm512_ternarylogic_epi32(a5, x5, x7, 0x6C);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x0);
+	x0 = _mm512_ternarylogic_epi32(a3, x4, x2, 0xA4);
+	x0 = _mm512_ternarylogic_epi32(a4, x5, x0, 0x76);
+	x4 = _mm512_ternarylogic_epi32(a2, a3, a4, 0xCD);
+	x4 = _mm512_ternarylogic_epi32(x3, x0, x4, 0x86);
+	x0 = _mm512_ternarylogic_epi32(a5, x0, x4, 0xA6);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x0);
+	x0 = _mm512_ternarylogic_epi32(a1, x8, x7, 0x2D);
+	x0 = _mm512_ternarylogic_epi32(x2, x5, x0, 0x26);
+	x1 = _mm512_ternarylogic_epi32(a2, x1, x6, 0x6B);
+	x1 = _mm512_ternarylogic_epi32(x3, x0, x1, 0xA2);
+	x0 = _mm512_ternarylogic_epi32(a5, x0, x1, 0xCA);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x0);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x8);
+}
+
+PRIVATE HS_TARGET("avx512f") void s7_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6, x7, x8;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a1, a3, 0x0B);
+	x1 = _mm512_ternarylogic_epi32(a0, a3, a4, 0x27);
+	x2 = _mm512_ternarylogic_epi32(a2, x0, x1, 0x9E);
+	x3 = _mm512_ternarylogic_epi32(a0, a2, a4, 0xA6);
+	x4 = _mm512_ternarylogic_epi32(a1, x2, x3, 0x6B);
+	x5 = _mm512_ternarylogic_epi32(a3, x0, x4, 0xA9);
+	x7 = _mm512_ternarylogic_epi32(a5, x2, x5, 0x6A);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x7);
+	x6 = _mm512_ternarylogic_epi32(a0, a1, a2, 0x63);
+	x7 = _mm512_ternarylogic_epi32(a1, x1, x3, 0xE7);
+	x8 = _mm512_ternarylogic_epi32(a3, x6, x7, 0x93);
+	x4 = _mm512_ternarylogic_epi32(a1, x4, x7, 0x5D);
+	x4 = _mm512_ternarylogic_epi32(a3, x3, x4, 0x6E);
+	x7 = _mm512_ternarylogic_epi32(a5, x8, x4, 0xC6);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x7);
+	x7 = _mm512_ternarylogic_epi32(a2, a3, x3, 0x6D);
+	x7 = _mm512_ternarylogic_epi32(a2, x6, x7, 0xA6);
+	x3 = _mm512_ternarylogic_epi32(a0, a1, a4, 0x23);
+	x6 = _mm512_ternarylogic_epi32(x5, x7, x3, 0x72);
+	x8 = _mm512_ternarylogic_epi32(a5, x7, x6, 0xAC);
+	x5 = _mm512_ternarylogic_epi32(a0, a2, a3, 0x21);
+	x1 = _mm512_ternarylogic_epi32(x1, x4, x6, 0xA4);
+	x1 = _mm512_ternarylogic_epi32(x3, x5, x1, 0x96);
+	x4 = _mm512_ternarylogic_epi32(x0, x7, x1, 0x3E);
+	x4 = _mm512_ternarylogic_epi32(x2, x6, x4, 0x6B);
+	x1 = _mm512_ternarylogic_epi32(a5, x1, x4, 0xC6);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x1);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x8);
+}
+
+PRIVATE HS_TARGET("avx512f") void s8_avx512f(AVX512_WORD a0, AVX512_WORD a1, AVX512_WORD a2, AVX512_WORD a3, AVX512_WORD a4, AVX512_WORD a5, AVX512_WORD* out)
+{
+	AVX512_WORD x0, x1, x2, x3, x4, x5, x6;
+
+	x0 = _mm512_ternarylogic_epi32(a0, a1, a4, 0x9D);
+	x1 = _mm512_ternarylogic_epi32(a0, a0, a1, 0x83);
+	x2 = _mm512_ternarylogic_epi32(a0, a1, a4, 0x5B);
+	x3 = _mm512_ternarylogic_epi32(a2, x1, x2, 0x85);
+	x0 = _mm512_ternarylogic_epi32(a3, x0, x3, 0xA6);
+	x4 = _mm512_ternarylogic_epi32(a1, a4, x0, 0xF9);
+	x5 = _mm512_ternarylogic_epi32(a3, a4, x3, 0x0E);
+	x5 = _mm512_ternarylogic_epi32(x1, x4, x5, 0x61);
+	x5 = _mm512_ternarylogic_epi32(a5, x0, x5, 0x6C);
+	out[3*MAX_REPEAT_AVX512] = AVX512_XOR(out[3*MAX_REPEAT_AVX512], x5);
+	x5 = _mm512_ternarylogic_epi32(a0, a1, a2, 0xDF);
+	x6 = _mm512_ternarylogic_epi32(a1, a4, x0, 0xD4);
+	x6 = _mm512_ternarylogic_epi32(a3, x5, x6, 0x69);
+	x5 = _mm512_ternarylogic_epi32(a0, x3, x6, 0x6F);
+	x3 = _mm512_ternarylogic_epi32(a2, x1, x5, 0xB9);
+	x3 = _mm512_ternarylogic_epi32(a5, x6, x3, 0xC6);
+	out[1*MAX_REPEAT_AVX512] = AVX512_XOR(out[1*MAX_REPEAT_AVX512], x3);
+	x3 = _mm512_ternarylogic_epi32(a1, x2, x6, 0x5C);
+	x3 = _mm512_ternarylogic_epi32(a0, x0, x3, 0x71);
+	x1 = _mm512_ternarylogic_epi32(a3, x1, x2, 0xB9);
+	x2 = _mm512_ternarylogic_epi32(x4, x6, x1, 0x69);
+	x3 = _mm512_ternarylogic_epi32(a5, x3, x2, 0x6A);
+	x2 = _mm512_ternarylogic_epi32(a0, a3, x1, 0xE2);
+	x2 = _mm512_ternarylogic_epi32(x4, x5, x2, 0x9C);
+	x2 = _mm512_ternarylogic_epi32(a5, x0, x2, 0x39);
+	out[0*MAX_REPEAT_AVX512] = AVX512_XOR(out[0*MAX_REPEAT_AVX512], x2);
+	out[2*MAX_REPEAT_AVX512] = AVX512_XOR(out[2*MAX_REPEAT_AVX512], x3);
+}
+
+
+PRIVATE HS_TARGET("avx512f") void lm_eval_avx512_kernel(void* lm_buffer_key, void* lm_buffer_crypt, void* tmp_stor)
+{
+	AVX512_WORD* first_c = (AVX512_WORD*)lm_buffer_crypt;
+	AVX512_WORD* first_k = (AVX512_WORD*)lm_buffer_key;
+	AVX512_WORD* c = first_c;
+	AVX512_WORD* k = first_k;
+	uint32_t repeat;
+
+	for(repeat = 0; repeat < MAX_REPEAT_AVX512; repeat++,c++)
+	{
+		c[0*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[1*MAX_REPEAT_AVX512]  = AVX512_ALL_ONES;
+		c[2*MAX_REPEAT_AVX512]  = AVX512_ALL_ONES;
+		c[3*MAX_REPEAT_AVX512]  = AVX512_ALL_ONES;
+		c[4*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[5*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[6*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[7*MAX_REPEAT_AVX512]  = AVX512_ALL_ONES;
+		c[8*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[9*MAX_REPEAT_AVX512]  = AVX512_ZERO;
+		c[10*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[11*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[12*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[13*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[14*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[15*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[16*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[17*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[18*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[19*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[20*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[21*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[22*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[23*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[24*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[25*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[26*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[27*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[28*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[29*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[30*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[31*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[32*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[33*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[34*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[35*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[36*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[37*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[38*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[39*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[40*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[41*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[42*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[43*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[44*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[45*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[46*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[47*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[48*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[49*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[50*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[51*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[52*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[53*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[54*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[55*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[56*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[57*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[58*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[59*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[60*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[61*MAX_REPEAT_AVX512] = AVX512_ALL_ONES;
+		c[62*MAX_REPEAT_AVX512] = AVX512_ZERO;
+		c[63*MAX_REPEAT_AVX512] = AVX512_ZERO;
+	}
+	c = first_c;
+
+	//1
+	REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512] ), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512] ), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512] ), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512] ), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512] ), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512] ), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512] ), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512] ), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//2
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[26*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[12*MAX_REPEAT_AVX512]), &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[27*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), &c[60*MAX_REPEAT_AVX512]);
+	//3
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//4
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[54*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[40*MAX_REPEAT_AVX512]), &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[55*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , &c[60*MAX_REPEAT_AVX512]);
+	//5
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//6
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[25*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[11*MAX_REPEAT_AVX512]), &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[26*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), &c[60*MAX_REPEAT_AVX512]);
+	//7
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	//8
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[53*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[39*MAX_REPEAT_AVX512]), &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[54*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , &c[60*MAX_REPEAT_AVX512]);
+	//9
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//10
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[17*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[3*MAX_REPEAT_AVX512]) , &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[18*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), &c[60*MAX_REPEAT_AVX512]);
+	//11
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//12
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[20*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[6*MAX_REPEAT_AVX512]) , &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[46*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), &c[60*MAX_REPEAT_AVX512]);
+	//13
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[41*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[18*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), &c[4*MAX_REPEAT_AVX512] );
+	s3_avx512f(AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[46*MAX_REPEAT_AVX512], k[48*MAX_REPEAT_AVX512]), AVX512_XOR(c[54*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), &c[8*MAX_REPEAT_AVX512] );
+	s4_avx512f(AVX512_XOR(c[57*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[36*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[49*MAX_REPEAT_AVX512], k[39*MAX_REPEAT_AVX512]), AVX512_XOR(c[62*MAX_REPEAT_AVX512], k[47*MAX_REPEAT_AVX512]), AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , &c[12*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[41*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[33*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[39*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[55*MAX_REPEAT_AVX512], k[21*MAX_REPEAT_AVX512]), AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), &c[16*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[45*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[63*MAX_REPEAT_AVX512], k[42*MAX_REPEAT_AVX512]), AVX512_XOR(c[58*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[34*MAX_REPEAT_AVX512], k[22*MAX_REPEAT_AVX512]), AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[43*MAX_REPEAT_AVX512]), &c[20*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[40*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[50*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[44*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[61*MAX_REPEAT_AVX512], k[44*MAX_REPEAT_AVX512]), AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), &c[24*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[37*MAX_REPEAT_AVX512], k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[53*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[42*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , AVX512_XOR(c[35*MAX_REPEAT_AVX512], k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), &c[28*MAX_REPEAT_AVX512]);
+	//14
+	}END_REPEAT;REPEAT_AVX512{
+	s1_avx512f(AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[19*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[6*MAX_REPEAT_AVX512] , k[55*MAX_REPEAT_AVX512]), AVX512_XOR(c[19*MAX_REPEAT_AVX512], k[32*MAX_REPEAT_AVX512]), AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[10*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), &c[32*MAX_REPEAT_AVX512]);
+	s2_avx512f(AVX512_XOR(c[20*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[28*MAX_REPEAT_AVX512], k[3*MAX_REPEAT_AVX512]) , AVX512_XOR(c[11*MAX_REPEAT_AVX512], k[26*MAX_REPEAT_AVX512]), AVX512_XOR(c[27*MAX_REPEAT_AVX512], k[20*MAX_REPEAT_AVX512]), AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[11*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[48*MAX_REPEAT_AVX512]), &c[36*MAX_REPEAT_AVX512]);
+	s3_avx512f(AVX512_XOR(c[16*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[0*MAX_REPEAT_AVX512] , k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[14*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , AVX512_XOR(c[22*MAX_REPEAT_AVX512], k[6*MAX_REPEAT_AVX512]) , AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[34*MAX_REPEAT_AVX512]), &c[40*MAX_REPEAT_AVX512]);
+	s4_avx512f(AVX512_XOR(c[25*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[4*MAX_REPEAT_AVX512] , k[27*MAX_REPEAT_AVX512]), AVX512_XOR(c[17*MAX_REPEAT_AVX512], k[53*MAX_REPEAT_AVX512]), AVX512_XOR(c[30*MAX_REPEAT_AVX512], k[4*MAX_REPEAT_AVX512]) , AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[17*MAX_REPEAT_AVX512]), &c[44*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	s5_avx512f(AVX512_XOR(c[9*MAX_REPEAT_AVX512] , k[8*MAX_REPEAT_AVX512]) , AVX512_XOR(c[1*MAX_REPEAT_AVX512] , k[30*MAX_REPEAT_AVX512]), AVX512_XOR(c[7*MAX_REPEAT_AVX512] , k[52*MAX_REPEAT_AVX512]), AVX512_XOR(c[23*MAX_REPEAT_AVX512], k[35*MAX_REPEAT_AVX512]), AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[50*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[51*MAX_REPEAT_AVX512]), &c[48*MAX_REPEAT_AVX512]);
+	s6_avx512f(AVX512_XOR(c[13*MAX_REPEAT_AVX512], k[45*MAX_REPEAT_AVX512]), AVX512_XOR(c[31*MAX_REPEAT_AVX512], k[1*MAX_REPEAT_AVX512]) , AVX512_XOR(c[26*MAX_REPEAT_AVX512], k[23*MAX_REPEAT_AVX512]), AVX512_XOR(c[2*MAX_REPEAT_AVX512] , k[36*MAX_REPEAT_AVX512]), AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[7*MAX_REPEAT_AVX512]) , AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[2*MAX_REPEAT_AVX512]) , &c[52*MAX_REPEAT_AVX512]);
+	s7_avx512f(AVX512_XOR(c[8*MAX_REPEAT_AVX512] , k[29*MAX_REPEAT_AVX512]), AVX512_XOR(c[18*MAX_REPEAT_AVX512], k[9*MAX_REPEAT_AVX512]) , AVX512_XOR(c[12*MAX_REPEAT_AVX512], k[49*MAX_REPEAT_AVX512]), AVX512_XOR(c[29*MAX_REPEAT_AVX512], k[31*MAX_REPEAT_AVX512]), AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[14*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[37*MAX_REPEAT_AVX512]), &c[56*MAX_REPEAT_AVX512]);
+	s8_avx512f(AVX512_XOR(c[5*MAX_REPEAT_AVX512] , k[43*MAX_REPEAT_AVX512]), AVX512_XOR(c[21*MAX_REPEAT_AVX512], k[15*MAX_REPEAT_AVX512]), AVX512_XOR(c[10*MAX_REPEAT_AVX512], k[16*MAX_REPEAT_AVX512]), AVX512_XOR(c[3*MAX_REPEAT_AVX512] , k[28*MAX_REPEAT_AVX512]), AVX512_XOR(c[24*MAX_REPEAT_AVX512], k[38*MAX_REPEAT_AVX512]), AVX512_XOR(c[15*MAX_REPEAT_AVX512], k[0*MAX_REPEAT_AVX512]) , &c[60*MAX_REPEAT_AVX512]);
+	}END_REPEAT;REPEAT_AVX512{
+	//15
+	s1_avx512f(AVX512_XOR(c[56*MAX_REPEAT_AVX512], k[33*MAX_REPEAT_AVX512]), AVX512_XOR(c[47*MAX_REPEAT_AVX512], k[54*MAX_REPEAT_AVX512]), AVX512_XOR(c[38*MAX_REPEAT_AVX512], k[12*MAX_REPEAT_AVX512]), AVX512_XOR(c[51*MAX_REPEAT_AVX512], k[46*MAX_REPEAT_AVX512]), AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[24*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[27*MAX_REPEAT_AVX512]), &c[0*MAX_REPEAT_AVX512] );
+	s2_avx512f(AVX512_XOR(c[52*MAX_REPEAT_AVX512], k[13*MAX_REPEAT_AVX512]), AVX512_XOR(c[60*MAX_REPEAT_AVX512], k[17*MAX_REPEAT_AVX512]), AVX512_XOR(c[43*MAX_REPEAT_AVX512], k[40*MAX_REPEAT_AVX512]), AVX512_XOR(c[59*MAX_REPEAT_AVX512], k[34*MAX_REPEAT_AVX512]), AVX512_XOR(c[48*MAX_REPEAT_AVX512], k[25*MAX_REPEAT_AVX512]), AVX512_XOR(c[32*MAX_REPEAT_AVX512], k[5*MAX_REPEAT_AVX512]) , &c[4*MAX_REPEAT_AVX512] );
+	}END_REPEAT;
+}
+
+PRIVATE void crypt_fast_lm_protocol_avx512(CryptParam* param)
+{
+	crypt_lm_body(param, lm_eval_avx512_kernel, calculate_hash_v128, calculate_lm_indexs_c, FALSE);
+}
 #else
 PRIVATE void lm_eval_sse2_kernel(SSE2_WORD* first_k, SSE2_WORD* first_c, SSE2_WORD* a)
 {
@@ -2669,7 +3189,9 @@ void calculate_lm_indexs_see2(uint32_t* hash_values, uint32_t* indexs);
 PRIVATE void crypt_utf8_lm_protocol_sse2(CryptParam* param)
 {
 #ifdef _M_X64
-	if (current_cpu.capabilites[CPU_CAP_AVX2])
+	if (current_cpu.capabilites[CPU_CAP_AVX512])
+		crypt_lm_body(param, lm_eval_avx512_kernel, calculate_hash_v128, calculate_lm_indexs_c, TRUE);
+	else if (current_cpu.capabilites[CPU_CAP_AVX2])
 		crypt_lm_body(param, lm_eval_avx2_kernel, calculate_hash_avx, calculate_lm_indexs_avx, TRUE);
 	else
 #endif
@@ -2879,6 +3401,111 @@ PRIVATE void lm_eval_final(V128_WORD* first_k, V128_WORD* first_c, V128_WORD* a,
 	}
 }
 
+#ifdef HS_TESTING
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Test all kernels compiled, not only the selected one
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define LM_TEST_BATCHES	16
+PRIVATE const struct
+{
+	int needed_cap;
+	lm_eval_kernel_func* kernel;
+	calculate_hash_func* calculate_hash;
+	const char* name;
+}
+lm_kernels[] = {
+#ifdef HS_ARM
+	{CPU_CAP_NEON, lm_eval_neon_kernel, calculate_hash_v128, "Neon"},
+#endif
+#ifdef HS_X86
+	{CPU_CAP_SSE2, (lm_eval_kernel_func*)lm_eval_sse2_kernel, calculate_hash_v128, "SSE2"},
+#endif
+#ifdef _M_X64
+	{CPU_CAP_AVX2, lm_eval_avx2_kernel, (calculate_hash_func*)calculate_hash_avx, "AVX2"},
+	{CPU_CAP_AVX512, lm_eval_avx512_kernel, calculate_hash_v128, "AVX512"},
+#endif
+};
+
+// Keep the first 32 bits of the hashes and don't look them up in the table
+PRIVATE uint32_t* lm_test_hash_values;
+PRIVATE void test_lm_indexs(uint32_t* hash_values, uint32_t* indexs)
+{
+	memcpy(lm_test_hash_values, hash_values, V128_BIT_LENGHT*MAX_REPEAT * sizeof(uint32_t));
+	memset(indexs, 0, V128_BIT_LENGHT*MAX_REPEAT / 4 * sizeof(uint32_t));
+}
+PUBLIC int test_lm_kernels()
+{
+	V128_WORD* lm_buffer_key	= (V128_WORD*)_aligned_malloc(56 * sizeof(V128_WORD)*MAX_REPEAT, 64);
+	V128_WORD* lm_buffer_crypt	= (V128_WORD*)_aligned_malloc(64 * sizeof(V128_WORD)*MAX_REPEAT, 64);
+	V128_WORD* tmp_stor			= (V128_WORD*)_aligned_malloc(8 * sizeof(V128_WORD), 64);
+	unsigned char* keys = (unsigned char*)calloc(8 * V128_BIT_LENGHT*MAX_REPEAT, sizeof(unsigned char));
+	uint32_t* binaries = (uint32_t*)malloc(V128_BIT_LENGHT*MAX_REPEAT * sizeof(uint32_t));
+	uint32_t old_size_bit_table = size_bit_table;
+	int result = TRUE;
+
+	lm_test_hash_values = (uint32_t*)malloc(V128_BIT_LENGHT*MAX_REPEAT * sizeof(uint32_t));
+	if (!lm_buffer_key || !lm_buffer_crypt || !tmp_stor || !keys || !binaries || !lm_test_hash_values)
+	{
+		hs_log(HS_LOG_ERROR, "Test Suite", "LM kernels test: not enough memory");
+		if (lm_buffer_key) _aligned_free(lm_buffer_key);
+		if (lm_buffer_crypt) _aligned_free(lm_buffer_crypt);
+		if (tmp_stor) _aligned_free(tmp_stor);
+		free(keys);
+		free(binaries);
+		free(lm_test_hash_values);
+		return FALSE;
+	}
+	// lm_eval_final calculates the 4 bytes of hash_values only with a big table
+	size_bit_table = UINT32_MAX;
+
+	for (uint32_t batch = 0; batch < LM_TEST_BATCHES; batch++)
+	{
+		// Random keys of all lengths without lowercase: the kernels receive them already in uppercase
+		for (uint32_t i = 0; i < V128_BIT_LENGHT*MAX_REPEAT; i++)
+		{
+			char hash[40];
+			unsigned char binary[BINARY_SIZE];
+			unsigned char* key = keys + 8 * i;
+			uint32_t len = i % (PLAINTEXT_LENGTH + 1);
+
+			memset(key, 0, 8);
+			generate_random(key, len);
+			for (uint32_t j = 0; j < len; j++)
+				key[j] = ' ' + key[j] % 64;
+
+			hash_lm((const char*)key, hash);
+			binaries[i] = get_binary((const unsigned char*)hash, binary, NULL);
+		}
+
+		for (uint32_t k = 0; k < LENGTH(lm_kernels); k++)
+			if (current_cpu.capabilites[lm_kernels[k].needed_cap])
+			{
+				for (uint32_t i = 0; i < MAX_REPEAT; i++)
+					convert_key_to_input_v128((uint32_t*)(keys + V128_BIT_LENGHT * 8 * i), lm_buffer_crypt, lm_buffer_key + i);
+
+				lm_kernels[k].kernel(lm_buffer_key, lm_buffer_crypt, tmp_stor);
+				lm_eval_final(lm_buffer_key, lm_buffer_crypt, tmp_stor, lm_kernels[k].calculate_hash, test_lm_indexs);
+
+				for (uint32_t i = 0; i < V128_BIT_LENGHT*MAX_REPEAT; i++)
+					if (lm_test_hash_values[i] != binaries[i])
+					{
+						hs_log(HS_LOG_ERROR, "Test Suite", "LM %s kernel fails with key: '%s'", lm_kernels[k].name, keys + 8 * i);
+						result = FALSE;
+					}
+			}
+	}
+
+	size_bit_table = old_size_bit_table;
+	free(lm_test_hash_values);
+	free(binaries);
+	free(keys);
+	_aligned_free(tmp_stor);
+	_aligned_free(lm_buffer_crypt);
+	_aligned_free(lm_buffer_key);
+	return result;
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementation
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -6451,12 +7078,12 @@ Format lm_format = {
 	NULL,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_avx2}, {CPU_CAP_SSE2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_avx2}, {CPU_CAP_SSE2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_sse2}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_neon}, {CPU_CAP_NEON, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}},
+		{{CPU_CAP_NEON, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_neon}, {CPU_CAP_NEON, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}},
+		{{CPU_CAP_SSE2, PROTOCOL_FAST_LM, crypt_fast_lm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_LM, crypt_utf8_lm_protocol_x86}},
 	#endif
 #endif
 	#ifdef HS_OPENCL_SUPPORT
@@ -146,6 +146,18 @@ PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* nt_b
 PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_asm_func* crypt_kernel_asm)
 {
 	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8 + 4) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
+	uint32_t* candidates = (uint32_t*)malloc(8 * sizeof(uint32_t) * NT_NUM_KEYS);
+
+	if (!nt_buffer || !candidates)
+	{
+		// Not enough memory: stop the attack so it can be resumed later
+		hs_log(HS_LOG_ERROR, "Raw-MD5", "Not enough memory for the thread buffers");
+		continue_attack = FALSE;
+		if (nt_buffer) _aligned_free(nt_buffer);
+		free(candidates);
+		finish_thread();
+		return;
+	}
 
 	uint32_t* unpacked_as = (uint32_t*)(nt_buffer + 8 * NT_NUM_KEYS);
 	uint32_t* unpacked_bs = (uint32_t*)(nt_buffer + 8 * NT_NUM_KEYS + 1 * NT_NUM_KEYS);
@@ -156,49 +168,60 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_as
 
 	memset(nt_buffer, 0, 8 * sizeof(uint32_t)* NT_NUM_KEYS);
 	memset(key, 0, sizeof(key));
+	int use_filter_batch = num_passwords_loaded >= CBG_FILTER_BATCH_MIN_HASHES;
 
 	while (continue_attack && param->gen(nt_buffer, NT_NUM_KEYS, param->thread_id))
 	{
 		crypt_kernel_asm(nt_buffer);
 
-		for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+		if (use_filter_batch)
 		{
-			uint32_t up0 = unpacked_cs[i];
-			uint32_t up1 = unpacked_bs[i];
-
-			uint32_t pos = up0 & cbg_mask;
-			uint_fast16_t data = cbg_filter[pos];
-			if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
-				password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-			// 2nd pos
-			if (data & 0b110)
+			// Filter all keys first with prefetch, then compare the few candidates
+			uint32_t num_candidates = cbg_filter_batch(unpacked_cs, unpacked_bs, NT_NUM_KEYS, candidates);
+			for (uint32_t j = 0; j < num_candidates; j += 2)
+				if (compare_elem(candidates[j], candidates[j + 1], nt_buffer))
+					password_was_found(candidates[j + 1], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, candidates[j]));// Total match
+		}
+		else// Few hashes: the filter stays in cache, compare each key in turn
+			for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
 			{
-				pos += data & 0b1 ? -1 : 1;
-				uint_fast16_t hash = cbg_filter[pos];
-				if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+				uint32_t up0 = unpacked_cs[i];
+				uint32_t up1 = unpacked_bs[i];
+
+				uint32_t pos = up0 & cbg_mask;
+				uint_fast16_t data = cbg_filter[pos];
+				if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
 					password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
 
-				// Unluky bucket
-				if (data & 0b10)
+				// 2nd pos
+				if (data & 0b110)
 				{
-					pos = up1 & cbg_mask;
-					data = cbg_filter[pos];
-					if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
-						password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-					// 2nd pos
 					pos += data & 0b1 ? -1 : 1;
-					hash = cbg_filter[pos];
-					if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+					uint_fast16_t hash = cbg_filter[pos];
+					if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
 						password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+					// Unluky bucket
+					if (data & 0b10)
+					{
+						pos = up1 & cbg_mask;
+						data = cbg_filter[pos];
+						if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+							password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+						// 2nd pos
+						pos += data & 0b1 ? -1 : 1;
+						hash = cbg_filter[pos];
+						if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+							password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+					}
 				}
 			}
-		}
 
 		report_keys_processed(NT_NUM_KEYS);
 	}
 
+	free(candidates);
 	_aligned_free(nt_buffer);
 
 	finish_thread();
@@ -444,6 +467,108 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 #endif
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+PRIVATE HS_TARGET("avx512f") void crypt_kernel_avx512(AVX512_WORD* nt_buffer)
+{
+	for (int i = 0; i < NT_NUM_KEYS/16; i++)
+	{
+		/* Round 1 */
+		AVX512_WORD a = AVX512_ADD(																				nt_buffer[0*NT_NUM_KEYS/16+i], AVX512_CONST(0xd76aa477)); a = AVX512_ADD(AVX512_ROTATE(a, 7 ), AVX512_CONST(INIT_B));
+		AVX512_WORD d = AVX512_3ADD(AVX512_XOR(AVX512_CONST(INIT_C), AVX512_AND(a, AVX512_CONST(0x77777777))),			nt_buffer[1*NT_NUM_KEYS/16+i], AVX512_CONST(0xf8fa0bcc)); d = AVX512_ADD(AVX512_ROTATE(d, 12), a);
+		AVX512_WORD c = AVX512_3ADD(AVX512_XOR(AVX512_CONST(INIT_B), AVX512_AND(d, AVX512_XOR(a, AVX512_CONST(INIT_B)))), nt_buffer[2*NT_NUM_KEYS/16+i], AVX512_CONST(0xbcdb4dd9)); c = AVX512_ADD(AVX512_ROTATE(c, 17), d);
+		AVX512_WORD b = AVX512_3ADD(AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))),									nt_buffer[3*NT_NUM_KEYS/16+i], AVX512_CONST(0xb18b7a77)); b = AVX512_ADD(AVX512_ROTATE(b, 22), c);
+					 					  
+		a = AVX512_4ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))), nt_buffer[4*NT_NUM_KEYS/16+i], AVX512_CONST(0xf57c0faf)); a = AVX512_ADD(AVX512_ROTATE(a, 7 ), b);
+		d = AVX512_4ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))), nt_buffer[5*NT_NUM_KEYS/16+i], AVX512_CONST(0x4787c62a)); d = AVX512_ADD(AVX512_ROTATE(d, 12), a);
+		c = AVX512_4ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))), nt_buffer[6*NT_NUM_KEYS/16+i], AVX512_CONST(0xa8304613)); c = AVX512_ADD(AVX512_ROTATE(c, 17), d);
+		b = AVX512_3ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))),						         AVX512_CONST(0xfd469501)); b = AVX512_ADD(AVX512_ROTATE(b, 22), c);
+																								 
+		a = AVX512_3ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))),						         AVX512_CONST(0x698098d8)); a = AVX512_ADD(AVX512_ROTATE(a, 7 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))),						         AVX512_CONST(0x8b44f7af)); d = AVX512_ADD(AVX512_ROTATE(d, 12), a);
+		c = AVX512_3ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))),						         AVX512_CONST(0xffff5bb1)); c = AVX512_ADD(AVX512_ROTATE(c, 17), d);
+		b = AVX512_3ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))),						         AVX512_CONST(0x895cd7be)); b = AVX512_ADD(AVX512_ROTATE(b, 22), c);
+																								 
+		a = AVX512_3ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))),						         AVX512_CONST(0x6b901122)); a = AVX512_ADD(AVX512_ROTATE(a, 7 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))),						         AVX512_CONST(0xfd987193)); d = AVX512_ADD(AVX512_ROTATE(d, 12), a);
+		c = AVX512_4ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))), nt_buffer[7*NT_NUM_KEYS/16+i], AVX512_CONST(0xa679438e)); c = AVX512_ADD(AVX512_ROTATE(c, 17), d);
+		b = AVX512_3ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))),						         AVX512_CONST(0x49b40821)); b = AVX512_ADD(AVX512_ROTATE(b, 22), c);
+
+		/* Round 2 */
+		a = AVX512_4ADD(a, AVX512_XOR(c, AVX512_AND(d, AVX512_XOR(b, c))), nt_buffer[1*NT_NUM_KEYS/16+i], AVX512_CONST(0xf61e2562)); a = AVX512_ADD(AVX512_ROTATE(a, 5 ), b);
+		d = AVX512_4ADD(d, AVX512_XOR(b, AVX512_AND(c, AVX512_XOR(a, b))), nt_buffer[6*NT_NUM_KEYS/16+i], AVX512_CONST(0xc040b340)); d = AVX512_ADD(AVX512_ROTATE(d, 9 ), a);
+		c = AVX512_3ADD(c, AVX512_XOR(a, AVX512_AND(b, AVX512_XOR(d, a))),							     AVX512_CONST(0x265e5a51)); c = AVX512_ADD(AVX512_ROTATE(c, 14), d);
+		b = AVX512_4ADD(b, AVX512_XOR(d, AVX512_AND(a, AVX512_XOR(c, d))), nt_buffer[0*NT_NUM_KEYS/16+i], AVX512_CONST(0xe9b6c7aa)); b = AVX512_ADD(AVX512_ROTATE(b, 20), c);
+
+		a = AVX512_4ADD(a, AVX512_XOR(c, AVX512_AND(d, AVX512_XOR(b, c))), nt_buffer[5*NT_NUM_KEYS/16+i], AVX512_CONST(0xd62f105d)); a = AVX512_ADD(AVX512_ROTATE(a, 5 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(b, AVX512_AND(c, AVX512_XOR(a, b))),						         AVX512_CONST(0x02441453)); d = AVX512_ADD(AVX512_ROTATE(d, 9 ), a);
+		c = AVX512_3ADD(c, AVX512_XOR(a, AVX512_AND(b, AVX512_XOR(d, a))),						         AVX512_CONST(0xd8a1e681)); c = AVX512_ADD(AVX512_ROTATE(c, 14), d);
+		b = AVX512_4ADD(b, AVX512_XOR(d, AVX512_AND(a, AVX512_XOR(c, d))), nt_buffer[4*NT_NUM_KEYS/16+i], AVX512_CONST(0xe7d3fbc8)); b = AVX512_ADD(AVX512_ROTATE(b, 20), c);
+
+		a = AVX512_3ADD(a, AVX512_XOR(c, AVX512_AND(d, AVX512_XOR(b, c))),						         AVX512_CONST(0x21e1cde6)); a = AVX512_ADD(AVX512_ROTATE(a, 5 ), b);
+		d = AVX512_4ADD(d, AVX512_XOR(b, AVX512_AND(c, AVX512_XOR(a, b))), nt_buffer[7*NT_NUM_KEYS/16+i], AVX512_CONST(0xc33707d6)); d = AVX512_ADD(AVX512_ROTATE(d, 9 ), a);
+		c = AVX512_4ADD(c, AVX512_XOR(a, AVX512_AND(b, AVX512_XOR(d, a))), nt_buffer[3*NT_NUM_KEYS/16+i], AVX512_CONST(0xf4d50d87)); c = AVX512_ADD(AVX512_ROTATE(c, 14), d);
+		b = AVX512_3ADD(b, AVX512_XOR(d, AVX512_AND(a, AVX512_XOR(c, d))),						         AVX512_CONST(0x455a14ed)); b = AVX512_ADD(AVX512_ROTATE(b, 20), c);
+
+		a = AVX512_3ADD(a, AVX512_XOR(c, AVX512_AND(d, AVX512_XOR(b, c))),						         AVX512_CONST(0xa9e3e905)); a = AVX512_ADD(AVX512_ROTATE(a, 5 ), b);
+		d = AVX512_4ADD(d, AVX512_XOR(b, AVX512_AND(c, AVX512_XOR(a, b))), nt_buffer[2*NT_NUM_KEYS/16+i], AVX512_CONST(0xfcefa3f8)); d = AVX512_ADD(AVX512_ROTATE(d, 9 ), a);
+		c = AVX512_3ADD(c, AVX512_XOR(a, AVX512_AND(b, AVX512_XOR(d, a))),							     AVX512_CONST(0x676f02d9)); c = AVX512_ADD(AVX512_ROTATE(c, 14), d);
+		b = AVX512_3ADD(b, AVX512_XOR(d, AVX512_AND(a, AVX512_XOR(c, d))),							     AVX512_CONST(0x8d2a4c8a)); b = AVX512_ADD(AVX512_ROTATE(b, 20), c);
+
+		/* Round 3 */
+		AVX512_WORD xx = AVX512_XOR(b, c);
+		a = AVX512_4ADD(a, AVX512_XOR(xx, d), nt_buffer[5 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xfffa3942)); a = AVX512_ADD(AVX512_ROTATE(a, 4 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(a, xx)									, AVX512_CONST(0x8771f681)); d = AVX512_ADD(AVX512_ROTATE(d, 11), a);xx = AVX512_XOR(d, a);
+		c = AVX512_3ADD(c, AVX512_XOR(xx, b)									, AVX512_CONST(0x6d9d6122)); c = AVX512_ADD(AVX512_ROTATE(c, 16), d);
+		b = AVX512_4ADD(b, AVX512_XOR(c, xx), nt_buffer[7 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xfde5380c)); b = AVX512_ADD(AVX512_ROTATE(b, 23), c); xx = AVX512_XOR(b, c);
+									
+		a = AVX512_4ADD(a, AVX512_XOR(xx, d), nt_buffer[1 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xa4beea44)); a = AVX512_ADD(AVX512_ROTATE(a, 4), b);
+		d = AVX512_4ADD(d, AVX512_XOR(a, xx), nt_buffer[4 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0x4bdecfa9)); d = AVX512_ADD(AVX512_ROTATE(d, 11), a); xx = AVX512_XOR(d, a);
+		c = AVX512_3ADD(c, AVX512_XOR(xx, b)									, AVX512_CONST(0xf6bb4b60)); c = AVX512_ADD(AVX512_ROTATE(c, 16), d);
+		b = AVX512_3ADD(b, AVX512_XOR(c, xx)									, AVX512_CONST(0xbebfbc70)); b = AVX512_ADD(AVX512_ROTATE(b, 23), c); xx = AVX512_XOR(b, c);
+								
+		a = AVX512_3ADD(a, AVX512_XOR(xx, d)									, AVX512_CONST(0x289b7ec6)); a = AVX512_ADD(AVX512_ROTATE(a, 4), b);
+		d = AVX512_4ADD(d, AVX512_XOR(a, xx), nt_buffer[0 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xeaa127fa)); d = AVX512_ADD(AVX512_ROTATE(d, 11), a); xx = AVX512_XOR(d, a);
+		c = AVX512_4ADD(c, AVX512_XOR(xx, b), nt_buffer[3 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xd4ef3085)); c = AVX512_ADD(AVX512_ROTATE(c, 16), d);
+		b = AVX512_4ADD(b, AVX512_XOR(c, xx), nt_buffer[6 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0x04881d05)); b = AVX512_ADD(AVX512_ROTATE(b, 23), c); xx = AVX512_XOR(b, c);
+									
+		a = AVX512_3ADD(a, AVX512_XOR(xx, d)									, AVX512_CONST(0xd9d4d039)); a = AVX512_ADD(AVX512_ROTATE(a, 4), b);
+		d = AVX512_3ADD(d, AVX512_XOR(a, xx)									, AVX512_CONST(0xe6db99e5)); d = AVX512_ADD(AVX512_ROTATE(d, 11), a); xx = AVX512_XOR(d, a);
+		c = AVX512_3ADD(c, AVX512_XOR(xx, b)									, AVX512_CONST(0x1fa27cf8)); c = AVX512_ADD(AVX512_ROTATE(c, 16), d);
+		b = AVX512_4ADD(b, AVX512_XOR(c, xx), nt_buffer[2 * NT_NUM_KEYS / 16 + i], AVX512_CONST(0xc4ac5665)); b = AVX512_ADD(AVX512_ROTATE(b, 23), c);
+
+		/* Round 4 */
+		a = AVX512_4ADD(a, AVX512_XOR(c, AVX512_OR(b, AVX512_NOT(d))), nt_buffer[0*NT_NUM_KEYS/16+i], AVX512_CONST(0xf4292244)); a = AVX512_ADD(AVX512_ROTATE(a, 6 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(b, AVX512_OR(a, AVX512_NOT(c)))							   , AVX512_CONST(0x432aff97)); d = AVX512_ADD(AVX512_ROTATE(d, 10), a);
+		c = AVX512_4ADD(c, AVX512_XOR(a, AVX512_OR(d, AVX512_NOT(b))), nt_buffer[7*NT_NUM_KEYS/16+i], AVX512_CONST(0xab9423a7)); c = AVX512_ADD(AVX512_ROTATE(c, 15), d);
+		b = AVX512_4ADD(b, AVX512_XOR(d, AVX512_OR(c, AVX512_NOT(a))), nt_buffer[5*NT_NUM_KEYS/16+i], AVX512_CONST(0xfc93a039)); b = AVX512_ADD(AVX512_ROTATE(b, 21), c);
+
+		a = AVX512_3ADD(a, AVX512_XOR(c, AVX512_OR(b, AVX512_NOT(d)))							   , AVX512_CONST(0x655b59c3)); a = AVX512_ADD(AVX512_ROTATE(a, 6 ), b);
+		d = AVX512_4ADD(d, AVX512_XOR(b, AVX512_OR(a, AVX512_NOT(c))), nt_buffer[3*NT_NUM_KEYS/16+i], AVX512_CONST(0x8f0ccc92)); d = AVX512_ADD(AVX512_ROTATE(d, 10), a);
+		c = AVX512_3ADD(c, AVX512_XOR(a, AVX512_OR(d, AVX512_NOT(b)))							   , AVX512_CONST(0xffeff47d)); c = AVX512_ADD(AVX512_ROTATE(c, 15), d);
+		b = AVX512_4ADD(b, AVX512_XOR(d, AVX512_OR(c, AVX512_NOT(a))), nt_buffer[1*NT_NUM_KEYS/16+i], AVX512_CONST(0x85845dd1)); b = AVX512_ADD(AVX512_ROTATE(b, 21), c);
+
+		a = AVX512_3ADD(a, AVX512_XOR(c, AVX512_OR(b, AVX512_NOT(d)))							   , AVX512_CONST(0x6fa87e4f)); a = AVX512_ADD(AVX512_ROTATE(a, 6 ), b);
+		d = AVX512_3ADD(d, AVX512_XOR(b, AVX512_OR(a, AVX512_NOT(c)))							   , AVX512_CONST(0xfe2ce6e0)); d = AVX512_ADD(AVX512_ROTATE(d, 10), a);
+		c = AVX512_4ADD(c, AVX512_XOR(a, AVX512_OR(d, AVX512_NOT(b))), nt_buffer[6*NT_NUM_KEYS/16+i], AVX512_CONST(0xa3014314)); c = AVX512_ADD(AVX512_ROTATE(c, 15), d);
+		b = AVX512_3ADD(b, AVX512_XOR(d, AVX512_OR(c, AVX512_NOT(a)))                              , AVX512_CONST(0x4e0811a1)); b = AVX512_ADD(AVX512_ROTATE(b, 21), c);
+		c = AVX512_ADD(c, nt_buffer[2 * NT_NUM_KEYS/16 + i]);
+
+		// Save
+		nt_buffer[8 * NT_NUM_KEYS / 16 + i] = a;
+		nt_buffer[8 * NT_NUM_KEYS / 16 + 1 * NT_NUM_KEYS / 16 + i] = b;
+		nt_buffer[8 * NT_NUM_KEYS / 16 + 2 * NT_NUM_KEYS / 16 + i] = c;
+		nt_buffer[8 * NT_NUM_KEYS / 16 + 3 * NT_NUM_KEYS / 16 + i] = d;
+	}
+}
+PRIVATE void crypt_utf8_coalesc_protocol_avx512(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_body(param, (crypt_kernel_asm_func*)crypt_kernel_avx512);
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementations
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1233,7 +1358,7 @@ PRIVATE int ocl_protocol_charset_init(OpenCL_Param* result, cl_uint gpu_index, g
 				bin[2] += 0x80;
 		}
 
-		free(cbg_table);
+		large_page_free(cbg_table);
 		large_page_free(cbg_filter);
 
 		cbg_table = old_cbg_table;
@@ -1936,12 +2061,12 @@ Format raw_md5_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
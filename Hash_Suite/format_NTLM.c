@@ -169,12 +169,8 @@ PRIVATE void binary2hex(const void* binary, const void* salt, unsigned char* cip
 	#define NT_NUM_KEYS		    256
 #endif
 
-PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* nt_buffer)
+PRIVATE uint32_t compare_binary(uint32_t i, const uint32_t* bin, uint32_t* nt_buffer)
 {
-	if(cbg_table_pos == NO_ELEM) return FALSE;
-
-	uint32_t* bin = ((uint32_t*)binary_values) + cbg_table_pos * 4;
-
 	uint32_t* unpacked_as = (uint32_t*)(nt_buffer + 16 * NT_NUM_KEYS);
 	uint32_t* unpacked_bs = (uint32_t*)(nt_buffer + 16 * NT_NUM_KEYS + 1 * NT_NUM_KEYS);
 	uint32_t* unpacked_cs = (uint32_t*)(nt_buffer + 16 * NT_NUM_KEYS + 2 * NT_NUM_KEYS);
@@ -191,10 +187,28 @@ PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* nt_b
 
 	return TRUE;
 }
+PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* nt_buffer)
+{
+	if(cbg_table_pos == NO_ELEM) return FALSE;
+
+	return compare_binary(i, ((uint32_t*)binary_values) + cbg_table_pos * 4, nt_buffer);
+}
 
 PRIVATE void crypt_ntlm_protocol_body(CryptParam* param, crypt_kernel_asm_func* crypt_ntlm_kernel_asm)
 {
 	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * 4 * NT_NUM_KEYS + 4 * 4 * NT_NUM_KEYS, 64);
+	uint32_t* candidates = (uint32_t*)malloc(8 * sizeof(uint32_t) * NT_NUM_KEYS);
+
+	if (!nt_buffer || !candidates)
+	{
+		// Not enough memory: stop the attack so it can be resumed later
+		hs_log(HS_LOG_ERROR, "NTLM", "Not enough memory for the thread buffers");
+		continue_attack = FALSE;
+		if (nt_buffer) _aligned_free(nt_buffer);
+		free(candidates);
+		finish_thread();
+		return;
+	}
 
 	uint32_t* unpacked_as = (uint32_t*)(nt_buffer + 16*NT_NUM_KEYS);
 	uint32_t* unpacked_bs = (uint32_t*)(nt_buffer + 16*NT_NUM_KEYS + 1*NT_NUM_KEYS);
@@ -203,49 +217,60 @@ PRIVATE void crypt_ntlm_protocol_body(CryptParam* param, crypt_kernel_asm_func*
 
 	memset(nt_buffer, 0, 16*4*NT_NUM_KEYS);
 	memset(key, 0, sizeof(key));
+	int use_filter_batch = num_passwords_loaded >= CBG_FILTER_BATCH_MIN_HASHES;
 
 	while(continue_attack && param->gen(nt_buffer, NT_NUM_KEYS, param->thread_id))
 	{
 		crypt_ntlm_kernel_asm(nt_buffer);
 
-		for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+		if (use_filter_batch)
 		{
-			uint32_t up_b = unpacked_bs[i];
-			uint32_t up_a = unpacked_as[i];
-
-			uint32_t pos = up_b & cbg_mask;
-			uint_fast16_t data = cbg_filter[pos];
-			if (((data ^ up_a) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
-				password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-			// 2nd pos
-			if (data & 0b110)
+			// Filter all keys first with prefetch, then compare the few candidates
+			uint32_t num_candidates = cbg_filter_batch(unpacked_bs, unpacked_as, NT_NUM_KEYS, candidates);
+			for (uint32_t j = 0; j < num_candidates; j += 2)
+				if (compare_elem(candidates[j], candidates[j + 1], nt_buffer))
+					password_was_found(candidates[j + 1], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, candidates[j]));// Total match
+		}
+		else// Few hashes: the filter stays in cache, compare each key in turn
+			for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
 			{
-				pos += data & 0b1 ? -1 : 1;
-				uint_fast16_t hash = cbg_filter[pos];
-				if (((hash ^ up_a) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+				uint32_t up_b = unpacked_bs[i];
+				uint32_t up_a = unpacked_as[i];
+
+				uint32_t pos = up_b & cbg_mask;
+				uint_fast16_t data = cbg_filter[pos];
+				if (((data ^ up_a) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
 					password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
 
-				// Unluky bucket
-				if (data & 0b10)
+				// 2nd pos
+				if (data & 0b110)
 				{
-					pos = up_a & cbg_mask;
-					data = cbg_filter[pos];
-					if (((data ^ up_b) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
-						password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-					// 2nd pos
 					pos += data & 0b1 ? -1 : 1;
-					hash = cbg_filter[pos];
-					if (((hash ^ up_b) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+					uint_fast16_t hash = cbg_filter[pos];
+					if (((hash ^ up_a) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
 						password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+					// Unluky bucket
+					if (data & 0b10)
+					{
+						pos = up_a & cbg_mask;
+						data = cbg_filter[pos];
+						if (((data ^ up_b) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+							password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+						// 2nd pos
+						pos += data & 0b1 ? -1 : 1;
+						hash = cbg_filter[pos];
+						if (((hash ^ up_b) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], nt_buffer))
+							password_was_found(cbg_table[pos], ntlm2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+					}
 				}
 			}
-		}
 
 		report_keys_processed(NT_NUM_KEYS);
 	}
 
+	free(candidates);
 	_aligned_free(nt_buffer);
 
 	finish_thread();
@@ -343,36 +368,374 @@ PRIVATE void crypt_ntlm_protocol_neon(CryptParam* param)
 
 #endif
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SSE2 Implementation
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef HS_X86
+#include "arch_simd.h"
+
+// Used by SSE2 and AVX: with AVX only change the encoding of the instructions
+PRIVATE __forceinline void crypt_ntlm_kernel_v128(uint32_t* buffer)
+{
+	SSE2_WORD* nt_buffer = (SSE2_WORD*)buffer;
+
+	for (int i = 0; i < NT_NUM_KEYS/4; i++)
+	{
+		/* Round 1 */
+		SSE2_WORD a = SSE2_ADD(SSE2_CONST(0xFFFFFFFF), nt_buffer[0*NT_NUM_KEYS/4+i]); a = SSE2_ROTATE(a, 3);
+		SSE2_WORD d = SSE2_3ADD(SSE2_CONST(INIT_D), SSE2_XOR(SSE2_CONST(INIT_C), SSE2_AND(a, SSE2_CONST(0x77777777))), nt_buffer[1*NT_NUM_KEYS/4+i]); d = SSE2_ROTATE(d, 7);
+		SSE2_WORD c = SSE2_3ADD(SSE2_CONST(INIT_C), SSE2_XOR(SSE2_CONST(INIT_B), SSE2_AND(d, SSE2_XOR(a, SSE2_CONST(INIT_B)))), nt_buffer[2*NT_NUM_KEYS/4+i]); c = SSE2_ROTATE(c, 11);
+		SSE2_WORD b = SSE2_3ADD(SSE2_CONST(INIT_B), SSE2_XOR(a, SSE2_AND(c, SSE2_XOR(d, a))), nt_buffer[3*NT_NUM_KEYS/4+i]); b = SSE2_ROTATE(b, 19);
+
+		a = SSE2_3ADD(a, SSE2_XOR(d, SSE2_AND(b, SSE2_XOR(c, d))), nt_buffer[4*NT_NUM_KEYS/4+i]); a = SSE2_ROTATE(a, 3);
+		d = SSE2_3ADD(d, SSE2_XOR(c, SSE2_AND(a, SSE2_XOR(b, c))), nt_buffer[5*NT_NUM_KEYS/4+i]); d = SSE2_ROTATE(d, 7);
+		c = SSE2_3ADD(c, SSE2_XOR(b, SSE2_AND(d, SSE2_XOR(a, b))), nt_buffer[6*NT_NUM_KEYS/4+i]); c = SSE2_ROTATE(c, 11);
+		b = SSE2_3ADD(b, SSE2_XOR(a, SSE2_AND(c, SSE2_XOR(d, a))), nt_buffer[7*NT_NUM_KEYS/4+i]); b = SSE2_ROTATE(b, 19);
+
+		a = SSE2_3ADD(a, SSE2_XOR(d, SSE2_AND(b, SSE2_XOR(c, d))), nt_buffer[8*NT_NUM_KEYS/4+i]); a = SSE2_ROTATE(a, 3);
+		d = SSE2_3ADD(d, SSE2_XOR(c, SSE2_AND(a, SSE2_XOR(b, c))), nt_buffer[9*NT_NUM_KEYS/4+i]); d = SSE2_ROTATE(d, 7);
+		c = SSE2_3ADD(c, SSE2_XOR(b, SSE2_AND(d, SSE2_XOR(a, b))), nt_buffer[10*NT_NUM_KEYS/4+i]); c = SSE2_ROTATE(c, 11);
+		b = SSE2_3ADD(b, SSE2_XOR(a, SSE2_AND(c, SSE2_XOR(d, a))), nt_buffer[11*NT_NUM_KEYS/4+i]); b = SSE2_ROTATE(b, 19);
+
+		a = SSE2_3ADD(a, SSE2_XOR(d, SSE2_AND(b, SSE2_XOR(c, d))), nt_buffer[12*NT_NUM_KEYS/4+i]); a = SSE2_ROTATE(a, 3);
+		d = SSE2_3ADD(d, SSE2_XOR(c, SSE2_AND(a, SSE2_XOR(b, c))), nt_buffer[13*NT_NUM_KEYS/4+i]); d = SSE2_ROTATE(d, 7);
+		c = SSE2_3ADD(c, SSE2_XOR(b, SSE2_AND(d, SSE2_XOR(a, b))), nt_buffer[14*NT_NUM_KEYS/4+i]); c = SSE2_ROTATE(c, 11);
+		b = SSE2_ADD(b, SSE2_XOR(a, SSE2_AND(c, SSE2_XOR(d, a)))); b = SSE2_ROTATE(b, 19);
+
+		/* Round 2 */
+		a = SSE2_4ADD(a, SSE2_OR(SSE2_AND(b, SSE2_OR(c, d)), SSE2_AND(c, d)), nt_buffer[0*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_OR(SSE2_AND(a, SSE2_OR(b, c)), SSE2_AND(b, c)), nt_buffer[4*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); d = SSE2_ROTATE(d, 5);
+		c = SSE2_4ADD(c, SSE2_OR(SSE2_AND(d, SSE2_OR(a, b)), SSE2_AND(a, b)), nt_buffer[8*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); c = SSE2_ROTATE(c, 9);
+		b = SSE2_4ADD(b, SSE2_OR(SSE2_AND(c, SSE2_OR(d, a)), SSE2_AND(d, a)), nt_buffer[12*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); b = SSE2_ROTATE(b, 13);
+
+		a = SSE2_4ADD(a, SSE2_OR(SSE2_AND(b, SSE2_OR(c, d)), SSE2_AND(c, d)), nt_buffer[1*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_OR(SSE2_AND(a, SSE2_OR(b, c)), SSE2_AND(b, c)), nt_buffer[5*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); d = SSE2_ROTATE(d, 5);
+		c = SSE2_4ADD(c, SSE2_OR(SSE2_AND(d, SSE2_OR(a, b)), SSE2_AND(a, b)), nt_buffer[9*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); c = SSE2_ROTATE(c, 9);
+		b = SSE2_4ADD(b, SSE2_OR(SSE2_AND(c, SSE2_OR(d, a)), SSE2_AND(d, a)), nt_buffer[13*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); b = SSE2_ROTATE(b, 13);
+
+		a = SSE2_4ADD(a, SSE2_OR(SSE2_AND(b, SSE2_OR(c, d)), SSE2_AND(c, d)), nt_buffer[2*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_OR(SSE2_AND(a, SSE2_OR(b, c)), SSE2_AND(b, c)), nt_buffer[6*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); d = SSE2_ROTATE(d, 5);
+		c = SSE2_4ADD(c, SSE2_OR(SSE2_AND(d, SSE2_OR(a, b)), SSE2_AND(a, b)), nt_buffer[10*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); c = SSE2_ROTATE(c, 9);
+		b = SSE2_4ADD(b, SSE2_OR(SSE2_AND(c, SSE2_OR(d, a)), SSE2_AND(d, a)), nt_buffer[14*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); b = SSE2_ROTATE(b, 13);
+
+		a = SSE2_4ADD(a, SSE2_OR(SSE2_AND(b, SSE2_OR(c, d)), SSE2_AND(c, d)), nt_buffer[3*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_OR(SSE2_AND(a, SSE2_OR(b, c)), SSE2_AND(b, c)), nt_buffer[7*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); d = SSE2_ROTATE(d, 5);
+		c = SSE2_4ADD(c, SSE2_OR(SSE2_AND(d, SSE2_OR(a, b)), SSE2_AND(a, b)), nt_buffer[11*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_2)); c = SSE2_ROTATE(c, 9);
+		b = SSE2_3ADD(b, SSE2_OR(SSE2_AND(c, SSE2_OR(d, a)), SSE2_AND(d, a)), SSE2_CONST(SQRT_2)); b = SSE2_ROTATE(b, 13);
+
+		/* Round 3 */
+		a = SSE2_4ADD(a, SSE2_3XOR(d, c, b), nt_buffer[0*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_3XOR(c, b, a), nt_buffer[8*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); d = SSE2_ROTATE(d, 9);
+		c = SSE2_4ADD(c, SSE2_3XOR(b, a, d), nt_buffer[4*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); c = SSE2_ROTATE(c, 11);
+		b = SSE2_4ADD(b, SSE2_3XOR(a, d, c), nt_buffer[12*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); b = SSE2_ROTATE(b, 15);
+
+		a = SSE2_4ADD(a, SSE2_3XOR(d, c, b), nt_buffer[2*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_3XOR(c, b, a), nt_buffer[10*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); d = SSE2_ROTATE(d, 9);
+		c = SSE2_4ADD(c, SSE2_3XOR(b, a, d), nt_buffer[6*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); c = SSE2_ROTATE(c, 11);
+		b = SSE2_4ADD(b, SSE2_3XOR(a, d, c), nt_buffer[14*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); b = SSE2_ROTATE(b, 15);
+
+		a = SSE2_4ADD(a, SSE2_3XOR(d, c, b), nt_buffer[1*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); a = SSE2_ROTATE(a, 3);
+		d = SSE2_4ADD(d, SSE2_3XOR(c, b, a), nt_buffer[9*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); d = SSE2_ROTATE(d, 9);
+		c = SSE2_4ADD(c, SSE2_3XOR(b, a, d), nt_buffer[5*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); c = SSE2_ROTATE(c, 11);
+		b = SSE2_4ADD(b, SSE2_3XOR(a, d, c), nt_buffer[13*NT_NUM_KEYS/4+i], SSE2_CONST(SQRT_3)); b = SSE2_ROTATE(b, 15);
+
+		a = SSE2_3ADD(a, SSE2_3XOR(b, d, c), nt_buffer[3*NT_NUM_KEYS/4+i]);
+
+		// Save
+		nt_buffer[16 * NT_NUM_KEYS/4 + i] = a;
+		nt_buffer[16 * NT_NUM_KEYS/4 + 1 * NT_NUM_KEYS/4 + i] = b;
+		nt_buffer[16 * NT_NUM_KEYS/4 + 2 * NT_NUM_KEYS/4 + i] = c;
+		nt_buffer[16 * NT_NUM_KEYS/4 + 3 * NT_NUM_KEYS/4 + i] = d;
+	}
+}
+PRIVATE void crypt_ntlm_kernel_sse2(uint32_t* nt_buffer)
+{
+	crypt_ntlm_kernel_v128(nt_buffer);
+}
+PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
+{
+	crypt_ntlm_protocol_body(param, crypt_ntlm_kernel_sse2);
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // AVX code
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #ifdef _M_X64
-void crypt_ntlm_avx_kernel_asm(uint32_t* nt_buffer);
+// VEX encoding of the 128 bits kernel: three operands save the register copies.
+// MSVC can't change the encoding of one function, so there it is the SSE2 code
+PRIVATE HS_TARGET("avx") void crypt_ntlm_kernel_avx(uint32_t* nt_buffer)
+{
+	crypt_ntlm_kernel_v128(nt_buffer);
+}
 PRIVATE void crypt_ntlm_protocol_avx(CryptParam* param)
 {
-	crypt_ntlm_protocol_body(param, crypt_ntlm_avx_kernel_asm);
+	crypt_ntlm_protocol_body(param, crypt_ntlm_kernel_avx);
 }
 #endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // AVX2 code
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #ifdef _M_X64
-void crypt_ntlm_avx2_kernel_asm(uint32_t* nt_buffer);
+PRIVATE HS_TARGET("avx2") void crypt_ntlm_kernel_avx2(uint32_t* buffer)
+{
+	AVX2_WORD* nt_buffer = (AVX2_WORD*)buffer;
+
+	for (int i = 0; i < NT_NUM_KEYS/8; i++)
+	{
+		/* Round 1 */
+		AVX2_WORD a = AVX2_ADD(AVX2_CONST(0xFFFFFFFF), nt_buffer[0*NT_NUM_KEYS/8+i]); a = AVX2_ROTATE(a, 3);
+		AVX2_WORD d = AVX2_3ADD(AVX2_CONST(INIT_D), AVX2_XOR(AVX2_CONST(INIT_C), AVX2_AND(a, AVX2_CONST(0x77777777))), nt_buffer[1*NT_NUM_KEYS/8+i]); d = AVX2_ROTATE(d, 7);
+		AVX2_WORD c = AVX2_3ADD(AVX2_CONST(INIT_C), AVX2_XOR(AVX2_CONST(INIT_B), AVX2_AND(d, AVX2_XOR(a, AVX2_CONST(INIT_B)))), nt_buffer[2*NT_NUM_KEYS/8+i]); c = AVX2_ROTATE(c, 11);
+		AVX2_WORD b = AVX2_3ADD(AVX2_CONST(INIT_B), AVX2_XOR(a, AVX2_AND(c, AVX2_XOR(d, a))), nt_buffer[3*NT_NUM_KEYS/8+i]); b = AVX2_ROTATE(b, 19);
+
+		a = AVX2_3ADD(a, AVX2_XOR(d, AVX2_AND(b, AVX2_XOR(c, d))), nt_buffer[4*NT_NUM_KEYS/8+i]); a = AVX2_ROTATE(a, 3);
+		d = AVX2_3ADD(d, AVX2_XOR(c, AVX2_AND(a, AVX2_XOR(b, c))), nt_buffer[5*NT_NUM_KEYS/8+i]); d = AVX2_ROTATE(d, 7);
+		c = AVX2_3ADD(c, AVX2_XOR(b, AVX2_AND(d, AVX2_XOR(a, b))), nt_buffer[6*NT_NUM_KEYS/8+i]); c = AVX2_ROTATE(c, 11);
+		b = AVX2_3ADD(b, AVX2_XOR(a, AVX2_AND(c, AVX2_XOR(d, a))), nt_buffer[7*NT_NUM_KEYS/8+i]); b = AVX2_ROTATE(b, 19);
+
+		a = AVX2_3ADD(a, AVX2_XOR(d, AVX2_AND(b, AVX2_XOR(c, d))), nt_buffer[8*NT_NUM_KEYS/8+i]); a = AVX2_ROTATE(a, 3);
+		d = AVX2_3ADD(d, AVX2_XOR(c, AVX2_AND(a, AVX2_XOR(b, c))), nt_buffer[9*NT_NUM_KEYS/8+i]); d = AVX2_ROTATE(d, 7);
+		c = AVX2_3ADD(c, AVX2_XOR(b, AVX2_AND(d, AVX2_XOR(a, b))), nt_buffer[10*NT_NUM_KEYS/8+i]); c = AVX2_ROTATE(c, 11);
+		b = AVX2_3ADD(b, AVX2_XOR(a, AVX2_AND(c, AVX2_XOR(d, a))), nt_buffer[11*NT_NUM_KEYS/8+i]); b = AVX2_ROTATE(b, 19);
+
+		a = AVX2_3ADD(a, AVX2_XOR(d, AVX2_AND(b, AVX2_XOR(c, d))), nt_buffer[12*NT_NUM_KEYS/8+i]); a = AVX2_ROTATE(a, 3);
+		d = AVX2_3ADD(d, AVX2_XOR(c, AVX2_AND(a, AVX2_XOR(b, c))), nt_buffer[13*NT_NUM_KEYS/8+i]); d = AVX2_ROTATE(d, 7);
+		c = AVX2_3ADD(c, AVX2_XOR(b, AVX2_AND(d, AVX2_XOR(a, b))), nt_buffer[14*NT_NUM_KEYS/8+i]); c = AVX2_ROTATE(c, 11);
+		b = AVX2_ADD(b, AVX2_XOR(a, AVX2_AND(c, AVX2_XOR(d, a)))); b = AVX2_ROTATE(b, 19);
+
+		/* Round 2 */
+		a = AVX2_4ADD(a, AVX2_OR(AVX2_AND(b, AVX2_OR(c, d)), AVX2_AND(c, d)), nt_buffer[0*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_OR(AVX2_AND(a, AVX2_OR(b, c)), AVX2_AND(b, c)), nt_buffer[4*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); d = AVX2_ROTATE(d, 5);
+		c = AVX2_4ADD(c, AVX2_OR(AVX2_AND(d, AVX2_OR(a, b)), AVX2_AND(a, b)), nt_buffer[8*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); c = AVX2_ROTATE(c, 9);
+		b = AVX2_4ADD(b, AVX2_OR(AVX2_AND(c, AVX2_OR(d, a)), AVX2_AND(d, a)), nt_buffer[12*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); b = AVX2_ROTATE(b, 13);
+
+		a = AVX2_4ADD(a, AVX2_OR(AVX2_AND(b, AVX2_OR(c, d)), AVX2_AND(c, d)), nt_buffer[1*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_OR(AVX2_AND(a, AVX2_OR(b, c)), AVX2_AND(b, c)), nt_buffer[5*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); d = AVX2_ROTATE(d, 5);
+		c = AVX2_4ADD(c, AVX2_OR(AVX2_AND(d, AVX2_OR(a, b)), AVX2_AND(a, b)), nt_buffer[9*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); c = AVX2_ROTATE(c, 9);
+		b = AVX2_4ADD(b, AVX2_OR(AVX2_AND(c, AVX2_OR(d, a)), AVX2_AND(d, a)), nt_buffer[13*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); b = AVX2_ROTATE(b, 13);
+
+		a = AVX2_4ADD(a, AVX2_OR(AVX2_AND(b, AVX2_OR(c, d)), AVX2_AND(c, d)), nt_buffer[2*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_OR(AVX2_AND(a, AVX2_OR(b, c)), AVX2_AND(b, c)), nt_buffer[6*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); d = AVX2_ROTATE(d, 5);
+		c = AVX2_4ADD(c, AVX2_OR(AVX2_AND(d, AVX2_OR(a, b)), AVX2_AND(a, b)), nt_buffer[10*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); c = AVX2_ROTATE(c, 9);
+		b = AVX2_4ADD(b, AVX2_OR(AVX2_AND(c, AVX2_OR(d, a)), AVX2_AND(d, a)), nt_buffer[14*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); b = AVX2_ROTATE(b, 13);
+
+		a = AVX2_4ADD(a, AVX2_OR(AVX2_AND(b, AVX2_OR(c, d)), AVX2_AND(c, d)), nt_buffer[3*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_OR(AVX2_AND(a, AVX2_OR(b, c)), AVX2_AND(b, c)), nt_buffer[7*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); d = AVX2_ROTATE(d, 5);
+		c = AVX2_4ADD(c, AVX2_OR(AVX2_AND(d, AVX2_OR(a, b)), AVX2_AND(a, b)), nt_buffer[11*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_2)); c = AVX2_ROTATE(c, 9);
+		b = AVX2_3ADD(b, AVX2_OR(AVX2_AND(c, AVX2_OR(d, a)), AVX2_AND(d, a)), AVX2_CONST(SQRT_2)); b = AVX2_ROTATE(b, 13);
+
+		/* Round 3 */
+		a = AVX2_4ADD(a, AVX2_3XOR(d, c, b), nt_buffer[0*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_3XOR(c, b, a), nt_buffer[8*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); d = AVX2_ROTATE(d, 9);
+		c = AVX2_4ADD(c, AVX2_3XOR(b, a, d), nt_buffer[4*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); c = AVX2_ROTATE(c, 11);
+		b = AVX2_4ADD(b, AVX2_3XOR(a, d, c), nt_buffer[12*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); b = AVX2_ROTATE(b, 15);
+
+		a = AVX2_4ADD(a, AVX2_3XOR(d, c, b), nt_buffer[2*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_3XOR(c, b, a), nt_buffer[10*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); d = AVX2_ROTATE(d, 9);
+		c = AVX2_4ADD(c, AVX2_3XOR(b, a, d), nt_buffer[6*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); c = AVX2_ROTATE(c, 11);
+		b = AVX2_4ADD(b, AVX2_3XOR(a, d, c), nt_buffer[14*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); b = AVX2_ROTATE(b, 15);
+
+		a = AVX2_4ADD(a, AVX2_3XOR(d, c, b), nt_buffer[1*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); a = AVX2_ROTATE(a, 3);
+		d = AVX2_4ADD(d, AVX2_3XOR(c, b, a), nt_buffer[9*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); d = AVX2_ROTATE(d, 9);
+		c = AVX2_4ADD(c, AVX2_3XOR(b, a, d), nt_buffer[5*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); c = AVX2_ROTATE(c, 11);
+		b = AVX2_4ADD(b, AVX2_3XOR(a, d, c), nt_buffer[13*NT_NUM_KEYS/8+i], AVX2_CONST(SQRT_3)); b = AVX2_ROTATE(b, 15);
+
+		a = AVX2_3ADD(a, AVX2_3XOR(b, d, c), nt_buffer[3*NT_NUM_KEYS/8+i]);
+
+		// Save
+		nt_buffer[16 * NT_NUM_KEYS/8 + i] = a;
+		nt_buffer[16 * NT_NUM_KEYS/8 + 1 * NT_NUM_KEYS/8 + i] = b;
+		nt_buffer[16 * NT_NUM_KEYS/8 + 2 * NT_NUM_KEYS/8 + i] = c;
+		nt_buffer[16 * NT_NUM_KEYS/8 + 3 * NT_NUM_KEYS/8 + i] = d;
+	}
+}
 PRIVATE void crypt_ntlm_protocol_avx2(CryptParam* param)
 {
-	crypt_ntlm_protocol_body(param, crypt_ntlm_avx2_kernel_asm);
+	crypt_ntlm_protocol_body(param, crypt_ntlm_kernel_avx2);
 }
 #endif
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+PRIVATE HS_TARGET("avx512f") void crypt_ntlm_kernel_avx512(uint32_t* buffer)
+{
+	AVX512_WORD* nt_buffer = (AVX512_WORD*)buffer;
+
+	for (int i = 0; i < NT_NUM_KEYS/16; i++)
+	{
+		/* Round 1 */
+		AVX512_WORD a = AVX512_ADD(AVX512_CONST(0xFFFFFFFF), nt_buffer[0*NT_NUM_KEYS/16+i]); a = AVX512_ROTATE(a, 3);
+		AVX512_WORD d = AVX512_3ADD(AVX512_CONST(INIT_D), AVX512_XOR(AVX512_CONST(INIT_C), AVX512_AND(a, AVX512_CONST(0x77777777))), nt_buffer[1*NT_NUM_KEYS/16+i]); d = AVX512_ROTATE(d, 7);
+		AVX512_WORD c = AVX512_3ADD(AVX512_CONST(INIT_C), AVX512_XOR(AVX512_CONST(INIT_B), AVX512_AND(d, AVX512_XOR(a, AVX512_CONST(INIT_B)))), nt_buffer[2*NT_NUM_KEYS/16+i]); c = AVX512_ROTATE(c, 11);
+		AVX512_WORD b = AVX512_3ADD(AVX512_CONST(INIT_B), AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))), nt_buffer[3*NT_NUM_KEYS/16+i]); b = AVX512_ROTATE(b, 19);
+
+		a = AVX512_3ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))), nt_buffer[4*NT_NUM_KEYS/16+i]); a = AVX512_ROTATE(a, 3);
+		d = AVX512_3ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))), nt_buffer[5*NT_NUM_KEYS/16+i]); d = AVX512_ROTATE(d, 7);
+		c = AVX512_3ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))), nt_buffer[6*NT_NUM_KEYS/16+i]); c = AVX512_ROTATE(c, 11);
+		b = AVX512_3ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))), nt_buffer[7*NT_NUM_KEYS/16+i]); b = AVX512_ROTATE(b, 19);
+
+		a = AVX512_3ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))), nt_buffer[8*NT_NUM_KEYS/16+i]); a = AVX512_ROTATE(a, 3);
+		d = AVX512_3ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))), nt_buffer[9*NT_NUM_KEYS/16+i]); d = AVX512_ROTATE(d, 7);
+		c = AVX512_3ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))), nt_buffer[10*NT_NUM_KEYS/16+i]); c = AVX512_ROTATE(c, 11);
+		b = AVX512_3ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a))), nt_buffer[11*NT_NUM_KEYS/16+i]); b = AVX512_ROTATE(b, 19);
+
+		a = AVX512_3ADD(a, AVX512_XOR(d, AVX512_AND(b, AVX512_XOR(c, d))), nt_buffer[12*NT_NUM_KEYS/16+i]); a = AVX512_ROTATE(a, 3);
+		d = AVX512_3ADD(d, AVX512_XOR(c, AVX512_AND(a, AVX512_XOR(b, c))), nt_buffer[13*NT_NUM_KEYS/16+i]); d = AVX512_ROTATE(d, 7);
+		c = AVX512_3ADD(c, AVX512_XOR(b, AVX512_AND(d, AVX512_XOR(a, b))), nt_buffer[14*NT_NUM_KEYS/16+i]); c = AVX512_ROTATE(c, 11);
+		b = AVX512_ADD(b, AVX512_XOR(a, AVX512_AND(c, AVX512_XOR(d, a)))); b = AVX512_ROTATE(b, 19);
+
+		/* Round 2 */
+		a = AVX512_4ADD(a, AVX512_OR(AVX512_AND(b, AVX512_OR(c, d)), AVX512_AND(c, d)), nt_buffer[0*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_OR(AVX512_AND(a, AVX512_OR(b, c)), AVX512_AND(b, c)), nt_buffer[4*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); d = AVX512_ROTATE(d, 5);
+		c = AVX512_4ADD(c, AVX512_OR(AVX512_AND(d, AVX512_OR(a, b)), AVX512_AND(a, b)), nt_buffer[8*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); c = AVX512_ROTATE(c, 9);
+		b = AVX512_4ADD(b, AVX512_OR(AVX512_AND(c, AVX512_OR(d, a)), AVX512_AND(d, a)), nt_buffer[12*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); b = AVX512_ROTATE(b, 13);
+
+		a = AVX512_4ADD(a, AVX512_OR(AVX512_AND(b, AVX512_OR(c, d)), AVX512_AND(c, d)), nt_buffer[1*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_OR(AVX512_AND(a, AVX512_OR(b, c)), AVX512_AND(b, c)), nt_buffer[5*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); d = AVX512_ROTATE(d, 5);
+		c = AVX512_4ADD(c, AVX512_OR(AVX512_AND(d, AVX512_OR(a, b)), AVX512_AND(a, b)), nt_buffer[9*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); c = AVX512_ROTATE(c, 9);
+		b = AVX512_4ADD(b, AVX512_OR(AVX512_AND(c, AVX512_OR(d, a)), AVX512_AND(d, a)), nt_buffer[13*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); b = AVX512_ROTATE(b, 13);
+
+		a = AVX512_4ADD(a, AVX512_OR(AVX512_AND(b, AVX512_OR(c, d)), AVX512_AND(c, d)), nt_buffer[2*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_OR(AVX512_AND(a, AVX512_OR(b, c)), AVX512_AND(b, c)), nt_buffer[6*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); d = AVX512_ROTATE(d, 5);
+		c = AVX512_4ADD(c, AVX512_OR(AVX512_AND(d, AVX512_OR(a, b)), AVX512_AND(a, b)), nt_buffer[10*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); c = AVX512_ROTATE(c, 9);
+		b = AVX512_4ADD(b, AVX512_OR(AVX512_AND(c, AVX512_OR(d, a)), AVX512_AND(d, a)), nt_buffer[14*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); b = AVX512_ROTATE(b, 13);
+
+		a = AVX512_4ADD(a, AVX512_OR(AVX512_AND(b, AVX512_OR(c, d)), AVX512_AND(c, d)), nt_buffer[3*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_OR(AVX512_AND(a, AVX512_OR(b, c)), AVX512_AND(b, c)), nt_buffer[7*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); d = AVX512_ROTATE(d, 5);
+		c = AVX512_4ADD(c, AVX512_OR(AVX512_AND(d, AVX512_OR(a, b)), AVX512_AND(a, b)), nt_buffer[11*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_2)); c = AVX512_ROTATE(c, 9);
+		b = AVX512_3ADD(b, AVX512_OR(AVX512_AND(c, AVX512_OR(d, a)), AVX512_AND(d, a)), AVX512_CONST(SQRT_2)); b = AVX512_ROTATE(b, 13);
+
+		/* Round 3 */
+		a = AVX512_4ADD(a, AVX512_3XOR(d, c, b), nt_buffer[0*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_3XOR(c, b, a), nt_buffer[8*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); d = AVX512_ROTATE(d, 9);
+		c = AVX512_4ADD(c, AVX512_3XOR(b, a, d), nt_buffer[4*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); c = AVX512_ROTATE(c, 11);
+		b = AVX512_4ADD(b, AVX512_3XOR(a, d, c), nt_buffer[12*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); b = AVX512_ROTATE(b, 15);
+
+		a = AVX512_4ADD(a, AVX512_3XOR(d, c, b), nt_buffer[2*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_3XOR(c, b, a), nt_buffer[10*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); d = AVX512_ROTATE(d, 9);
+		c = AVX512_4ADD(c, AVX512_3XOR(b, a, d), nt_buffer[6*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); c = AVX512_ROTATE(c, 11);
+		b = AVX512_4ADD(b, AVX512_3XOR(a, d, c), nt_buffer[14*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); b = AVX512_ROTATE(b, 15);
+
+		a = AVX512_4ADD(a, AVX512_3XOR(d, c, b), nt_buffer[1*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); a = AVX512_ROTATE(a, 3);
+		d = AVX512_4ADD(d, AVX512_3XOR(c, b, a), nt_buffer[9*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); d = AVX512_ROTATE(d, 9);
+		c = AVX512_4ADD(c, AVX512_3XOR(b, a, d), nt_buffer[5*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); c = AVX512_ROTATE(c, 11);
+		b = AVX512_4ADD(b, AVX512_3XOR(a, d, c), nt_buffer[13*NT_NUM_KEYS/16+i], AVX512_CONST(SQRT_3)); b = AVX512_ROTATE(b, 15);
+
+		a = AVX512_3ADD(a, AVX512_3XOR(b, d, c), nt_buffer[3*NT_NUM_KEYS/16+i]);
+
+		// Save
+		nt_buffer[16 * NT_NUM_KEYS/16 + i] = a;
+		nt_buffer[16 * NT_NUM_KEYS/16 + 1 * NT_NUM_KEYS/16 + i] = b;
+		nt_buffer[16 * NT_NUM_KEYS/16 + 2 * NT_NUM_KEYS/16 + i] = c;
+		nt_buffer[16 * NT_NUM_KEYS/16 + 3 * NT_NUM_KEYS/16 + i] = d;
+	}
+}
+PRIVATE void crypt_ntlm_protocol_avx512(CryptParam* param)
+{
+	crypt_ntlm_protocol_body(param, crypt_ntlm_kernel_avx512);
+}
+#endif
 
+#ifdef HS_TESTING
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// SSE2 Implementation
+// Test all kernels compiled, not only the selected one
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define NTLM_TEST_BATCHES	16
+PRIVATE const struct
+{
+	int needed_cap;
+	crypt_kernel_asm_func* kernel;
+	const char* name;
+}
+ntlm_kernels[] = {
+#ifndef _M_X64
+	{CPU_CAP_C_CODE, crypt_ntlm_kernel_c, "C code"},
+#endif
+#ifdef HS_ARM
+	{CPU_CAP_NEON, crypt_ntlm_neon_kernel_asm, "Neon"},
+#endif
 #ifdef HS_X86
-void crypt_ntlm_sse2_kernel_asm(uint32_t* nt_buffer);
-PRIVATE void crypt_ntlm_protocol_sse2(CryptParam* param)
+	{CPU_CAP_SSE2, crypt_ntlm_kernel_sse2, "SSE2"},
+#endif
+#ifdef _M_X64
+	{CPU_CAP_AVX, crypt_ntlm_kernel_avx, "AVX"},
+	{CPU_CAP_AVX2, crypt_ntlm_kernel_avx2, "AVX2"},
+	{CPU_CAP_AVX512, crypt_ntlm_kernel_avx512, "AVX512"},
+#endif
+};
+// Same layout as the key-providers: UTF-16 with the 0x80 padding and the bit length in word 14
+PRIVATE void test_put_ntlm_key(uint32_t* nt_buffer, uint32_t index, const unsigned char* key)
+{
+	uint32_t len = (uint32_t)strlen((const char*)key);
+	uint32_t i = 0;
+
+	for (uint32_t j = 0; j < 16; j++)
+		nt_buffer[j * NT_NUM_KEYS + index] = 0;
+
+	for (; i < len / 2; i++)
+		nt_buffer[i * NT_NUM_KEYS + index] = key[2 * i] | (key[2 * i + 1] << 16);
+
+	nt_buffer[i * NT_NUM_KEYS + index] = (len % 2) ? key[2 * i] | 0x800000 : 0x80;
+	nt_buffer[14 * NT_NUM_KEYS + index] = len << 4;
+}
+PUBLIC int test_ntlm_kernels()
 {
-	crypt_ntlm_protocol_body(param, crypt_ntlm_sse2_kernel_asm);
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc(16 * 4 * NT_NUM_KEYS + 4 * 4 * NT_NUM_KEYS, 64);
+	unsigned char (*keys)[NTLM_MAX_KEY_LENGHT + 1] = (unsigned char(*)[NTLM_MAX_KEY_LENGHT + 1])malloc(NT_NUM_KEYS * (NTLM_MAX_KEY_LENGHT + 1));
+	uint32_t (*binaries)[BINARY_SIZE / sizeof(uint32_t)] = (uint32_t(*)[BINARY_SIZE / sizeof(uint32_t)])malloc(NT_NUM_KEYS * BINARY_SIZE);
+	int result = TRUE;
+
+	if (!nt_buffer || !keys || !binaries)
+	{
+		hs_log(HS_LOG_ERROR, "Test Suite", "NTLM kernels test: not enough memory");
+		if (nt_buffer) _aligned_free(nt_buffer);
+		free(keys);
+		free(binaries);
+		return FALSE;
+	}
+
+	for (uint32_t batch = 0; batch < NTLM_TEST_BATCHES; batch++)
+	{
+		// Random printable keys of all lengths
+		for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+		{
+			char hash[48];
+			uint32_t len = i % (NTLM_MAX_KEY_LENGHT + 1);
+
+			generate_random(keys[i], len);
+			for (uint32_t j = 0; j < len; j++)
+				keys[i][j] = ' ' + keys[i][j] % 95;
+			keys[i][len] = 0;
+
+			hash_ntlm(keys[i], hash);
+			get_binary((const unsigned char*)hash, binaries[i], NULL);
+		}
+
+		for (uint32_t k = 0; k < LENGTH(ntlm_kernels); k++)
+			if (current_cpu.capabilites[ntlm_kernels[k].needed_cap])
+			{
+				for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+					test_put_ntlm_key(nt_buffer, i, keys[i]);
+
+				ntlm_kernels[k].kernel(nt_buffer);
+
+				for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+					if (!compare_binary(i, binaries[i], nt_buffer))
+					{
+						hs_log(HS_LOG_ERROR, "Test Suite", "NTLM %s kernel fails with key: '%s'", ntlm_kernels[k].name, keys[i]);
+						result = FALSE;
+					}
+			}
+	}
+
+	free(binaries);
+	free(keys);
+	_aligned_free(nt_buffer);
+	return result;
 }
 #endif
 
@@ -1115,7 +1478,7 @@ PRIVATE int ocl_protocol_charset_init(OpenCL_Param* result, cl_uint gpu_index, g
 			bin[3] += (ROTATE(bin[0] + SQRT_3, 3) ^ bin[1] ^ bin[2]);
 		}
 
-		free(cbg_table);
+		large_page_free(cbg_table);
 		large_page_free(cbg_filter);
 
 		cbg_table = old_cbg_table;
@@ -1807,12 +2170,12 @@ Format ntlm_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_NTLM, crypt_ntlm_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_NTLM, crypt_ntlm_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_NTLM, crypt_ntlm_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_NEON, PROTOCOL_NTLM, crypt_ntlm_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
+		{{CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_NTLM, crypt_ntlm_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_NTLM, crypt_ntlm_protocol_c_code}},
 	#endif
 #endif
 	#ifdef HS_OPENCL_SUPPORT
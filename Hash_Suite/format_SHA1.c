@@ -195,6 +195,18 @@ PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* unpa
 PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_asm_func* crypt_kernel_asm)
 {
 	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
+	uint32_t* candidates = (uint32_t*)malloc(8 * sizeof(uint32_t) * NT_NUM_KEYS);
+
+	if (!nt_buffer || !candidates)
+	{
+		// Not enough memory: stop the attack so it can be resumed later
+		hs_log(HS_LOG_ERROR, "Raw-SHA1", "Not enough memory for the thread buffers");
+		continue_attack = FALSE;
+		if (nt_buffer) _aligned_free(nt_buffer);
+		free(candidates);
+		finish_thread();
+		return;
+	}
 
 	uint32_t* unpacked_W  = nt_buffer  + 8 * NT_NUM_KEYS;
 	uint32_t* unpacked_as = unpacked_W + 2 * NT_NUM_KEYS;
@@ -204,49 +216,60 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_as
 
 	memset(nt_buffer, 0, 8 * sizeof(uint32_t)* NT_NUM_KEYS);
 	memset(key, 0, sizeof(key));
+	int use_filter_batch = num_passwords_loaded >= CBG_FILTER_BATCH_MIN_HASHES;
 
 	while (continue_attack && param->gen(nt_buffer, NT_NUM_KEYS, param->thread_id))
 	{
 		crypt_kernel_asm(nt_buffer);
 
-		for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+		if (use_filter_batch)
 		{
-			uint32_t up0 = unpacked_as[i];
-			uint32_t up1 = unpacked_es[i];
-
-			uint32_t pos = up0 & cbg_mask;
-			uint_fast16_t data = cbg_filter[pos];
-			if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-				password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-			// 2nd pos
-			if (data & 0b110)
+			// Filter all keys first with prefetch, then compare the few candidates
+			uint32_t num_candidates = cbg_filter_batch(unpacked_as, unpacked_es, NT_NUM_KEYS, candidates);
+			for (uint32_t j = 0; j < num_candidates; j += 2)
+				if (compare_elem(candidates[j], candidates[j + 1], unpacked_W))
+					password_was_found(candidates[j + 1], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, candidates[j]));// Total match
+		}
+		else// Few hashes: the filter stays in cache, compare each key in turn
+			for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
 			{
-				pos += data & 0b1 ? -1 : 1;
-				uint_fast16_t hash = cbg_filter[pos];
-				if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+				uint32_t up0 = unpacked_as[i];
+				uint32_t up1 = unpacked_es[i];
+
+				uint32_t pos = up0 & cbg_mask;
+				uint_fast16_t data = cbg_filter[pos];
+				if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
 					password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
 
-				// Unluky bucket
-				if (data & 0b10)
+				// 2nd pos
+				if (data & 0b110)
 				{
-					pos = up1 & cbg_mask;
-					data = cbg_filter[pos];
-					if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-						password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-					// 2nd pos
 					pos += data & 0b1 ? -1 : 1;
-					hash = cbg_filter[pos];
-					if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+					uint_fast16_t hash = cbg_filter[pos];
+					if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
 						password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+					// Unluky bucket
+					if (data & 0b10)
+					{
+						pos = up1 & cbg_mask;
+						data = cbg_filter[pos];
+						if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+							password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+						// 2nd pos
+						pos += data & 0b1 ? -1 : 1;
+						hash = cbg_filter[pos];
+						if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+							password_was_found(cbg_table[pos], utf8_be_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+					}
 				}
 			}
-		}
 
 		report_keys_processed(NT_NUM_KEYS);
 	}
 
+	free(candidates);
 	_aligned_free(nt_buffer);
 
 	finish_thread();
@@ -554,6 +577,144 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 #endif
 
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+#undef SHA1_NUM
+#undef DCC2_R
+#define SHA1_NUM		(NT_NUM_KEYS/16)
+#define LOAD_BIG_ENDIAN_AVX512(x,data) x = AVX512_ROTATE(data, 16); x = AVX512_ADD(AVX512_SL(AVX512_AND(x, mask), 8), AVX512_AND(AVX512_SR(x, 8), mask));
+#define DCC2_R(w0, w1, w2, w3)	W[w0*SHA1_NUM] = AVX512_ROTATE(AVX512_4XOR(W[w0*SHA1_NUM], W[w1*SHA1_NUM], W[w2*SHA1_NUM], W[w3*SHA1_NUM]), 1)
+
+PRIVATE HS_TARGET("avx512f") void crypt_kernel_avx512(AVX512_WORD* nt_buffer)
+{
+	AVX512_WORD* W = nt_buffer + 8 *SHA1_NUM;
+	AVX512_WORD mask = AVX512_CONST(0x00FF00FF);
+	AVX512_WORD step_const;
+	for (int i = 0; i < SHA1_NUM; i++, nt_buffer++, W++)
+	{
+		LOAD_BIG_ENDIAN_AVX512(W[0*SHA1_NUM], nt_buffer[0*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[1*SHA1_NUM], nt_buffer[1*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[2*SHA1_NUM], nt_buffer[2*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[3*SHA1_NUM], nt_buffer[3*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[4*SHA1_NUM], nt_buffer[4*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[5*SHA1_NUM], nt_buffer[5*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[6*SHA1_NUM], nt_buffer[6*SHA1_NUM]);
+		W[15*SHA1_NUM] = nt_buffer[7*SHA1_NUM];
+		nt_buffer[0*SHA1_NUM] = W[0*SHA1_NUM];
+		nt_buffer[1*SHA1_NUM] = W[1*SHA1_NUM];
+		nt_buffer[2*SHA1_NUM] = W[2*SHA1_NUM];
+		nt_buffer[3*SHA1_NUM] = W[3*SHA1_NUM];
+		nt_buffer[4*SHA1_NUM] = W[4*SHA1_NUM];
+		nt_buffer[5*SHA1_NUM] = W[5*SHA1_NUM];
+		nt_buffer[6*SHA1_NUM] = W[6*SHA1_NUM];
+
+		/* Round 1 */
+		AVX512_WORD E = AVX512_ADD(AVX512_CONST(0x9fb498b3), W[0*SHA1_NUM]);
+		AVX512_WORD D = AVX512_3ADD(AVX512_ROTATE(E, 5), AVX512_CONST(0x66b0cd0d), W[1*SHA1_NUM]);
+		AVX512_WORD C = AVX512_4ADD(AVX512_ROTATE(D, 5), AVX512_XOR(AVX512_CONST(0x7bf36ae2), AVX512_AND(E, AVX512_CONST(0x22222222))), AVX512_CONST(0xf33d5697), W[2*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		AVX512_WORD B = AVX512_4ADD(AVX512_ROTATE(C, 5), AVX512_XOR(AVX512_CONST(0x59d148c0), AVX512_AND(D, AVX512_XOR(E, AVX512_CONST(0x59d148c0)))), AVX512_CONST(0xd675e47b), W[3*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		AVX512_WORD A = AVX512_4ADD(AVX512_ROTATE(B, 5), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), AVX512_CONST(0xb453c259), W[4*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+
+		step_const = AVX512_CONST(SQRT_2);
+																								 E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), step_const, W[5 *SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+																								 D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), step_const, W[6 *SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+																								 C = AVX512_4ADD(C, AVX512_ROTATE(D, 5), AVX512_XOR(B, AVX512_AND(E, AVX512_XOR(A, B))), step_const				 ); E = AVX512_ROTATE(E, 30);
+																								 B = AVX512_4ADD(B, AVX512_ROTATE(C, 5), AVX512_XOR(A, AVX512_AND(D, AVX512_XOR(E, A))), step_const				 ); D = AVX512_ROTATE(D, 30);
+																								 A = AVX512_4ADD(A, AVX512_ROTATE(B, 5), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), step_const				 ); C = AVX512_ROTATE(C, 30);
+																								 E = AVX512_4ADD(E, AVX512_ROTATE(A, 5), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), step_const				 ); B = AVX512_ROTATE(B, 30);
+																								 D = AVX512_4ADD(D, AVX512_ROTATE(E, 5), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), step_const				 ); A = AVX512_ROTATE(A, 30);
+																								 C = AVX512_4ADD(C, AVX512_ROTATE(D, 5), AVX512_XOR(B, AVX512_AND(E, AVX512_XOR(A, B))), step_const				 ); E = AVX512_ROTATE(E, 30);
+																								 B = AVX512_4ADD(B, AVX512_ROTATE(C, 5), AVX512_XOR(A, AVX512_AND(D, AVX512_XOR(E, A))), step_const				 ); D = AVX512_ROTATE(D, 30);
+																								 A = AVX512_4ADD(A, AVX512_ROTATE(B, 5), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), step_const				 ); C = AVX512_ROTATE(C, 30);
+																								 E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), step_const, W[15*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		W[0*SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[0*SHA1_NUM], W[2 *SHA1_NUM]				  ), 1); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), step_const, W[0 *SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		W[1*SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[1*SHA1_NUM], W[3 *SHA1_NUM]				  ), 1); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_XOR(B, AVX512_AND(E, AVX512_XOR(A, B))), step_const, W[1 *SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		W[2*SHA1_NUM] = AVX512_ROTATE(AVX512_3XOR(W[2*SHA1_NUM], W[15*SHA1_NUM], W[4*SHA1_NUM]), 1); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_XOR(A, AVX512_AND(D, AVX512_XOR(E, A))), step_const, W[2 *SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		W[3*SHA1_NUM] = AVX512_ROTATE(AVX512_3XOR(W[3*SHA1_NUM], W[ 0*SHA1_NUM], W[5*SHA1_NUM]), 1); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), step_const, W[3 *SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+
+		/* Round 2 */
+		step_const = AVX512_CONST(SQRT_3);
+		W[4 *SHA1_NUM] = AVX512_ROTATE(AVX512_3XOR(W[4 *SHA1_NUM], W[1 *SHA1_NUM], W[6 *SHA1_NUM]), 1); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[4 *SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		W[5 *SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[5 *SHA1_NUM], W[2 *SHA1_NUM])				  , 1); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[5 *SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		W[6 *SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[6 *SHA1_NUM], W[3 *SHA1_NUM])				  , 1); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[6 *SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		W[7 *SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[4 *SHA1_NUM], W[15*SHA1_NUM])				  , 1); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[7 *SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		W[8 *SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[5 *SHA1_NUM], W[ 0*SHA1_NUM])				  , 1); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[8 *SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		W[9 *SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[6 *SHA1_NUM], W[ 1*SHA1_NUM])				  , 1); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[9 *SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		W[10*SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[7 *SHA1_NUM], W[ 2*SHA1_NUM])				  , 1); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[10*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		W[11*SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[8 *SHA1_NUM], W[ 3*SHA1_NUM])				  , 1); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[11*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		W[12*SHA1_NUM] = AVX512_ROTATE(AVX512_XOR (W[9 *SHA1_NUM], W[ 4*SHA1_NUM])				  , 1); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[12*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		W[13*SHA1_NUM] = AVX512_ROTATE(AVX512_3XOR(W[10*SHA1_NUM], W[ 5*SHA1_NUM], W[15*SHA1_NUM]), 1); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[13*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		W[14*SHA1_NUM] = AVX512_ROTATE(AVX512_3XOR(W[11*SHA1_NUM], W[ 6*SHA1_NUM], W[ 0*SHA1_NUM]), 1); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[14*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R(15, 12, 7,  1)																	  ; D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[15*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R(0 , 13, 8,  2)																	  ; C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[0 *SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R(1 , 14, 9,  3)																	  ; B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[1 *SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R(2 , 15, 10, 4)																	  ; A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[2 *SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R(3 ,  0, 11, 5)																	  ; E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[3 *SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R(4 ,  1, 12, 6)																	  ; D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[4 *SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R(5 ,  2, 13, 7)																	  ; C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[5 *SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R(6 ,  3, 14, 8)																	  ; B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[6 *SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R(7 ,  4, 15, 9)																	  ; A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[7 *SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+										  
+		/* Round 3 */
+		step_const = AVX512_CONST(0x8F1BBCDC);
+		DCC2_R( 8, 5,  0, 10); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))), step_const, W[ 8*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R( 9, 6,  1, 11); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))), step_const, W[ 9*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R(10, 7,  2, 12); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_OR(AVX512_AND(E, A), AVX512_AND(B, AVX512_OR(E, A))), step_const, W[10*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R(11, 8,  3, 13); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_OR(AVX512_AND(D, E), AVX512_AND(A, AVX512_OR(D, E))), step_const, W[11*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R(12, 9,  4, 14); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))), step_const, W[12*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R(13, 10, 5, 15); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))), step_const, W[13*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R(14, 11, 6,  0); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))), step_const, W[14*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R(15, 12, 7,  1); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_OR(AVX512_AND(E, A), AVX512_AND(B, AVX512_OR(E, A))), step_const, W[15*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R( 0, 13, 8,  2); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_OR(AVX512_AND(D, E), AVX512_AND(A, AVX512_OR(D, E))), step_const, W[ 0*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R( 1, 14, 9,  3); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))), step_const, W[ 1*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R( 2, 15, 10, 4); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))), step_const, W[ 2*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R( 3, 0, 11,  5); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))), step_const, W[ 3*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R( 4, 1, 12,  6); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_OR(AVX512_AND(E, A), AVX512_AND(B, AVX512_OR(E, A))), step_const, W[ 4*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R( 5, 2, 13,  7); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_OR(AVX512_AND(D, E), AVX512_AND(A, AVX512_OR(D, E))), step_const, W[ 5*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R( 6, 3, 14,  8); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))), step_const, W[ 6*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R( 7, 4, 15,  9); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))), step_const, W[ 7*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R( 8, 5,  0, 10); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))), step_const, W[ 8*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R( 9, 6,  1, 11); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_OR(AVX512_AND(E, A), AVX512_AND(B, AVX512_OR(E, A))), step_const, W[ 9*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R(10, 7,  2, 12); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_OR(AVX512_AND(D, E), AVX512_AND(A, AVX512_OR(D, E))), step_const, W[10*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R(11, 8,  3, 13); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))), step_const, W[11*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+										  
+		/* Round 4 */
+		step_const = AVX512_CONST(0xCA62C1D6);
+		DCC2_R(12, 9, 4, 14); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[12*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R(13,10, 5, 15); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[13*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R(14, 11, 6, 0); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[14*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R(15, 12, 7, 1); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[15*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R( 0, 13, 8, 2); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[ 0*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R( 1, 14, 9, 3); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[ 1*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R(2, 15, 10, 4); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[ 2*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R( 3, 0, 11, 5); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[ 3*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R( 4, 1, 12, 6); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[ 4*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R( 5, 2, 13, 7); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[ 5*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R( 6, 3, 14, 8); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[ 6*SHA1_NUM]); B = AVX512_ROTATE(B, 30);
+		DCC2_R( 7, 4, 15, 9); D = AVX512_5ADD(D, AVX512_ROTATE(E, 5), AVX512_3XOR(A, B, C), step_const, W[ 7*SHA1_NUM]); A = AVX512_ROTATE(A, 30);
+		DCC2_R( 8, 5, 0, 10); C = AVX512_5ADD(C, AVX512_ROTATE(D, 5), AVX512_3XOR(E, A, B), step_const, W[ 8*SHA1_NUM]); E = AVX512_ROTATE(E, 30);
+		DCC2_R( 9, 6, 1, 11); B = AVX512_5ADD(B, AVX512_ROTATE(C, 5), AVX512_3XOR(D, E, A), step_const, W[ 9*SHA1_NUM]); D = AVX512_ROTATE(D, 30);
+		DCC2_R(10, 7, 2, 12); A = AVX512_5ADD(A, AVX512_ROTATE(B, 5), AVX512_3XOR(C, D, E), step_const, W[10*SHA1_NUM]); C = AVX512_ROTATE(C, 30);
+		DCC2_R(11, 8, 3, 13); E = AVX512_5ADD(E, AVX512_ROTATE(A, 5), AVX512_3XOR(B, C, D), step_const, W[11*SHA1_NUM]);
+			
+		DCC2_R(12, 9, 4, 14); DCC2_R(15, 12, 7, 1); A = AVX512_ADD(AVX512_ROTATE(A, 30), W[15*SHA1_NUM]);
+
+		// Save
+		W[2 * SHA1_NUM] = A;
+		W[4 * SHA1_NUM] = B;
+		W[9 * SHA1_NUM] = C;
+		W[8 * SHA1_NUM] = D;
+		W[3 * SHA1_NUM] = E;
+	}
+}
+PRIVATE void crypt_utf8_coalesc_protocol_avx512(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_body(param, (crypt_kernel_asm_func*)crypt_kernel_avx512);
+}
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementations
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2409,12 +2570,12 @@ Format raw_sha1_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
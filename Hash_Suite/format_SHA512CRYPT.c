@@ -216,6 +216,64 @@ PRIVATE void binary2hex(const void* binary, const uint8_t* salt, unsigned char*
 	pos[2] = 0;
 }
 
+// Order salts by rounds, so cheap salts are finished first
+PRIVATE int compare_salt_cost(const void* arg1, const void* arg2)
+{
+	const uint32_t* salt1 = (const uint32_t*)arg1;
+	const uint32_t* salt2 = (const uint32_t*)arg2;
+
+	// Compare rounds, then original position
+	for (int i = 0; i < 2; i++)
+		if (salt1[i] != salt2[i])
+			return salt1[i] < salt2[i] ? -1 : 1;
+
+	return 0;
+}
+PRIVATE void optimize_hashes()
+{
+	crypt_sha256_salt* salts = (crypt_sha256_salt*)salts_values;
+
+	// Common case: salts already ordered, usually all with default rounds
+	uint32_t i = 1;
+	for (; i < num_diff_salts && salts[i - 1].rounds <= salts[i].rounds; i++);
+	if (i >= num_diff_salts)
+		return;
+
+	uint32_t* salt_cost = (uint32_t*)malloc(2 * sizeof(uint32_t) * num_diff_salts);
+	crypt_sha256_salt* old_salts = (crypt_sha256_salt*)malloc(sizeof(crypt_sha256_salt) * num_diff_salts);
+	uint32_t* old_salt_index = (uint32_t*)malloc(sizeof(uint32_t) * num_diff_salts);
+
+	// Not enough memory: only slower, keep the current order
+	if (!salt_cost || !old_salts || !old_salt_index)
+	{
+		free(salt_cost);
+		free(old_salts);
+		free(old_salt_index);
+		return;
+	}
+
+	memcpy(old_salts, salts, sizeof(crypt_sha256_salt) * num_diff_salts);
+	memcpy(old_salt_index, salt_index, sizeof(uint32_t) * num_diff_salts);
+	for (i = 0; i < num_diff_salts; i++)
+	{
+		salt_cost[2 * i + 0] = salts[i].rounds;
+		salt_cost[2 * i + 1] = i;
+	}
+	qsort(salt_cost, num_diff_salts, 2 * sizeof(uint32_t), compare_salt_cost);
+
+	for (i = 0; i < num_diff_salts; i++)
+	{
+		salts[i] = old_salts[salt_cost[2 * i + 1]];
+		salt_index[i] = old_salt_index[salt_cost[2 * i + 1]];
+	}
+
+	free(salt_cost);
+	free(old_salts);
+	free(old_salt_index);
+	// Salts are no longer in the same order as hashes
+	cache_had_hashes = FALSE;
+}
+
 
 void sha512_process_block(uint64_t* state, uint64_t* W);
 #define SHA512_INIT_STATE(state) \
@@ -327,14 +385,234 @@ PRIVATE void pre_cycle(const char* cleartext, uint32_t key_len, const crypt_sha2
 typedef void copy_pattern_same_size_func(void* pattern, const void* state);
 PRIVATE uint8_t g[] = { 0, 7, 3, 5, 3, 7, 1, 6, 3, 5, 3, 7, 1, 7, 2, 5, 3, 7, 1, 7, 3, 4, 3, 7, 1, 7, 3, 5, 2, 7, 1, 7, 3, 5, 3, 6, 1, 7, 3, 5, 3, 7 };
 typedef void sha512_process_block_func(void* state, void* tmp_block, const void* block);
-PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, sha512_process_block_func* kernels_asm[], uint32_t keys_in_parallel, copy_pattern_same_size_func* copy_asm[])
+// Copy state at the end of the pattern for only one key. Used when keys of different lengths share the SIMD batch
+PRIVATE void copy_pattern_by_key(uint64_t* pattern, const uint64_t* state, uint32_t len, uint32_t keys_in_parallel)
+{
+	uint32_t shift = (len & 7) * 8;
+	pattern += (len / 8) * keys_in_parallel;
+
+	if (shift)
+	{
+		uint64_t buffer_value = pattern[0] & (0xFFFFFFFFFFFFFFFFULL << (64 - shift));
+		for (uint32_t j = 0; j < 8; j++, pattern += keys_in_parallel)
+		{
+			uint64_t state_value = state[j * keys_in_parallel];
+			pattern[0] = buffer_value | (state_value >> shift);
+			buffer_value = state_value << (64 - shift);
+		}
+		pattern[0] = buffer_value | ((0x80ull << 56) >> shift);
+	}
+	else
+	{
+		for (uint32_t j = 0; j < 8; j++)
+			pattern[j * keys_in_parallel] = state[j * keys_in_parallel];
+		pattern[8 * keys_in_parallel] = 0x80ull << 56;
+	}
+}
+// Process keys_in_parallel keys against all salts. Keys may have different lengths, but it is faster if they are equal
+PRIVATE void crypt_keys_batch(sha512_process_block_func* kernels_asm[], uint32_t keys_in_parallel, copy_pattern_same_size_func* copy_asm[], uint64_t* sha256_buffer, uint8_t* simple_buffer, const char** keys, const uint32_t* keys_length, uint32_t num_keys)
 {
-	//                                           keys sha256 tmp state                                   simple_buffer    ordered_keys
-	uint32_t* buffer = (uint32_t*)_aligned_malloc((4 + 32*8 + 16 + 8) * sizeof(uint64_t) * keys_in_parallel + 256 + MAX_KEY_SIZE*(MAX_KEY_SIZE+1)*keys_in_parallel, 32);
-	uint64_t* sha256_buffer = (uint64_t*)(buffer + 8 * keys_in_parallel);// size: 32 * 8 * keys_in_parallel
 	uint64_t* tmp_buffer = sha256_buffer + 32 * 8 * keys_in_parallel;// size: 16 * keys_in_parallel
 	uint64_t* state = tmp_buffer + 16 * keys_in_parallel;// size: 8 * keys_in_parallel
-	uint8_t* simple_buffer = (uint8_t*)(state + 8 * keys_in_parallel);// size: 128
+	uint64_t* saved_state = state + 8 * keys_in_parallel;// size: 8 * keys_in_parallel
+	unsigned char key[MAX_KEY_LENGHT_SMALL];
+
+	// Same length in all keys -> use the fast copy
+	int same_length = TRUE;
+	for (uint32_t i = 1; i < keys_in_parallel; i++)
+		if (keys_length[i] != keys_length[0])
+			same_length = FALSE;
+
+	for (uint32_t current_salt_index = 0; current_salt_index < num_diff_salts; current_salt_index++)
+	{
+		const crypt_sha256_salt* salt = ((crypt_sha256_salt*)salts_values) + current_salt_index;
+
+		// Pre-calculations
+		uint32_t need_2nd_block_by_g[4] = { 0, 0, 0, 0 };
+		uint32_t mixed_2nd_block_by_g[4] = { FALSE, FALSE, FALSE, FALSE };
+		uint32_t len_by_g[4][128];
+		uint32_t need_2nd_block_by_key[4][128];
+
+		for (uint32_t i = 0; i < keys_in_parallel; i++)
+		{
+			len_by_g[0][i] =     keys_length[i];
+			len_by_g[1][i] = 2 * keys_length[i];
+			len_by_g[2][i] =     keys_length[i] + salt->saltlen;
+			len_by_g[3][i] = 2 * keys_length[i] + salt->saltlen;
+
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				need_2nd_block_by_key[j][i] = (len_by_g[j][i] + 64) >= 112 ? 16 : 0;
+				if (i && need_2nd_block_by_key[j][i] != need_2nd_block_by_g[j])
+					mixed_2nd_block_by_g[j] = TRUE;
+				need_2nd_block_by_g[j] |= need_2nd_block_by_key[j][i];
+			}
+		}
+
+		memset(sha256_buffer, 0, 32 * 8 * sizeof(uint64_t) * keys_in_parallel);
+		for (uint32_t i = 0; i < keys_in_parallel; i++)
+		{
+			char p_bytes[MAX_KEY_SIZE];
+			char s_bytes[MAX_SALT_SIZE];
+			uint64_t tmp_state[8];
+			uint32_t key_length = keys_length[i];
+
+			pre_cycle(keys[i], key_length, salt, simple_buffer, tmp_state, p_bytes, s_bytes);
+			for (uint32_t j = 0; j < 8; j++)
+				state[j * keys_in_parallel + i] = tmp_state[j];
+
+			// Patterns---------------------------------------------------------------------------------------------
+			//pattern[0]=alt pass
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, p_bytes, key_length);
+			simple_buffer[key_length] = 0x80;
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 0 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[1]=alt pass pass
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, p_bytes, key_length);
+			memcpy(simple_buffer + key_length, p_bytes, key_length);
+			simple_buffer[2 * key_length] = 0x80;
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 1 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[2]=alt salt pass
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, s_bytes, salt->saltlen);
+			memcpy(simple_buffer + salt->saltlen, p_bytes, key_length);
+			simple_buffer[salt->saltlen + key_length] = 0x80;
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 2 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[3]=alt salt pass pass
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, s_bytes, salt->saltlen);
+			memcpy(simple_buffer + salt->saltlen, p_bytes, key_length);
+			memcpy(simple_buffer + salt->saltlen + key_length, p_bytes, key_length);
+			simple_buffer[salt->saltlen + 2 * key_length] = 0x80;
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 3 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[4]=pass alt
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, p_bytes, key_length);
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 4 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[5]=pass pass alt
+			memset(simple_buffer, 0, 256);
+			memcpy(simple_buffer, p_bytes, key_length);
+			memcpy(simple_buffer + key_length, p_bytes, key_length);
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < 32; j++)
+				sha256_buffer[(32 * 5 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[6]=pass salt alt
+			memcpy(simple_buffer, p_bytes, key_length);
+			memcpy(simple_buffer + key_length, s_bytes, salt->saltlen);
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < (key_length + salt->saltlen + 7) / 8; j++)
+				sha256_buffer[(32 * 6 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+			//pattern[7]=pass salt pass alt
+			memcpy(simple_buffer, p_bytes, key_length);
+			memcpy(simple_buffer + key_length, s_bytes, salt->saltlen);
+			memcpy(simple_buffer + key_length + salt->saltlen, p_bytes, key_length);
+			swap_endianness_array64((uint64_t*)simple_buffer, 32);
+			for (uint32_t j = 0; j < (2 * key_length + salt->saltlen + 7) / 8; j++)
+				sha256_buffer[(32 * 7 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
+
+			// Size
+			for (uint32_t j = 0; j < 4; j++)
+			{
+				sha256_buffer[(32 * (j + 0) + need_2nd_block_by_key[j][i] + 15) * keys_in_parallel + i] = (len_by_g[j][i] + 64ull) << 3;
+				sha256_buffer[(32 * (j + 4) + need_2nd_block_by_key[j][i] + 15) * keys_in_parallel + i] = (len_by_g[j][i] + 64ull) << 3;
+			}
+			// end patterns------------------------------------------------------------------------------------------------------------
+		}
+
+		// Big cycle
+		swap_endianness_array64(state, 8 * keys_in_parallel);
+		for (uint32_t k = 0, g_index = 0; k < salt->rounds; k++, g_index++)
+		{
+			uint64_t* pattern_buffer = sha256_buffer + 32 * keys_in_parallel * g[g_index];
+			uint32_t need_2nd_block = need_2nd_block_by_g[g[g_index] & 3];
+			if (k & 1)// Copy at end
+			{
+				if (same_length)
+				{
+					uint32_t len = len_by_g[g[g_index] & 3][0];
+					uint32_t len3 = len & 7;
+					len /= 8;
+
+					if (len3)// Note: Use 7 versions of functions because register shifts are incredible expensive
+						copy_asm[len3 - 1](pattern_buffer + len * keys_in_parallel, state);
+					else
+					{
+						memcpy(pattern_buffer + len * keys_in_parallel, state, 64 * keys_in_parallel);
+						for (uint32_t i = 0; i < keys_in_parallel; i++)
+							pattern_buffer[(len + 8) * keys_in_parallel + i] = 0x80ull << 56;
+					}
+				}
+				else
+					for (uint32_t i = 0; i < keys_in_parallel; i++)
+						copy_pattern_by_key(pattern_buffer + i, state + i, len_by_g[g[g_index] & 3][i], keys_in_parallel);
+			}
+			else// Copy at begining
+				memcpy(pattern_buffer, state, 64 * keys_in_parallel);
+
+			// Two sha512 calls
+			kernels_asm[0](state, tmp_buffer, pattern_buffer);
+			if (need_2nd_block)
+			{
+				if (mixed_2nd_block_by_g[g[g_index] & 3])
+				{
+					// Keys that finish in the first block don't use the second one
+					const uint32_t* need_2nd_block_by_this_key = need_2nd_block_by_key[g[g_index] & 3];
+					memcpy(saved_state, state, 64 * keys_in_parallel);
+					kernels_asm[1](state, tmp_buffer, pattern_buffer + 16 * keys_in_parallel);
+
+					for (uint32_t i = 0; i < keys_in_parallel; i++)
+						if (!need_2nd_block_by_this_key[i])
+							for (uint32_t j = 0; j < 8; j++)
+								state[j * keys_in_parallel + i] = saved_state[j * keys_in_parallel + i];
+				}
+				else
+					kernels_asm[1](state, tmp_buffer, pattern_buffer + 16 * keys_in_parallel);
+			}
+
+			if (g_index == 41)
+				g_index = -1;
+		}
+
+		// Search for a match
+		uint32_t indx = salt_index[current_salt_index];
+
+		while (indx != NO_ELEM)
+		{
+			uint64_t* bin = ((uint64_t*)binary_values) + indx * 8;
+
+			for (uint32_t i = 0; i < num_keys; i++)
+				// Total match
+				if (bin[0] == state[0 * keys_in_parallel + i] && bin[1] == state[1 * keys_in_parallel + i] && bin[2] == state[2 * keys_in_parallel + i] && bin[3] == state[3 * keys_in_parallel + i] &&
+					bin[4] == state[4 * keys_in_parallel + i] && bin[5] == state[5 * keys_in_parallel + i] && bin[6] == state[6 * keys_in_parallel + i] && bin[7] == state[7 * keys_in_parallel + i])
+				{
+					memcpy(key, keys[i], keys_length[i]);
+					key[keys_length[i]] = 0;
+					password_was_found(indx, key);
+				}
+
+			indx = same_salt_next[indx];
+		}
+	}
+
+	report_keys_processed(num_keys);
+}
+PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, sha512_process_block_func* kernels_asm[], uint32_t keys_in_parallel, copy_pattern_same_size_func* copy_asm[])
+{
+	//                                           keys sha256 tmp state saved_state                       simple_buffer    ordered_keys
+	uint32_t* buffer = (uint32_t*)_aligned_malloc((4 + 32*8 + 16 + 8 + 8) * sizeof(uint64_t) * keys_in_parallel + 256 + MAX_KEY_SIZE*(MAX_KEY_SIZE+1)*keys_in_parallel, 32);
+	uint64_t* sha256_buffer = (uint64_t*)(buffer + 8 * keys_in_parallel);// size: 32 * 8 * keys_in_parallel
+	uint8_t* simple_buffer = (uint8_t*)(sha256_buffer + (32*8 + 16 + 8 + 8) * keys_in_parallel);// size: 256
 	char* ordered_keys = simple_buffer + 256;
 
 	unsigned char key[MAX_KEY_LENGHT_SMALL];
@@ -344,6 +622,9 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, sha512_process_
 	assert(keys_in_parallel < 128);
 	uint8_t count_by_length[MAX_KEY_SIZE + 1];
 	char* ptr_by_length[MAX_KEY_SIZE + 1];
+	// Keys of the current batch
+	const char* batch_keys[128];
+	uint32_t batch_keys_length[128];
 
 	memset(count_by_length, 0, sizeof(count_by_length));
 	memset(ordered_keys, 0, MAX_KEY_SIZE * (MAX_KEY_SIZE + 1) * keys_in_parallel);
@@ -352,7 +633,6 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, sha512_process_
 
 	while (TRUE)
 	{
-		uint32_t last_iteration = FALSE;
 		uint32_t num_keys_gen = param->gen(buffer, keys_in_parallel, param->thread_id);
 		assert(num_keys_gen <= keys_in_parallel);
 		// Save keys to ordered buffer
@@ -365,170 +645,20 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, sha512_process_
 			count_by_length[key_length]++;
 		}
 
-process_keys:
+		// Process full batches: all keys with the same length. crypt_keys_batch() runs one salt
+		// at a time, so each pass uses a single (key length, salt length) copy pattern
 		for (uint32_t key_length = 0; !stop_universe && key_length <= MAX_KEY_SIZE; key_length++)
-			if (count_by_length[key_length] && (count_by_length[key_length] >= keys_in_parallel || last_iteration))
+			if (count_by_length[key_length] >= keys_in_parallel)
 			{
-				for (uint32_t current_salt_index = 0; current_salt_index < num_diff_salts; current_salt_index++)
+				for (uint32_t i = 0; i < keys_in_parallel; i++)
 				{
-					const crypt_sha256_salt* salt = ((crypt_sha256_salt*)salts_values) + current_salt_index;
-
-					// Pre-calculations
-					uint32_t need_2nd_block_by_g[4] = {
-						(    key_length + 64                ) >= 112 ? 16 : 0,
-						(2 * key_length + 64                ) >= 112 ? 16 : 0,
-						(    key_length + 64 + salt->saltlen) >= 112 ? 16 : 0,
-						(2 * key_length + 64 + salt->saltlen) >= 112 ? 16 : 0
-					};
-
-					memset(sha256_buffer, 0, 32 * 8 * sizeof(uint64_t) * keys_in_parallel);
-					for (uint32_t i = 0; i < keys_in_parallel; i++)
-					{
-						char p_bytes[MAX_KEY_SIZE];
-						char s_bytes[MAX_SALT_SIZE];
-						uint64_t tmp_state[8];
-
-						pre_cycle(ptr_by_length[key_length] + i * key_length, key_length, salt, simple_buffer, tmp_state, p_bytes, s_bytes);
-						for (uint32_t j = 0; j < 8; j++)
-							state[j * keys_in_parallel + i] = tmp_state[j];
-
-						// Patterns---------------------------------------------------------------------------------------------
-						//pattern[0]=alt pass
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, p_bytes, key_length);
-						simple_buffer[key_length] = 0x80;
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 0 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[1]=alt pass pass
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, p_bytes, key_length);
-						memcpy(simple_buffer + key_length, p_bytes, key_length);
-						simple_buffer[2 * key_length] = 0x80;
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 1 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[2]=alt salt pass
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, s_bytes, salt->saltlen);
-						memcpy(simple_buffer + salt->saltlen, p_bytes, key_length);
-						simple_buffer[salt->saltlen + key_length] = 0x80;
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 2 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[3]=alt salt pass pass
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, s_bytes, salt->saltlen);
-						memcpy(simple_buffer + salt->saltlen, p_bytes, key_length);
-						memcpy(simple_buffer + salt->saltlen + key_length, p_bytes, key_length);
-						simple_buffer[salt->saltlen + 2 * key_length] = 0x80;
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 3 + (j + 8)) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[4]=pass alt
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, p_bytes, key_length);
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 4 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[5]=pass pass alt
-						memset(simple_buffer, 0, 256);
-						memcpy(simple_buffer, p_bytes, key_length);
-						memcpy(simple_buffer + key_length, p_bytes, key_length);
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < 32; j++)
-							sha256_buffer[(32 * 5 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[6]=pass salt alt
-						memcpy(simple_buffer, p_bytes, key_length);
-						memcpy(simple_buffer + key_length, s_bytes, salt->saltlen);
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < (key_length + salt->saltlen + 3) / 4; j++)
-							sha256_buffer[(32 * 6 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-						//pattern[7]=pass salt pass alt
-						memcpy(simple_buffer, p_bytes, key_length);
-						memcpy(simple_buffer + key_length, s_bytes, salt->saltlen);
-						memcpy(simple_buffer + key_length + salt->saltlen, p_bytes, key_length);
-						swap_endianness_array64((uint64_t*)simple_buffer, 32);
-						for (uint32_t j = 0; j < (2 * key_length + salt->saltlen + 3) / 4; j++)
-							sha256_buffer[(32 * 7 + j) * keys_in_parallel + i] = ((uint64_t*)simple_buffer)[j];
-
-						// Size
-						sha256_buffer[(32 * 0 + need_2nd_block_by_g[0] + 15) * keys_in_parallel + i] = (       key_length + 64ull                ) << 3;
-						sha256_buffer[(32 * 1 + need_2nd_block_by_g[1] + 15) * keys_in_parallel + i] = (2ull * key_length + 64ull                ) << 3;
-						sha256_buffer[(32 * 2 + need_2nd_block_by_g[2] + 15) * keys_in_parallel + i] = (       key_length + 64ull + salt->saltlen) << 3;
-						sha256_buffer[(32 * 3 + need_2nd_block_by_g[3] + 15) * keys_in_parallel + i] = (2ull * key_length + 64ull + salt->saltlen) << 3;
-						sha256_buffer[(32 * 4 + need_2nd_block_by_g[0] + 15) * keys_in_parallel + i] = (       key_length + 64ull                ) << 3;
-						sha256_buffer[(32 * 5 + need_2nd_block_by_g[1] + 15) * keys_in_parallel + i] = (2ull * key_length + 64ull                ) << 3;
-						sha256_buffer[(32 * 6 + need_2nd_block_by_g[2] + 15) * keys_in_parallel + i] = (       key_length + 64ull + salt->saltlen) << 3;
-						sha256_buffer[(32 * 7 + need_2nd_block_by_g[3] + 15) * keys_in_parallel + i] = (2ull * key_length + 64ull + salt->saltlen) << 3;
-						// end patterns------------------------------------------------------------------------------------------------------------
-					}
-
-					// Big cycle
-					swap_endianness_array64(state, 8 * keys_in_parallel);
-					for (uint32_t k = 0, g_index = 0; k < salt->rounds; k++, g_index++)
-					{
-						uint64_t* pattern_buffer = sha256_buffer + 32 * keys_in_parallel * g[g_index];
-						uint32_t need_2nd_block = need_2nd_block_by_g[g[g_index] & 3];
-						if (k & 1)// Copy at end
-						{
-							uint32_t len = (uint32_t)(pattern_buffer[(need_2nd_block + 15) * keys_in_parallel] >> 3) - 64;
-							uint32_t len3 = len & 7;
-							len /= 8;
-
-							if (len3)// Note: Use 7 versions of functions because register shifts are incredible expensive
-								copy_asm[len3 - 1](pattern_buffer + len * keys_in_parallel, state);
-							else
-							{
-								memcpy(pattern_buffer + len * keys_in_parallel, state, 64 * keys_in_parallel);
-								for (uint32_t i = 0; i < keys_in_parallel; i++)
-									pattern_buffer[(len + 8) * keys_in_parallel + i] = 0x80ull << 56;
-							}
-						}
-						else// Copy at begining
-							memcpy(pattern_buffer, state, 64 * keys_in_parallel);
-
-						// Two sha512 calls
-						kernels_asm[0](state, tmp_buffer, pattern_buffer);
-						if (need_2nd_block)
-							kernels_asm[1](state, tmp_buffer, pattern_buffer + 16 * keys_in_parallel);
-
-						if (g_index == 41)
-							g_index = -1;
-					}
-
-					// Search for a match
-					uint32_t indx = salt_index[current_salt_index];
-
-					while (indx != NO_ELEM)
-					{
-						uint64_t* bin = ((uint64_t*)binary_values) + indx * 8;
-
-						for (uint32_t i = 0; i < keys_in_parallel; i++)
-							// Total match
-							if (bin[0] == state[0 * keys_in_parallel + i] && bin[1] == state[1 * keys_in_parallel + i] && bin[2] == state[2 * keys_in_parallel + i] && bin[3] == state[3 * keys_in_parallel + i] &&
-								bin[4] == state[4 * keys_in_parallel + i] && bin[5] == state[5 * keys_in_parallel + i] && bin[6] == state[6 * keys_in_parallel + i] && bin[7] == state[7 * keys_in_parallel + i])
-							{
-								memcpy(key, ptr_by_length[key_length] + i * key_length, key_length);
-								key[key_length] = 0;
-								password_was_found(indx, key);
-							}
-
-						indx = same_salt_next[indx];
-					}
+					batch_keys[i] = ptr_by_length[key_length] + i * key_length;
+					batch_keys_length[i] = key_length;
 				}
+				crypt_keys_batch(kernels_asm, keys_in_parallel, copy_asm, sha256_buffer, simple_buffer, batch_keys, batch_keys_length, keys_in_parallel);
 
-				if (last_iteration)
-				{
-					report_keys_processed(count_by_length[key_length]);
-					count_by_length[key_length] = 0;
-				}
-				else
-				{
-					count_by_length[key_length] -= keys_in_parallel;
-					memcpy(ptr_by_length[key_length], ptr_by_length[key_length] + keys_in_parallel * key_length, count_by_length[key_length] * key_length);
-					report_keys_processed(keys_in_parallel);
-				}
+				count_by_length[key_length] -= keys_in_parallel;
+				memcpy(ptr_by_length[key_length], ptr_by_length[key_length] + keys_in_parallel * key_length, count_by_length[key_length] * key_length);
 			}
 
 		// Cycle checks
@@ -540,13 +670,35 @@ process_keys:
 
 			if (!stop_universe && total_keys)
 			{
-				// TODO: Group keys by length+salt_length to provide faster finish
-				last_iteration = TRUE;
 				send_message_gui(MESSAGE_FLUSHING_KEYS);
-				goto process_keys;
+				// Group the remaining keys ordered by length to provide faster finish
+				uint32_t num_keys = 0;
+				for (uint32_t key_length = 0; !stop_universe && key_length <= MAX_KEY_SIZE; key_length++)
+					for (uint32_t i = 0; i < count_by_length[key_length]; i++)
+					{
+						batch_keys[num_keys] = ptr_by_length[key_length] + i * key_length;
+						batch_keys_length[num_keys] = key_length;
+						num_keys++;
+
+						if (num_keys == keys_in_parallel)
+						{
+							crypt_keys_batch(kernels_asm, keys_in_parallel, copy_asm, sha256_buffer, simple_buffer, batch_keys, batch_keys_length, keys_in_parallel);
+							num_keys = 0;
+						}
+					}
+
+				if (!stop_universe && num_keys)
+				{
+					// Fill the batch with the last key
+					for (uint32_t i = num_keys; i < keys_in_parallel; i++)
+					{
+						batch_keys[i] = batch_keys[num_keys - 1];
+						batch_keys_length[i] = batch_keys_length[num_keys - 1];
+					}
+					crypt_keys_batch(kernels_asm, keys_in_parallel, copy_asm, sha256_buffer, simple_buffer, batch_keys, batch_keys_length, num_keys);
+				}
 			}
-			else
-				break;
+			break;
 		}
 	}
 
@@ -841,6 +993,152 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 }
 #endif
 
+#ifdef HS_TESTING
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Benchmark of the grouping by key length
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define SHA512CRYPT_BENCH_NUM_KEYS	256
+#define SHA512CRYPT_BENCH_VECTOR	"$6$saltstring$svn8UoSVapNtMuq1ukKS4tPQd8iKwSMHWjl/O817G3uBnIFNjnQJuesI68u4OTLiBFdcbYEdFCoEOfaS35inz1"
+#define SHA512CRYPT_BENCH_KEY		"Hello world!"
+// Key lengths with a mix similar to rockyou
+PRIVATE const uint8_t sha512crypt_bench_lengths[] = { 4, 5, 6, 6, 6, 7, 7, 7, 8, 8, 8, 8, 9, 9, 9, 10, 10, 11, 12, 13, 15, 18, 22, 27 };
+PRIVATE struct {
+	uint32_t needed_cap;
+	sha512_process_block_func* kernels[2];
+	copy_pattern_same_size_func* copy[7];
+	uint32_t keys_in_parallel;
+	const char* name;
+} sha512crypt_engines[] = {
+#ifndef _M_X64
+	{ CPU_CAP_C_CODE, { (sha512_process_block_func*)sha512_process_first_block_c, sha512_process_block_c }, { (copy_pattern_same_size_func*)copy_pattern_c_code_1, (copy_pattern_same_size_func*)copy_pattern_c_code_2, (copy_pattern_same_size_func*)copy_pattern_c_code_3, (copy_pattern_same_size_func*)copy_pattern_c_code_4, (copy_pattern_same_size_func*)copy_pattern_c_code_5, (copy_pattern_same_size_func*)copy_pattern_c_code_6, (copy_pattern_same_size_func*)copy_pattern_c_code_7 }, 1, "C code" },
+#endif
+#ifdef HS_X86
+	{ CPU_CAP_SSE2, { (sha512_process_block_func*)sha512_process_first_block_sse2, (sha512_process_block_func*)sha512_process_block_sse2 }, { (copy_pattern_same_size_func*)copy_pattern_v128_1, (copy_pattern_same_size_func*)copy_pattern_v128_2, (copy_pattern_same_size_func*)copy_pattern_v128_3, (copy_pattern_same_size_func*)copy_pattern_v128_4, (copy_pattern_same_size_func*)copy_pattern_v128_5, (copy_pattern_same_size_func*)copy_pattern_v128_6, (copy_pattern_same_size_func*)copy_pattern_v128_7 }, 2, "SSE2" },
+#endif
+#ifdef _M_X64
+	{ CPU_CAP_AVX , { sha512_process_first_block_avx , sha512_process_block_avx  }, { (copy_pattern_same_size_func*)copy_pattern_v128_1, (copy_pattern_same_size_func*)copy_pattern_v128_2, (copy_pattern_same_size_func*)copy_pattern_v128_3, (copy_pattern_same_size_func*)copy_pattern_v128_4, (copy_pattern_same_size_func*)copy_pattern_v128_5, (copy_pattern_same_size_func*)copy_pattern_v128_6, (copy_pattern_same_size_func*)copy_pattern_v128_7 }, 2, "AVX" },
+	{ CPU_CAP_AVX2, { sha512_process_first_block_avx2, sha512_process_block_avx2 }, { (copy_pattern_same_size_func*)copy_pattern_avx2_1, (copy_pattern_same_size_func*)copy_pattern_avx2_2, (copy_pattern_same_size_func*)copy_pattern_avx2_3, (copy_pattern_same_size_func*)copy_pattern_avx2_4, (copy_pattern_same_size_func*)copy_pattern_avx2_5, (copy_pattern_same_size_func*)copy_pattern_avx2_6, (copy_pattern_same_size_func*)copy_pattern_avx2_7 }, 4, "AVX2" },
+#endif
+};
+// Crypts the keys in the given order, in batches of the engine size, and saves the final state of each key.
+// Returns the milliseconds used
+PRIVATE int64_t bench_sha512crypt_order(uint32_t engine, const uint16_t* order, const char** keys, const uint32_t* keys_length, uint64_t* buffer, uint64_t (*states)[8])
+{
+	uint32_t keys_in_parallel = sha512crypt_engines[engine].keys_in_parallel;
+	uint8_t* simple_buffer = (uint8_t*)(buffer + (32*8 + 16 + 8 + 8) * keys_in_parallel);
+	const uint64_t* state = buffer + (32*8 + 16) * keys_in_parallel;
+	const char* batch_keys[128];
+	uint32_t batch_keys_length[128];
+
+	int64_t start = get_milliseconds();
+	for (uint32_t first = 0; first < SHA512CRYPT_BENCH_NUM_KEYS; first += keys_in_parallel)
+	{
+		uint32_t num_keys = __min(keys_in_parallel, SHA512CRYPT_BENCH_NUM_KEYS - first);
+		// Fill the batch with the last key, as the flush does
+		for (uint32_t i = 0; i < keys_in_parallel; i++)
+		{
+			uint32_t index = order[first + __min(i, num_keys - 1)];
+			batch_keys[i] = keys[index];
+			batch_keys_length[i] = keys_length[index];
+		}
+		crypt_keys_batch(sha512crypt_engines[engine].kernels, keys_in_parallel, sha512crypt_engines[engine].copy, buffer, simple_buffer, batch_keys, batch_keys_length, num_keys);
+
+		for (uint32_t i = 0; i < num_keys; i++)
+			for (uint32_t j = 0; j < 8; j++)
+				states[order[first + i]][j] = state[j * keys_in_parallel + i];
+	}
+
+	return get_milliseconds() - start;
+}
+// Keys/s of a mixed-length wordlist crypted in generator order (batches of mixed lengths)
+// and grouped by length (one copy pattern by batch, as the main path does)
+PUBLIC int bench_sha512crypt_grouping()
+{
+	char* keys_buffer = (char*)malloc(SHA512CRYPT_BENCH_NUM_KEYS * MAX_KEY_SIZE);
+	uint64_t* states = (uint64_t*)malloc(2 * SHA512CRYPT_BENCH_NUM_KEYS * 8 * sizeof(uint64_t));
+	uint64_t* buffer = (uint64_t*)_aligned_malloc((32*8 + 16 + 8 + 8) * sizeof(uint64_t) * 4 + 256, 32);
+	const char* keys[SHA512CRYPT_BENCH_NUM_KEYS];
+	uint32_t keys_length[SHA512CRYPT_BENCH_NUM_KEYS];
+	uint16_t order[2][SHA512CRYPT_BENCH_NUM_KEYS];// 0: generator order, 1: grouped by length
+	uint64_t binary[8];
+	crypt_sha256_salt salt;
+	uint32_t no_hash = NO_ELEM;
+	int result = TRUE;
+
+	if (!keys_buffer || !states || !buffer)
+	{
+		hs_log(HS_LOG_ERROR, "Test Suite", "SHA512CRYPT grouping benchmark: not enough memory");
+		free(keys_buffer);
+		free(states);
+		if (buffer) _aligned_free(buffer);
+		return FALSE;
+	}
+
+	// Save the attack state. Only one salt without hashes: password_was_found is never called
+	void* old_salts_values = salts_values;
+	uint32_t old_num_diff_salts = num_diff_salts;
+	uint32_t* old_salt_index = salt_index;
+	int64_t old_from_save, old_from_start;
+	get_num_keys_served_ptr(&old_from_save, &old_from_start);
+
+	get_binary((const unsigned char*)SHA512CRYPT_BENCH_VECTOR, binary, &salt);
+	salts_values = &salt;
+	num_diff_salts = 1;
+	salt_index = &no_hash;
+
+	// Random printable keys with the known one in the middle
+	for (uint32_t i = 0; i < SHA512CRYPT_BENCH_NUM_KEYS; i++)
+	{
+		uint8_t* key = (uint8_t*)keys_buffer + i * MAX_KEY_SIZE;
+
+		generate_random(key, MAX_KEY_SIZE);
+		keys_length[i] = sha512crypt_bench_lengths[key[0] % LENGTH(sha512crypt_bench_lengths)];
+		for (uint32_t j = 0; j < keys_length[i]; j++)
+			key[j] = ' ' + key[j] % 95;
+		keys[i] = (const char*)key;
+		order[0][i] = (uint16_t)i;
+	}
+	keys_length[SHA512CRYPT_BENCH_NUM_KEYS / 2] = (uint32_t)strlen(SHA512CRYPT_BENCH_KEY);
+	memcpy(keys_buffer + SHA512CRYPT_BENCH_NUM_KEYS / 2 * MAX_KEY_SIZE, SHA512CRYPT_BENCH_KEY, keys_length[SHA512CRYPT_BENCH_NUM_KEYS / 2]);
+	// Counting sort by length
+	for (uint32_t key_length = 0, num_ordered = 0; key_length <= MAX_KEY_SIZE; key_length++)
+		for (uint32_t i = 0; i < SHA512CRYPT_BENCH_NUM_KEYS; i++)
+			if (keys_length[i] == key_length)
+				order[1][num_ordered++] = (uint16_t)i;
+
+	for (uint32_t e = 0; e < LENGTH(sha512crypt_engines); e++)
+		if (current_cpu.capabilites[sha512crypt_engines[e].needed_cap])
+		{
+			double keys_per_second[2];
+			for (uint32_t o = 0; o < 2; o++)
+			{
+				int64_t ms = bench_sha512crypt_order(e, order[o], keys, keys_length, buffer, (uint64_t(*)[8])(states + o * SHA512CRYPT_BENCH_NUM_KEYS * 8));
+				keys_per_second[o] = SHA512CRYPT_BENCH_NUM_KEYS * 1000. / __max(ms, 1);
+			}
+
+			if (memcmp(states, states + SHA512CRYPT_BENCH_NUM_KEYS * 8, SHA512CRYPT_BENCH_NUM_KEYS * 8 * sizeof(uint64_t)) ||
+				memcmp(states + SHA512CRYPT_BENCH_NUM_KEYS / 2 * 8, binary, BINARY_SIZE))
+			{
+				hs_log(HS_LOG_ERROR, "Test Suite", "SHA512CRYPT %s engine fails with mixed lengths", sha512crypt_engines[e].name);
+				result = FALSE;
+			}
+			hs_log(HS_LOG_INFO, "Test Suite", "SHA512CRYPT %s: %.0f keys/s in generator order, %.0f grouped by length", sha512crypt_engines[e].name, keys_per_second[0], keys_per_second[1]);
+		}
+
+	// Restore the attack state
+	salts_values = old_salts_values;
+	num_diff_salts = old_num_diff_salts;
+	salt_index = old_salt_index;
+	set_num_keys_zero();
+	set_num_keys_save_add_start(old_from_save, old_from_start);
+
+	free(keys_buffer);
+	free(states);
+	_aligned_free(buffer);
+	return result;
+}
+#endif
+
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementations
@@ -1965,14 +2263,14 @@ Format sha512crypt_format = {
 	DEFAULT_VALUE_MAP_INDEX,
 	is_valid,
 	add_hash_from_line,
-	NULL,
+	optimize_hashes,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
@@ -95,7 +95,8 @@ PRIVATE uint32_t get_binary(const unsigned char* ciphertext, void* binary, void*
 	memcpy(salt, binary_buffer + BINARY_SIZE, salt_len);
 	((uint8_t*)salt)[salt_len] = 0x80;
 	((uint8_t*)salt)[SSHA_SALT_SIZE_INDEX] = salt_len;
-	swap_endianness_array(salt, salt_len/4+1);
+	// The 0x80 of a MAX_SALT_SIZE salt don't fit: it is added in optimize_hashes
+	swap_endianness_array(salt, salt_len < MAX_SALT_SIZE ? (salt_len/4+1) : (MAX_SALT_SIZE/4));
 
 	out[0] -= INIT_A;
 	out[1] -= INIT_B;
@@ -146,6 +147,73 @@ PRIVATE void binary2hex(const void* binary, const uint8_t* salt, unsigned char*
 
 	base64_encode_mime((const unsigned char*)bin, BINARY_SIZE + salt_size, (char*)ciphertext);
 }
+// Check the salt is as get_binary() put it: length, 0x80 after the salt and zeros
+PRIVATE int is_salt_record_valid(const uint8_t* salt)
+{
+	uint32_t salt_len = salt[SSHA_SALT_SIZE_INDEX];
+	if (salt_len == MAX_SALT_SIZE)
+		return TRUE;
+	if (salt_len > MAX_SALT_SIZE)
+		return FALSE;
+
+	uint32_t salt_words[MAX_SALT_SIZE/4];
+	memcpy(salt_words, salt, MAX_SALT_SIZE);
+	swap_endianness_array(salt_words, salt_len/4+1);
+
+	const uint8_t* salt_bytes = (const uint8_t*)salt_words;
+	if (salt_bytes[salt_len] != 0x80)
+		return FALSE;
+	for (uint32_t i = salt_len + 1; i < MAX_SALT_SIZE; i++)
+		if (salt_bytes[i])
+			return FALSE;
+
+	return TRUE;
+}
+// Old versions of get_binary() swapped 5 words of 16 bytes salts: the first 4 words
+// are right, but the salt length was replaced by a garbage byte. Put it back on
+// the hashes in the db, so they load, show and match new imports.
+// Return FALSE if any hash couldn't be upgraded: try again next time.
+PUBLIC int ssha_upgrade_db_salts()
+{
+	sqlite3_stmt* select_bins = NULL;
+	sqlite3_stmt* update_bin = NULL;
+	int step_result, is_upgraded = TRUE;
+
+	if (sqlite3_prepare_v2(db, "SELECT ID,Bin FROM Hash WHERE Type=?;", -1, &select_bins, NULL) != SQLITE_OK ||
+		sqlite3_prepare_v2(db, "UPDATE Hash SET Bin=? WHERE ID=?;", -1, &update_bin, NULL) != SQLITE_OK)
+	{
+		sqlite3_finalize(update_bin);
+		sqlite3_finalize(select_bins);
+		return FALSE;
+	}
+	sqlite3_bind_int64(select_bins, 1, formats[SSHA_INDEX].db_id);
+
+	while ((step_result = sqlite3_step(select_bins)) == SQLITE_ROW)
+	{
+		uint8_t bin[BINARY_SIZE + SALT_SIZE];
+		if (sqlite3_column_bytes(select_bins, 1) != sizeof(bin))
+			continue;
+		memcpy(bin, sqlite3_column_blob(select_bins, 1), sizeof(bin));
+
+		if (!is_salt_record_valid(bin + BINARY_SIZE))
+		{
+			bin[BINARY_SIZE + SSHA_SALT_SIZE_INDEX] = MAX_SALT_SIZE;
+
+			sqlite3_reset(update_bin);
+			sqlite3_bind_blob(update_bin, 1, bin, sizeof(bin), SQLITE_STATIC);
+			sqlite3_bind_int64(update_bin, 2, sqlite3_column_int64(select_bins, 0));
+			if (sqlite3_step(update_bin) != SQLITE_DONE)
+				is_upgraded = FALSE;
+		}
+	}
+	if (step_result != SQLITE_DONE)
+		is_upgraded = FALSE;
+
+	sqlite3_finalize(update_bin);
+	sqlite3_finalize(select_bins);
+
+	return is_upgraded;
+}
 
 PRIVATE uint32_t max_salt_len;
 PRIVATE uint32_t MAX_SIZE_SALT;
@@ -169,7 +237,10 @@ PRIVATE void optimize_hashes()
 	for (uint32_t i = 0; i < num_diff_salts; i++, salt_buffer += SALT_SIZE)
 	{
 		uint32_t salt_len = salt_buffer[SSHA_SALT_SIZE_INDEX];
-		uint32_t* salt = (uint32_t*)salt_buffer;
+		uint32_t salt[MAX_SALT_SIZE/4+1];
+		memcpy(salt, salt_buffer, MAX_SALT_SIZE);
+		if (salt_len == MAX_SALT_SIZE)
+			salt[MAX_SALT_SIZE/4] = 0x80000000;
 
 		// Len = 0
 		for (uint32_t j = 0; j < (salt_len / 4 + 1); j++)
@@ -207,6 +278,7 @@ PRIVATE void optimize_hashes()
 
 typedef void ssha_kernel_asm_func(void* nt_buffer);
 typedef uint32_t convert_big_endian_func(void* keys_buffer, uint32_t NUM_KEYS);
+typedef void copy_2_W_by_len_func(uint32_t* nt_buffer, uint32_t salt_index, uint32_t max_len, const uint32_t* len_pos);
 // Return the max lenght
 PRIVATE uint32_t convert_big_endian_c_code(uint32_t* keys_buffer, uint32_t NUM_KEYS)
 {
@@ -254,6 +326,36 @@ PRIVATE uint32_t convert_big_endian_sse2(uint32_t* keys_buffer, uint32_t NUM_KEY
 	return max_len;
 }
 #endif
+// Group the keys by lenght, removing the 0x80 and clearing the words after it.
+// Keys with lenght 'len' are in positions [len_pos[len], len_pos[len+1])
+PRIVATE void sort_keys_by_len(const uint32_t* keys_buffer, uint32_t* nt_buffer, uint32_t* len_pos)
+{
+	uint32_t pos[NTLM_MAX_KEY_LENGHT + 1];
+
+	// Count keys of each lenght
+	memset(len_pos, 0, (NTLM_MAX_KEY_LENGHT + 2) * sizeof(uint32_t));
+	for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+		len_pos[(keys_buffer[7 * NT_NUM_KEYS + i] >> 3) + 1]++;
+	for (uint32_t len = 0; len <= NTLM_MAX_KEY_LENGHT; len++)
+	{
+		len_pos[len + 1] += len_pos[len];
+		pos[len] = len_pos[len];
+	}
+
+	memset(nt_buffer, 0, 7 * NT_NUM_KEYS * sizeof(uint32_t));
+	for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+	{
+		uint32_t len = keys_buffer[7 * NT_NUM_KEYS + i] >> 3;
+		uint32_t index = pos[len]++;
+
+		for (uint32_t j = 0; j < len / 4; j++)
+			nt_buffer[j * NT_NUM_KEYS + index] = keys_buffer[j * NT_NUM_KEYS + i];
+		if (len & 3)// eliminate the last 0x80
+			nt_buffer[len / 4 * NT_NUM_KEYS + index] = keys_buffer[len / 4 * NT_NUM_KEYS + i] & (0xffffffff << (32 - (len & 3) * 8));
+
+		nt_buffer[7 * NT_NUM_KEYS + index] = len << 3;
+	}
+}
 PRIVATE void copy_2_W(uint32_t* keys_buffer, uint32_t salt_index, uint32_t max_len)
 {
 	uint32_t* salt_by_len = (uint32_t*)salts_values;
@@ -291,9 +393,16 @@ PRIVATE void copy_2_W(uint32_t* keys_buffer, uint32_t salt_index, uint32_t max_l
 		W[15 * NT_NUM_KEYS] = (len + salt_len) << 3;
 	}
 }
-PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, ssha_kernel_asm_func* ssha_kernel_asm, convert_big_endian_func* convert_big_endian)
+// Sorting the keys by lenght only pays when it is amortized over some salts
+#define SORT_KEYS_MIN_SALTS 4
+// copy_2_W_by_len may be NULL: keys are then processed one by one with copy_2_W
+PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, ssha_kernel_asm_func* ssha_kernel_asm, convert_big_endian_func* convert_big_endian, copy_2_W_by_len_func* copy_2_W_by_len)
 {
 	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16+2) * sizeof(uint32_t) * NT_NUM_KEYS, 32);
+	// When sorting, keys are generated in a separate buffer
+	int by_len = copy_2_W_by_len && num_diff_salts >= SORT_KEYS_MIN_SALTS;
+	uint32_t* keys_buffer = by_len ? (uint32_t*)_aligned_malloc(8 * sizeof(uint32_t) * NT_NUM_KEYS, 32) : nt_buffer;
+	uint32_t len_pos[NTLM_MAX_KEY_LENGHT + 2];
 
 	uint32_t* unpacked_W  = nt_buffer  + 8 * NT_NUM_KEYS;
 	uint32_t* unpacked_as = unpacked_W + 2 * NT_NUM_KEYS;
@@ -304,20 +413,25 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, ssha_kernel_asm
 
 	unsigned char key[MAX_KEY_LENGHT_SMALL];
 
-	memset(nt_buffer, 0, 8 * sizeof(uint32_t)* NT_NUM_KEYS);
+	memset(keys_buffer, 0, 8 * sizeof(uint32_t)* NT_NUM_KEYS);
 	memset(key, 0, sizeof(key));
 
-	while (continue_attack && param->gen(nt_buffer, NT_NUM_KEYS, param->thread_id))
+	while (continue_attack && param->gen(keys_buffer, NT_NUM_KEYS, param->thread_id))
 	{
 		// Convert to big-endian
-		uint32_t max_len = convert_big_endian(nt_buffer, NT_NUM_KEYS);
+		uint32_t max_len = convert_big_endian(keys_buffer, NT_NUM_KEYS);
+		if (by_len)
+			sort_keys_by_len(keys_buffer, nt_buffer, len_pos);
 
 		// Hash: AVX2 raw SHA1: 49.6M
 		//       AVX2 SSHA1   : 42.5M (17% slower)
 		for (uint32_t j = 0; j < num_diff_salts; j++)
 		{
 			// Generate the initial W
-			copy_2_W(nt_buffer, j, max_len);
+			if (by_len)
+				copy_2_W_by_len(nt_buffer, j, max_len, len_pos);
+			else
+				copy_2_W(nt_buffer, j, max_len);
 			ssha_kernel_asm(nt_buffer);
 
 			// All salts differents
@@ -394,6 +508,8 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, ssha_kernel_asm
 		report_keys_processed(NT_NUM_KEYS);
 	}
 
+	if (by_len)
+		_aligned_free(keys_buffer);
 	_aligned_free(nt_buffer);
 
 	finish_thread();
@@ -506,7 +622,7 @@ PRIVATE void crypt_c_code_kernel(uint32_t* nt_buffer)
 }
 PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 {
-	crypt_utf8_coalesc_protocol_body(param, crypt_c_code_kernel, convert_big_endian_c_code);
+	crypt_utf8_coalesc_protocol_body(param, crypt_c_code_kernel, convert_big_endian_c_code, NULL);
 }
 #endif
 
@@ -518,8 +634,8 @@ PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 //void crypt_ssha_neon_kernel_asm(uint32_t* nt_buffer);
 PRIVATE void crypt_utf8_coalesc_protocol_neon(CryptParam* param)
 {
-	//crypt_utf8_coalesc_protocol_body(param, crypt_ssha_neon_kernel_asm, convert_big_endian_c_code);
-	crypt_utf8_coalesc_protocol_body(param, crypt_c_code_kernel, convert_big_endian_c_code);
+	//crypt_utf8_coalesc_protocol_body(param, crypt_ssha_neon_kernel_asm, convert_big_endian_c_code, NULL);
+	crypt_utf8_coalesc_protocol_body(param, crypt_c_code_kernel, convert_big_endian_c_code, NULL);
 }
 #endif
 
@@ -532,7 +648,7 @@ PRIVATE void crypt_utf8_coalesc_protocol_neon(CryptParam* param)
 #define SHA1_NUM		(NT_NUM_KEYS/4)
 #undef DCC2_R
 #define DCC2_R(w0, w1, w2, w3)	W[w0*SHA1_NUM] = SSE2_ROTATE(SSE2_4XOR(W[w0*SHA1_NUM], W[w1*SHA1_NUM], W[w2*SHA1_NUM], W[w3*SHA1_NUM]), 1)
-PRIVATE void crypt_kernel_sse2(SSE2_WORD* nt_buffer)
+PRIVATE __forceinline void crypt_kernel_v128(SSE2_WORD* nt_buffer)
 {
 	SSE2_WORD* W = nt_buffer + 8 * SHA1_NUM;
 	SSE2_WORD step_const;
@@ -636,20 +752,69 @@ PRIVATE void crypt_kernel_sse2(SSE2_WORD* nt_buffer)
 		W[17 * SHA1_NUM] = E;
 	}
 }
+PRIVATE void crypt_kernel_sse2(SSE2_WORD* nt_buffer)
+{
+	crypt_kernel_v128(nt_buffer);
+}
+// Same as copy_2_W but appending the salt to all keys of the same lenght at once
+PRIVATE void copy_2_W_sse2(uint32_t* nt_buffer, uint32_t salt_index, uint32_t max_len, const uint32_t* len_pos)
+{
+	uint32_t* salt_by_len = (uint32_t*)salts_values;
+	uint32_t salt_len = salt_by_len[MAX_SIZE_SALT*4*num_diff_salts+salt_index];
+	salt_index *= MAX_SIZE_SALT;
+	uint32_t pos_len_multiplier = MAX_SIZE_SALT*num_diff_salts;
+	SSE2_WORD* keys = (SSE2_WORD*)nt_buffer;
+	SSE2_WORD* W = keys + 8 * SHA1_NUM;
+	// Copy and Clear W
+	max_len = max_len / 4 + 1;
+	memcpy(W, keys, max_len * NT_NUM_KEYS * sizeof(uint32_t));
+	memset(W + max_len*SHA1_NUM, 0, (15-max_len) * NT_NUM_KEYS * sizeof(uint32_t));
+
+	SSE2_WORD salt_bits = SSE2_CONST(salt_len << 3);
+	for (uint32_t i = 0; i < SHA1_NUM; i++)
+		W[15 * SHA1_NUM + i] = SSE2_ADD(keys[7 * SHA1_NUM + i], salt_bits);
+
+	SSE2_WORD salt[MAX_SALT_SIZE/4 + 1];
+	SSE2_WORD lanes_index = _mm_set_epi32(3, 2, 1, 0);
+	for (uint32_t len = 0; len <= NTLM_MAX_KEY_LENGHT; len++)
+		if (len_pos[len] < len_pos[len + 1])
+		{
+			uint32_t len3 = len & 3;
+			uint32_t size_salt = (salt_len + len3) / 4 + 1;
+			uint32_t* salt_ptr = salt_by_len + len3*pos_len_multiplier + salt_index;
+			for (uint32_t j = 0; j < size_salt; j++)
+				salt[j] = SSE2_CONST(salt_ptr[j]);
+
+			SSE2_WORD begin = SSE2_CONST(len_pos[len] - 1);
+			SSE2_WORD end = SSE2_CONST(len_pos[len + 1]);
+			SSE2_WORD* Wj = W + len / 4 * SHA1_NUM;
+			// Keys of the same lenght are consecutive: only the first and last vector are mixed
+			for (uint32_t i = len_pos[len] / 4; i < (len_pos[len + 1] + 3) / 4; i++)
+			{
+				SSE2_WORD index = SSE2_ADD(SSE2_CONST(4 * i), lanes_index);
+				SSE2_WORD mask = SSE2_AND(_mm_cmpgt_epi32(index, begin), _mm_cmplt_epi32(index, end));
+
+				for (uint32_t j = 0; j < size_salt; j++)
+					Wj[j*SHA1_NUM + i] = SSE2_OR(Wj[j*SHA1_NUM + i], SSE2_AND(salt[j], mask));
+			}
+		}
+}
 PRIVATE void crypt_utf8_coalesc_protocol_sse2(CryptParam* param)
 {
-	crypt_utf8_coalesc_protocol_body(param, crypt_kernel_sse2, convert_big_endian_sse2);
+	crypt_utf8_coalesc_protocol_body(param, crypt_kernel_sse2, convert_big_endian_sse2, copy_2_W_sse2);
 }
 #endif
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // AVX code
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #ifdef HS_X86
-
-void crypt_ssha_avx_kernel_asm(uint32_t* nt_buffer);
+PRIVATE HS_TARGET("avx") void crypt_kernel_avx(SSE2_WORD* nt_buffer)
+{
+	crypt_kernel_v128(nt_buffer);
+}
 PRIVATE void crypt_utf8_coalesc_protocol_avx(CryptParam* param)
 {
-	crypt_utf8_coalesc_protocol_body(param, crypt_ssha_avx_kernel_asm, convert_big_endian_sse2);
+	crypt_utf8_coalesc_protocol_body(param, crypt_kernel_avx, convert_big_endian_sse2, copy_2_W_sse2);
 }
 #endif
 
@@ -657,11 +822,156 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx(CryptParam* param)
 // AVX2 code
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 #ifdef HS_X86
+#define SHA1_NUM_AVX2	(NT_NUM_KEYS/8)
+#undef DCC2_R
+#define DCC2_R(w0, w1, w2, w3)	W[w0*SHA1_NUM_AVX2] = AVX2_ROTATE(AVX2_4XOR(W[w0*SHA1_NUM_AVX2], W[w1*SHA1_NUM_AVX2], W[w2*SHA1_NUM_AVX2], W[w3*SHA1_NUM_AVX2]), 1)
+PRIVATE HS_TARGET("avx2") void crypt_kernel_avx2(AVX2_WORD* nt_buffer)
+{
+	AVX2_WORD* W = nt_buffer + 8 * SHA1_NUM_AVX2;
+	AVX2_WORD step_const;
+	for (uint32_t i = 0; i < SHA1_NUM_AVX2; i++, W++)
+	{
+		/* Round 1 */
+		AVX2_WORD E = AVX2_ADD(AVX2_CONST(0x9fb498b3), W[0*SHA1_NUM_AVX2]);
+		AVX2_WORD D = AVX2_3ADD(AVX2_ROTATE(E, 5), AVX2_CONST(0x66b0cd0d), W[1*SHA1_NUM_AVX2]);
+		AVX2_WORD C = AVX2_4ADD(AVX2_ROTATE(D, 5), AVX2_XOR(AVX2_CONST(0x7bf36ae2), AVX2_AND(E, AVX2_CONST(0x22222222))), AVX2_CONST(0xf33d5697), W[2*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		AVX2_WORD B = AVX2_4ADD(AVX2_ROTATE(C, 5), AVX2_XOR(AVX2_CONST(0x59d148c0), AVX2_AND(D, AVX2_XOR(E, AVX2_CONST(0x59d148c0)))), AVX2_CONST(0xd675e47b), W[3*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		AVX2_WORD A = AVX2_4ADD(AVX2_ROTATE(B, 5), AVX2_XOR(E, AVX2_AND(C, AVX2_XOR(D, E))), AVX2_CONST(0xb453c259), W[4*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+
+		step_const = AVX2_CONST(SQRT_2);
+							   E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_XOR(D, AVX2_AND(B, AVX2_XOR(C, D))), step_const, W[5 *SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+							   D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_XOR(C, AVX2_AND(A, AVX2_XOR(B, C))), step_const, W[6 *SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+							   C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_XOR(B, AVX2_AND(E, AVX2_XOR(A, B))), step_const, W[7 *SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+							   B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_XOR(A, AVX2_AND(D, AVX2_XOR(E, A))), step_const, W[8 *SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+							   A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_XOR(E, AVX2_AND(C, AVX2_XOR(D, E))), step_const, W[9 *SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+							   E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_XOR(D, AVX2_AND(B, AVX2_XOR(C, D))), step_const, W[10*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+							   D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_XOR(C, AVX2_AND(A, AVX2_XOR(B, C))), step_const, W[11*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+							   C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_XOR(B, AVX2_AND(E, AVX2_XOR(A, B))), step_const, W[12*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+							   B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_XOR(A, AVX2_AND(D, AVX2_XOR(E, A))), step_const, W[13*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+							   A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_XOR(E, AVX2_AND(C, AVX2_XOR(D, E))), step_const, W[14*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+							   E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_XOR(D, AVX2_AND(B, AVX2_XOR(C, D))), step_const, W[15*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(0 , 13, 8,  2); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_XOR(C, AVX2_AND(A, AVX2_XOR(B, C))), step_const, W[0 *SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(1 , 14, 9,  3); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_XOR(B, AVX2_AND(E, AVX2_XOR(A, B))), step_const, W[1 *SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(2 , 15, 10, 4); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_XOR(A, AVX2_AND(D, AVX2_XOR(E, A))), step_const, W[2 *SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(3 ,  0, 11, 5); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_XOR(E, AVX2_AND(C, AVX2_XOR(D, E))), step_const, W[3 *SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
 
-void crypt_ssha_avx2_kernel_asm(uint32_t* nt_buffer);
+		/* Round 2 */
+		step_const = AVX2_CONST(SQRT_3);
+		DCC2_R(4 ,  1, 12, 6); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[4 *SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(5 ,  2, 13, 7); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[5 *SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(6 ,  3, 14, 8); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[6 *SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(7 ,  4, 15, 9); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[7 *SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R( 8, 5,  0, 10); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[8 *SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R( 9, 6,  1, 11); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[9 *SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(10, 7,  2, 12); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[10*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(11, 8,  3, 13); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[11*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(12, 9,  4, 14); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[12*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(13, 10, 5, 15); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[13*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R(14, 11, 6,  0); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[14*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(15, 12, 7,  1); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[15*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(0 , 13, 8,  2); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[0 *SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(1 , 14, 9,  3); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[1 *SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(2 , 15, 10, 4); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[2 *SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R(3 ,  0, 11, 5); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[3 *SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(4 ,  1, 12, 6); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[4 *SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(5 ,  2, 13, 7); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[5 *SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(6 ,  3, 14, 8); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[6 *SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(7 ,  4, 15, 9); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[7 *SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+										  
+		/* Round 3 */
+		step_const = AVX2_CONST(0x8F1BBCDC);
+		DCC2_R( 8, 5,  0, 10); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_OR(AVX2_AND(B, C), AVX2_AND(D, AVX2_OR(B, C))), step_const, W[ 8*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R( 9, 6,  1, 11); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_OR(AVX2_AND(A, B), AVX2_AND(C, AVX2_OR(A, B))), step_const, W[ 9*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(10, 7,  2, 12); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_OR(AVX2_AND(E, A), AVX2_AND(B, AVX2_OR(E, A))), step_const, W[10*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(11, 8,  3, 13); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_OR(AVX2_AND(D, E), AVX2_AND(A, AVX2_OR(D, E))), step_const, W[11*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(12, 9,  4, 14); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_OR(AVX2_AND(C, D), AVX2_AND(E, AVX2_OR(C, D))), step_const, W[12*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R(13, 10, 5, 15); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_OR(AVX2_AND(B, C), AVX2_AND(D, AVX2_OR(B, C))), step_const, W[13*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(14, 11, 6,  0); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_OR(AVX2_AND(A, B), AVX2_AND(C, AVX2_OR(A, B))), step_const, W[14*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(15, 12, 7,  1); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_OR(AVX2_AND(E, A), AVX2_AND(B, AVX2_OR(E, A))), step_const, W[15*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R( 0, 13, 8,  2); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_OR(AVX2_AND(D, E), AVX2_AND(A, AVX2_OR(D, E))), step_const, W[ 0*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R( 1, 14, 9,  3); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_OR(AVX2_AND(C, D), AVX2_AND(E, AVX2_OR(C, D))), step_const, W[ 1*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R( 2, 15, 10, 4); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_OR(AVX2_AND(B, C), AVX2_AND(D, AVX2_OR(B, C))), step_const, W[ 2*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R( 3, 0, 11,  5); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_OR(AVX2_AND(A, B), AVX2_AND(C, AVX2_OR(A, B))), step_const, W[ 3*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R( 4, 1, 12,  6); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_OR(AVX2_AND(E, A), AVX2_AND(B, AVX2_OR(E, A))), step_const, W[ 4*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R( 5, 2, 13,  7); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_OR(AVX2_AND(D, E), AVX2_AND(A, AVX2_OR(D, E))), step_const, W[ 5*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R( 6, 3, 14,  8); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_OR(AVX2_AND(C, D), AVX2_AND(E, AVX2_OR(C, D))), step_const, W[ 6*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R( 7, 4, 15,  9); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_OR(AVX2_AND(B, C), AVX2_AND(D, AVX2_OR(B, C))), step_const, W[ 7*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R( 8, 5,  0, 10); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_OR(AVX2_AND(A, B), AVX2_AND(C, AVX2_OR(A, B))), step_const, W[ 8*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R( 9, 6,  1, 11); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_OR(AVX2_AND(E, A), AVX2_AND(B, AVX2_OR(E, A))), step_const, W[ 9*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(10, 7,  2, 12); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_OR(AVX2_AND(D, E), AVX2_AND(A, AVX2_OR(D, E))), step_const, W[10*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(11, 8,  3, 13); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_OR(AVX2_AND(C, D), AVX2_AND(E, AVX2_OR(C, D))), step_const, W[11*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+										  
+		/* Round 4 */
+		step_const = AVX2_CONST(0xCA62C1D6);
+		DCC2_R(12, 9, 4, 14); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[12*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(13,10, 5, 15); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[13*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R(14, 11, 6, 0); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[14*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R(15, 12, 7, 1); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[15*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R( 0, 13, 8, 2); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[ 0*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R( 1, 14, 9, 3); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[ 1*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R(2, 15, 10, 4); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[ 2*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R( 3, 0, 11, 5); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[ 3*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R( 4, 1, 12, 6); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[ 4*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R( 5, 2, 13, 7); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[ 5*SHA1_NUM_AVX2]); C = AVX2_ROTATE(C, 30);
+		DCC2_R( 6, 3, 14, 8); E = AVX2_5ADD(E, AVX2_ROTATE(A, 5), AVX2_3XOR(B, C, D), step_const, W[ 6*SHA1_NUM_AVX2]); B = AVX2_ROTATE(B, 30);
+		DCC2_R( 7, 4, 15, 9); D = AVX2_5ADD(D, AVX2_ROTATE(E, 5), AVX2_3XOR(A, B, C), step_const, W[ 7*SHA1_NUM_AVX2]); A = AVX2_ROTATE(A, 30);
+		DCC2_R( 8, 5, 0, 10); C = AVX2_5ADD(C, AVX2_ROTATE(D, 5), AVX2_3XOR(E, A, B), step_const, W[ 8*SHA1_NUM_AVX2]); E = AVX2_ROTATE(E, 30);
+		DCC2_R( 9, 6, 1, 11); B = AVX2_5ADD(B, AVX2_ROTATE(C, 5), AVX2_3XOR(D, E, A), step_const, W[ 9*SHA1_NUM_AVX2]); D = AVX2_ROTATE(D, 30);
+		DCC2_R(10, 7, 2, 12); A = AVX2_5ADD(A, AVX2_ROTATE(B, 5), AVX2_3XOR(C, D, E), step_const, W[10*SHA1_NUM_AVX2]); 
+			
+		DCC2_R(12, 9, 4, 14); DCC2_R(15, 12, 7, 1); A = AVX2_ADD(AVX2_ROTATE(A, 30), W[15*SHA1_NUM_AVX2]);
 
-#include <immintrin.h>
-PRIVATE uint32_t convert_big_endian_avx2(__m256i* keys_buffer, uint32_t NUM_KEYS)
+		// Save
+		W[2  * SHA1_NUM_AVX2] = A;
+		W[4  * SHA1_NUM_AVX2] = B;
+		W[9  * SHA1_NUM_AVX2] = C;
+		W[16 * SHA1_NUM_AVX2] = D;
+		W[17 * SHA1_NUM_AVX2] = E;
+	}
+}
+PRIVATE HS_TARGET("avx2") void copy_2_W_avx2(uint32_t* nt_buffer, uint32_t salt_index, uint32_t max_len, const uint32_t* len_pos)
+{
+	uint32_t* salt_by_len = (uint32_t*)salts_values;
+	uint32_t salt_len = salt_by_len[MAX_SIZE_SALT*4*num_diff_salts+salt_index];
+	salt_index *= MAX_SIZE_SALT;
+	uint32_t pos_len_multiplier = MAX_SIZE_SALT*num_diff_salts;
+	AVX2_WORD* keys = (AVX2_WORD*)nt_buffer;
+	AVX2_WORD* W = keys + 8 * SHA1_NUM_AVX2;
+	// Copy and Clear W
+	max_len = max_len / 4 + 1;
+	memcpy(W, keys, max_len * NT_NUM_KEYS * sizeof(uint32_t));
+	memset(W + max_len*SHA1_NUM_AVX2, 0, (15-max_len) * NT_NUM_KEYS * sizeof(uint32_t));
+
+	AVX2_WORD salt_bits = AVX2_CONST(salt_len << 3);
+	for (uint32_t i = 0; i < SHA1_NUM_AVX2; i++)
+		W[15 * SHA1_NUM_AVX2 + i] = AVX2_ADD(keys[7 * SHA1_NUM_AVX2 + i], salt_bits);
+
+	AVX2_WORD salt[MAX_SALT_SIZE/4 + 1];
+	AVX2_WORD lanes_index = _mm256_set_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+	for (uint32_t len = 0; len <= NTLM_MAX_KEY_LENGHT; len++)
+		if (len_pos[len] < len_pos[len + 1])
+		{
+			uint32_t len3 = len & 3;
+			uint32_t size_salt = (salt_len + len3) / 4 + 1;
+			uint32_t* salt_ptr = salt_by_len + len3*pos_len_multiplier + salt_index;
+			for (uint32_t j = 0; j < size_salt; j++)
+				salt[j] = AVX2_CONST(salt_ptr[j]);
+
+			AVX2_WORD begin = AVX2_CONST(len_pos[len] - 1);
+			AVX2_WORD end = AVX2_CONST(len_pos[len + 1]);
+			AVX2_WORD* Wj = W + len / 4 * SHA1_NUM_AVX2;
+			// Keys of the same lenght are consecutive: only the first and last vector are mixed
+			for (uint32_t i = len_pos[len] / 8; i < (len_pos[len + 1] + 7) / 8; i++)
+			{
+				AVX2_WORD index = AVX2_ADD(AVX2_CONST(8 * i), lanes_index);
+				AVX2_WORD mask = AVX2_AND(_mm256_cmpgt_epi32(index, begin), _mm256_cmpgt_epi32(end, index));
+
+				for (uint32_t j = 0; j < size_salt; j++)
+					Wj[j*SHA1_NUM_AVX2 + i] = AVX2_OR(Wj[j*SHA1_NUM_AVX2 + i], AVX2_AND(salt[j], mask));
+			}
+		}
+}
+PRIVATE HS_TARGET("avx2") uint32_t convert_big_endian_avx2(__m256i* keys_buffer, uint32_t NUM_KEYS)
 {
 	// Find max_len
 	__m256i max_len_vec = _mm256_set1_epi32(0);
@@ -670,10 +980,12 @@ PRIVATE uint32_t convert_big_endian_avx2(__m256i* keys_buffer, uint32_t NUM_KEYS
 		__m256i len = _mm256_srli_epi32(keys_buffer[i], 3);
 		max_len_vec = _mm256_max_epu32(len, max_len_vec);
 	}
+	uint32_t max_len_lanes[8];
+	_mm256_storeu_si256((__m256i*)max_len_lanes, max_len_vec);
 	uint32_t max_len = 0;
 	for (uint32_t i = 0; i < 8; i++)
-		if (max_len_vec.m256i_u32[i] > max_len)
-			max_len = max_len_vec.m256i_u32[i];
+		if (max_len_lanes[i] > max_len)
+			max_len = max_len_lanes[i];
 
 	// Convert
 	uint32_t len = (max_len / 4 + 1) * NUM_KEYS / 8;
@@ -685,7 +997,7 @@ PRIVATE uint32_t convert_big_endian_avx2(__m256i* keys_buffer, uint32_t NUM_KEYS
 }
 PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 {
-	crypt_utf8_coalesc_protocol_body(param, crypt_ssha_avx2_kernel_asm, convert_big_endian_avx2);
+	crypt_utf8_coalesc_protocol_body(param, crypt_kernel_avx2, convert_big_endian_avx2, copy_2_W_avx2);
 }
 #endif
 
@@ -1983,12 +2295,12 @@ Format ssha_format = {
 	add_hash_from_line,
 	optimize_hashes,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
@@ -418,10 +418,13 @@ PRIVATE void crypt_utf8_coalesc_protocol_c_code(CryptParam* param)
 #include "arch_simd.h"
 
 #ifdef HS_X86
-// Calculate W in each iteration
+// PBKDF2 cycle implemented in format_DCC2.c
+typedef void pbkdf2_sha1_func(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
 void sha1_process_sha1_sse2(const __m128i* state, __m128i* sha1_hash, __m128i* W);
+void pbkdf2_sha1_sse2(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
+void pbkdf2_sha1_sha_ni(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
 
-PRIVATE void crypt_utf8_coalesc_protocol_sse2(CryptParam* param)
+PRIVATE void crypt_utf8_coalesc_protocol_sse2_body(CryptParam* param, pbkdf2_sha1_func* pbkdf2_sha1)
 {
 	__m128i* nt_buffer = (__m128i*)_aligned_malloc(17 * 4 * NT_NUM_KEYS, 16);
 	unsigned char* key = (unsigned char*)calloc(MAX_KEY_LENGHT_BIG, sizeof(unsigned char));
@@ -470,18 +473,7 @@ PRIVATE void crypt_utf8_coalesc_protocol_sse2(CryptParam* param)
 					// Copy
 					memcpy(crypt_result + di * 5, sha1_hash, 5 * sizeof(__m128i));
 
-					for (uint32_t k = 1; k < 4096; k++)
-					{
-						sha1_process_sha1_sse2(ipad_state, sha1_hash, W);
-						sha1_process_sha1_sse2(opad_state, sha1_hash, W);
-
-						// XOR
-						crypt_result[0+di*5] = SSE2_XOR(crypt_result[0+di*5], sha1_hash[0]);
-						crypt_result[1+di*5] = SSE2_XOR(crypt_result[1+di*5], sha1_hash[1]);
-						crypt_result[2+di*5] = SSE2_XOR(crypt_result[2+di*5], sha1_hash[2]);
-						crypt_result[3+di*5] = SSE2_XOR(crypt_result[3+di*5], sha1_hash[3]);
-						crypt_result[4+di*5] = SSE2_XOR(crypt_result[4+di*5], sha1_hash[4]);
-					}
+					pbkdf2_sha1(ipad_state, opad_state, sha1_hash, crypt_result + di * 5, W, 5, 4096);
 				}
 
 				// Search for a match
@@ -516,6 +508,14 @@ PRIVATE void crypt_utf8_coalesc_protocol_sse2(CryptParam* param)
 	_aligned_free(crypt_result);
 	finish_thread();
 }
+PRIVATE void crypt_utf8_coalesc_protocol_sse2(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_sse2_body(param, pbkdf2_sha1_sse2);
+}
+PRIVATE void crypt_utf8_coalesc_protocol_sha_ni(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_sse2_body(param, pbkdf2_sha1_sha_ni);
+}
 #endif
 
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -645,13 +645,6 @@ PRIVATE void crypt_utf8_coalesc_protocol_v128(CryptParam* param)
 #ifdef HS_X86
 #include <immintrin.h>
 
-#define AVX2_WORD				__m256i
-#define AVX2_AND(a,b)			_mm256_and_si256(a,b)
-#define AVX2_XOR(a,b)			_mm256_xor_si256(a,b)
-#define AVX2_ADD(a,b)			_mm256_add_epi32(a,b)
-#define AVX2_SR(a,shift)		_mm256_srli_epi32(a,shift)
-#define AVX2_CONST(u32_const)	_mm256_broadcastd_epi32(_mm_set1_epi32(u32_const))
-
 void sha1_process_sha1_avx2(const void* state, void* sha1_hash, void* W);
 
 PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
@@ -1672,12 +1665,12 @@ Format wpa_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_v128}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_SHA, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sha_ni}, {CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_v128}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 	#ifdef HS_ARM
-		{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_v128}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+		{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_v128}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 	#else
-		{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+		{{CPU_CAP_SHA, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sha_ni}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 	#endif
 #endif
 
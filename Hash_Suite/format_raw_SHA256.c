@@ -237,14 +237,53 @@ PRIVATE uint32_t compare_elem(uint32_t i, uint32_t cbg_table_pos, uint32_t* unpa
 	return TRUE;
 }
 
-PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_asm_func* crypt_kernel_asm)
+typedef void sha256_found_func(uint32_t index, unsigned char* cleartext);
+// Search the hashes of a batch in the cuckoo table
+PRIVATE void compare_batch(uint32_t* nt_buffer, unsigned char* key, sha256_found_func* found)
 {
-	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16+6) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
-
 	uint32_t* unpacked_W  = nt_buffer  + 8 * NT_NUM_KEYS;
 	uint32_t* unpacked_as = unpacked_W + 4 * NT_NUM_KEYS;
 	uint32_t* unpacked_hs = unpacked_W + 6 * NT_NUM_KEYS;
 
+	for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
+	{
+		uint32_t up0 = unpacked_as[i];
+		uint32_t up1 = unpacked_hs[i];
+
+		uint32_t pos = up0 & cbg_mask;
+		uint_fast16_t data = cbg_filter[pos];
+		if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+			found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+		// 2nd pos
+		if (data & 0b110)
+		{
+			pos += data & 0b1 ? -1 : 1;
+			uint_fast16_t hash = cbg_filter[pos];
+			if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+				found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+			// Unluky bucket
+			if (data & 0b10)
+			{
+				pos = up1 & cbg_mask;
+				data = cbg_filter[pos];
+				if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+					found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+
+				// 2nd pos
+				pos += data & 0b1 ? -1 : 1;
+				hash = cbg_filter[pos];
+				if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
+					found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
+			}
+		}
+	}
+}
+
+PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_asm_func* crypt_kernel_asm)
+{
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16+6) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
 	unsigned char key[MAX_KEY_LENGHT_SMALL];
 
 	memset(nt_buffer, 0, 8 * sizeof(uint32_t)* NT_NUM_KEYS);
@@ -254,40 +293,7 @@ PRIVATE void crypt_utf8_coalesc_protocol_body(CryptParam* param, crypt_kernel_as
 	{
 		crypt_kernel_asm(nt_buffer);
 
-		for (uint32_t i = 0; i < NT_NUM_KEYS; i++)
-		{
-			uint32_t up0 = unpacked_as[i];
-			uint32_t up1 = unpacked_hs[i];
-
-			uint32_t pos = up0 & cbg_mask;
-			uint_fast16_t data = cbg_filter[pos];
-			if (((data ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-				password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-			// 2nd pos
-			if (data & 0b110)
-			{
-				pos += data & 0b1 ? -1 : 1;
-				uint_fast16_t hash = cbg_filter[pos];
-				if (((hash ^ up1) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-					password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-				// Unluky bucket
-				if (data & 0b10)
-				{
-					pos = up1 & cbg_mask;
-					data = cbg_filter[pos];
-					if (((data ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-						password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-
-					// 2nd pos
-					pos += data & 0b1 ? -1 : 1;
-					hash = cbg_filter[pos];
-					if (((hash ^ up0) & 0xFFF8) == 0 && compare_elem(i, cbg_table[pos], unpacked_W))
-						password_was_found(cbg_table[pos], utf8_coalesc2utf8_key(nt_buffer, key, NT_NUM_KEYS, i));// Total match
-				}
-			}
-		}
+		compare_batch(nt_buffer, key, password_was_found);
 
 		report_keys_processed(NT_NUM_KEYS);
 	}
@@ -551,6 +557,425 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 }
 #endif
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SHA-NI code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef HS_X86
+PRIVATE const uint32_t sha256_k[56] = {
+	0x428A2F98, 0x71374491, 0xB5C0FBCF, 0xE9B5DBA5, 0x3956C25B, 0x59F111F1, 0x923F82A4, 0xAB1C5ED5,
+	0xD807AA98, 0x12835B01, 0x243185BE, 0x550C7DC3, 0x72BE5D74, 0x80DEB1FE, 0x9BDC06A7, 0xC19BF174,
+	0xE49B69C1, 0xEFBE4786, 0x0FC19DC6, 0x240CA1CC, 0x2DE92C6F, 0x4A7484AA, 0x5CB0A9DC, 0x76F988DA,
+	0x983E5152, 0xA831C66D, 0xB00327C8, 0xBF597FC7, 0xC6E00BF3, 0xD5A79147, 0x06CA6351, 0x14292967,
+	0x27B70A85, 0x2E1B2138, 0x4D2C6DFC, 0x53380D13, 0x650A7354, 0x766A0ABB, 0x81C2C92E, 0x92722C85,
+	0xA2BFE8A1, 0xA81A664B, 0xC24B8B70, 0xC76C51A3, 0xD192E819, 0xD6990624, 0xF40E3585, 0x106AA070,
+	0x19A4C116, 0x1E376C08, 0x2748774C, 0x34B0BCB5, 0x391C0CB3, 0x4ED8AA4A, 0x5B9CCA4F, 0x682E6FF3
+};
+
+// SHA-NI only works on one key by register: process some keys at the same time to hide latency
+#define SHA_NI_KEYS 4
+#define SHA_NI_FOR_KEYS(code) for (int k = 0; k < SHA_NI_KEYS; k++) { code }
+// From 4 words of 4 keys to 4 keys of 4 words and the other way around
+#define SHA_NI_TRANSPOSE(x0, x1, x2, x3, out) {\
+	__m128i t0 = _mm_unpacklo_epi32(x0, x1), t1 = _mm_unpacklo_epi32(x2, x3), t2 = _mm_unpackhi_epi32(x0, x1), t3 = _mm_unpackhi_epi32(x2, x3);\
+	out[0] = _mm_unpacklo_epi64(t0, t1);\
+	out[1] = _mm_unpackhi_epi64(t0, t1);\
+	out[2] = _mm_unpacklo_epi64(t2, t3);\
+	out[3] = _mm_unpackhi_epi64(t2, t3);\
+}
+
+// Same output as crypt_kernel_sse2: rounds 0..55 with SHA-NI, round 56 and last message words with SSE2
+PRIVATE HS_TARGET("sha,sse4.1") void crypt_kernel_sha_ni(SSE2_WORD* nt_buffer)
+{
+	SSE2_WORD* W = nt_buffer + 8 * SHA1_NUM;
+	__m128i bswap_mask = _mm_set_epi8(12, 13, 14, 15, 8, 9, 10, 11, 4, 5, 6, 7, 0, 1, 2, 3);
+	__m128i state0[SHA_NI_KEYS], state1[SHA_NI_KEYS], msg[16][SHA_NI_KEYS], tmp[SHA_NI_KEYS];
+	SSE2_WORD A, B, C, D, E, F, G, H;
+
+	for (int i = 0; i < SHA1_NUM; i++, nt_buffer++, W++)
+	{
+		// Load keys: W7..W14 are zero and W15 is the bit lenght
+		SHA_NI_TRANSPOSE(nt_buffer[0*SHA1_NUM], nt_buffer[1*SHA1_NUM], nt_buffer[2*SHA1_NUM], nt_buffer[3*SHA1_NUM], msg[0]);
+		SHA_NI_TRANSPOSE(nt_buffer[4*SHA1_NUM], nt_buffer[5*SHA1_NUM], nt_buffer[6*SHA1_NUM], nt_buffer[7*SHA1_NUM], tmp);
+		SHA_NI_FOR_KEYS(
+			msg[0][k] = _mm_shuffle_epi8(msg[0][k], bswap_mask);
+			msg[1][k] = _mm_blend_epi16(_mm_shuffle_epi8(tmp[k], bswap_mask), _mm_setzero_si128(), 0xC0);
+			msg[2][k] = _mm_setzero_si128();
+			msg[3][k] = _mm_blend_epi16(tmp[k], _mm_setzero_si128(), 0x3F);
+
+			state0[k] = _mm_set_epi32(INIT_A, INIT_B, INIT_E, INIT_F);
+			state1[k] = _mm_set_epi32(INIT_C, INIT_D, INIT_G, INIT_H);
+		)
+
+		/* Rounds */
+		for (int j = 0; j < 14; j++)
+		{
+			__m128i round_k = _mm_loadu_si128((const __m128i*)(sha256_k + 4 * j));
+			SHA_NI_FOR_KEYS(
+				if (j >= 4)
+					msg[j][k] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(msg[j-4][k], msg[j-3][k]), _mm_alignr_epi8(msg[j-1][k], msg[j-2][k], 4)), msg[j-1][k]);
+
+				__m128i msg_k = _mm_add_epi32(msg[j][k], round_k);
+				state1[k] = _mm_sha256rnds2_epu32(state1[k], state0[k], msg_k);
+				state0[k] = _mm_sha256rnds2_epu32(state0[k], state1[k], _mm_shuffle_epi32(msg_k, 0x0E));
+			)
+		}
+		SHA_NI_FOR_KEYS(
+			msg[14][k] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(msg[10][k], msg[11][k]), _mm_alignr_epi8(msg[13][k], msg[12][k], 4)), msg[13][k]);
+			msg[15][k] = _mm_sha256msg2_epu32(_mm_add_epi32(_mm_sha256msg1_epu32(msg[11][k], msg[12][k]), _mm_alignr_epi8(msg[14][k], msg[13][k], 4)), msg[14][k]);
+		)
+
+		// Back to one key by lane: state0 is ABEF and state1 is CDGH in reverse order
+		SHA_NI_TRANSPOSE(state0[0], state0[1], state0[2], state0[3], tmp);
+		F = tmp[0]; E = tmp[1]; B = tmp[2]; A = tmp[3];
+		SHA_NI_TRANSPOSE(state1[0], state1[1], state1[2], state1[3], tmp);
+		H = tmp[0]; G = tmp[1]; D = tmp[2]; C = tmp[3];
+
+		SHA_NI_TRANSPOSE(msg[10][0], msg[10][1], msg[10][2], msg[10][3], tmp);
+		W[10 * SHA1_NUM] = tmp[2];
+		W[11 * SHA1_NUM] = tmp[3];
+		SHA_NI_TRANSPOSE(msg[11][0], msg[11][1], msg[11][2], msg[11][3], tmp);
+		W[12 * SHA1_NUM] = tmp[0];
+		W[13 * SHA1_NUM] = tmp[1];
+		W[14 * SHA1_NUM] = tmp[2];
+		W[15 * SHA1_NUM] = tmp[3];
+		SHA_NI_TRANSPOSE(msg[12][0], msg[12][1], msg[12][2], msg[12][3], tmp);
+		W[ 3 * SHA1_NUM] = tmp[3];
+		SHA_NI_TRANSPOSE(msg[13][0], msg[13][1], msg[13][2], msg[13][3], tmp);
+		W[ 5 * SHA1_NUM] = tmp[1];
+		W[ 7 * SHA1_NUM] = tmp[3];
+		SHA_NI_TRANSPOSE(msg[14][0], msg[14][1], msg[14][2], msg[14][3], tmp);
+		W[ 8 * SHA1_NUM] = tmp[0];
+		W[ 9 * SHA1_NUM] = tmp[1];
+		W[ 2 * SHA1_NUM] = tmp[3];
+		SHA_NI_TRANSPOSE(msg[15][0], msg[15][1], msg[15][2], msg[15][3], tmp);
+		W[ 1 * SHA1_NUM] = tmp[1];
+		W[ 0 * SHA1_NUM] = tmp[3];
+
+		H = SSE2_5ADD(H, R_E(E), SSE2_XOR(G, SSE2_AND(E, SSE2_XOR(F, G))), SSE2_CONST(0x748F82EE), W[ 8 * SHA1_NUM]); D = SSE2_ADD(D, H); H = SSE2_3ADD(H, R_A(A), SSE2_OR(SSE2_AND(A, B), SSE2_AND(C, SSE2_OR(A, B))));
+		A = SSE2_ADD(A, W[0 * SHA1_NUM]);
+
+		W[4  * SHA1_NUM] = A;
+		W[16 * SHA1_NUM] = B;
+		W[17 * SHA1_NUM] = C;
+		W[18 * SHA1_NUM] = D;
+		W[19 * SHA1_NUM] = E;
+		W[20 * SHA1_NUM] = F;
+		W[21 * SHA1_NUM] = G;
+		W[6  * SHA1_NUM] = H;
+	}
+}
+PRIVATE void crypt_utf8_coalesc_protocol_sha_ni(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_body(param, (crypt_kernel_asm_func*)crypt_kernel_sha_ni);
+}
+#endif
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+#undef SHA1_NUM
+#define SHA1_NUM		(NT_NUM_KEYS/16)
+#define LOAD_BIG_ENDIAN_AVX512(x,data) x = AVX512_ROTATE(data, 16); x = AVX512_ADD(AVX512_SL(AVX512_AND(x, mask), 8), AVX512_AND(AVX512_SR(x, 8), mask));
+
+#undef R_E
+#undef R_A
+#undef R0
+#undef R1
+#define R_E(x) AVX512_3XOR(AVX512_ROTATE(x,26), AVX512_ROTATE(x,21), AVX512_ROTATE(x,7 ))
+#define R_A(x) AVX512_3XOR(AVX512_ROTATE(x,30), AVX512_ROTATE(x,19), AVX512_ROTATE(x,10))
+#define R0(x)  AVX512_3XOR(AVX512_ROTATE(x,25), AVX512_ROTATE(x,14), AVX512_SR(x,3))
+#define R1(x)  AVX512_3XOR(AVX512_ROTATE(x,15), AVX512_ROTATE(x,13), AVX512_SR(x,10))
+
+PRIVATE HS_TARGET("avx512f") void crypt_kernel_avx512(AVX512_WORD* nt_buffer)
+{
+	AVX512_WORD* W = nt_buffer + 8 * SHA1_NUM;
+	AVX512_WORD mask = AVX512_CONST(0x00FF00FF);
+	AVX512_WORD A, B, C, D, E, F, G, H;
+
+	for (int i = 0; i < SHA1_NUM; i++, nt_buffer++, W++)
+	{
+		LOAD_BIG_ENDIAN_AVX512(W[0*SHA1_NUM], nt_buffer[0*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[1*SHA1_NUM], nt_buffer[1*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[2*SHA1_NUM], nt_buffer[2*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[3*SHA1_NUM], nt_buffer[3*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[4*SHA1_NUM], nt_buffer[4*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[5*SHA1_NUM], nt_buffer[5*SHA1_NUM]);
+		LOAD_BIG_ENDIAN_AVX512(W[6*SHA1_NUM], nt_buffer[6*SHA1_NUM]);
+		W[15*SHA1_NUM] = nt_buffer[7*SHA1_NUM];
+		
+		/* Rounds */
+		H = AVX512_ADD(AVX512_CONST(0xfc08884d), W[0 * SHA1_NUM]);						                                                                 D = AVX512_ADD(AVX512_CONST(0x9cbf5a55), H);
+		G = AVX512_4ADD(R_E(D), AVX512_XOR(AVX512_CONST(INIT_F), AVX512_AND(D, AVX512_CONST(0xca0b3af3)))         , AVX512_CONST(0x90bb1e3c), W[ 1 * SHA1_NUM]); C = AVX512_ADD(AVX512_CONST(INIT_C),G); G = AVX512_3ADD(G, R_A(H), AVX512_OR(AVX512_AND(H, AVX512_CONST(INIT_A)), AVX512_AND(AVX512_CONST(INIT_B), AVX512_OR(H, AVX512_CONST(INIT_A)))));
+		F = AVX512_4ADD(R_E(C), AVX512_XOR(AVX512_CONST(INIT_E), AVX512_AND(C, AVX512_XOR(D, AVX512_CONST(INIT_E)))), AVX512_CONST(0x50c6645b), W[ 2 * SHA1_NUM]); B = AVX512_ADD(AVX512_CONST(INIT_B),F); F = AVX512_3ADD(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(AVX512_CONST(INIT_A), AVX512_OR(G, H))));
+		E = AVX512_4ADD(R_E(B), AVX512_CH(B, C, D)			                        , AVX512_CONST(0x3ac42e24), W[ 3 * SHA1_NUM]); A = AVX512_ADD(AVX512_CONST(INIT_A),E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C)			                    , AVX512_CONST(0x3956C25B), W[ 4 * SHA1_NUM]); H = AVX512_ADD(H, D);                 D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B)			                    , AVX512_CONST(0x59F111F1), W[ 5 * SHA1_NUM]); G = AVX512_ADD(G, C);                 C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A)			                    , AVX512_CONST(0x923F82A4), W[ 6 * SHA1_NUM]); F = AVX512_ADD(F, B);                 B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		A = AVX512_4ADD(A, R_E(F), AVX512_CH(F, G, H)			                    , AVX512_CONST(0xAB1C5ED5)                  ); E = AVX512_ADD(E, A);                 A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+		H = AVX512_4ADD(H, R_E(E), AVX512_CH(E, F, G)			                    , AVX512_CONST(0xD807AA98)                  ); D = AVX512_ADD(D, H);                 H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		G = AVX512_4ADD(G, R_E(D), AVX512_CH(D, E, F)			                    , AVX512_CONST(0x12835B01)                  ); C = AVX512_ADD(C, G);                 G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		F = AVX512_4ADD(F, R_E(C), AVX512_CH(C, D, E)			                    , AVX512_CONST(0x243185BE)                  ); B = AVX512_ADD(B, F);                 F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		E = AVX512_4ADD(E, R_E(B), AVX512_CH(B, C, D)			                    , AVX512_CONST(0x550C7DC3)                  ); A = AVX512_ADD(A, E);                 E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		D = AVX512_4ADD(D, R_E(A), AVX512_CH(A, B, C)			                    , AVX512_CONST(0x72BE5D74)                  ); H = AVX512_ADD(H, D);                 D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		C = AVX512_4ADD(C, R_E(H), AVX512_CH(H, A, B)			                    , AVX512_CONST(0x80DEB1FE)                  ); G = AVX512_ADD(G, C);                 C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		B = AVX512_4ADD(B, R_E(G), AVX512_CH(G, H, A)			                    , AVX512_CONST(0x9BDC06A7)                  ); F = AVX512_ADD(F, B);                 B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H)			                    , AVX512_CONST(0xC19BF174), W[15 * SHA1_NUM]); E = AVX512_ADD(E, A);                 A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+
+		W[ 0 * SHA1_NUM] = AVX512_ADD (W[ 0 * SHA1_NUM], 				                           R0(W[1  * SHA1_NUM])); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0xE49B69C1), W[ 0 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 1 * SHA1_NUM] = AVX512_3ADD(W[ 1 * SHA1_NUM], R1(W[15 * SHA1_NUM]),                   R0(W[2  * SHA1_NUM])); G = AVX512_5ADD(G, R_E(D), AVX512_CH(D, E, F), AVX512_CONST(0xEFBE4786), W[ 1 * SHA1_NUM]); C = AVX512_ADD(C, G); G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		W[ 2 * SHA1_NUM] = AVX512_3ADD(W[ 2 * SHA1_NUM], R1(W[0  * SHA1_NUM]),                   R0(W[3  * SHA1_NUM])); F = AVX512_5ADD(F, R_E(C), AVX512_CH(C, D, E), AVX512_CONST(0x0FC19DC6), W[ 2 * SHA1_NUM]); B = AVX512_ADD(B, F); F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		W[ 3 * SHA1_NUM] = AVX512_3ADD(W[ 3 * SHA1_NUM], R1(W[1  * SHA1_NUM]),                   R0(W[4  * SHA1_NUM])); E = AVX512_5ADD(E, R_E(B), AVX512_CH(B, C, D), AVX512_CONST(0x240CA1CC), W[ 3 * SHA1_NUM]); A = AVX512_ADD(A, E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		W[ 4 * SHA1_NUM] = AVX512_3ADD(W[ 4 * SHA1_NUM], R1(W[2  * SHA1_NUM]),                   R0(W[5  * SHA1_NUM])); D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C), AVX512_CONST(0x2DE92C6F), W[ 4 * SHA1_NUM]); H = AVX512_ADD(H, D); D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		W[ 5 * SHA1_NUM] = AVX512_3ADD(W[ 5 * SHA1_NUM], R1(W[3  * SHA1_NUM]),                   R0(W[6  * SHA1_NUM])); C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B), AVX512_CONST(0x4A7484AA), W[ 5 * SHA1_NUM]); G = AVX512_ADD(G, C); C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		W[ 6 * SHA1_NUM] = AVX512_3ADD(W[ 6 * SHA1_NUM], R1(W[4  * SHA1_NUM]), W[15 * SHA1_NUM]                      ); B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A), AVX512_CONST(0x5CB0A9DC), W[ 6 * SHA1_NUM]); F = AVX512_ADD(F, B); B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		W[ 7 * SHA1_NUM] = AVX512_ADD (                  R1(W[5  * SHA1_NUM]), W[0  * SHA1_NUM]                      ); A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H), AVX512_CONST(0x76F988DA), W[ 7 * SHA1_NUM]); E = AVX512_ADD(E, A); A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+		W[ 8 * SHA1_NUM] = AVX512_ADD (                  R1(W[6  * SHA1_NUM]), W[1  * SHA1_NUM]                      ); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0x983E5152), W[ 8 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 9 * SHA1_NUM] = AVX512_ADD (                  R1(W[7  * SHA1_NUM]), W[2  * SHA1_NUM]                      ); G = AVX512_5ADD(G, R_E(D), AVX512_CH(D, E, F), AVX512_CONST(0xA831C66D), W[ 9 * SHA1_NUM]); C = AVX512_ADD(C, G); G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		W[10 * SHA1_NUM] = AVX512_ADD (                  R1(W[8  * SHA1_NUM]), W[3  * SHA1_NUM]                      ); F = AVX512_5ADD(F, R_E(C), AVX512_CH(C, D, E), AVX512_CONST(0xB00327C8), W[10 * SHA1_NUM]); B = AVX512_ADD(B, F); F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		W[11 * SHA1_NUM] = AVX512_ADD (                  R1(W[9  * SHA1_NUM]), W[4  * SHA1_NUM]                      ); E = AVX512_5ADD(E, R_E(B), AVX512_CH(B, C, D), AVX512_CONST(0xBF597FC7), W[11 * SHA1_NUM]); A = AVX512_ADD(A, E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		W[12 * SHA1_NUM] = AVX512_ADD (                  R1(W[10 * SHA1_NUM]), W[5  * SHA1_NUM]                      ); D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C), AVX512_CONST(0xC6E00BF3), W[12 * SHA1_NUM]); H = AVX512_ADD(H, D); D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		W[13 * SHA1_NUM] = AVX512_ADD (                  R1(W[11 * SHA1_NUM]), W[6  * SHA1_NUM]                      ); C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B), AVX512_CONST(0xD5A79147), W[13 * SHA1_NUM]); G = AVX512_ADD(G, C); C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		W[14 * SHA1_NUM] = AVX512_3ADD(                  R1(W[12 * SHA1_NUM]), W[7  * SHA1_NUM], R0(W[15 * SHA1_NUM])); B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A), AVX512_CONST(0x06CA6351), W[14 * SHA1_NUM]); F = AVX512_ADD(F, B); B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		W[15 * SHA1_NUM] = AVX512_4ADD(W[15 * SHA1_NUM], R1(W[13 * SHA1_NUM]), W[8  * SHA1_NUM], R0(W[0  * SHA1_NUM])); A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H), AVX512_CONST(0x14292967), W[15 * SHA1_NUM]); E = AVX512_ADD(E, A); A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+																    												  
+		W[ 0 * SHA1_NUM] = AVX512_4ADD(W[ 0 * SHA1_NUM], R1(W[14 * SHA1_NUM]), W[9  * SHA1_NUM], R0(W[1  * SHA1_NUM])); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0x27B70A85), W[ 0 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 1 * SHA1_NUM] = AVX512_4ADD(W[ 1 * SHA1_NUM], R1(W[15 * SHA1_NUM]), W[10 * SHA1_NUM], R0(W[2  * SHA1_NUM])); G = AVX512_5ADD(G, R_E(D), AVX512_CH(D, E, F), AVX512_CONST(0x2E1B2138), W[ 1 * SHA1_NUM]); C = AVX512_ADD(C, G); G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		W[ 2 * SHA1_NUM] = AVX512_4ADD(W[ 2 * SHA1_NUM], R1(W[0  * SHA1_NUM]), W[11 * SHA1_NUM], R0(W[3  * SHA1_NUM])); F = AVX512_5ADD(F, R_E(C), AVX512_CH(C, D, E), AVX512_CONST(0x4D2C6DFC), W[ 2 * SHA1_NUM]); B = AVX512_ADD(B, F); F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		W[ 3 * SHA1_NUM] = AVX512_4ADD(W[ 3 * SHA1_NUM], R1(W[1  * SHA1_NUM]), W[12 * SHA1_NUM], R0(W[4  * SHA1_NUM])); E = AVX512_5ADD(E, R_E(B), AVX512_CH(B, C, D), AVX512_CONST(0x53380D13), W[ 3 * SHA1_NUM]); A = AVX512_ADD(A, E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		W[ 4 * SHA1_NUM] = AVX512_4ADD(W[ 4 * SHA1_NUM], R1(W[2  * SHA1_NUM]), W[13 * SHA1_NUM], R0(W[5  * SHA1_NUM])); D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C), AVX512_CONST(0x650A7354), W[ 4 * SHA1_NUM]); H = AVX512_ADD(H, D); D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		W[ 5 * SHA1_NUM] = AVX512_4ADD(W[ 5 * SHA1_NUM], R1(W[3  * SHA1_NUM]), W[14 * SHA1_NUM], R0(W[6  * SHA1_NUM])); C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B), AVX512_CONST(0x766A0ABB), W[ 5 * SHA1_NUM]); G = AVX512_ADD(G, C); C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		W[ 6 * SHA1_NUM] = AVX512_4ADD(W[ 6 * SHA1_NUM], R1(W[4  * SHA1_NUM]), W[15 * SHA1_NUM], R0(W[7  * SHA1_NUM])); B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A), AVX512_CONST(0x81C2C92E), W[ 6 * SHA1_NUM]); F = AVX512_ADD(F, B); B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		W[ 7 * SHA1_NUM] = AVX512_4ADD(W[ 7 * SHA1_NUM], R1(W[5  * SHA1_NUM]), W[0  * SHA1_NUM], R0(W[8  * SHA1_NUM])); A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H), AVX512_CONST(0x92722C85), W[ 7 * SHA1_NUM]); E = AVX512_ADD(E, A); A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+		W[ 8 * SHA1_NUM] = AVX512_4ADD(W[ 8 * SHA1_NUM], R1(W[6  * SHA1_NUM]), W[1  * SHA1_NUM], R0(W[9  * SHA1_NUM])); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0xA2BFE8A1), W[ 8 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 9 * SHA1_NUM] = AVX512_4ADD(W[ 9 * SHA1_NUM], R1(W[7  * SHA1_NUM]), W[2  * SHA1_NUM], R0(W[10 * SHA1_NUM])); G = AVX512_5ADD(G, R_E(D), AVX512_CH(D, E, F), AVX512_CONST(0xA81A664B), W[ 9 * SHA1_NUM]); C = AVX512_ADD(C, G); G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		W[10 * SHA1_NUM] = AVX512_4ADD(W[10 * SHA1_NUM], R1(W[8  * SHA1_NUM]), W[3  * SHA1_NUM], R0(W[11 * SHA1_NUM])); F = AVX512_5ADD(F, R_E(C), AVX512_CH(C, D, E), AVX512_CONST(0xC24B8B70), W[10 * SHA1_NUM]); B = AVX512_ADD(B, F); F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		W[11 * SHA1_NUM] = AVX512_4ADD(W[11 * SHA1_NUM], R1(W[9  * SHA1_NUM]), W[4  * SHA1_NUM], R0(W[12 * SHA1_NUM])); E = AVX512_5ADD(E, R_E(B), AVX512_CH(B, C, D), AVX512_CONST(0xC76C51A3), W[11 * SHA1_NUM]); A = AVX512_ADD(A, E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		W[12 * SHA1_NUM] = AVX512_4ADD(W[12 * SHA1_NUM], R1(W[10 * SHA1_NUM]), W[5  * SHA1_NUM], R0(W[13 * SHA1_NUM])); D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C), AVX512_CONST(0xD192E819), W[12 * SHA1_NUM]); H = AVX512_ADD(H, D); D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		W[13 * SHA1_NUM] = AVX512_4ADD(W[13 * SHA1_NUM], R1(W[11 * SHA1_NUM]), W[6  * SHA1_NUM], R0(W[14 * SHA1_NUM])); C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B), AVX512_CONST(0xD6990624), W[13 * SHA1_NUM]); G = AVX512_ADD(G, C); C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		W[14 * SHA1_NUM] = AVX512_4ADD(W[14 * SHA1_NUM], R1(W[12 * SHA1_NUM]), W[7  * SHA1_NUM], R0(W[15 * SHA1_NUM])); B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A), AVX512_CONST(0xF40E3585), W[14 * SHA1_NUM]); F = AVX512_ADD(F, B); B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		W[15 * SHA1_NUM] = AVX512_4ADD(W[15 * SHA1_NUM], R1(W[13 * SHA1_NUM]), W[8  * SHA1_NUM], R0(W[0  * SHA1_NUM])); A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H), AVX512_CONST(0x106AA070), W[15 * SHA1_NUM]); E = AVX512_ADD(E, A); A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+																    								 						
+		W[ 0 * SHA1_NUM] = AVX512_4ADD(W[ 0 * SHA1_NUM], R1(W[14 * SHA1_NUM]), W[9  * SHA1_NUM], R0(W[1  * SHA1_NUM])); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0x19A4C116), W[ 0 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 1 * SHA1_NUM] = AVX512_4ADD(W[ 1 * SHA1_NUM], R1(W[15 * SHA1_NUM]), W[10 * SHA1_NUM], R0(W[2  * SHA1_NUM])); G = AVX512_5ADD(G, R_E(D), AVX512_CH(D, E, F), AVX512_CONST(0x1E376C08), W[ 1 * SHA1_NUM]); C = AVX512_ADD(C, G); G = AVX512_3ADD(G, R_A(H), AVX512_MAJ(H, A, B));
+		W[ 2 * SHA1_NUM] = AVX512_4ADD(W[ 2 * SHA1_NUM], R1(W[0  * SHA1_NUM]), W[11 * SHA1_NUM], R0(W[3  * SHA1_NUM])); F = AVX512_5ADD(F, R_E(C), AVX512_CH(C, D, E), AVX512_CONST(0x2748774C), W[ 2 * SHA1_NUM]); B = AVX512_ADD(B, F); F = AVX512_3ADD(F, R_A(G), AVX512_MAJ(G, H, A));
+		W[ 3 * SHA1_NUM] = AVX512_4ADD(W[ 3 * SHA1_NUM], R1(W[1  * SHA1_NUM]), W[12 * SHA1_NUM], R0(W[4  * SHA1_NUM])); E = AVX512_5ADD(E, R_E(B), AVX512_CH(B, C, D), AVX512_CONST(0x34B0BCB5), W[ 3 * SHA1_NUM]); A = AVX512_ADD(A, E); E = AVX512_3ADD(E, R_A(F), AVX512_MAJ(F, G, H));
+		W[ 4 * SHA1_NUM] = AVX512_4ADD(W[ 4 * SHA1_NUM], R1(W[2  * SHA1_NUM]), W[13 * SHA1_NUM], R0(W[5  * SHA1_NUM])); D = AVX512_5ADD(D, R_E(A), AVX512_CH(A, B, C), AVX512_CONST(0x391C0CB3), W[ 4 * SHA1_NUM]); H = AVX512_ADD(H, D); D = AVX512_3ADD(D, R_A(E), AVX512_MAJ(E, F, G));
+		W[ 5 * SHA1_NUM] = AVX512_4ADD(W[ 5 * SHA1_NUM], R1(W[3  * SHA1_NUM]), W[14 * SHA1_NUM], R0(W[6  * SHA1_NUM])); C = AVX512_5ADD(C, R_E(H), AVX512_CH(H, A, B), AVX512_CONST(0x4ED8AA4A), W[ 5 * SHA1_NUM]); G = AVX512_ADD(G, C); C = AVX512_3ADD(C, R_A(D), AVX512_MAJ(D, E, F));
+		W[ 6 * SHA1_NUM] = AVX512_4ADD(W[ 6 * SHA1_NUM], R1(W[4  * SHA1_NUM]), W[15 * SHA1_NUM], R0(W[7  * SHA1_NUM])); B = AVX512_5ADD(B, R_E(G), AVX512_CH(G, H, A), AVX512_CONST(0x5B9CCA4F), W[ 6 * SHA1_NUM]); F = AVX512_ADD(F, B); B = AVX512_3ADD(B, R_A(C), AVX512_MAJ(C, D, E));
+		W[ 7 * SHA1_NUM] = AVX512_4ADD(W[ 7 * SHA1_NUM], R1(W[5  * SHA1_NUM]), W[0  * SHA1_NUM], R0(W[8  * SHA1_NUM])); A = AVX512_5ADD(A, R_E(F), AVX512_CH(F, G, H), AVX512_CONST(0x682E6FF3), W[ 7 * SHA1_NUM]); E = AVX512_ADD(E, A); A = AVX512_3ADD(A, R_A(B), AVX512_MAJ(B, C, D));
+		W[ 8 * SHA1_NUM] = AVX512_4ADD(W[ 8 * SHA1_NUM], R1(W[6  * SHA1_NUM]), W[1  * SHA1_NUM], R0(W[9  * SHA1_NUM])); H = AVX512_5ADD(H, R_E(E), AVX512_CH(E, F, G), AVX512_CONST(0x748F82EE), W[ 8 * SHA1_NUM]); D = AVX512_ADD(D, H); H = AVX512_3ADD(H, R_A(A), AVX512_MAJ(A, B, C));
+		W[ 9 * SHA1_NUM] = AVX512_4ADD(W[ 9 * SHA1_NUM], R1(W[7  * SHA1_NUM]), W[2  * SHA1_NUM], R0(W[10 * SHA1_NUM]));
+		W[ 2 * SHA1_NUM] = AVX512_4ADD(W[11 * SHA1_NUM], R1(W[9  * SHA1_NUM]), W[4  * SHA1_NUM], R0(W[12 * SHA1_NUM]));
+		W[ 1 * SHA1_NUM] = AVX512_4ADD(W[13 * SHA1_NUM], R1(W[2  * SHA1_NUM]), W[6  * SHA1_NUM], R0(W[14 * SHA1_NUM]));
+		W[ 0 * SHA1_NUM] = AVX512_4ADD(W[15 * SHA1_NUM], R1(W[1  * SHA1_NUM]), W[8  * SHA1_NUM], R0(W[0  * SHA1_NUM])); A = AVX512_ADD(A, W[0 * SHA1_NUM]); 
+
+		W[4  * SHA1_NUM] = A;
+		W[16 * SHA1_NUM] = B;
+		W[17 * SHA1_NUM] = C;
+		W[18 * SHA1_NUM] = D;
+		W[19 * SHA1_NUM] = E;
+		W[20 * SHA1_NUM] = F;
+		W[21 * SHA1_NUM] = G;
+		W[6  * SHA1_NUM] = H;
+	}
+}
+PRIVATE void crypt_utf8_coalesc_protocol_avx512(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_body(param, (crypt_kernel_asm_func*)crypt_kernel_avx512);
+}
+#endif
+
+#ifdef HS_X86
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// SHA-NI is slower than the best SIMD code in some CPUs, and CPU_CAP_SHA is calibrated with SHA1.
+// Compare the SHA256 kernels themselves to set CPU_CAP_SHA256. Run after the AVX512 calibration.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define SHA256_NI_CALIBRATION_MS	8
+PUBLIC int is_sha256_ni_faster()
+{
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16+6) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
+	crypt_kernel_asm_func* simd_kernel = (crypt_kernel_asm_func*)crypt_kernel_sse2;
+	int64_t sha_ni_keys = 0, simd_keys = 0;
+
+#ifdef _M_X64
+	if (current_cpu.capabilites[CPU_CAP_AVX512])
+		simd_kernel = (crypt_kernel_asm_func*)crypt_kernel_avx512;
+	else if (current_cpu.capabilites[CPU_CAP_AVX2])
+		simd_kernel = crypt_sha256_avx2_kernel_asm;
+	else if (current_cpu.capabilites[CPU_CAP_AVX])
+		simd_kernel = crypt_sha256_avx_kernel_asm;
+#endif
+	memset(nt_buffer, 0, (8+16+6) * sizeof(uint32_t) * NT_NUM_KEYS);
+
+	// Alternate both kernels so a noisy moment doesn't favor one of them
+	for (int i = 0; i < 2; i++)
+	{
+		int64_t start = get_milliseconds();
+		while ((get_milliseconds() - start) < SHA256_NI_CALIBRATION_MS)
+		{
+			crypt_kernel_sha_ni((SSE2_WORD*)nt_buffer);
+			sha_ni_keys += NT_NUM_KEYS;
+		}
+
+		start = get_milliseconds();
+		while ((get_milliseconds() - start) < SHA256_NI_CALIBRATION_MS)
+		{
+			simd_kernel(nt_buffer);
+			simd_keys += NT_NUM_KEYS;
+		}
+	}
+
+	_aligned_free(nt_buffer);
+	return sha_ni_keys > simd_keys;
+}
+
+#ifdef HS_TESTING
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Kernels checked against hash_sha256 and timed with 1 to 10^6 loaded hashes
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define RAW_SHA256_BENCH_MAX_HASHES	1000000
+#define RAW_SHA256_BENCH_KEYS		(1 << 20)
+void convert_utf8_2_coalesc(const unsigned char* key, uint32_t* nt_buffer, uint32_t max_number, uint32_t len);
+PRIVATE const struct {
+	uint32_t needed_cap;
+	crypt_kernel_asm_func* kernel;
+	const char* name;
+} raw_sha256_engines[] = {
+	{ CPU_CAP_SSE2  , (crypt_kernel_asm_func*)crypt_kernel_sse2  , "SSE2"    },
+#ifdef _M_X64
+	{ CPU_CAP_AVX   , crypt_sha256_avx_kernel_asm                 , "AVX"     },
+	{ CPU_CAP_AVX2  , crypt_sha256_avx2_kernel_asm                , "AVX2"    },
+	{ CPU_CAP_AVX512, (crypt_kernel_asm_func*)crypt_kernel_avx512, "AVX-512" },
+#endif
+	// Tested when the CPU has it, even if slower than the SIMD code
+	{ CPU_CAP_SHA256, (crypt_kernel_asm_func*)crypt_kernel_sha_ni, "SHA-NI"  },
+};
+// Key k of the batch is the one of hash k/3 when k is a multiple of 3: all lengths have a hash
+PRIVATE uint32_t raw_sha256_bench_found, raw_sha256_bench_wrong;
+PRIVATE const unsigned char (*raw_sha256_bench_keys)[NTLM_MAX_KEY_LENGHT + 1];
+PRIVATE void raw_sha256_bench_password_found(uint32_t index, unsigned char* cleartext)
+{
+	if (index * 3 < NT_NUM_KEYS && !strcmp((const char*)cleartext, (const char*)raw_sha256_bench_keys[index * 3]))
+		raw_sha256_bench_found++;
+	else
+		raw_sha256_bench_wrong++;
+}
+PUBLIC int bench_raw_sha256_kernels()
+{
+	uint32_t* nt_buffer = (uint32_t*)_aligned_malloc((8+16+6) * sizeof(uint32_t) * NT_NUM_KEYS, 64);
+	uint32_t* keys_buffer = (uint32_t*)malloc(8 * sizeof(uint32_t) * NT_NUM_KEYS);
+	uint32_t* bench_binaries = (uint32_t*)malloc(BINARY_SIZE * (size_t)RAW_SHA256_BENCH_MAX_HASHES);
+	unsigned char keys[NT_NUM_KEYS][NTLM_MAX_KEY_LENGHT + 1];
+	unsigned char key[MAX_KEY_LENGHT_SMALL];
+	int result = TRUE;
+
+	if (!nt_buffer || !keys_buffer || !bench_binaries)
+	{
+		hs_log(HS_LOG_INFO, "Test Suite", "Raw-SHA256 kernels benchmark: skipped, not enough memory");
+		if (nt_buffer) _aligned_free(nt_buffer);
+		free(keys_buffer);
+		free(bench_binaries);
+		return TRUE;
+	}
+
+	// Save the attack state
+	void* old_binary_values = binary_values;
+	uint32_t* old_is_foundBit = is_foundBit;
+	uint32_t old_num_passwords_loaded = num_passwords_loaded;
+	uint16_t* old_cbg_filter = cbg_filter;
+	uint32_t* old_cbg_table = cbg_table;
+	uint32_t old_cbg_mask = cbg_mask;
+	uint32_t old_cbg_count_moved = cbg_count_moved;
+	uint32_t old_cbg_count_unlucky = cbg_count_unlucky;
+	uint32_t old_cbg_num_removed = cbg_num_removed;
+
+	// Different random keys of all lengths, the planted hashes first and the others random
+	generate_random((uint8_t*)bench_binaries, BINARY_SIZE * (size_t)RAW_SHA256_BENCH_MAX_HASHES);
+	memset(keys, 0, sizeof(keys));
+	for (uint32_t k = 0; k < NT_NUM_KEYS; k++)
+	{
+		uint32_t len = k ? 1 + (k - 1) % NTLM_MAX_KEY_LENGHT : 0;
+		uint32_t same_key;
+
+		do
+		{
+			generate_random(keys[k], len);
+			for (uint32_t j = 0; j < len; j++)
+				keys[k][j] = ' ' + keys[k][j] % 95;
+
+			for (same_key = 0; same_key < k && strcmp((const char*)keys[same_key], (const char*)keys[k]); same_key++);
+		}
+		while (same_key < k);
+		convert_utf8_2_coalesc(keys[k], keys_buffer + k, NT_NUM_KEYS, len);
+
+		if (k % 3 == 0)
+		{
+			char hash[65];
+			hash_sha256((const char*)keys[k], hash);
+			get_binary((const unsigned char*)hash, bench_binaries + k / 3 * 8, NULL);
+		}
+	}
+	raw_sha256_bench_keys = keys;
+	binary_values = bench_binaries;
+	is_foundBit = NULL;
+
+	for (uint32_t num_hashes = 1; num_hashes <= RAW_SHA256_BENCH_MAX_HASHES; num_hashes *= 1000)
+	{
+		uint32_t num_found_by_batch = __min(num_hashes, (NT_NUM_KEYS + 2) / 3);
+
+		num_passwords_loaded = num_hashes;
+		if (build_cbg_table(SHA256_INDEX, VALUE_MAP_INDEX0, VALUE_MAP_INDEX1) == CBG_TABLE_FAILED)
+		{
+			result = FALSE;
+			break;
+		}
+
+		for (uint32_t e = 0; e < LENGTH(raw_sha256_engines); e++)
+			if (raw_sha256_engines[e].needed_cap == CPU_CAP_SHA256 ? has_sha_ni : current_cpu.capabilites[raw_sha256_engines[e].needed_cap])
+			{
+				raw_sha256_bench_found = raw_sha256_bench_wrong = 0;
+
+				int64_t start = get_milliseconds();
+				for (uint32_t i = 0; i < RAW_SHA256_BENCH_KEYS / NT_NUM_KEYS; i++)
+				{
+					memcpy(nt_buffer, keys_buffer, 8 * sizeof(uint32_t) * NT_NUM_KEYS);
+					raw_sha256_engines[e].kernel(nt_buffer);
+					compare_batch(nt_buffer, key, raw_sha256_bench_password_found);
+				}
+				int64_t ms = get_milliseconds() - start;
+
+				if (raw_sha256_bench_wrong || raw_sha256_bench_found != num_found_by_batch * (RAW_SHA256_BENCH_KEYS / NT_NUM_KEYS))
+				{
+					hs_log(HS_LOG_ERROR, "Test Suite", "Raw-SHA256 %s kernel fails with %u hashes", raw_sha256_engines[e].name, num_hashes);
+					result = FALSE;
+				}
+				hs_log(HS_LOG_INFO, "Test Suite", "Raw-SHA256 %u hashes, %s: %.2f M keys/s", num_hashes, raw_sha256_engines[e].name, RAW_SHA256_BENCH_KEYS / 1000. / __max(ms, 1));
+			}
+
+		large_page_free(cbg_filter);
+		large_page_free(cbg_table);
+	}
+
+	// Restore the attack state
+	binary_values = old_binary_values;
+	is_foundBit = old_is_foundBit;
+	num_passwords_loaded = old_num_passwords_loaded;
+	cbg_filter = old_cbg_filter;
+	cbg_table = old_cbg_table;
+	cbg_mask = old_cbg_mask;
+	cbg_count_moved = old_cbg_count_moved;
+	cbg_count_unlucky = old_cbg_count_unlucky;
+	cbg_num_removed = old_cbg_num_removed;
+
+	_aligned_free(nt_buffer);
+	free(keys_buffer);
+	free(bench_binaries);
+	return result;
+}
+#endif
+#endif
+
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementations
 //////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -1621,12 +2046,12 @@ Format raw_sha256_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_SHA256, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sha_ni}, {CPU_CAP_AVX512, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SHA256, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sha_ni}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
@@ -697,6 +697,174 @@ PRIVATE void crypt_utf8_coalesc_protocol_avx2(CryptParam* param)
 }
 #endif
 
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// AVX512 code
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef _M_X64
+#undef SHA512_NUM
+#define SHA512_NUM		(NT_NUM_KEYS/8)
+#define SWAP_ENDIANNESS_AVX512(x,data) x = AVX512_ROTATE(data, 16); x = AVX512_ADD(AVX512_SL(AVX512_AND(x, mask), 8), AVX512_AND(AVX512_SR(x, 8), mask));
+// Zero extend the low 8 values to 64 bits
+#define AVX512_LOW_TO_64(x)		_mm512_cvtepu32_epi64(_mm512_castsi512_si256(x))
+#define AVX512_HIGH_TO_LOW(x)	x = _mm512_shuffle_i64x2(x, x, 0xEE)
+#define K512(index)				AVX512_CONST64(K64[2 * (index)])
+
+#undef R_E
+#undef R_A
+#undef R0
+#undef R1
+#define R_E(x) AVX512_3XOR(AVX512_ROTATE64(x,50), AVX512_ROTATE64(x,46), AVX512_ROTATE64(x,23))
+#define R_A(x) AVX512_3XOR(AVX512_ROTATE64(x,36), AVX512_ROTATE64(x,30), AVX512_ROTATE64(x,25))
+#define R0(x)  AVX512_3XOR(AVX512_ROTATE64(x,63), AVX512_ROTATE64(x,56), AVX512_SR64(x,7))
+#define R1(x)  AVX512_3XOR(AVX512_ROTATE64(x,45), AVX512_ROTATE64(x,3 ), AVX512_SR64(x,6))
+
+PRIVATE HS_TARGET("avx512f") void crypt_kernel_avx512(uint32_t* nt_bufferu)
+{
+	AVX512_WORD* W = (AVX512_WORD*)(nt_bufferu + 8 * NT_NUM_KEYS);
+	AVX512_WORD mask = AVX512_CONST(0x00FF00FF);
+	AVX512_WORD A, B, C, D, E, F, G, H;
+	AVX512_WORD t0, t1, t2, t3, t4, t5, t6, len;
+
+	for (int i = 0; i < SHA512_NUM; i++, W++)
+	{
+		// 16 keys are loaded: use the low 8 now and the high 8 in the next iteration
+		if ((i & 1) == 0)
+		{
+			AVX512_WORD* nt_buffer = (AVX512_WORD*)nt_bufferu;
+
+			SWAP_ENDIANNESS_AVX512(t0, nt_buffer[0 * NT_NUM_KEYS / 16]);
+			SWAP_ENDIANNESS_AVX512(t1, nt_buffer[1 * NT_NUM_KEYS / 16]);
+
+			SWAP_ENDIANNESS_AVX512(t2, nt_buffer[2 * NT_NUM_KEYS / 16]);
+			SWAP_ENDIANNESS_AVX512(t3, nt_buffer[3 * NT_NUM_KEYS / 16]);
+
+			SWAP_ENDIANNESS_AVX512(t4, nt_buffer[4 * NT_NUM_KEYS / 16]);
+			SWAP_ENDIANNESS_AVX512(t5, nt_buffer[5 * NT_NUM_KEYS / 16]);
+
+			SWAP_ENDIANNESS_AVX512(t6, nt_buffer[6 * NT_NUM_KEYS / 16]);
+			len = nt_buffer[7 * NT_NUM_KEYS / 16];
+
+			nt_bufferu += 16;
+		}
+		else
+		{
+			AVX512_HIGH_TO_LOW(t0);
+			AVX512_HIGH_TO_LOW(t1);
+			AVX512_HIGH_TO_LOW(t2);
+			AVX512_HIGH_TO_LOW(t3);
+			AVX512_HIGH_TO_LOW(t4);
+			AVX512_HIGH_TO_LOW(t5);
+			AVX512_HIGH_TO_LOW(t6);
+			AVX512_HIGH_TO_LOW(len);
+		}
+
+		W[0 * SHA512_NUM] = AVX512_ADD64(AVX512_SL64(AVX512_LOW_TO_64(t0), 32), AVX512_LOW_TO_64(t1));
+		W[1 * SHA512_NUM] = AVX512_ADD64(AVX512_SL64(AVX512_LOW_TO_64(t2), 32), AVX512_LOW_TO_64(t3));
+		W[2 * SHA512_NUM] = AVX512_ADD64(AVX512_SL64(AVX512_LOW_TO_64(t4), 32), AVX512_LOW_TO_64(t5));
+		W[3 * SHA512_NUM] = AVX512_SL64(AVX512_LOW_TO_64(t6), 32);
+		W[15* SHA512_NUM] = AVX512_LOW_TO_64(len);
+		
+		/* Rounds */
+		A = K512(72); E = K512(73); F = K512(74);
+
+		H = AVX512_ADD64(K512(0), W[0 * SHA512_NUM]); D = AVX512_ADD64(K512(75), H);
+		G = AVX512_4ADD64(   R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(1), W[ 1 * SHA512_NUM]); C = AVX512_ADD64(K512(76),G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(K512(77), AVX512_OR(H, A))));
+		F = AVX512_4ADD64(   R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(2), W[ 2 * SHA512_NUM]); B = AVX512_ADD64(K512(77),F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		E = AVX512_4ADD64(   R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(3), W[ 3 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		D = AVX512_4ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(4)                    ); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		C = AVX512_4ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(5)                    ); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		B = AVX512_4ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(6)                    ); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		A = AVX512_4ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(7)                    ); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+		H = AVX512_4ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(8)                    ); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		G = AVX512_4ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(9)                    ); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		F = AVX512_4ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(10)                    ); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		E = AVX512_4ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(11)                    ); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		D = AVX512_4ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(12)                    ); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		C = AVX512_4ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(13)                    ); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		B = AVX512_4ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(14)                    ); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(15), W[15 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+
+		W[ 0 * SHA512_NUM] = AVX512_ADD64 (W[ 0 * SHA512_NUM], 					                         R0(W[1  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(16), W[ 0 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 1 * SHA512_NUM] = AVX512_3ADD64(W[ 1 * SHA512_NUM], R1(W[15 * SHA512_NUM])                    , R0(W[2  * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(17), W[ 1 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[ 2 * SHA512_NUM] = AVX512_3ADD64(W[ 2 * SHA512_NUM], R1(W[0  * SHA512_NUM])                    , R0(W[3  * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(18), W[ 2 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[ 3 * SHA512_NUM] = AVX512_ADD64 (W[ 3 * SHA512_NUM], R1(W[1  * SHA512_NUM])                                            ); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(19), W[ 3 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[ 4 * SHA512_NUM] =                                 R1(W[2  * SHA512_NUM])                                             ; D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(20), W[ 4 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[ 5 * SHA512_NUM] =                                 R1(W[3  * SHA512_NUM])                                             ; C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(21), W[ 5 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[ 6 * SHA512_NUM] = AVX512_ADD64(                     R1(W[4  * SHA512_NUM]), W[15 * SHA512_NUM]                        ); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(22), W[ 6 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[ 7 * SHA512_NUM] = AVX512_ADD64(                     R1(W[5  * SHA512_NUM]), W[0  * SHA512_NUM]                        ); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(23), W[ 7 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+		W[ 8 * SHA512_NUM] = AVX512_ADD64(                     R1(W[6  * SHA512_NUM]), W[1  * SHA512_NUM]                        ); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(24), W[ 8 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 9 * SHA512_NUM] = AVX512_ADD64(                     R1(W[7  * SHA512_NUM]), W[2  * SHA512_NUM]                        ); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(25), W[ 9 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[10 * SHA512_NUM] = AVX512_ADD64(                     R1(W[8  * SHA512_NUM]), W[3  * SHA512_NUM]                        ); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(26), W[10 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[11 * SHA512_NUM] = AVX512_ADD64(                     R1(W[9  * SHA512_NUM]), W[4  * SHA512_NUM]                        ); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(27), W[11 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[12 * SHA512_NUM] = AVX512_ADD64(                     R1(W[10 * SHA512_NUM]), W[5  * SHA512_NUM]                        ); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(28), W[12 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[13 * SHA512_NUM] = AVX512_ADD64(                     R1(W[11 * SHA512_NUM]), W[6  * SHA512_NUM]                        ); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(29), W[13 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[14 * SHA512_NUM] = AVX512_3ADD64(                    R1(W[12 * SHA512_NUM]), W[7  * SHA512_NUM], R0(W[15 * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(30), W[14 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[15 * SHA512_NUM] = AVX512_4ADD64(W[15 * SHA512_NUM], R1(W[13 * SHA512_NUM]), W[8  * SHA512_NUM], R0(W[0  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(31), W[15 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+																														 	  			
+		W[ 0 * SHA512_NUM] = AVX512_4ADD64(W[ 0 * SHA512_NUM], R1(W[14 * SHA512_NUM]), W[9  * SHA512_NUM], R0(W[1  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(32), W[ 0 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 1 * SHA512_NUM] = AVX512_4ADD64(W[ 1 * SHA512_NUM], R1(W[15 * SHA512_NUM]), W[10 * SHA512_NUM], R0(W[2  * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(33), W[ 1 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[ 2 * SHA512_NUM] = AVX512_4ADD64(W[ 2 * SHA512_NUM], R1(W[0  * SHA512_NUM]), W[11 * SHA512_NUM], R0(W[3  * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(34), W[ 2 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[ 3 * SHA512_NUM] = AVX512_4ADD64(W[ 3 * SHA512_NUM], R1(W[1  * SHA512_NUM]), W[12 * SHA512_NUM], R0(W[4  * SHA512_NUM])); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(35), W[ 3 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[ 4 * SHA512_NUM] = AVX512_4ADD64(W[ 4 * SHA512_NUM], R1(W[2  * SHA512_NUM]), W[13 * SHA512_NUM], R0(W[5  * SHA512_NUM])); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(36), W[ 4 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[ 5 * SHA512_NUM] = AVX512_4ADD64(W[ 5 * SHA512_NUM], R1(W[3  * SHA512_NUM]), W[14 * SHA512_NUM], R0(W[6  * SHA512_NUM])); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(37), W[ 5 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[ 6 * SHA512_NUM] = AVX512_4ADD64(W[ 6 * SHA512_NUM], R1(W[4  * SHA512_NUM]), W[15 * SHA512_NUM], R0(W[7  * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(38), W[ 6 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[ 7 * SHA512_NUM] = AVX512_4ADD64(W[ 7 * SHA512_NUM], R1(W[5  * SHA512_NUM]), W[0  * SHA512_NUM], R0(W[8  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(39), W[ 7 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+		W[ 8 * SHA512_NUM] = AVX512_4ADD64(W[ 8 * SHA512_NUM], R1(W[6  * SHA512_NUM]), W[1  * SHA512_NUM], R0(W[9  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(40), W[ 8 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 9 * SHA512_NUM] = AVX512_4ADD64(W[ 9 * SHA512_NUM], R1(W[7  * SHA512_NUM]), W[2  * SHA512_NUM], R0(W[10 * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(41), W[ 9 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[10 * SHA512_NUM] = AVX512_4ADD64(W[10 * SHA512_NUM], R1(W[8  * SHA512_NUM]), W[3  * SHA512_NUM], R0(W[11 * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(42), W[10 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[11 * SHA512_NUM] = AVX512_4ADD64(W[11 * SHA512_NUM], R1(W[9  * SHA512_NUM]), W[4  * SHA512_NUM], R0(W[12 * SHA512_NUM])); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(43), W[11 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[12 * SHA512_NUM] = AVX512_4ADD64(W[12 * SHA512_NUM], R1(W[10 * SHA512_NUM]), W[5  * SHA512_NUM], R0(W[13 * SHA512_NUM])); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(44), W[12 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[13 * SHA512_NUM] = AVX512_4ADD64(W[13 * SHA512_NUM], R1(W[11 * SHA512_NUM]), W[6  * SHA512_NUM], R0(W[14 * SHA512_NUM])); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(45), W[13 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[14 * SHA512_NUM] = AVX512_4ADD64(W[14 * SHA512_NUM], R1(W[12 * SHA512_NUM]), W[7  * SHA512_NUM], R0(W[15 * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(46), W[14 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[15 * SHA512_NUM] = AVX512_4ADD64(W[15 * SHA512_NUM], R1(W[13 * SHA512_NUM]), W[8  * SHA512_NUM], R0(W[0  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(47), W[15 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+			   										   							  														
+		W[ 0 * SHA512_NUM] = AVX512_4ADD64(W[ 0 * SHA512_NUM], R1(W[14 * SHA512_NUM]), W[9  * SHA512_NUM], R0(W[1  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(48), W[ 0 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 1 * SHA512_NUM] = AVX512_4ADD64(W[ 1 * SHA512_NUM], R1(W[15 * SHA512_NUM]), W[10 * SHA512_NUM], R0(W[2  * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(49), W[ 1 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[ 2 * SHA512_NUM] = AVX512_4ADD64(W[ 2 * SHA512_NUM], R1(W[0  * SHA512_NUM]), W[11 * SHA512_NUM], R0(W[3  * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(50), W[ 2 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[ 3 * SHA512_NUM] = AVX512_4ADD64(W[ 3 * SHA512_NUM], R1(W[1  * SHA512_NUM]), W[12 * SHA512_NUM], R0(W[4  * SHA512_NUM])); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(51), W[ 3 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[ 4 * SHA512_NUM] = AVX512_4ADD64(W[ 4 * SHA512_NUM], R1(W[2  * SHA512_NUM]), W[13 * SHA512_NUM], R0(W[5  * SHA512_NUM])); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(52), W[ 4 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[ 5 * SHA512_NUM] = AVX512_4ADD64(W[ 5 * SHA512_NUM], R1(W[3  * SHA512_NUM]), W[14 * SHA512_NUM], R0(W[6  * SHA512_NUM])); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(53), W[ 5 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[ 6 * SHA512_NUM] = AVX512_4ADD64(W[ 6 * SHA512_NUM], R1(W[4  * SHA512_NUM]), W[15 * SHA512_NUM], R0(W[7  * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(54), W[ 6 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[ 7 * SHA512_NUM] = AVX512_4ADD64(W[ 7 * SHA512_NUM], R1(W[5  * SHA512_NUM]), W[0  * SHA512_NUM], R0(W[8  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(55), W[ 7 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+		W[ 8 * SHA512_NUM] = AVX512_4ADD64(W[ 8 * SHA512_NUM], R1(W[6  * SHA512_NUM]), W[1  * SHA512_NUM], R0(W[9  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(56), W[ 8 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 9 * SHA512_NUM] = AVX512_4ADD64(W[ 9 * SHA512_NUM], R1(W[7  * SHA512_NUM]), W[2  * SHA512_NUM], R0(W[10 * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(57), W[ 9 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[10 * SHA512_NUM] = AVX512_4ADD64(W[10 * SHA512_NUM], R1(W[8  * SHA512_NUM]), W[3  * SHA512_NUM], R0(W[11 * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(58), W[10 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[11 * SHA512_NUM] = AVX512_4ADD64(W[11 * SHA512_NUM], R1(W[9  * SHA512_NUM]), W[4  * SHA512_NUM], R0(W[12 * SHA512_NUM])); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(59), W[11 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[12 * SHA512_NUM] = AVX512_4ADD64(W[12 * SHA512_NUM], R1(W[10 * SHA512_NUM]), W[5  * SHA512_NUM], R0(W[13 * SHA512_NUM])); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(60), W[12 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[13 * SHA512_NUM] = AVX512_4ADD64(W[13 * SHA512_NUM], R1(W[11 * SHA512_NUM]), W[6  * SHA512_NUM], R0(W[14 * SHA512_NUM])); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(61), W[13 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[14 * SHA512_NUM] = AVX512_4ADD64(W[14 * SHA512_NUM], R1(W[12 * SHA512_NUM]), W[7  * SHA512_NUM], R0(W[15 * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(62), W[14 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[15 * SHA512_NUM] = AVX512_4ADD64(W[15 * SHA512_NUM], R1(W[13 * SHA512_NUM]), W[8  * SHA512_NUM], R0(W[0  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(63), W[15 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+														   					 		   													
+		W[ 0 * SHA512_NUM] = AVX512_4ADD64(W[ 0 * SHA512_NUM], R1(W[14 * SHA512_NUM]), W[9  * SHA512_NUM], R0(W[1  * SHA512_NUM])); H = AVX512_5ADD64(H, R_E(E), AVX512_XOR(G, AVX512_AND(E, AVX512_XOR(F, G))), K512(64), W[ 0 * SHA512_NUM]); D = AVX512_ADD64(D, H); H = AVX512_3ADD64(H, R_A(A), AVX512_OR(AVX512_AND(A, B), AVX512_AND(C, AVX512_OR(A, B))));
+		W[ 1 * SHA512_NUM] = AVX512_4ADD64(W[ 1 * SHA512_NUM], R1(W[15 * SHA512_NUM]), W[10 * SHA512_NUM], R0(W[2  * SHA512_NUM])); G = AVX512_5ADD64(G, R_E(D), AVX512_XOR(F, AVX512_AND(D, AVX512_XOR(E, F))), K512(65), W[ 1 * SHA512_NUM]); C = AVX512_ADD64(C, G); G = AVX512_3ADD64(G, R_A(H), AVX512_OR(AVX512_AND(H, A), AVX512_AND(B, AVX512_OR(H, A))));
+		W[ 2 * SHA512_NUM] = AVX512_4ADD64(W[ 2 * SHA512_NUM], R1(W[0  * SHA512_NUM]), W[11 * SHA512_NUM], R0(W[3  * SHA512_NUM])); F = AVX512_5ADD64(F, R_E(C), AVX512_XOR(E, AVX512_AND(C, AVX512_XOR(D, E))), K512(66), W[ 2 * SHA512_NUM]); B = AVX512_ADD64(B, F); F = AVX512_3ADD64(F, R_A(G), AVX512_OR(AVX512_AND(G, H), AVX512_AND(A, AVX512_OR(G, H))));
+		W[ 3 * SHA512_NUM] = AVX512_4ADD64(W[ 3 * SHA512_NUM], R1(W[1  * SHA512_NUM]), W[12 * SHA512_NUM], R0(W[4  * SHA512_NUM])); E = AVX512_5ADD64(E, R_E(B), AVX512_XOR(D, AVX512_AND(B, AVX512_XOR(C, D))), K512(67), W[ 3 * SHA512_NUM]); A = AVX512_ADD64(A, E); E = AVX512_3ADD64(E, R_A(F), AVX512_OR(AVX512_AND(F, G), AVX512_AND(H, AVX512_OR(F, G))));
+		W[ 4 * SHA512_NUM] = AVX512_4ADD64(W[ 4 * SHA512_NUM], R1(W[2  * SHA512_NUM]), W[13 * SHA512_NUM], R0(W[5  * SHA512_NUM])); D = AVX512_5ADD64(D, R_E(A), AVX512_XOR(C, AVX512_AND(A, AVX512_XOR(B, C))), K512(68), W[ 4 * SHA512_NUM]); H = AVX512_ADD64(H, D); D = AVX512_3ADD64(D, R_A(E), AVX512_OR(AVX512_AND(E, F), AVX512_AND(G, AVX512_OR(E, F))));
+		W[ 5 * SHA512_NUM] = AVX512_4ADD64(W[ 5 * SHA512_NUM], R1(W[3  * SHA512_NUM]), W[14 * SHA512_NUM], R0(W[6  * SHA512_NUM])); C = AVX512_5ADD64(C, R_E(H), AVX512_XOR(B, AVX512_AND(H, AVX512_XOR(A, B))), K512(69), W[ 5 * SHA512_NUM]); G = AVX512_ADD64(G, C); C = AVX512_3ADD64(C, R_A(D), AVX512_OR(AVX512_AND(D, E), AVX512_AND(F, AVX512_OR(D, E))));
+		W[ 6 * SHA512_NUM] = AVX512_4ADD64(W[ 6 * SHA512_NUM], R1(W[4  * SHA512_NUM]), W[15 * SHA512_NUM], R0(W[7  * SHA512_NUM])); B = AVX512_5ADD64(B, R_E(G), AVX512_XOR(A, AVX512_AND(G, AVX512_XOR(H, A))), K512(70), W[ 6 * SHA512_NUM]); F = AVX512_ADD64(F, B); B = AVX512_3ADD64(B, R_A(C), AVX512_OR(AVX512_AND(C, D), AVX512_AND(E, AVX512_OR(C, D))));
+		W[ 7 * SHA512_NUM] = AVX512_4ADD64(W[ 7 * SHA512_NUM], R1(W[5  * SHA512_NUM]), W[0  * SHA512_NUM], R0(W[8  * SHA512_NUM])); A = AVX512_5ADD64(A, R_E(F), AVX512_XOR(H, AVX512_AND(F, AVX512_XOR(G, H))), K512(71), W[ 7 * SHA512_NUM]); E = AVX512_ADD64(E, A); A = AVX512_3ADD64(A, R_A(B), AVX512_OR(AVX512_AND(B, C), AVX512_AND(D, AVX512_OR(B, C))));
+		W[ 8 * SHA512_NUM] = AVX512_4ADD64(W[ 8 * SHA512_NUM], R1(W[6  * SHA512_NUM]), W[1  * SHA512_NUM], R0(W[9  * SHA512_NUM]));
+		W[ 9 * SHA512_NUM] = AVX512_4ADD64(W[ 9 * SHA512_NUM], R1(W[7  * SHA512_NUM]), W[2  * SHA512_NUM], R0(W[10 * SHA512_NUM]));
+		W[2 * SHA512_NUM] = AVX512_4ADD64(W[11 * SHA512_NUM], R1(W[9 * SHA512_NUM]), W[4 * SHA512_NUM], R0(W[12 * SHA512_NUM]));
+		W[1 * SHA512_NUM] = AVX512_4ADD64(W[13 * SHA512_NUM], R1(W[2 * SHA512_NUM]), W[6 * SHA512_NUM], R0(W[14 * SHA512_NUM]));
+		W[0 * SHA512_NUM] = AVX512_4ADD64(W[15 * SHA512_NUM], R1(W[1 * SHA512_NUM]), W[8 * SHA512_NUM], R0(W[0  * SHA512_NUM])); A = AVX512_ADD64(A, W[0 * SHA512_NUM]); 
+
+		W[4  * SHA512_NUM] = A;
+		W[6  * SHA512_NUM] = B;
+		W[16 * SHA512_NUM] = C;
+		W[17 * SHA512_NUM] = D;
+		W[18 * SHA512_NUM] = E;
+		W[19 * SHA512_NUM] = F;
+		W[20 * SHA512_NUM] = G;
+		W[21 * SHA512_NUM] = H;
+	}
+}
+PRIVATE void crypt_utf8_coalesc_protocol_avx512(CryptParam* param)
+{
+	crypt_utf8_coalesc_protocol_body(param, (crypt_kernel_asm_func*)crypt_kernel_avx512);
+}
+#endif
+
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // OpenCL Implementations
 /////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
@@ -2695,12 +2863,12 @@ Format raw_sha512_format = {
 	add_hash_from_line,
 	NULL,
 #ifdef _M_X64
-	{{CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
+	{{CPU_CAP_AVX512, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx512}, {CPU_CAP_AVX2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx2}, {CPU_CAP_AVX, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_avx}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}},
 #else
 #ifdef HS_ARM
-	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
+	{{CPU_CAP_NEON, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_neon}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code}},
 #else
-	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code } },
+	{{CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_SSE2, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_sse2}, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }, {CPU_CAP_C_CODE, PROTOCOL_UTF8_COALESC_LE, crypt_utf8_coalesc_protocol_c_code }},
 #endif
 #endif
 #ifdef HS_OPENCL_SUPPORT
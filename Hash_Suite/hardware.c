@@ -35,17 +35,21 @@ PUBLIC OtherSystemInfo current_system_info;
 #define PROC_CENTAUR            "Centaur CPU"
 #define PROC_UNKNOWN            "Unknown CPU"
 
-PRIVATE void cpuID(uint32_t i, uint32_t regs[4])
+PRIVATE void cpuID_ex(uint32_t i, uint32_t sub_leaf, uint32_t regs[4])
 {
 	#ifdef _WIN32
-	  __cpuid((int*)regs, (int)i);
+	  __cpuidex((int*)regs, (int)i, (int)sub_leaf);
 	#else
 	  asm volatile
 		("cpuid" : "=a" (regs[0]), "=b" (regs[1]), "=c" (regs[2]), "=d" (regs[3])
-		 : "a" (i), "c" (0));
-	  // ECX is set to zero for CPUID function 4
+		 : "a" (i), "c" (sub_leaf));
 	#endif
 }
+PRIVATE void cpuID(uint32_t i, uint32_t regs[4])
+{
+	// ECX is set to zero for CPUID function 4
+	cpuID_ex(i, 0, regs);
+}
 
 /***
 * Checks if OS Supports the capability or not
@@ -56,6 +60,17 @@ PRIVATE void cpuID(uint32_t i, uint32_t regs[4])
 *   Returns 1 if OS support exist and 0 when OS doesn't support it.
 ****************************************************************/
 #ifdef _M_X64
+// Read XFEATURE_ENABLED_MASK register. Only valid when CPUID reports OSXSAVE
+PRIVATE int64_t read_xcr0()
+{
+	#ifdef _WIN32
+	  return _xgetbv(0);
+	#else
+	  uint32_t eax, edx;
+	  asm volatile ("xgetbv" : "=a" (eax), "=d" (edx) : "c" (0));
+	  return (int64_t)(((uint64_t)edx << 32) | eax);
+	#endif
+}
 PRIVATE int os_support(int feature)
 {
 	switch (feature)
@@ -64,9 +79,14 @@ PRIVATE int os_support(int feature)
 		return TRUE;
 	case CPU_CAP_AVX:
 		{
-			int64_t val = _xgetbv(0);       // read XFEATURE_ENABLED_MASK register 
+			int64_t val = read_xcr0();
 			return (val & 6) == 6;          // check OS has enabled both XMM and YMM support. 
 		}
+	case CPU_CAP_AVX512:
+		{
+			int64_t val = read_xcr0();
+			return (val & 0xE6) == 0xE6;    // XMM, YMM, opmask and the upper ZMM registers
+		}
 	}
 
 	return 0;
@@ -101,7 +121,7 @@ PRIVATE int os_support(int feature)
 #endif
 #endif
 
-#ifdef HS_X86
+#if defined(HS_X86) && defined(_WIN32)
 typedef BOOL (WINAPI *PGPI)(DWORD, DWORD, DWORD, DWORD, PDWORD);
 typedef VOID WINAPI RtlGetNtVersionNumbers(LPDWORD pMajor, LPDWORD pMinor, LPDWORD pBuild);
 PRIVATE void get_os_display_string()
@@ -397,6 +417,92 @@ PRIVATE void detect_logical_processor_info()
     
     free(buffer);
 }
+#elif defined(HS_X86)
+#include <sys/utsname.h>
+PRIVATE void get_os_display_string()
+{
+	struct utsname os_name;
+
+	current_system_info.granularity = (unsigned long)sysconf(_SC_PAGESIZE);
+	current_system_info.is_64bits = TRUE;
+
+	if (uname(&os_name) == 0)
+	{
+		snprintf(current_system_info.os, sizeof(current_system_info.os), "%s %s", os_name.sysname, os_name.release);
+		sscanf(os_name.release, "%lu.%lu", &current_system_info.major_version, &current_system_info.minor_version);
+	}
+}
+// Cores are the different pairs (physical id, core id) in /proc/cpuinfo
+#define MAX_CORES_IDS	1024
+PRIVATE void detect_logical_processor_info()
+{
+	uint32_t cores_ids[MAX_CORES_IDS];
+	uint32_t physical_id = 0, core_id;
+	char line[256];
+
+	current_cpu.logical_processors = (uint32_t)sysconf(_SC_NPROCESSORS_ONLN);
+	current_cpu.cores = 0;
+
+	FILE* cpuinfo = fopen("/proc/cpuinfo", "r");
+	if (cpuinfo)
+	{
+		while (fgets(line, sizeof(line), cpuinfo))
+			if (sscanf(line, "physical id : %u", &physical_id) == 1)
+				continue;
+			else if (sscanf(line, "core id : %u", &core_id) == 1)
+			{
+				uint32_t id = (physical_id << 16) | core_id;
+				uint32_t i = 0;
+				for (; i < current_cpu.cores && cores_ids[i] != id; i++);
+
+				if (i == current_cpu.cores && current_cpu.cores < MAX_CORES_IDS)
+					cores_ids[current_cpu.cores++] = id;
+			}
+
+		fclose(cpuinfo);
+	}
+
+	// Virtual machines may not give the topology
+	if (!current_cpu.cores || current_cpu.cores > current_cpu.logical_processors)
+		current_cpu.cores = current_cpu.logical_processors;
+}
+#endif
+
+#ifndef _WIN32
+// Huge pages: explicit hugetlbfs reserved pages or transparent huge pages
+PRIVATE void detect_large_page_support()
+{
+	char line[128];
+	unsigned long long value;
+
+	current_system_info.large_page_size = 0;
+	current_system_info.is_large_page_enable = 0;
+
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo)
+	{
+		while (fgets(line, sizeof(line), meminfo))
+			if (sscanf(line, "Hugepagesize: %llu kB", &value) == 1)
+				current_system_info.large_page_size = (size_t)value * 1024;
+			else if (sscanf(line, "HugePages_Free: %llu", &value) == 1 && value)
+				current_system_info.is_large_page_enable |= LARGE_PAGE_HUGETLB;
+
+		fclose(meminfo);
+	}
+
+	FILE* thp = fopen("/sys/kernel/mm/transparent_hugepage/enabled", "r");
+	if (thp)
+	{
+		// Format: "always [madvise] never"
+		if (fgets(line, sizeof(line), thp) && !strstr(line, "[never]"))
+			current_system_info.is_large_page_enable |= LARGE_PAGE_THP;
+
+		fclose(thp);
+	}
+
+	if (!current_system_info.large_page_size)
+		current_system_info.is_large_page_enable = 0;
+}
 #endif
 
 #ifdef __ANDROID__
@@ -416,6 +522,8 @@ PUBLIC void detect_hardware()
 #endif
 
 	current_cpu.cores = current_cpu.logical_processors = android_getCpuCount();
+
+	detect_large_page_support();
 }
 #else
 
@@ -436,6 +544,7 @@ PUBLIC void detect_hardware()
 	current_cpu.cores = current_cpu.logical_processors = si.dwNumberOfProcessors;
 }
 #else
+#ifdef _WIN32
 typedef int(*GETLARGEPAGEMINIMUM)(void);
 int enable_large_page_support()
 {
@@ -457,6 +566,148 @@ int enable_large_page_support()
 
 	return FALSE;
 }
+#endif
+#include "arch_simd.h"
+#ifdef _M_X64
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Some CPUs lower the clock when executing AVX512 instructions.
+// Run the same MD4-like step with AVX2 and AVX512 for a few milliseconds
+// and only use AVX512 if it process more keys. Both use the same 6
+// instructions by step: only the width of the vector change.
+// Cost is bounded to 2*CALIBRATION_MS (plus the timer resolution).
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define CALIBRATION_MS		16
+PRIVATE volatile uint32_t calibration_result;
+
+PRIVATE HS_TARGET("avx2") int64_t calibrate_avx2()
+{
+	__m256i state[4][4];
+	int64_t num_steps = 0;
+
+	for (int j = 0; j < 4; j++)
+		for (int k = 0; k < 4; k++)
+			state[j][k] = _mm256_set1_epi32(j * 4 + k);
+
+	int64_t start = get_milliseconds();
+	while ((get_milliseconds() - start) < CALIBRATION_MS)
+	{
+		for (int i = 0; i < 256; i++)
+			for (int j = 0; j < 4; j++)
+			{
+				__m256i a = _mm256_add_epi32(state[j][0], _mm256_xor_si256(_mm256_xor_si256(state[j][1], state[j][2]), state[j][3]));
+				state[j][0] = state[j][1];
+				state[j][1] = state[j][2];
+				state[j][2] = state[j][3];
+				state[j][3] = _mm256_or_si256(_mm256_slli_epi32(a, 3), _mm256_srli_epi32(a, 29));
+			}
+		num_steps++;
+	}
+	calibration_result = _mm256_extract_epi32(state[0][3], 0) ^ _mm256_extract_epi32(state[3][3], 7);
+
+	// Keys processed
+	return num_steps * 8;
+}
+PRIVATE HS_TARGET("avx512f") int64_t calibrate_avx512()
+{
+	__m512i state[4][4];
+	int64_t num_steps = 0;
+
+	for (int j = 0; j < 4; j++)
+		for (int k = 0; k < 4; k++)
+			state[j][k] = _mm512_set1_epi32(j * 4 + k);
+
+	int64_t start = get_milliseconds();
+	while ((get_milliseconds() - start) < CALIBRATION_MS)
+	{
+		for (int i = 0; i < 256; i++)
+			for (int j = 0; j < 4; j++)
+			{
+				__m512i a = _mm512_add_epi32(state[j][0], _mm512_xor_si512(_mm512_xor_si512(state[j][1], state[j][2]), state[j][3]));
+				state[j][0] = state[j][1];
+				state[j][1] = state[j][2];
+				state[j][2] = state[j][3];
+				state[j][3] = _mm512_or_si512(_mm512_slli_epi32(a, 3), _mm512_srli_epi32(a, 29));
+			}
+		num_steps++;
+	}
+	calibration_result = _mm512_cvtsi512_si32(state[0][3]) ^ _mm512_cvtsi512_si32(state[3][3]);
+
+	// Keys processed
+	return num_steps * 16;
+}
+PRIVATE int is_avx512_faster()
+{
+	// AVX512 first: the clock transition is then included in the measure
+	int64_t avx512_keys = calibrate_avx512();
+	int64_t avx2_keys = calibrate_avx2();
+
+	return avx512_keys > avx2_keys;
+}
+#endif
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Some CPUs execute the SHA instructions slowly: only use them when faster than the SIMD code.
+// Run after the AVX2 detection.
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#define SHA_NI_CALIBRATION_MS	16
+// All kernels run the same PBKDF2 loop: from iteration 1 to SHA_NI_CALIBRATION_ITERATIONS-1
+#define SHA_NI_CALIBRATION_ITERATIONS	64
+// Implemented in format_DCC2.c
+void pbkdf2_sha1_sse2(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
+void pbkdf2_sha1_sha_ni(const __m128i* ipad_state, const __m128i* opad_state, __m128i* sha1_hash, __m128i* crypt_result, __m128i* W, uint32_t num_words, uint32_t num_iterations);
+void sha1_process_sha1_avx2(const void* state, void* sha1_hash, void* W);
+#ifdef _M_X64
+// Same loop as pbkdf2_sha1_sse2 for the 16 keys of sha1_process_sha1_avx2 (two groups of 8)
+PRIVATE HS_TARGET("avx2") void pbkdf2_sha1_avx2(const __m256i* ipad_state, const __m256i* opad_state, __m256i* sha1_hash, __m256i* crypt_result, __m256i* W, uint32_t num_iterations)
+{
+	for (uint32_t k = 1; k < num_iterations; k++)
+	{
+		sha1_process_sha1_avx2(ipad_state, sha1_hash, W);
+		sha1_process_sha1_avx2(opad_state, sha1_hash, W);
+
+		for (uint32_t i = 0; i < 10; i++)
+			crypt_result[i] = AVX2_XOR(crypt_result[i], sha1_hash[i]);
+	}
+}
+#endif
+PUBLIC int is_sha_ni_faster()
+{
+	// Sized for AVX2: states of 10 vectors and 32 vectors of W. SSE2 and SHA-NI use the start of each array
+	__m128i* buffer = (__m128i*)_aligned_malloc(sizeof(__m128i) * 2 * (10 + 10 + 10 + 10 + 32), 32);
+	memset(buffer, 0, sizeof(__m128i) * 2 * (10 + 10 + 10 + 10 + 32));
+
+	__m128i* ipad_state   = buffer;
+	__m128i* opad_state   = ipad_state + 2 * 10;
+	__m128i* sha1_hash    = opad_state + 2 * 10;
+	__m128i* crypt_result = sha1_hash + 2 * 10;
+	__m128i* W            = crypt_result + 2 * 10;
+	int64_t sha_ni_keys = 0, simd_keys = 0;
+
+	int64_t start = get_milliseconds();
+	while ((get_milliseconds() - start) < SHA_NI_CALIBRATION_MS)
+	{
+		pbkdf2_sha1_sha_ni(ipad_state, opad_state, sha1_hash, crypt_result, W, 5, SHA_NI_CALIBRATION_ITERATIONS);
+		sha_ni_keys += 4;
+	}
+
+	start = get_milliseconds();
+	while ((get_milliseconds() - start) < SHA_NI_CALIBRATION_MS)
+	{
+#ifdef _M_X64
+		if (current_cpu.capabilites[CPU_CAP_AVX2])
+		{
+			pbkdf2_sha1_avx2((__m256i*)ipad_state, (__m256i*)opad_state, (__m256i*)sha1_hash, (__m256i*)crypt_result, (__m256i*)W, SHA_NI_CALIBRATION_ITERATIONS);
+			simd_keys += 16;
+			continue;
+		}
+#endif
+		pbkdf2_sha1_sse2(ipad_state, opad_state, sha1_hash, crypt_result, W, 5, SHA_NI_CALIBRATION_ITERATIONS);
+		simd_keys += 4;
+	}
+
+	_aligned_free(buffer);
+	return sha_ni_keys > simd_keys;
+}
+PUBLIC int has_sha_ni = FALSE;
 PUBLIC void detect_hardware()
 {
 	int CPUInfo[4] = {-1};
@@ -468,6 +719,7 @@ PUBLIC void detect_hardware()
 
 	// OS string
 	get_os_display_string();
+#ifdef _WIN32
 	GetComputerName(current_system_info.machine_name, &nIds);
 
 	// Large page support
@@ -482,6 +734,10 @@ PUBLIC void detect_hardware()
 		FreeLibrary(hDll);
 	}
 	current_system_info.is_large_page_enable = current_system_info.large_page_size && enable_large_page_support();
+#else
+	gethostname(current_system_info.machine_name, sizeof(current_system_info.machine_name) - 1);
+	detect_large_page_support();
+#endif
 	
 	detect_logical_processor_info();
 
@@ -501,11 +757,16 @@ PUBLIC void detect_hardware()
 		//current_cpu.capabilites[CPU_CAP_MMX]			= ((CPUInfo[3] >> 23) & 1) && os_support(CPU_CAP_MMX);
 		//current_cpu.capabilites[CPU_CAP_SSE]			= ((CPUInfo[3] >> 25) & 1) && os_support(CPU_CAP_SSE);
 		current_cpu.capabilites[CPU_CAP_SSE2]			= ((CPUInfo[3] >> 26) & 1) && os_support(CPU_CAP_SSE2);
-		current_cpu.capabilites[CPU_CAP_AVX]			= ((CPUInfo[2] >> 28) & 1) && os_support(CPU_CAP_AVX);
+		// Use the XMM registers as SSE2
+		current_cpu.capabilites[CPU_CAP_SSSE3]			= ((CPUInfo[2] >>  9) & 1) && current_cpu.capabilites[CPU_CAP_SSE2];
+		current_cpu.capabilites[CPU_CAP_SSE41]			= ((CPUInfo[2] >> 19) & 1) && current_cpu.capabilites[CPU_CAP_SSE2];
+		// OSXSAVE: the OS saves the AVX registers and XGETBV is available
+		current_cpu.capabilites[CPU_CAP_AVX]			= ((CPUInfo[2] >> 28) & 1) && ((CPUInfo[2] >> 27) & 1) && os_support(CPU_CAP_AVX);
 
 		//current_cpu.model  = (CPUInfo[0] >> 4) & 0xF;
 		//current_cpu.family = (CPUInfo[0] >> 8) & 0xF;
 	}
+#ifdef _WIN32
 	// At least one processor exist: needed for wine support
 	if (current_cpu.logical_processors <= 0 || current_cpu.cores <= 0)
 	{
@@ -513,6 +774,7 @@ PUBLIC void detect_hardware()
 		GetNativeSystemInfo(&si);// Need XP
 		current_cpu.logical_processors = current_cpu.cores = si.dwNumberOfProcessors;
 	}
+#endif
 
 	current_cpu.capabilites[CPU_CAP_HTT] = current_cpu.cores < current_cpu.logical_processors;
 	// Modern Cache information
@@ -520,7 +782,7 @@ PUBLIC void detect_hardware()
 	{
 		for (int i = 0; ; i++)
 		{
-			__cpuidex(CPUInfo, 4, i);
+			cpuID_ex(4, i, CPUInfo);
 			if(!(CPUInfo[0] & 0xF0)) break;
 
 			int cache_level = (CPUInfo[0] & 0xe0) >> 5;
@@ -646,9 +908,13 @@ PUBLIC void detect_hardware()
 	}
 	if(nIds >= 7)
 	{
-		__cpuidex(CPUInfo, 7, 0);
+		cpuID_ex(7, 0, CPUInfo);
 		current_cpu.capabilites[CPU_CAP_AVX2] = ((CPUInfo[1] >> 5) & 1) && current_cpu.capabilites[CPU_CAP_AVX];
 		current_cpu.capabilites[CPU_CAP_BMI ] =  (CPUInfo[1] >> 8) & 1;
+		current_cpu.capabilites[CPU_CAP_AVX512] = ((CPUInfo[1] >> 16) & 1) && current_cpu.capabilites[CPU_CAP_AVX2] && os_support(CPU_CAP_AVX512);
+		// CPU_CAP_SHA, CPU_CAP_SHA256 and CPU_CAP_AVX2_GATHER are set by calibrate_hardware()
+		// The SHA-NI kernels also use SSSE3 shuffles and SSE4.1 blends/extracts
+		has_sha_ni = ((CPUInfo[1] >> 29) & 1) && current_cpu.capabilites[CPU_CAP_SSE2] && current_cpu.capabilites[CPU_CAP_SSSE3] && current_cpu.capabilites[CPU_CAP_SSE41];
 	}
 
 	// Extended
@@ -783,6 +1049,212 @@ PUBLIC void detect_hardware()
 	remove_str(current_cpu.brand, "(TM)");
 	remove_str(current_cpu.brand, "(tm)");
 }
+// Timing probes: about 100ms, so run them only once and only when an attack selects its CPU implementation.
+// Before this call CPU_CAP_SHA, CPU_CAP_SHA256 and CPU_CAP_AVX2_GATHER are FALSE and CPU_CAP_AVX512 is only the CPUID flag.
+PRIVATE int hardware_calibrated = FALSE;
+PUBLIC void calibrate_hardware()
+{
+	if (hardware_calibrated)
+		return;
+	hardware_calibrated = TRUE;
+
+	if (has_sha_ni)
+		current_cpu.capabilites[CPU_CAP_SHA] = is_sha_ni_faster();
+#ifdef _M_X64
+	if (current_cpu.capabilites[CPU_CAP_AVX512])
+		current_cpu.capabilites[CPU_CAP_AVX512] = is_avx512_faster();
+	if (current_cpu.capabilites[CPU_CAP_AVX2])
+		current_cpu.capabilites[CPU_CAP_AVX2_GATHER] = is_avx2_gather_faster();
+#endif
+	// Against the SIMD code selected above
+	if (has_sha_ni)
+		current_cpu.capabilites[CPU_CAP_SHA256] = is_sha256_ni_faster();
+}
+#endif
 #endif
+
+////////////////////////////////////////////////////////////////////////////////////
+// Memory available
+////////////////////////////////////////////////////////////////////////////////////
+#ifdef _WIN32
+#include <psapi.h>
+PRIVATE uint64_t get_process_memory_used()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.WorkingSetSize;
+
+	return 0;
+}
+#ifdef HS_TESTING
+PUBLIC uint64_t get_process_peak_memory_used()
+{
+	PROCESS_MEMORY_COUNTERS counters;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+		return counters.PeakWorkingSetSize;
+
+	return 0;
+}
 #endif
+#else
+#include <unistd.h>
+// Read the number at the beginning of a file. Fail with "max" (cgroup v2 no limit)
+PRIVATE int read_number_from_file(const char* path, uint64_t* value)
+{
+	int result = FALSE;
+	FILE* file = fopen(path, "r");
 
+	if (file)
+	{
+		unsigned long long number;
+		if (fscanf(file, "%llu", &number) == 1)
+		{
+			*value = number;
+			result = TRUE;
+		}
+		fclose(file);
+	}
+
+	return result;
+}
+// Memory left to one cgroup directory. UINT64_MAX if no limit found
+PRIVATE uint64_t get_cgroup_dir_memory_available(const char* dir, int is_v2)
+{
+	uint64_t limit, usage;
+	char path[700];
+
+	sprintf(path, is_v2 ? "%s/memory.max" : "%s/memory.limit_in_bytes", dir);
+	if (!read_number_from_file(path, &limit)) return UINT64_MAX;
+	sprintf(path, is_v2 ? "%s/memory.current" : "%s/memory.usage_in_bytes", dir);
+	if (!read_number_from_file(path, &usage)) return UINT64_MAX;
+
+	return limit > usage ? limit - usage : 0;
+}
+// Memory left to the process cgroup (v1 or v2). A parent limit also apply
+// to us, so check all cgroups up to the root of the hierarchy
+PRIVATE uint64_t get_cgroup_memory_available()
+{
+	uint64_t result = UINT64_MAX;
+	char line[512], dir[640];
+	FILE* cgroup_file = fopen("/proc/self/cgroup", "r");
+
+	if (cgroup_file)
+	{
+		while (fgets(line, sizeof(line), cgroup_file))
+		{
+			int is_v2 = !strncmp(line, "0::", 3);
+			char* cgroup_path = strrchr(line, ':');
+			if (!cgroup_path || (!is_v2 && !strstr(line, ":memory:"))) continue;
+			cgroup_path++;
+			cgroup_path[strcspn(cgroup_path, "\r\n")] = 0;
+
+			const char* base = is_v2 ? "/sys/fs/cgroup" : "/sys/fs/cgroup/memory";
+			size_t base_len = strlen(base);
+			sprintf(dir, "%s%s", base, cgroup_path);
+
+			// From our cgroup to the root
+			for (;;)
+			{
+				size_t dir_len = strlen(dir);
+				while (dir_len > base_len && dir[dir_len - 1] == '/')
+					dir[--dir_len] = 0;
+
+				uint64_t dir_available = get_cgroup_dir_memory_available(dir, is_v2);
+				result = __min(result, dir_available);
+
+				char* last_slash = strrchr(dir, '/');
+				if (dir_len <= base_len || !last_slash || (size_t)(last_slash - dir) < base_len)
+					break;
+				*last_slash = 0;
+			}
+		}
+		fclose(cgroup_file);
+	}
+
+	return result;
+}
+PRIVATE uint64_t get_process_memory_used()
+{
+	uint64_t result = 0;
+	FILE* statm = fopen("/proc/self/statm", "r");
+
+	if (statm)
+	{
+		unsigned long long size, resident;
+		if (fscanf(statm, "%llu %llu", &size, &resident) == 2)
+			result = resident * sysconf(_SC_PAGESIZE);
+		fclose(statm);
+	}
+
+	return result;
+}
+#ifdef HS_TESTING
+PUBLIC uint64_t get_process_peak_memory_used()
+{
+	uint64_t result = 0;
+	FILE* status = fopen("/proc/self/status", "r");
+
+	if (status)
+	{
+		char line[128];
+		unsigned long long kb;
+		while (fgets(line, sizeof(line), status))
+			if (sscanf(line, "VmHWM: %llu kB", &kb) == 1)
+				result = kb * 1024;
+		fclose(status);
+	}
+
+	return result;
+}
+#endif
+#endif
+// Bytes we can still allocate: free RAM, container limits and user budget
+PUBLIC uint64_t get_available_memory()
+{
+	uint64_t result = UINT64_MAX;
+
+#ifdef _WIN32
+	MEMORYSTATUSEX memx;
+	memx.dwLength = sizeof(memx);
+	if (GlobalMemoryStatusEx(&memx))
+		result = memx.ullAvailPhys;
+#else
+	FILE* meminfo = fopen("/proc/meminfo", "r");
+	if (meminfo)
+	{
+		char line[128];
+		unsigned long long kb;
+		uint64_t mem_free = 0, cached = 0;
+		int has_mem_available = FALSE;
+
+		while (fgets(line, sizeof(line), meminfo))
+			if (sscanf(line, "MemAvailable: %llu kB", &kb) == 1)
+			{
+				result = kb * 1024;
+				has_mem_available = TRUE;
+			}
+			else if (sscanf(line, "MemFree: %llu kB", &kb) == 1)
+				mem_free = kb * 1024;
+			else if (sscanf(line, "Cached: %llu kB", &kb) == 1)
+				cached = kb * 1024;
+
+		fclose(meminfo);
+		// Kernels before 3.14 don't have MemAvailable
+		if (!has_mem_available && mem_free)
+			result = mem_free + cached;
+	}
+
+	uint64_t cgroup_available = get_cgroup_memory_available();
+	result = __min(result, cgroup_available);
+#endif
+
+	// User memory budget
+	uint64_t budget = ((uint64_t)(uint32_t)get_setting(ID_MEMORY_BUDGET_MB, 0)) << 20;
+	if (budget)
+	{
+		uint64_t used = get_process_memory_used();
+		result = __min(result, budget > used ? budget - used : 0);
+	}
+
+	return result;
+}
@@ -1591,7 +1591,8 @@ PUBLIC void hash_sha256crypt(const char* cleartext, char* hash)
 	crypt_sha256_salt salt;
 	salt.saltlen = 16;// Faster testing
 	//salt.saltlen = 1 + rand() % 16;// [1,16]
-	salt.rounds = 5000;// TODO: Manage this
+	// Mostly default rounds, but test others too. Not a multiple of 42 to test the last partial cycle
+	salt.rounds = (rand() & 3) ? 5000 : (1000 + rand() % 9000);
 	for (uint8_t i = 0; i < salt.saltlen; i++)
 	{
 		uint8_t salt_char = 1 + rand() % 255;
@@ -1776,7 +1777,8 @@ PUBLIC void hash_sha512crypt(const char* cleartext, char* hash)
 	crypt_sha256_salt salt;
 	salt.saltlen = 16;// Faster testing
 	//salt.saltlen = 1 + rand() % 16;// [1,16]
-	salt.rounds = 5000;// TODO: Manage this
+	// Mostly default rounds, but test others too. Not a multiple of 42 to test the last partial cycle
+	salt.rounds = (rand() & 3) ? 5000 : (1000 + rand() % 9000);
 	for (uint8_t i = 0; i < salt.saltlen; i++)
 	{
 		uint8_t salt_char = 1 + rand() % 255;
@@ -2270,7 +2272,8 @@ PUBLIC void hash_bcrypt(const char* cleartext, unsigned char* hash)
 {
 	uint32_t crypt_result[6];
 	BF_salt salt;
-	int exponent = 5;
+	// Mostly the minimum cost, but test others too without slowing the tests much
+	int exponent = (rand() & 7) ? 5 : ((rand() & 1) ? 6 : 7);
 
 	salt.rounds = 1 << exponent;
 	salt.sign_extension_bug = ((rand() & 3) == 3);
@@ -2279,7 +2282,8 @@ PUBLIC void hash_bcrypt(const char* cleartext, unsigned char* hash)
 
 	bf_key(cleartext, &salt, crypt_result);
 
-	sprintf((char*)hash, "$2%s$%02i$", salt.sign_extension_bug ? "x" : "y", exponent);
+	// $2a$, $2b$ and $2y$ only differ for keys longer than 255 characters: same hash here
+	sprintf((char*)hash, "$2%c$%02i$", salt.sign_extension_bug ? 'x' : "aby"[rand() % 3], exponent);
 	swap_endianness_array(salt.salt, 6);
 	BF_encode(hash + 7, salt.salt, 16);
 	hash[7 + 22 - 1] = BF_itoa64[(int)BF_atoi64[(int)hash[7 + 22 - 1] - 0x20] & 0x30];
@@ -4,11 +4,13 @@
 #include "common.h"
 #include <stdio.h>
 #include <ctype.h>
+#include <math.h>
 
 #ifdef _WIN32
 	#include <windows.h>
 #else
 	#include <pthread.h>
+	#include <unistd.h>
 #endif
 
 PUBLIC int64_t num_key_space;
@@ -24,14 +26,37 @@ PUBLIC uint32_t num_thread_params = 0;
 PUBLIC HS_MUTEX key_provider_mutex;
 
 // Manage num_keys_served_*
+// Keys processed are added without locks to a counter by thread, and the counters are
+// summed when read. The mutex only serialize reads and changes of the totals.
+#define NUM_KEYS_SERVED_COUNTERS	64
+typedef struct KeysServedCounter
+{
+	int64_t value;
+	int64_t padding[7];// One cache line by counter
+}
+KeysServedCounter;
+
 PRIVATE HS_MUTEX num_keys_served_mutex;
-PRIVATE int64_t num_keys_served_from_save;
+PRIVATE HS_ALIGN(64) KeysServedCounter num_keys_served_by_thread[NUM_KEYS_SERVED_COUNTERS];
+PRIVATE int64_t num_keys_served_threads = 0;
+PRIVATE HS_THREAD_LOCAL uint32_t num_keys_served_counter = 0;// Index+1 of the thread counter
+PRIVATE int64_t num_keys_served_from_save;// Plus the counters
 PRIVATE int64_t num_keys_served_from_start;
 
+// Sum of counters, optionally putting them to zero. Need the mutex.
+PRIVATE int64_t sum_keys_served_counters(int reset)
+{
+	int64_t result = 0;
+
+	for (int i = 0; i < NUM_KEYS_SERVED_COUNTERS; i++)
+		result += reset ? HS_ATOMIC_EXCHANGE64(&num_keys_served_by_thread[i].value, 0) : HS_ATOMIC_LOAD64(&num_keys_served_by_thread[i].value);
+
+	return result;
+}
 PUBLIC int64_t get_num_keys_served()
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
-	int64_t result = num_keys_served_from_save + num_keys_served_from_start;
+	int64_t result = num_keys_served_from_save + sum_keys_served_counters(FALSE) + num_keys_served_from_start;
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
 
 	return result;
@@ -39,6 +64,7 @@ PUBLIC int64_t get_num_keys_served()
 PUBLIC void set_num_keys_zero()
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
+	sum_keys_served_counters(TRUE);
 	num_keys_served_from_start = 0;
 	num_keys_served_from_save = 0;
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
@@ -47,26 +73,29 @@ PUBLIC void set_num_keys_save_add_start(int64_t from_save_val, int64_t to_add_st
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
 	num_keys_served_from_start += to_add_start;
+	sum_keys_served_counters(TRUE);
 	num_keys_served_from_save = from_save_val;
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
 }
 PUBLIC void add_num_keys_from_save_to_start()
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
-	num_keys_served_from_start += num_keys_served_from_save;
+	num_keys_served_from_start += num_keys_served_from_save + sum_keys_served_counters(TRUE);
 	num_keys_served_from_save = 0;
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
 }
 PUBLIC void report_keys_processed(int64_t num)
 {
-	HS_ENTER_MUTEX(&num_keys_served_mutex);
-	num_keys_served_from_save += num;
-	HS_LEAVE_MUTEX(&num_keys_served_mutex);
+	// First report of this thread: select his counter
+	if (!num_keys_served_counter)
+		num_keys_served_counter = (uint32_t)(HS_ATOMIC_ADD64(&num_keys_served_threads, 1) % NUM_KEYS_SERVED_COUNTERS) + 1;
+
+	HS_ATOMIC_ADD64(&num_keys_served_by_thread[num_keys_served_counter - 1].value, num);
 }
 PUBLIC int64_t get_num_keys_served_from_save()
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
-	int64_t result = num_keys_served_from_save;
+	int64_t result = num_keys_served_from_save + sum_keys_served_counters(FALSE);
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
 
 	return result;
@@ -74,10 +103,77 @@ PUBLIC int64_t get_num_keys_served_from_save()
 PUBLIC void get_num_keys_served_ptr(int64_t* from_save, int64_t* from_start)
 {
 	HS_ENTER_MUTEX(&num_keys_served_mutex);
-	*from_save = num_keys_served_from_save;
+	*from_save = num_keys_served_from_save + sum_keys_served_counters(FALSE);
 	*from_start = num_keys_served_from_start;
 	HS_LEAVE_MUTEX(&num_keys_served_mutex);
 }
+#ifdef HS_TESTING
+// Contention of report_keys_processed() against the mutex it replaced, with 1 to 128 threads.
+// The same number of reports is split between the threads. Log ns by report.
+// Return FALSE if a total is not exact.
+#define BENCH_KEYS_SERVED_REPORTS		(1 << 23)
+#define BENCH_KEYS_SERVED_KEYS			256
+#define BENCH_KEYS_SERVED_MAX_THREADS	128
+PRIVATE int64_t bench_keys_served_mutex_total;
+PRIVATE int64_t bench_keys_served_threads_finished;
+PRIVATE void bench_report_keys_thread(void* param)
+{
+	uint32_t num_reports = BENCH_KEYS_SERVED_REPORTS / (uint32_t)(((size_t)param) >> 1);
+
+	if (((size_t)param) & 1)
+		for (uint32_t i = 0; i < num_reports; i++)
+		{
+			HS_ENTER_MUTEX(&num_keys_served_mutex);
+			bench_keys_served_mutex_total += BENCH_KEYS_SERVED_KEYS;
+			HS_LEAVE_MUTEX(&num_keys_served_mutex);
+		}
+	else
+		for (uint32_t i = 0; i < num_reports; i++)
+			report_keys_processed(BENCH_KEYS_SERVED_KEYS);
+
+	HS_ATOMIC_ADD64(&bench_keys_served_threads_finished, 1);
+}
+PUBLIC int bench_report_keys_processed()
+{
+	int64_t old_from_save, old_from_start;
+	int result = TRUE;
+
+	// Save the attack state
+	get_num_keys_served_ptr(&old_from_save, &old_from_start);
+
+	for (size_t num_threads = 1; num_threads <= BENCH_KEYS_SERVED_MAX_THREADS; num_threads *= 2)
+	{
+		double ns_report[2];
+		// 0: atomic counters, 1: mutex
+		for (size_t use_mutex = 0; use_mutex < 2; use_mutex++)
+		{
+			set_num_keys_zero();
+			bench_keys_served_mutex_total = 0;
+			HS_ATOMIC_EXCHANGE64(&bench_keys_served_threads_finished, 0);
+
+			int64_t start = get_milliseconds();
+			for (size_t i = 0; i < num_threads; i++)
+				HS_NEW_THREAD(bench_report_keys_thread, (void*)((num_threads << 1) | use_mutex));
+			while (HS_ATOMIC_LOAD64(&bench_keys_served_threads_finished) < (int64_t)num_threads)
+				Sleep(1);
+			ns_report[use_mutex] = (get_milliseconds() - start) * 1000000. / BENCH_KEYS_SERVED_REPORTS;
+
+			int64_t total = use_mutex ? bench_keys_served_mutex_total : get_num_keys_served();
+			if (total != ((int64_t)BENCH_KEYS_SERVED_REPORTS) / num_threads * num_threads * BENCH_KEYS_SERVED_KEYS)
+				result = FALSE;
+		}
+		hs_log(HS_LOG_INFO, "Test Suite", "Keys served %u threads: atomic %.1f ns/report, mutex %.1f ns/report", (uint32_t)num_threads, ns_report[0], ns_report[1]);
+	}
+
+	// Restore the attack state
+	set_num_keys_zero();
+	set_num_keys_save_add_start(old_from_save, old_from_start);
+
+	if (!result)
+		hs_log(HS_LOG_ERROR, "Test Suite", "Keys served total is not exact");
+	return result;
+}
+#endif
 
 PRIVATE void do_nothing(){}
 PRIVATE void do_nothing_save_resume_arg(char* resume)
@@ -227,39 +323,48 @@ PRIVATE void charset_resume(int pmin_lenght, int pmax_lenght, char* param, const
 		}
 	}
 }
-PRIVATE void charset_save_resume_arg(char* resume_arg)
+// Find the most old key saved by the threads. Need the mutex
+PRIVATE uint32_t find_oldest_thread_save(uint32_t* save_key_lenght)
 {
-	uint32_t save_key_lenght = UINT_MAX;
 	uint32_t old_index = 0;
 	unsigned char* buffer = (unsigned char*)thread_params;
-	resume_arg[0] = 0;
+	*save_key_lenght = UINT_MAX;
 
-	if (thread_params)
+	for (uint32_t i = 0; i < num_thread_params; i++)
 	{
-		uint32_t i, j;
-		HS_ENTER_MUTEX(&key_provider_mutex);
-
-		// Find the most old saved data
-		for (i = 0; i < num_thread_params; i++)
+		uint32_t thread_key_lenght = ((uint32_t*)thread_params)[8 * i + 7];
+		if (thread_key_lenght < *save_key_lenght)
 		{
-			uint32_t thread_key_lenght = ((uint32_t*)thread_params)[8 * i + 7];
-			if (thread_key_lenght < save_key_lenght)
+			*save_key_lenght = thread_key_lenght;
+			old_index = i;
+		}
+		if (thread_key_lenght == *save_key_lenght)
+			for (uint32_t j = thread_key_lenght - 1; j < thread_key_lenght; j--)
 			{
-				save_key_lenght = thread_key_lenght;
-				old_index = i;
-			}
-			if (thread_key_lenght == save_key_lenght)
-				for (j = thread_key_lenght - 1; j < thread_key_lenght; j--)
+				if (buffer[32 * i + j] < buffer[32 * old_index + j])
 				{
-					if (buffer[32 * i + j] < buffer[32 * old_index + j])
-					{
-						old_index = i;
-						break;
-					}
-					if (buffer[32 * i + j] > buffer[32 * old_index + j])
-						break;
+					old_index = i;
+					break;
 				}
-		}
+				if (buffer[32 * i + j] > buffer[32 * old_index + j])
+					break;
+			}
+	}
+
+	return old_index;
+}
+PRIVATE void charset_save_resume_arg(char* resume_arg)
+{
+	uint32_t save_key_lenght;
+	unsigned char* buffer = (unsigned char*)thread_params;
+	resume_arg[0] = 0;
+
+	if (thread_params)
+	{
+		uint32_t i;
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		uint32_t old_index = find_oldest_thread_save(&save_key_lenght);
 
 		// Save current candidate
 		for (i = 0; i < save_key_lenght; i++)
@@ -338,59 +443,102 @@ PRIVATE void memset_uint(uint32_t* buffer, uint32_t value, int size)
 }
 
 
-// Request 'max_number' keys. Only part with syncronization
-PRIVATE int charset_request(uint32_t max_number, int thread_id, unsigned char* current_key1, uint32_t* current_key_lenght1)
+// Keys reserved by a thread. Stored in 'thread_params' after the keys saved by thread
+#define CHARSET_KEYS_BY_CHUNK	16384
+typedef struct KeysChunk
+{
+	unsigned char key[MAX_KEY_LENGHT_BIG];
+	uint32_t key_lenght;
+	uint32_t num_keys;// Keys left
+}
+KeysChunk;
+// Advance a key 'num' positions
+typedef void advance_key_funtion(unsigned char* key, uint32_t* key_lenght, uint32_t num);
+
+// Request 'max_number' keys beginning in 'current_key1'. Used by Charset and Mask.
+// Only syncronize when reserving a new chunk of keys from 'current_key'.
+// Return the number of keys served: less than 'max_number' only when the chunk
+// has less keys left (the request size changed or the chunk reached the end).
+PRIVATE uint32_t request_keys_by_chunk(uint32_t max_number, int thread_id, unsigned char* current_key1, uint32_t* current_key_lenght1, advance_key_funtion* advance_key)
 {
 	unsigned char* current_save = ((unsigned char*)thread_params) + 32 * thread_id;
-	if (!num_char_in_charset) return 0;
-
-	HS_ENTER_MUTEX(&key_provider_mutex);
+	KeysChunk* chunk = ((KeysChunk*)(((unsigned char*)thread_params) + 32 * num_thread_params)) + thread_id;
 
-	if (current_key_lenght > max_lenght)
+	// Chunk empty or past the last key: reserve more
+	if (!chunk->num_keys || chunk->key_lenght > max_lenght)
 	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		if (current_key_lenght > max_lenght)
+		{
+			HS_LEAVE_MUTEX(&key_provider_mutex);
+			chunk->num_keys = 0;
+			return 0;
+		}
+
+		// Save the begin of the chunk
+		((uint32_t*)current_save)[7] = current_key_lenght;
+		memcpy(current_save, current_key, current_key_lenght);
+
+		// Reserve an exact number of batches
+		memcpy(chunk->key, current_key, sizeof(chunk->key));
+		chunk->key_lenght = current_key_lenght;
+		chunk->num_keys = __max(1, CHARSET_KEYS_BY_CHUNK / max_number) * max_number;
+		advance_key(current_key, &current_key_lenght, chunk->num_keys);
+
 		HS_LEAVE_MUTEX(&key_provider_mutex);
-		return 0;
 	}
-	else
+
+	// Serve only keys of this chunk: the ones after it belong to other thread
+	uint32_t num_served = __min(chunk->num_keys, max_number);
+	*current_key_lenght1 = chunk->key_lenght;
+	memcpy(current_key1, chunk->key, sizeof(chunk->key));
+	advance_key(chunk->key, &chunk->key_lenght, num_served);
+	chunk->num_keys -= num_served;
+
+	return num_served;
+}
+
+// Advance the key 'num' positions
+PRIVATE void charset_advance_key(unsigned char* key, uint32_t* key_lenght, uint32_t num)
+{
+	uint32_t lenght = *key_lenght;
+
+	if (!lenght)
 	{
-		// Copy all
-		*current_key_lenght1 = current_key_lenght;
-		((uint32_t*)current_save)[7] = current_key_lenght;
-		memcpy(current_save, current_key, current_key_lenght);
-		memcpy(current_key1, current_key, max_lenght);
+		lenght++;
+		num--;
+	}
+	// Sum
+	uint32_t i = 0;
+	while (num && lenght <= max_lenght)
+	{
+		uint32_t current_char = ((uint32_t)key[i]) + num%num_char_in_charset;
+		num /= num_char_in_charset;
 
-		// Calculate final current_key with new algorithm
-		if (!current_key_lenght)
+		if (current_char >= num_char_in_charset)
 		{
-			current_key_lenght++;
-			max_number--;
+			num++;
+			current_char -= num_char_in_charset;
 		}
-		// Sum
-		uint32_t i = 0;
-		while (max_number)
-		{
-			uint32_t current_char = ((uint32_t)current_key[i]) + max_number%num_char_in_charset;
-			max_number /= num_char_in_charset;
+		key[i] = current_char;
 
-			if (current_char >= num_char_in_charset)
-			{
-				max_number++;
-				current_char -= num_char_in_charset;
-			}
-			current_key[i] = current_char;
-
-			// Increase length
-			if (max_number && (++i == current_key_lenght))
-			{
-				current_key_lenght++;
-				max_number--;
-			}
+		// Increase length
+		if (num && (++i == lenght))
+		{
+			lenght++;
+			num--;
 		}
 	}
 
-	HS_LEAVE_MUTEX(&key_provider_mutex);
+	*key_lenght = lenght;
+}
+// Request 'max_number' keys. Only syncronize when reserving a new chunk of keys
+PRIVATE uint32_t charset_request(uint32_t max_number, int thread_id, unsigned char* current_key1, uint32_t* current_key_lenght1)
+{
+	if (!num_char_in_charset) return 0;
 
-	return 1;
+	return request_keys_by_chunk(max_number, thread_id, current_key1, current_key_lenght1, charset_advance_key);
 }
 
 PRIVATE int charset_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
@@ -398,10 +546,11 @@ PRIVATE int charset_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int threa
 	uint32_t current_key_lenght1;
 	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
 
-	if (!charset_request(max_number, thread_id, current_key1, &current_key_lenght1)) return 0;
+	uint32_t num_keys = charset_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
 
 	// If only change first 2 chars --> optimized version
-	if(current_key_lenght1 <= max_lenght && current_key_lenght1 > 2 && (num_char_in_charset-current_key1[0]-1+(num_char_in_charset-current_key1[1]-1)*num_char_in_charset) > max_number)
+	if(num_keys == max_number && current_key_lenght1 <= max_lenght && current_key_lenght1 > 2 && (num_char_in_charset-current_key1[0]-1+(num_char_in_charset-current_key1[1]-1)*num_char_in_charset) > max_number)
 	{
 		uint32_t j = 1, key_0, key_1;
 		uint32_t tmp;
@@ -434,7 +583,7 @@ PRIVATE int charset_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int threa
 		}
 	}
 	else
-		for (uint32_t i = 0; i < max_number; i++)
+		for (uint32_t i = 0; i < num_keys; i++)
 		{
 			uint32_t j = 0;
 			// Copy key to nt_buffer
@@ -472,9 +621,10 @@ PRIVATE int charset_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int th
 	uint32_t current_key_lenght1;
 	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
 
-	if (!charset_request(max_number, thread_id, current_key1, &current_key_lenght1)) return 0;
+	uint32_t num_keys = charset_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
 
-	for(uint32_t i = 0; i < max_number; i++, keys+=8u)
+	for(uint32_t i = 0; i < num_keys; i++, keys+=8u)
 	{
 		// All keys generated
 		if (current_key_lenght1 > max_lenght)
@@ -620,15 +770,15 @@ PRIVATE int charset_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number
 //	MEMSET_UINT_DEC* memset_uint = current_cpu.capabilites[CPU_CAP_NEON] ? memset_uint_neon : memset_uint_c_code;
 //#endif
 
-	if (!charset_request(max_number, thread_id, current_key1, &current_key_lenght1)) return 0;
+	uint32_t num_keys = charset_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
 
-	
 	uint32_t first_amount = 0;
 	uint32_t pow = 1;
 	for (int i = 0; i < 4; i++, pow*=num_char_in_charset)
 		first_amount += (num_char_in_charset - current_key1[i] - 1)*pow;
 	// If only change first 4 chars --> optimized version
-	if (current_key_lenght1 >= 4 && first_amount > max_number)
+	if (num_keys == max_number && current_key_lenght1 >= 4 && first_amount > max_number)
 	{
 		// Copy key to nt_buffer
 		for (uint32_t j = 1; j < current_key_lenght1 / 4; j++)
@@ -673,7 +823,7 @@ PRIVATE int charset_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number
 	else
 	{
 		uint32_t i = 0;
-		for (i = 0; i < max_number && current_key_lenght1 <= max_lenght; i++)
+		for (i = 0; i < num_keys && current_key_lenght1 <= max_lenght; i++)
 		{
 			// Copy key to nt_buffer
 			for (uint32_t j = 0; j < current_key_lenght1 / 4; j++)
@@ -771,6 +921,24 @@ int wordlist_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
 int wordlist_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id);
 int wordlist_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id);
 int wordlist_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
+int wordlist_read_lines(char* params, int max_line_lenght, void (*process_line)(const unsigned char* line, int lenght));
+int wordlist_getline(unsigned char* line, int max_line_lenght);
+int64_t wordlist_get_position();
+
+void stdin_resume(int pmin_lenght, int pmax_lenght, char* params, const char* resume_arg, int format_index);
+void stdin_save_resume_arg(char* resume_arg);
+void stdin_finish();
+void stdin_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght);
+int stdin_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
+int stdin_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id);
+int stdin_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id);
+int stdin_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
+// The reader of the stream needs its own thread
+#ifdef HS_NO_THREADS
+	#define STDIN_SHOW_TO_USER	FALSE
+#else
+	#define STDIN_SHOW_TO_USER	TRUE
+#endif
 
 void sentence_resume(int pmin_lenght, int pmax_lenght, char* params, const char* resume_arg, int format_index);
 int sentence_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
@@ -1721,156 +1889,2233 @@ PUBLIC void introduce_fast_lm(AttackData** batch, int* num_attack_in_batch)
 			}
 	}
 }
-////////////////////////////////////////////////////////////////////////////////////////////////////////////
-PUBLIC void register_key_providers(int db_already_initialize)
+////////////////////////////////////////////////////////////////////////////////////
+// Mask mode
+////////////////////////////////////////////////////////////////////////////////////
+// Each position of the key has his own charset. Use 'current_key' as in charset mode,
+// but current_key[i] is an index into mask_charset[i]. Position 0 change faster.
+#define MASK_MAX_POSITIONS			27
+#define MASK_NUM_CUSTOM_CHARSETS	4
+PRIVATE unsigned char mask_charset[MAX_KEY_LENGHT_BIG][256];
+PRIVATE uint32_t mask_charset_size[MAX_KEY_LENGHT_BIG];
+PRIVATE uint32_t mask_num_positions;
+PRIVATE int mask_to_upper;
+
+// Add the char if is not already in the charset
+PRIVATE void mask_add_char(unsigned char* charset_pos, uint32_t* size, uint32_t* chars_used_bitmap, unsigned char c)
 {
-	int i = 0;
-
-	// Mutex for thread-safe access
-	HS_CREATE_MUTEX(&key_provider_mutex);
-	HS_CREATE_MUTEX(&num_keys_served_mutex);
+	if (mask_to_upper)
+		c = (unsigned char)toupper(c);
 
-	if (!db_already_initialize)
+	if (c && !(chars_used_bitmap[c >> 5] & (1 << (c & 31))))
 	{
-		sqlite3_stmt* insert;
-		// KeyProvider in database
-		sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO KeyProvider (ID, Name, Description) VALUES (?, ?, ?);", -1, &insert, NULL);
-
-		for (; i < num_key_providers; i++)
-		{
-			// Ensures all KeyProvider are in the db
-			sqlite3_reset(insert);
-			sqlite3_bind_int64(insert, 1, key_providers[i].db_id);
-			sqlite3_bind_text(insert, 2, key_providers[i].name, -1, SQLITE_STATIC);
-			sqlite3_bind_text(insert, 3, key_providers[i].description, -1, SQLITE_STATIC);
-			sqlite3_step(insert);
-		}
-
-		sqlite3_finalize(insert);
+		chars_used_bitmap[c >> 5] |= 1 << (c & 31);
+		charset_pos[size[0]++] = c;
 	}
 }
-
-// Rules support
-void rules_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index);
-int rules_gen_common(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
-void rules_finish();
-void rules_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght);
-
-PUBLIC KeyProvider key_providers[] = {
-	{
-		"Charset" , "Fast generation of keys.", 1, 
-		{{PROTOCOL_NTLM, charset_gen_ntlm}, {PROTOCOL_UTF8_LM, charset_gen_utf8_lm}, {PROTOCOL_CHARSET_OCL, charset_gen_opencl}, { PROTOCOL_CHARSET_OCL_NO_ALIGNED, charset_gen_opencl_no_aligned }, { PROTOCOL_UTF8_COALESC_LE, charset_gen_utf8_coalesc_le } },
-		charset_save_resume_arg , charset_resume , do_nothing, charset_get_description, 0, 6, TRUE, FALSE, MAX_KEY_LENGHT_BIG
-	},
-	{
-		"Wordlist", "Read keys from a file." , 2,
-		{{PROTOCOL_NTLM, wordlist_gen_ntlm}, {PROTOCOL_UTF8_LM, wordlist_gen_utf8_lm}, {PROTOCOL_UTF8, wordlist_gen_utf8}, {PROTOCOL_UTF8, wordlist_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, wordlist_gen_utf8_coalesc_le}},
-		wordlist_save_resume_arg, wordlist_resume, NULL, wordlist_get_description, 1, MAX_KEY_LENGHT_BIG, TRUE, TRUE, sizeof(fpos_t)
-	},
-	{
-		"Keyboard", "Generate combination of adjacent keys in keyboard." , 3,
-		{{PROTOCOL_NTLM, keyboard_gen_ntlm}, {PROTOCOL_UTF8_LM, keyboard_gen_utf8_lm}, {PROTOCOL_UTF8, keyboard_gen_utf8}, {PROTOCOL_UTF8, keyboard_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, keyboard_gen_utf8_coalesc_le}},
-		charset_save_resume_arg, keyboard_resume, do_nothing, keyboard_get_description, 2, 10, TRUE, FALSE, MAX_KEY_LENGHT_BIG
-	},
-	{
-		"Phrases" , "Generate phrases combining words from a wordlist.", 4,
-		{{PROTOCOL_NTLM, sentence_gen_ntlm}, {PROTOCOL_PHRASES_OPENCL, sentence_gen_ocl}, {PROTOCOL_UTF8, sentence_gen_utf8}, {PROTOCOL_UTF8, sentence_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, sentence_gen_utf8_coalesc_le}},
-		sentence_save_resume_arg, sentence_resume, sentence_finish, sentence_get_description, 2, 2, TRUE, FALSE, MAX_KEY_LENGHT_SMALL*sizeof(uint32_t)
-	},
-	{
-		"DB Info" , "Tries usernames and passwords found.", 5, 
-		{{PROTOCOL_NTLM, db_gen_ntlm}, {PROTOCOL_UTF8_LM, db_gen_utf8_lm}, {PROTOCOL_UTF8, db_gen_utf8}, {PROTOCOL_UTF8, db_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, db_gen_utf8_coalesc_le}},
-		do_nothing_save_resume_arg, db_resume, db_finish, do_nothing_description, 1, MAX_KEY_LENGHT_BIG, TRUE, TRUE, 0
-	},
-	{
-		"LM2NT" , "Found NTLM passwords using LM passwords and correcting case.", 6, 
-		{{PROTOCOL_NTLM, lm2ntlm_gen_ntlm}, {PROTOCOL_NTLM, lm2ntlm_gen_ntlm}, {PROTOCOL_UTF8, lm2ntlm_gen_utf8}, {PROTOCOL_UTF8, lm2ntlm_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, lm2ntlm_gen_utf8_coalesc_le}},
-		do_nothing_save_resume_arg, lm2ntlm_resume, lm2ntlm_finish, do_nothing_description, 0, MAX_KEY_LENGHT_SMALL, TRUE, FALSE, 0
-	},
-	//////////////////////////////////////////////////////////////////////////////////////////////
-	// Down are the 'private' key_providers: These key_providers don't show to the user directly
-	//////////////////////////////////////////////////////////////////////////////////////////////
-	{
-		"FastLM" , "Very fast generation of LM keys.", 7, 
-		{{PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM_OPENCL, fast_lm_opencl_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}},
-		charset_save_resume_arg, fast_lm_resume, do_nothing, charset_get_description, 4, 7, FALSE, FALSE, MAX_KEY_LENGHT_SMALL
-	},
+// Chars of the built-in classes
+PRIVATE const char* mask_get_builtin(char class_char)
+{
+	switch (class_char)
 	{
-		"Rules" , "Apply rules.", 8, 
-		{{PROTOCOL_NTLM, rules_gen_common}, {PROTOCOL_NTLM, rules_gen_common}, {PROTOCOL_RULES_OPENCL, rules_gen_common}, {PROTOCOL_RULES_OPENCL, rules_gen_common}, {PROTOCOL_UTF8_COALESC_LE, rules_gen_common}},
-		NULL, rules_resume, rules_finish, rules_get_description, 0, 27, FALSE, FALSE, 0
+	case 'l': return "abcdefghijklmnopqrstuvwxyz";
+	case 'u': return "ABCDEFGHIJKLMNOPQRSTUVWXYZ";
+	case 'd': return "0123456789";
+	case 's': return " !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+	case 'a': return "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789 !\"#$%&'()*+,-./:;<=>?@[\\]^_`{|}~";
+	case 'h': return "0123456789abcdef";
+	case 'H': return "0123456789ABCDEF";
 	}
-	// TODO: Mask or KnowForce, characters Added, Subset, From STDIN, Distributed, ...
-};
-PUBLIC int num_key_providers = LENGTH(key_providers);
 
+	return NULL;
+}
+// Add the chars of one element of the mask: a literal char, a built-in class (?l ?u ?d ?s ?a ?h ?H),
+// a custom charset (?1 to ?4) or '??' for the '?' char. Return the number of chars of 'src' consumed
+PRIVATE int mask_add_element(const unsigned char* src, unsigned char* charset_pos, uint32_t* size, uint32_t* chars_used_bitmap, unsigned char custom[][256], const uint32_t* custom_size)
+{
+	if (src[0] != '?' || !src[1] || src[1] == '\n')
+	{
+		mask_add_char(charset_pos, size, chars_used_bitmap, src[0]);
+		return 1;
+	}
 
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-// OpenCL Implementation
-//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
-#ifdef HS_OPENCL_SUPPORT
-#include "attack.h"
-PUBLIC cl_uint ocl_rule_simple_copy_unicode(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size)
+	const char* builtin = mask_get_builtin(src[1]);
+	if (builtin)
+		for (; *builtin; builtin++)
+			mask_add_char(charset_pos, size, chars_used_bitmap, *builtin);
+	else if (custom && src[1] >= '1' && src[1] < '1' + MASK_NUM_CUSTOM_CHARSETS)
+		for (uint32_t i = 0; i < custom_size[src[1] - '1']; i++)
+			mask_add_char(charset_pos, size, chars_used_bitmap, custom[src[1] - '1'][i]);
+	else// '??' or not a class: literal
+		mask_add_char(charset_pos, size, chars_used_bitmap, src[1]);
+
+	return 2;
+}
+// param: mask[\ncustom1[\ncustom2[\ncustom3[\ncustom4]]]]
+// Custom charsets may use the built-in classes, but not other custom charsets. Return the number of positions,
+// 0 if the mask is invalid: uses an empty charset (unused custom charset) or has more than MASK_MAX_POSITIONS
+PRIVATE uint32_t mask_parse_charsets(const char* param, unsigned char charset[][256], uint32_t* charset_size)
 {
-	strcpy(nt_buffer[0 ], "+nt_buffer[0]");
-	strcpy(nt_buffer[1 ], "+nt_buffer[1]");
-	strcpy(nt_buffer[2 ], "+nt_buffer[2]");
-	strcpy(nt_buffer[3 ], "+nt_buffer[3]");
-	strcpy(nt_buffer[4 ], "+nt_buffer[4]");
-	strcpy(nt_buffer[5 ], "+nt_buffer[5]");
-	strcpy(nt_buffer[6 ], "+nt_buffer[6]");
-	strcpy(nt_buffer[7 ], "+nt_buffer[7]");
-	strcpy(nt_buffer[8 ], "+nt_buffer[8]");
-	strcpy(nt_buffer[9 ], "+nt_buffer[9]");
-	strcpy(nt_buffer[10], "+nt_buffer[10]");
-	strcpy(nt_buffer[11], "+nt_buffer[11]");
-	strcpy(nt_buffer[12], "+nt_buffer[12]");
-	strcpy(nt_buffer[13], "+nt_buffer[13]");
-	strcpy(nt_buffer[14], "+nt_len"       );
+	unsigned char custom[MASK_NUM_CUSTOM_CHARSETS][256];
+	uint32_t custom_size[MASK_NUM_CUSTOM_CHARSETS];
+	uint32_t chars_used_bitmap[8];
+	const unsigned char* mask = (const unsigned char*)param;
+	const unsigned char* custom_ptr = (const unsigned char*)strchr(param, '\n');
 
-	// Total number of keys
-	sprintf(source + strlen(source),
-		"indx=get_global_id(0);"
-		"uint nt_buffer[14];"
-		"uint nt_len=keys[indx+7*%uu];"
-		"if(nt_len>(27u<<4u))return;"
-		"uint max_len=(nt_len>>6)+1;", NUM_KEYS_OPENCL);
+	// Custom charsets
+	memset(custom_size, 0, sizeof(custom_size));
+	for (uint32_t i = 0; custom_ptr && i < MASK_NUM_CUSTOM_CHARSETS; i++)
+	{
+		memset(chars_used_bitmap, 0, sizeof(chars_used_bitmap));
+		for (custom_ptr++; *custom_ptr && *custom_ptr != '\n';)
+			custom_ptr += mask_add_element(custom_ptr, custom[i], custom_size + i, chars_used_bitmap, NULL, NULL);
 
-	sprintf(source + strlen(source),
-		"for(uint i=0;i<max_len;i++){"
-			"uint copy_tmp=keys[indx+i*%uu];"
-			"nt_buffer[2*i]=GET_1(copy_tmp);"
-			"nt_buffer[2*i+1]=GET_2(copy_tmp);"
-		"}", NUM_KEYS_OPENCL);
+		if (*custom_ptr != '\n')
+			custom_ptr = NULL;
+	}
 
-	sprintf(source + strlen(source),
-		"for(uint i=2*max_len;i<14;i++)"
-			"nt_buffer[i]=0;");
+	// Charset of each position
+	uint32_t num_positions;
+	memset(charset_size, 0, MAX_KEY_LENGHT_BIG * sizeof(uint32_t));
+	for (num_positions = 0; *mask && *mask != '\n' && num_positions < MASK_MAX_POSITIONS; num_positions++)
+	{
+		memset(chars_used_bitmap, 0, sizeof(chars_used_bitmap));
+		mask += mask_add_element(mask, charset[num_positions], charset_size + num_positions, chars_used_bitmap, custom, custom_size);
 
-	return 1;
+		if (!charset_size[num_positions])
+			return 0;
+	}
+	// Not all the mask parsed
+	if (*mask && *mask != '\n')
+		return 0;
+
+	return num_positions;
 }
-PUBLIC cl_uint ocl_rule_simple_copy_utf8_le(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size)
+PRIVATE void mask_parse(const char* param)
 {
-	strcpy(nt_buffer[0], "+buffer0");
-	strcpy(nt_buffer[1], "+buffer1");
-	strcpy(nt_buffer[2], "+buffer2");
-	strcpy(nt_buffer[3], "+buffer3");
-	strcpy(nt_buffer[4], "+buffer4");
-	strcpy(nt_buffer[5], "+buffer5");
-	strcpy(nt_buffer[6], "+buffer6");
-	strcpy(nt_buffer[7], "+len");
+	mask_num_positions = mask_parse_charsets(param, mask_charset, mask_charset_size);
 
-	// Total number of keys
-	sprintf(source + strlen(source),
-		"indx=get_global_id(0);"
-		"uint len=keys[indx+7*%uu];"
-		"if(len>(27u<<4u))return;"
-		"len>>=1u;", NUM_KEYS_OPENCL);
+	if (!mask_num_positions && *param && *param != '\n')
+		hs_log(HS_LOG_ERROR, "Mask", "Invalid mask '%.*s': empty charset or more than %i positions", (int)__min(strcspn(param, "\n"), 40), param, MASK_MAX_POSITIONS);
+}
+// Keys of lenght 'i' use the first 'i' positions of the mask
+PRIVATE void mask_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index)
+{
+	int64_t pow_num;
+	uint32_t i, j;
 
-	strcat(source,"uint buffer0=keys[indx];");
+	memset(current_key, 0, sizeof(current_key));
 
-	for (cl_uint i = 1; i < 7; i++)
-		sprintf(source + strlen(source),
+	mask_to_upper = format_index == LM_INDEX;
+	mask_parse(param);
+
+	current_key_lenght = pmin_lenght;
+	max_lenght = __min((uint32_t)pmax_lenght, mask_num_positions);
+
+	if (!mask_num_positions)
+	{
+		current_key_lenght = 1;
+		max_lenght = 0;
+	}
+
+	// Resume
+	if (resume_arg && strlen(resume_arg))
+	{
+		current_key_lenght = __min((uint32_t)strlen(resume_arg), MASK_MAX_POSITIONS);
+
+		for (i = 0; i < current_key_lenght; i++)
+			for (j = 0; j < mask_charset_size[i]; j++)
+				if (((unsigned char*)resume_arg)[i] == mask_charset[i][j])
+				{
+					current_key[i] = j;
+					break;
+				}
+	}
+
+	// Calculate the key-space: sum of the product of the charset sizes of each lenght
+	num_key_space = 0;
+	pow_num = 1;
+
+	// Take into account resume attacks
+	for (i = 0; i < current_key_lenght && i < max_lenght; pow_num *= mask_charset_size[i], i++)
+		num_key_space -= current_key[i] * pow_num;
+
+	for (i = current_key_lenght; i <= max_lenght; pow_num *= mask_charset_size[i], i++)
+	{
+		num_key_space += pow_num;
+		// Protects against integer overflow
+		if (num_key_space > 0xFFFFFFFFFFFFFFF || pow_num > 0xFFFFFFFFFFFFFFF)
+		{
+			num_key_space = KEY_SPACE_UNKNOW;
+			break;
+		}
+	}
+
+	if (current_key_lenght > max_lenght)
+		num_key_space = 0;
+}
+PRIVATE void mask_save_resume_arg(char* resume_arg)
+{
+	uint32_t save_key_lenght;
+	unsigned char* buffer = (unsigned char*)thread_params;
+	resume_arg[0] = 0;
+
+	if (thread_params)
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		uint32_t old_index = find_oldest_thread_save(&save_key_lenght);
+
+		// Save current candidate
+		for (uint32_t i = 0; i < save_key_lenght; i++)
+			resume_arg[i] = mask_charset[i][buffer[32 * old_index + i]];
+
+		resume_arg[save_key_lenght] = 0;
+
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+	}
+	else
+	{
+		// Save current candidate
+		for (uint32_t i = 0; i < current_key_lenght; i++)
+			resume_arg[i] = mask_charset[i][current_key[i]];
+
+		resume_arg[current_key_lenght] = 0;
+	}
+}
+// Advance the key 'num' positions
+PRIVATE void mask_advance_key(unsigned char* key, uint32_t* key_lenght, uint32_t num)
+{
+	uint32_t lenght = *key_lenght;
+
+	if (!lenght)
+	{
+		lenght++;
+		num--;
+	}
+	// Sum with a different base by position
+	uint32_t i = 0;
+	while (num && lenght <= max_lenght)
+	{
+		uint32_t current_char = ((uint32_t)key[i]) + num%mask_charset_size[i];
+		num /= mask_charset_size[i];
+
+		if (current_char >= mask_charset_size[i])
+		{
+			num++;
+			current_char -= mask_charset_size[i];
+		}
+		key[i] = current_char;
+
+		// Increase length
+		if (num && (++i == lenght))
+		{
+			lenght++;
+			num--;
+		}
+	}
+
+	*key_lenght = lenght;
+}
+PRIVATE __forceinline void mask_next_key(unsigned char* key, uint32_t* key_lenght)
+{
+	if (*key_lenght) //if length > 0
+	{
+		uint32_t j = 0;
+		while (++key[j] == mask_charset_size[j])
+		{
+			key[j] = 0;
+
+			if (++j == *key_lenght)
+			{
+				(*key_lenght)++;
+				break;
+			}
+		}
+	}
+	else// if length == 0
+		(*key_lenght)++;
+}
+// Request 'max_number' keys. Only syncronize when reserving a new chunk of keys
+PRIVATE uint32_t mask_request(uint32_t max_number, int thread_id, unsigned char* current_key1, uint32_t* current_key_lenght1)
+{
+	if (!mask_num_positions) return 0;
+
+	return request_keys_by_chunk(max_number, thread_id, current_key1, current_key_lenght1, mask_advance_key);
+}
+PRIVATE int mask_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	uint32_t current_key_lenght1;
+	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
+
+	uint32_t num_keys = mask_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
+
+	// If only change first 2 chars --> optimized version
+	if (num_keys == max_number && current_key_lenght1 > 2 && (mask_charset_size[0]-current_key1[0]-1+(mask_charset_size[1]-current_key1[1]-1)*mask_charset_size[0]) >= max_number)
+	{
+		uint32_t j = 1, key_0, key_1;
+		uint32_t tmp;
+
+		for(; j < current_key_lenght1/2; j++)
+		{
+			tmp = ((uint32_t)mask_charset[2*j][current_key1[2*j]]) | ((uint32_t)mask_charset[2*j+1][current_key1[2*j+1]]) << 16;
+			memset_uint(nt_buffer + j*max_number, tmp, max_number);
+		}
+
+		tmp = (current_key_lenght1 & 1) ? ((uint32_t)mask_charset[2*j][current_key1[2*j]]) | 0x800000 : 0x80;
+		memset_uint(nt_buffer + j*max_number, tmp, max_number);
+		memset_uint(nt_buffer + 14 * max_number, current_key_lenght1 << 4, max_number);
+
+		key_0 = current_key1[0];
+		key_1 = current_key1[1];
+		for(uint32_t i = 0; i < max_number; i++)
+		{
+			nt_buffer[i] = ((uint32_t)mask_charset[0][key_0]) | ((uint32_t)mask_charset[1][key_1]) << 16;
+			// Next key
+			if(++key_0 == mask_charset_size[0])
+			{
+				key_0 = 0;
+				key_1++;
+			}
+		}
+
+		return max_number;
+	}
+
+	uint32_t i = 0;
+	for (; i < num_keys && current_key_lenght1 <= max_lenght; i++)
+	{
+		uint32_t j = 0;
+		// Copy key to nt_buffer
+		for(; j < current_key_lenght1/2; j++)
+			nt_buffer[j*max_number+i] = ((uint32_t)mask_charset[2*j][current_key1[2*j]]) | ((uint32_t)mask_charset[2*j+1][current_key1[2*j+1]]) << 16;
+
+		nt_buffer[j*max_number+i] = (current_key_lenght1 & 1) ? ((uint32_t)mask_charset[2*j][current_key1[2*j]]) | 0x800000 : 0x80;
+		nt_buffer[14*max_number+i] = current_key_lenght1 << 4;
+
+		mask_next_key(current_key1, &current_key_lenght1);
+	}
+
+	return i;
+}
+PRIVATE int mask_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	uint32_t current_key_lenght1;
+	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
+
+	uint32_t num_keys = mask_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
+
+	memset(keys, 0, max_number*8);
+
+	uint32_t i = 0;
+	for (; i < num_keys && current_key_lenght1 <= max_lenght; i++, keys += 8u)
+	{
+		// Copy key
+		for (uint32_t j = 0; j < current_key_lenght1; j++)
+			keys[j] = mask_charset[j][current_key1[j]];
+
+		mask_next_key(current_key1, &current_key_lenght1);
+	}
+
+	return i;
+}
+PRIVATE int mask_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	uint32_t current_key_lenght1;
+	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
+
+	uint32_t num_keys = mask_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
+
+	uint32_t i = 0;
+	for (; i < num_keys && current_key_lenght1 <= max_lenght; i++, keys += MAX_KEY_LENGHT_SMALL)
+	{
+		// Copy key
+		for (uint32_t j = 0; j < current_key_lenght1; j++)
+			keys[j] = mask_charset[j][current_key1[j]];
+
+		keys[current_key_lenght1] = 0;
+
+		mask_next_key(current_key1, &current_key_lenght1);
+	}
+
+	return i;
+}
+PRIVATE int mask_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	uint32_t current_key_lenght1;
+	unsigned char current_key1[MAX_KEY_LENGHT_BIG];
+
+	uint32_t num_keys = mask_request(max_number, thread_id, current_key1, &current_key_lenght1);
+	if (!num_keys) return 0;
+
+	// Keys before the first 4 chars overflow
+	uint64_t first_amount = 0;
+	uint64_t pow = 1;
+	for (uint32_t i = 0; i < 4 && i < current_key_lenght1; pow *= mask_charset_size[i], i++)
+		first_amount += (mask_charset_size[i] - current_key1[i] - 1)*pow;
+
+	// If only change first 4 chars --> optimized version
+	if (num_keys == max_number && current_key_lenght1 >= 4 && first_amount >= max_number)
+	{
+		// Copy key to nt_buffer
+		for (uint32_t j = 1; j < current_key_lenght1 / 4; j++)
+		{
+			uint32_t val = mask_charset[4 * j][current_key1[4 * j]];
+			val |= ((uint32_t)mask_charset[4 * j + 1][current_key1[4 * j + 1]]) << 8;
+			val |= ((uint32_t)mask_charset[4 * j + 2][current_key1[4 * j + 2]]) << 16;
+			val |= ((uint32_t)mask_charset[4 * j + 3][current_key1[4 * j + 3]]) << 24;
+
+			memset_uint(nt_buffer + j*max_number, val, max_number);
+		}
+
+		uint32_t val = 0x80 << (8 * (current_key_lenght1 & 3));
+		for (uint32_t k = 0; k < (current_key_lenght1 & 3); k++)
+			val |= ((uint32_t)mask_charset[4 * (current_key_lenght1 / 4) + k][current_key1[4 * (current_key_lenght1 / 4) + k]]) << (8 * k);
+
+		memset_uint(nt_buffer + (current_key_lenght1 / 4)*max_number, val, max_number);
+		memset_uint(nt_buffer + 7 * max_number, current_key_lenght1 << 3, max_number);
+
+		for (uint32_t i = 0; i < max_number; i++)
+		{
+			// Copy key to nt_buffer
+			uint32_t val = mask_charset[0][current_key1[0]];
+			val |= ((uint32_t)mask_charset[1][current_key1[1]]) << 8;
+			val |= ((uint32_t)mask_charset[2][current_key1[2]]) << 16;
+			val |= ((uint32_t)mask_charset[3][current_key1[3]]) << 24;
+			nt_buffer[i] = val;
+
+			// Next key
+			uint32_t j = 0;
+			while (++current_key1[j] == mask_charset_size[j])
+			{
+				current_key1[j] = 0;
+				j++;
+			}
+		}
+
+		return max_number;
+	}
+
+	uint32_t i = 0;
+	for (; i < num_keys && current_key_lenght1 <= max_lenght; i++)
+	{
+		// Copy key to nt_buffer
+		for (uint32_t j = 0; j < current_key_lenght1 / 4; j++)
+		{
+			uint32_t val = mask_charset[4 * j][current_key1[4 * j]];
+			val |= ((uint32_t)mask_charset[4 * j + 1][current_key1[4 * j + 1]]) << 8;
+			val |= ((uint32_t)mask_charset[4 * j + 2][current_key1[4 * j + 2]]) << 16;
+			val |= ((uint32_t)mask_charset[4 * j + 3][current_key1[4 * j + 3]]) << 24;
+
+			nt_buffer[j * max_number + i] = val;
+		}
+
+		uint32_t val = 0x80 << (8 * (current_key_lenght1 & 3));
+		for (uint32_t k = 0; k < (current_key_lenght1 & 3); k++)
+			val |= ((uint32_t)mask_charset[4 * (current_key_lenght1 / 4) + k][current_key1[4 * (current_key_lenght1 / 4) + k]]) << (8 * k);
+
+		nt_buffer[(current_key_lenght1 / 4) * max_number + i] = val;
+		nt_buffer[7 * max_number + i] = current_key_lenght1 << 3;
+
+		mask_next_key(current_key1, &current_key_lenght1);
+	}
+
+	return i;
+}
+// Same buffer than charset_gen_opencl_no_aligned: the GPU add the work-item index to the key
+PRIVATE int mask_gen_opencl(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	int result = 1;
+	unsigned char* current_save = ((unsigned char*)thread_params) + 32 * thread_id;
+
+	HS_ENTER_MUTEX(&key_provider_mutex);
+
+	if(current_key_lenght > max_lenght)
+		result = 0;
+	else if(!current_key_lenght)
+	{
+		nt_buffer[8] = 0;
+		nt_buffer[9] = 1;
+		current_key_lenght++;
+	}
+	else
+	{
+		uint32_t index = 0;
+
+		// Copy all
+		((uint32_t*)current_save)[7] = current_key_lenght;
+		memcpy(current_save, current_key, current_key_lenght);
+		memcpy(nt_buffer, current_key, sizeof(current_key));
+		nt_buffer[8] = current_key_lenght;
+		nt_buffer[9] = max_number;
+
+		// Calculate final current_key
+		while(max_number)// Sum
+		{
+			max_number += current_key[index];
+			current_key[index] = max_number%mask_charset_size[index];
+			max_number /= mask_charset_size[index];
+
+			if(max_number && ++index >= current_key_lenght)
+			{
+				// Calculate how much we exceed
+				uint32_t pow = 1;
+				uint32_t exceed_served = 0;
+				for(index = 0; index < current_key_lenght; pow *= mask_charset_size[index], index++)
+					exceed_served += current_key[index]*pow;
+
+				exceed_served += (max_number-1)*pow;
+				nt_buffer[9] -= exceed_served;
+				// Support only one length in each call
+				current_key_lenght++;
+				memset(current_key, 0, current_key_lenght);
+				break;
+			}
+		}
+	}
+
+	HS_LEAVE_MUTEX(&key_provider_mutex);
+	return result;
+}
+PRIVATE void mask_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
+{
+	int mask_lenght = (int)strcspn(provider_param, "\n");
+
+	sprintf(description, " %i-%i [%.*s%s]", min_lenght, max_lenght, __min(mask_lenght, 20), provider_param, mask_lenght > 20 ? "..." : "");
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// Markov mode
+////////////////////////////////////////////////////////////////////////////////////
+// Keys are scored with the cost of the first char plus the cost of each transition between
+// chars, cost = -MARKOV_COST_SCALE*log2(probability), trained with found passwords or a wordlist.
+// Keys with total cost <= level are generated by bands of cost, more probable first, and inside
+// a band by lenght. Inside a band and lenght the chars are ordered by cost. Transitions don't
+// depend on the position: this maintains small the table used to count the keys, so the
+// key-space is exact and any key can be found by his index.
+#define MARKOV_MAX_CHARS		256
+#define MARKOV_COST_SCALE		10
+#define MARKOV_BAND_WIDTH		10
+#define MARKOV_DEFAULT_LEVEL	350
+#define MARKOV_MAX_LEVEL		1000
+#define MARKOV_MAX_LENGHT		27
+#define MARKOV_MAX_COUNT		(1LL << 57)// The sum of counts of all lenghts don't overflow
+
+PRIVATE unsigned char markov_chars[MARKOV_MAX_CHARS];
+PRIVATE uint32_t markov_num_chars;
+// Chars ordered by cost after the previous char and his cost. Row 'markov_num_chars' is for the first char
+PRIVATE unsigned char markov_order[MARKOV_MAX_CHARS + 1][MARKOV_MAX_CHARS];
+PRIVATE uint16_t markov_order_cost[MARKOV_MAX_CHARS + 1][MARKOV_MAX_CHARS];
+// markov_counts[k][prev][r]: number of 'k' chars after 'prev' with cost <= r
+PRIVATE int64_t* markov_counts = NULL;
+PRIVATE uint32_t markov_counts_stride;
+PRIVATE int32_t markov_level;
+// Each segment is a band of cost and a lenght. Index of the first key of each segment
+PRIVATE int64_t* markov_segment_start = NULL;
+PRIVATE uint32_t markov_num_segments;
+PRIVATE int64_t markov_current_index;
+// Found passwords used to train, so a resume use the same order
+PRIVATE int64_t markov_train_max_pk;
+// Training: markov_train_count[prev][c] by byte value. Row 256 is for the first char
+PRIVATE uint32_t* markov_train_count = NULL;
+PRIVATE int markov_to_upper;
+// Source of the current trained table: resume is called for the key-space, the self-test and the attack
+PRIVATE char markov_train_source[64] = "";
+
+// Keys reserved by a thread. Stored in 'thread_params' after the index saved by thread
+typedef struct MarkovChunk
+{
+	int64_t index;// Index of the current key
+	uint32_t num_keys;
+	uint32_t segment;
+	uint32_t lenght;
+	int32_t lo, hi;// Cost in (lo, hi]
+	unsigned char pos[MAX_KEY_LENGHT_BIG];// Position in markov_order
+	unsigned char key[MAX_KEY_LENGHT_BIG];// Index in markov_chars
+	unsigned char chars[MAX_KEY_LENGHT_BIG];
+	int32_t acc[MAX_KEY_LENGHT_BIG + 1];// Cost of the chars before the position
+}
+MarkovChunk;
+
+PRIVATE void markov_train_line(const unsigned char* line, int lenght)
+{
+	uint32_t prev = 256;
+
+	for (int i = 0; i < lenght; i++)
+	{
+		uint32_t c = markov_to_upper ? (unsigned char)toupper(line[i]) : line[i];
+		if (!c) break;
+
+		markov_train_count[prev * 256 + c]++;
+		prev = c;
+	}
+}
+// Build the chars used and the cost of each transition from the training counts
+PRIVATE void markov_build_costs()
+{
+	uint32_t char_index[256];
+	uint16_t cost[MARKOV_MAX_CHARS];
+
+	// Chars used
+	markov_num_chars = 0;
+	for (uint32_t c = 1; c < 256; c++)
+		for (uint32_t prev = 0; prev <= 256; prev++)
+			if (markov_train_count[prev * 256 + c])
+			{
+				char_index[markov_num_chars] = c;
+				markov_chars[markov_num_chars++] = (unsigned char)c;
+				break;
+			}
+
+	// Without training: all printable chars with the same cost
+	if (!markov_num_chars)
+		for (uint32_t c = ' '; c <= '~'; c++)
+			if (!markov_to_upper || !islower(c))
+			{
+				char_index[markov_num_chars] = c;
+				markov_chars[markov_num_chars++] = (unsigned char)c;
+			}
+
+	for (uint32_t prev = 0; prev <= markov_num_chars; prev++)
+	{
+		const uint32_t* count = markov_train_count + 256 * (prev < markov_num_chars ? char_index[prev] : 256);
+		double total = markov_num_chars;
+
+		for (uint32_t i = 0; i < markov_num_chars; i++)
+			total += count[char_index[i]];
+
+		// Laplace smoothing: all transitions are possible
+		for (uint32_t i = 0; i < markov_num_chars; i++)
+			cost[i] = (uint16_t)(MARKOV_COST_SCALE * log(total / (count[char_index[i]] + 1)) / log(2.0) + 0.5);
+
+		// Order by cost with insertion sort. Chars with the same cost maintain the order
+		for (uint32_t i = 0; i < markov_num_chars; i++)
+		{
+			uint32_t j = i;
+			for (; j > 0 && markov_order_cost[prev][j - 1] > cost[i]; j--)
+			{
+				markov_order[prev][j] = markov_order[prev][j - 1];
+				markov_order_cost[prev][j] = markov_order_cost[prev][j - 1];
+			}
+			markov_order[prev][j] = (unsigned char)i;
+			markov_order_cost[prev][j] = cost[i];
+		}
+	}
+}
+// Count the keys. Reduce the level if some count overflow
+PRIVATE void markov_calculate_counts()
+{
+	uint32_t num_prev = markov_num_chars + 1;
+	int32_t level_overflow = markov_level + 1;
+
+	markov_counts_stride = markov_level + 1;
+	markov_counts = (int64_t*)malloc((max_lenght + 1) * num_prev * markov_counts_stride * sizeof(int64_t));
+	if (!markov_counts)
+	{
+		hs_log(HS_LOG_ERROR, "Markov", "Not enough memory for level %i", markov_level);
+		markov_level = -1;
+		return;
+	}
+
+	// Zero chars: only one key
+	for (uint32_t i = 0; i < num_prev * markov_counts_stride; i++)
+		markov_counts[i] = 1;
+
+	for (uint32_t k = 1; k <= max_lenght; k++)
+	{
+		const int64_t* last_counts = markov_counts + (k - 1) * num_prev * markov_counts_stride;
+		for (uint32_t prev = 0; prev < num_prev; prev++)
+		{
+			int64_t* counts = markov_counts + (k * num_prev + prev) * markov_counts_stride;
+			for (int32_t r = 0; r <= markov_level; r++)
+			{
+				int64_t sum = 0;
+				for (uint32_t p = 0; p < markov_num_chars && markov_order_cost[prev][p] <= r; p++)
+				{
+					sum += last_counts[markov_order[prev][p] * markov_counts_stride + r - markov_order_cost[prev][p]];
+					if (sum >= MARKOV_MAX_COUNT)
+					{
+						sum = MARKOV_MAX_COUNT;
+						if (r < level_overflow)
+							level_overflow = r;
+						break;
+					}
+				}
+				counts[r] = sum;
+			}
+		}
+	}
+
+	markov_level = level_overflow - 1;
+}
+// Number of 'k' chars after 'prev' with cost in (lo, hi]
+PRIVATE __forceinline int64_t markov_count_range(uint32_t k, uint32_t prev, int32_t lo, int32_t hi)
+{
+	const int64_t* counts = markov_counts + (k * (markov_num_chars + 1) + prev) * markov_counts_stride;
+
+	if (hi < 0) return 0;
+	return counts[hi] - (lo < 0 ? 0 : counts[lo]);
+}
+PRIVATE void markov_segment_limits(uint32_t segment, uint32_t* lenght, int32_t* lo, int32_t* hi)
+{
+	uint32_t num_lenghts = max_lenght - min_lenght + 1;
+	int32_t band = segment / num_lenghts;
+
+	*lenght = min_lenght + segment % num_lenghts;
+	*lo = band * MARKOV_BAND_WIDTH - 1;
+	*hi = __min((band + 1) * MARKOV_BAND_WIDTH - 1, markov_level);
+}
+// Put in the chunk the key with 'index' in his segment, changing from 'from_pos' onward
+PRIVATE void markov_unrank(MarkovChunk* chunk, uint32_t from_pos, int64_t index)
+{
+	for (uint32_t i = from_pos; i < chunk->lenght; i++)
+	{
+		uint32_t prev = i ? chunk->key[i - 1] : markov_num_chars;
+		uint32_t p = 0;
+
+		// Last char: valid chars are consecutive in the order
+		if (i == chunk->lenght - 1)
+		{
+			while (chunk->acc[i] + markov_order_cost[prev][p] <= chunk->lo)
+				p++;
+			p += (uint32_t)index;
+		}
+		else
+			for (; p < markov_num_chars - 1; p++)
+			{
+				int32_t cost = chunk->acc[i] + markov_order_cost[prev][p];
+				int64_t num = markov_count_range(chunk->lenght - 1 - i, markov_order[prev][p], chunk->lo - cost, chunk->hi - cost);
+
+				if (index < num) break;
+				index -= num;
+			}
+
+		chunk->pos[i] = p;
+		chunk->key[i] = markov_order[prev][p];
+		chunk->chars[i] = markov_chars[chunk->key[i]];
+		chunk->acc[i + 1] = chunk->acc[i] + markov_order_cost[prev][p];
+	}
+}
+// Next key in the segment. Return FALSE if the segment is finished
+PRIVATE __forceinline int markov_next_key(MarkovChunk* chunk)
+{
+	int32_t i = chunk->lenght - 1;
+	if (i < 0) return FALSE;
+
+	// Last char: valid chars are consecutive in the order
+	uint32_t prev = i ? chunk->key[i - 1] : markov_num_chars;
+	uint32_t p = chunk->pos[i] + 1u;
+	if (p < markov_num_chars && chunk->acc[i] + markov_order_cost[prev][p] <= chunk->hi)
+	{
+		chunk->pos[i] = p;
+		chunk->key[i] = markov_order[prev][p];
+		chunk->chars[i] = markov_chars[chunk->key[i]];
+		return TRUE;
+	}
+
+	// Change other chars
+	for (i--; i >= 0; i--)
+	{
+		prev = i ? chunk->key[i - 1] : markov_num_chars;
+		for (p = chunk->pos[i] + 1u; p < markov_num_chars; p++)
+		{
+			int32_t cost = chunk->acc[i] + markov_order_cost[prev][p];
+			if (cost > chunk->hi) break;
+
+			if (markov_count_range(chunk->lenght - 1 - i, markov_order[prev][p], chunk->lo - cost, chunk->hi - cost))
+			{
+				chunk->pos[i] = p;
+				chunk->key[i] = markov_order[prev][p];
+				chunk->chars[i] = markov_chars[chunk->key[i]];
+				chunk->acc[i + 1] = cost;
+				markov_unrank(chunk, i + 1, 0);
+				return TRUE;
+			}
+		}
+	}
+
+	return FALSE;
+}
+PRIVATE void markov_set_segment(MarkovChunk* chunk, uint32_t segment, int64_t index)
+{
+	chunk->segment = segment;
+	markov_segment_limits(segment, &chunk->lenght, &chunk->lo, &chunk->hi);
+	chunk->acc[0] = 0;
+	markov_unrank(chunk, 0, index);
+}
+// Reserve keys for the thread. Only part with syncronization
+PRIVATE int markov_reserve_chunk(MarkovChunk* chunk, int thread_id, uint32_t num_keys, int64_t batch_begin)
+{
+	uint32_t segment = 0;
+	int64_t index;
+
+	// The resume failed
+	if (!markov_segment_start) return FALSE;
+
+	HS_ENTER_MUTEX(&key_provider_mutex);
+
+	index = markov_current_index;
+	chunk->num_keys = (uint32_t)__min(__max(num_keys, CHARSET_KEYS_BY_CHUNK), markov_segment_start[markov_num_segments] - index);
+	markov_current_index += chunk->num_keys;
+	// Save the begin of the batch, that may be in the last chunk
+	((int64_t*)thread_params)[thread_id] = batch_begin >= 0 ? batch_begin : index;
+
+	HS_LEAVE_MUTEX(&key_provider_mutex);
+
+	// All keys generated
+	if (!chunk->num_keys) return FALSE;
+
+	// Binary search of the segment
+	for (uint32_t max_segment = markov_num_segments; segment + 1 < max_segment;)
+	{
+		uint32_t middle = (segment + max_segment) / 2;
+		if (markov_segment_start[middle] <= index)
+			segment = middle;
+		else
+			max_segment = middle;
+	}
+
+	chunk->index = index;
+	markov_set_segment(chunk, segment, index - markov_segment_start[segment]);
+	return TRUE;
+}
+PRIVATE __forceinline void markov_advance(MarkovChunk* chunk)
+{
+	chunk->index++;
+	if (--chunk->num_keys && !markov_next_key(chunk))
+	{
+		// Next non-empty segment
+		uint32_t segment = chunk->segment + 1;
+		while (markov_segment_start[segment + 1] == markov_segment_start[segment])
+			segment++;
+
+		markov_set_segment(chunk, segment, 0);
+	}
+}
+PRIVATE void markov_finish()
+{
+	free(markov_counts);
+	free(markov_segment_start);
+	markov_counts = NULL;
+	markov_segment_start = NULL;
+}
+// param: level[\nwordlist_id]. Without wordlist train with the found passwords
+PRIVATE void markov_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index)
+{
+	char* wordlist_id = strchr(param, '\n');
+	int64_t resume_index = 0;
+
+	markov_finish();
+	markov_to_upper = format_index == LM_INDEX;
+	markov_train_max_pk = -1;
+	// Empty key-space if the resume fails
+	markov_num_segments = 0;
+	markov_current_index = 0;
+	num_key_space = 0;
+
+	// Resume
+	if (resume_arg && strlen(resume_arg))
+		sscanf(resume_arg, "%lli:%lli", &resume_index, &markov_train_max_pk);
+
+	// Train
+	char train_source[64];
+	if (wordlist_id)
+		sprintf(train_source, "%i:w%.40s", markov_to_upper, wordlist_id + 1);
+	else
+	{
+		if (markov_train_max_pk < 0)
+		{
+			sqlite3_stmt* select_max;
+			sqlite3_prepare_v2(db, "SELECT MAX(PK) FROM FindHash;", -1, &select_max, NULL);
+			sqlite3_step(select_max);
+			markov_train_max_pk = sqlite3_column_int64(select_max, 0);
+			sqlite3_finalize(select_max);
+		}
+		sprintf(train_source, "%i:f%lli", markov_to_upper, markov_train_max_pk);
+	}
+	// Reuse the table if trained with the same data
+	if (strcmp(train_source, markov_train_source))
+	{
+		markov_train_count = (uint32_t*)calloc(257 * 256, sizeof(uint32_t));
+		if (!markov_train_count)
+		{
+			hs_log(HS_LOG_ERROR, "Markov", "Not enough memory to train");
+			markov_train_source[0] = 0;
+			return;
+		}
+		if (wordlist_id)
+		{
+			if (!wordlist_read_lines(wordlist_id + 1, MARKOV_MAX_LENGHT, markov_train_line))
+			{
+				hs_log(HS_LOG_ERROR, "Markov", "Can't read the plaintext wordlist to train");
+				free(markov_train_count);
+				markov_train_count = NULL;
+				markov_train_source[0] = 0;
+				return;
+			}
+		}
+		else
+		{
+			sqlite3_stmt* select_found;
+			sqlite3_prepare_v2(db, "SELECT ClearText FROM FindHash WHERE PK<=?;", -1, &select_found, NULL);
+			sqlite3_bind_int64(select_found, 1, markov_train_max_pk);
+			while (sqlite3_step(select_found) == SQLITE_ROW)
+				markov_train_line(sqlite3_column_text(select_found, 0), sqlite3_column_bytes(select_found, 0));
+			sqlite3_finalize(select_found);
+		}
+		markov_build_costs();
+		free(markov_train_count);
+		markov_train_count = NULL;
+		strcpy(markov_train_source, train_source);
+	}
+
+	min_lenght = pmin_lenght;
+	max_lenght = __min(pmax_lenght, MARKOV_MAX_LENGHT);
+	markov_level = atoi(param);
+	if (markov_level <= 0)
+		markov_level = MARKOV_DEFAULT_LEVEL;
+	markov_level = __min(markov_level, MARKOV_MAX_LEVEL);
+
+	markov_calculate_counts();
+
+	// Segments
+	markov_num_segments = 0;
+	if (markov_level >= 0 && min_lenght <= max_lenght)
+		markov_num_segments = (markov_level / MARKOV_BAND_WIDTH + 1) * (max_lenght - min_lenght + 1);
+
+	markov_segment_start = (int64_t*)malloc((markov_num_segments + 2) * sizeof(int64_t));
+	if (!markov_segment_start)
+	{
+		hs_log(HS_LOG_ERROR, "Markov", "Not enough memory for %u segments", markov_num_segments);
+		return;
+	}
+	markov_segment_start[0] = 0;
+	for (uint32_t i = 0; i < markov_num_segments; i++)
+	{
+		uint32_t lenght;
+		int32_t lo, hi;
+		markov_segment_limits(i, &lenght, &lo, &hi);
+
+		markov_segment_start[i + 1] = markov_segment_start[i] + markov_count_range(lenght, markov_num_chars, lo, hi);
+	}
+	// Sentinel used when finding the next non-empty segment
+	markov_segment_start[markov_num_segments + 1] = markov_segment_start[markov_num_segments] + 1;
+
+	markov_current_index = __min(resume_index, markov_segment_start[markov_num_segments]);
+	num_key_space = markov_segment_start[markov_num_segments] - markov_current_index;
+}
+PRIVATE void markov_save_resume_arg(char* resume_arg)
+{
+	int64_t old_index = markov_current_index;
+
+	if (thread_params)
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		// Find the most old saved data
+		for (uint32_t i = 0; i < num_thread_params; i++)
+			if (old_index > ((int64_t*)thread_params)[i])
+				old_index = ((int64_t*)thread_params)[i];
+
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+	}
+
+	sprintf(resume_arg, "%lli:%lli", old_index, markov_train_max_pk);
+}
+PRIVATE int markov_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	MarkovChunk* chunk = ((MarkovChunk*)(((int64_t*)thread_params) + num_thread_params)) + thread_id;
+	int64_t batch_begin = chunk->num_keys ? chunk->index : -1;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++)
+	{
+		if (!chunk->num_keys && !markov_reserve_chunk(chunk, thread_id, max_number - i, batch_begin))
+			break;
+
+		// Copy key to nt_buffer
+		uint32_t j = 0;
+		for (; j < chunk->lenght / 2; j++)
+			nt_buffer[j*max_number+i] = ((uint32_t)chunk->chars[2*j]) | ((uint32_t)chunk->chars[2*j+1]) << 16;
+
+		nt_buffer[j*max_number+i] = (chunk->lenght & 1) ? ((uint32_t)chunk->chars[2*j]) | 0x800000 : 0x80;
+		nt_buffer[14*max_number+i] = chunk->lenght << 4;
+
+		for (j++; j < 14; j++)
+			nt_buffer[j*max_number+i] = 0;
+
+		markov_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int markov_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	MarkovChunk* chunk = ((MarkovChunk*)(((int64_t*)thread_params) + num_thread_params)) + thread_id;
+	int64_t batch_begin = chunk->num_keys ? chunk->index : -1;
+	uint32_t i = 0;
+
+	memset(keys, 0, max_number*8);
+
+	for (; i < max_number; i++, keys += 8u)
+	{
+		if (!chunk->num_keys && !markov_reserve_chunk(chunk, thread_id, max_number - i, batch_begin))
+			break;
+
+		memcpy(keys, chunk->chars, __min(chunk->lenght, 8u));
+		markov_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int markov_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	MarkovChunk* chunk = ((MarkovChunk*)(((int64_t*)thread_params) + num_thread_params)) + thread_id;
+	int64_t batch_begin = chunk->num_keys ? chunk->index : -1;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++, keys += MAX_KEY_LENGHT_SMALL)
+	{
+		if (!chunk->num_keys && !markov_reserve_chunk(chunk, thread_id, max_number - i, batch_begin))
+			break;
+
+		memcpy(keys, chunk->chars, chunk->lenght);
+		keys[chunk->lenght] = 0;
+		markov_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int markov_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	MarkovChunk* chunk = ((MarkovChunk*)(((int64_t*)thread_params) + num_thread_params)) + thread_id;
+	int64_t batch_begin = chunk->num_keys ? chunk->index : -1;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++)
+	{
+		if (!chunk->num_keys && !markov_reserve_chunk(chunk, thread_id, max_number - i, batch_begin))
+			break;
+
+		convert_utf8_2_coalesc(chunk->chars, nt_buffer + i, max_number, chunk->lenght);
+		markov_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE void markov_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
+{
+	const char* wordlist_id = strchr(provider_param, '\n');
+	int level = atoi(provider_param);
+
+	if (level <= 0)
+		level = MARKOV_DEFAULT_LEVEL;
+
+	sprintf(description, " %i-%i [Level %i]", min_lenght, max_lenght, __min(level, MARKOV_MAX_LEVEL));
+	// Trained with a wordlist
+	if (wordlist_id)
+		wordlist_get_description(wordlist_id + 1, description + strlen(description), min_lenght, max_lenght);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// Hybrid mode
+////////////////////////////////////////////////////////////////////////////////////
+// Each word of a wordlist followed (or preceded) by all the keys of a mask. All positions of the
+// mask are used and change faster than the word. Words that don't fit in the lenght are skipped,
+// so the key-space is exact: the number of words used by the size of the mask.
+#define HYBRID_CHUNK_WORDS		256
+#define HYBRID_MAX_MASK_SIZE	(1LL << 48)
+
+PRIVATE int hybrid_prepend;
+PRIVATE int hybrid_wordlist_open = FALSE;
+PRIVATE int64_t hybrid_mask_size;
+PRIVATE uint32_t hybrid_min_word_lenght;
+PRIVATE uint32_t hybrid_max_word_lenght;
+// Next keys to reserve: the word, his position in the wordlist and the index in the mask
+PRIVATE HS_ALIGN(16) unsigned char hybrid_word[MAX_KEY_LENGHT_BIG + 4];
+PRIVATE uint32_t hybrid_word_lenght;// 0 when all words are reserved
+PRIVATE int64_t hybrid_word_pos;
+PRIVATE int64_t hybrid_mask_index;
+// Words counted from a position: the same while the position is before the first word that fit.
+// Cached because resume is called for the key-space, the self-test and the attack
+PRIVATE char hybrid_count_source[64] = "";
+PRIVATE int64_t hybrid_count_begin, hybrid_count_first, hybrid_count_words;
+
+// Keys reserved by a thread. Stored in 'thread_params' after the position and mask index saved by thread
+typedef struct HybridChunk
+{
+	uint32_t num_keys;
+	uint32_t num_words;
+	uint32_t current;// Current word
+	uint32_t lenght;// Lenght of the current key
+	uint32_t mask_offset;// Position of the mask in the key
+	int64_t mask_index;// Mask index of the current key
+	unsigned char mask_key[MASK_MAX_POSITIONS];// Index in mask_charset by position
+	unsigned char chars[MAX_KEY_LENGHT_BIG + 4];// The current key
+	int64_t word_pos[HYBRID_CHUNK_WORDS];
+	unsigned char word_lenght[HYBRID_CHUNK_WORDS];
+	unsigned char words[HYBRID_CHUNK_WORDS][MAX_KEY_LENGHT_BIG];
+}
+HybridChunk;
+
+// Read the next word that fit. Need the mutex
+PRIVATE int hybrid_next_word(unsigned char* word, uint32_t* word_lenght, int64_t* word_pos)
+{
+	for (;;)
+	{
+		*word_pos = wordlist_get_position();
+		int lenght = wordlist_getline(word, max_lenght);
+		// All words read
+		if (lenght < 0)
+			return FALSE;
+
+		if ((uint32_t)lenght >= hybrid_min_word_lenght && (uint32_t)lenght <= hybrid_max_word_lenght)
+		{
+			if (mask_to_upper)
+				_strupr(word);
+
+			*word_lenght = lenght;
+			return TRUE;
+		}
+	}
+}
+// The mask index is saved in the chunks: limit his size. Return the number of positions used
+PRIVATE uint32_t hybrid_limit_mask(uint32_t num_positions, const uint32_t* charset_size, int64_t* mask_size)
+{
+	*mask_size = 1;
+	for (uint32_t i = 0; i < num_positions; i++)
+	{
+		if (*mask_size * charset_size[i] > HYBRID_MAX_MASK_SIZE)
+			return i;
+
+		*mask_size *= charset_size[i];
+	}
+
+	return num_positions;
+}
+// Put in the chunk the current word with the current mask key
+PRIVATE void hybrid_set_key(HybridChunk* chunk)
+{
+	uint32_t word_lenght = chunk->word_lenght[chunk->current];
+
+	chunk->lenght = word_lenght + mask_num_positions;
+	chunk->mask_offset = hybrid_prepend ? 0 : word_lenght;
+	memcpy(chunk->chars + (hybrid_prepend ? mask_num_positions : 0), chunk->words[chunk->current], word_lenght);
+
+	for (uint32_t i = 0; i < mask_num_positions; i++)
+		chunk->chars[chunk->mask_offset + i] = mask_charset[i][chunk->mask_key[i]];
+
+	chunk->chars[chunk->lenght] = 0;
+}
+// Reserve keys for the thread. Only part with syncronization
+PRIVATE int hybrid_reserve_chunk(HybridChunk* chunk, int thread_id, uint32_t num_keys, int64_t batch_pos, int64_t batch_mask_index)
+{
+	int64_t* current_save = ((int64_t*)thread_params) + 2 * thread_id;
+	int64_t mask_index;
+
+	num_keys = __max(num_keys, CHARSET_KEYS_BY_CHUNK);
+
+	HS_ENTER_MUTEX(&key_provider_mutex);
+
+	// Save the begin of the batch, that may be in the last chunk
+	current_save[0] = batch_pos >= 0 ? batch_pos : hybrid_word_pos;
+	current_save[1] = batch_pos >= 0 ? batch_mask_index : hybrid_mask_index;
+
+	mask_index = hybrid_mask_index;
+	for (chunk->num_keys = 0, chunk->num_words = 0; hybrid_word_lenght && chunk->num_keys < num_keys && chunk->num_words < HYBRID_CHUNK_WORDS; chunk->num_words++)
+	{
+		int64_t num = __min(hybrid_mask_size - hybrid_mask_index, (int64_t)(num_keys - chunk->num_keys));
+
+		memcpy(chunk->words[chunk->num_words], hybrid_word, hybrid_word_lenght);
+		chunk->word_lenght[chunk->num_words] = hybrid_word_lenght;
+		chunk->word_pos[chunk->num_words] = hybrid_word_pos;
+		chunk->num_keys += (uint32_t)num;
+		hybrid_mask_index += num;
+
+		// Next word
+		if (hybrid_mask_index == hybrid_mask_size)
+		{
+			hybrid_mask_index = 0;
+			if (!hybrid_next_word(hybrid_word, &hybrid_word_lenght, &hybrid_word_pos))
+				hybrid_word_lenght = 0;
+		}
+	}
+
+	HS_LEAVE_MUTEX(&key_provider_mutex);
+
+	// All keys generated
+	if (!chunk->num_keys) return FALSE;
+
+	chunk->current = 0;
+	chunk->mask_index = mask_index;
+	for (uint32_t i = 0; i < mask_num_positions; i++)
+	{
+		chunk->mask_key[i] = (unsigned char)(mask_index % mask_charset_size[i]);
+		mask_index /= mask_charset_size[i];
+	}
+	hybrid_set_key(chunk);
+
+	return TRUE;
+}
+PRIVATE __forceinline void hybrid_advance(HybridChunk* chunk)
+{
+	if (--chunk->num_keys)
+	{
+		uint32_t j = 0;
+		chunk->mask_index++;
+
+		while (++chunk->mask_key[j] == mask_charset_size[j])
+		{
+			chunk->mask_key[j] = 0;
+			chunk->chars[chunk->mask_offset + j] = mask_charset[j][0];
+
+			// Next word
+			if (++j == mask_num_positions)
+			{
+				chunk->current++;
+				chunk->mask_index = 0;
+				hybrid_set_key(chunk);
+				return;
+			}
+		}
+		chunk->chars[chunk->mask_offset + j] = mask_charset[j][chunk->mask_key[j]];
+	}
+}
+PRIVATE void hybrid_finish()
+{
+	if (hybrid_wordlist_open)
+		key_providers[WORDLIST_INDEX].finish();
+
+	hybrid_wordlist_open = FALSE;
+}
+// param: [-]wordlist_id\nmask[\ncustom1[\ncustom2[\ncustom3[\ncustom4]]]]. With '-' the mask is before the word
+PRIVATE void hybrid_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index)
+{
+	const char* mask = strchr(param, '\n');
+	char resume_pos[32];
+	char count_source[64];
+	int64_t num_words = 0;
+
+	hybrid_finish();
+	hybrid_prepend = param[0] == '-';
+	mask_to_upper = format_index == LM_INDEX;
+	mask_parse(mask ? mask + 1 : "");
+
+	uint32_t num_positions_used = hybrid_limit_mask(mask_num_positions, mask_charset_size, &hybrid_mask_size);
+	if (num_positions_used < mask_num_positions)
+	{
+		hs_log(HS_LOG_WARNING, "Hybrid", "Mask too big: only the first %u of %u positions are used", num_positions_used, mask_num_positions);
+		mask_num_positions = num_positions_used;
+	}
+
+	hybrid_min_word_lenght = __max(1, pmin_lenght - (int)mask_num_positions);
+	hybrid_max_word_lenght = __max(0, pmax_lenght - (int)mask_num_positions);
+	if (!mask_num_positions)
+		hybrid_max_word_lenght = 0;
+
+	// Resume
+	resume_pos[0] = 0;
+	hybrid_mask_index = 0;
+	if (resume_arg && strlen(resume_arg))
+	{
+		int64_t pos = 0;
+		sscanf(resume_arg, "%lli:%lli", &pos, &hybrid_mask_index);
+		sprintf(resume_pos, "%lli", pos);
+	}
+
+	// Count the words to know the exact key-space
+	sprintf(count_source, "%.*s:%u-%u", __min((int)strcspn(param + hybrid_prepend, "\n"), 40), param + hybrid_prepend, hybrid_min_word_lenght, hybrid_max_word_lenght);
+	wordlist_resume(pmin_lenght, pmax_lenght, param + hybrid_prepend, resume_pos, format_index);
+	hybrid_wordlist_open = TRUE;
+	int64_t count_begin = wordlist_get_position();
+	if (strcmp(count_source, hybrid_count_source) || count_begin < hybrid_count_begin || count_begin > hybrid_count_first)
+	{
+		hybrid_count_first = LLONG_MAX;
+		while (hybrid_max_word_lenght && hybrid_next_word(hybrid_word, &hybrid_word_lenght, &hybrid_word_pos))
+		{
+			if (!num_words)
+				hybrid_count_first = hybrid_word_pos;
+			num_words++;
+		}
+		hybrid_finish();
+
+		strcpy(hybrid_count_source, count_source);
+		hybrid_count_begin = count_begin;
+		hybrid_count_words = num_words;
+
+		wordlist_resume(pmin_lenght, pmax_lenght, param + hybrid_prepend, resume_pos, format_index);
+		hybrid_wordlist_open = TRUE;
+	}
+	else
+		num_words = hybrid_count_words;
+
+	hybrid_word_lenght = 0;
+	hybrid_word_pos = wordlist_get_position();
+	if (num_words && !hybrid_next_word(hybrid_word, &hybrid_word_lenght, &hybrid_word_pos))
+		hybrid_word_lenght = 0;
+
+	hybrid_mask_index = __max(0, __min(hybrid_mask_index, hybrid_mask_size - 1));
+
+	// Calculate the key-space
+	if (!num_words)
+		num_key_space = 0;
+	else if (num_words > 0x7FFFFFFFFFFFFFFF / hybrid_mask_size)
+		num_key_space = KEY_SPACE_UNKNOW;
+	else
+		num_key_space = num_words * hybrid_mask_size - hybrid_mask_index;
+}
+// resume_arg: wordlist_position:mask_index
+PRIVATE void hybrid_save_resume_arg(char* resume_arg)
+{
+	int64_t old_pos = hybrid_word_pos;
+	int64_t old_mask_index = hybrid_mask_index;
+
+	if (thread_params)
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		// Find the most old saved data
+		for (uint32_t i = 0; i < num_thread_params; i++)
+		{
+			int64_t* save = ((int64_t*)thread_params) + 2 * i;
+			if (old_pos > save[0] || (old_pos == save[0] && old_mask_index > save[1]))
+			{
+				old_pos = save[0];
+				old_mask_index = save[1];
+			}
+		}
+
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+	}
+
+	sprintf(resume_arg, "%lli:%lli", old_pos, old_mask_index);
+}
+PRIVATE int hybrid_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	HybridChunk* chunk = ((HybridChunk*)(((int64_t*)thread_params) + 2 * num_thread_params)) + thread_id;
+	int64_t batch_pos = chunk->num_keys ? chunk->word_pos[chunk->current] : -1;
+	int64_t batch_mask_index = chunk->mask_index;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++)
+	{
+		if (!chunk->num_keys && !hybrid_reserve_chunk(chunk, thread_id, max_number - i, batch_pos, batch_mask_index))
+			break;
+
+		// Copy key to nt_buffer
+		uint32_t j = 0;
+		for (; j < chunk->lenght / 2; j++)
+			nt_buffer[j*max_number+i] = ((uint32_t)chunk->chars[2*j]) | ((uint32_t)chunk->chars[2*j+1]) << 16;
+
+		nt_buffer[j*max_number+i] = (chunk->lenght & 1) ? ((uint32_t)chunk->chars[2*j]) | 0x800000 : 0x80;
+		nt_buffer[14*max_number+i] = chunk->lenght << 4;
+
+		for (j++; j < 14; j++)
+			nt_buffer[j*max_number+i] = 0;
+
+		hybrid_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int hybrid_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	HybridChunk* chunk = ((HybridChunk*)(((int64_t*)thread_params) + 2 * num_thread_params)) + thread_id;
+	int64_t batch_pos = chunk->num_keys ? chunk->word_pos[chunk->current] : -1;
+	int64_t batch_mask_index = chunk->mask_index;
+	uint32_t i = 0;
+
+	memset(keys, 0, max_number*8);
+
+	for (; i < max_number; i++, keys += 8u)
+	{
+		if (!chunk->num_keys && !hybrid_reserve_chunk(chunk, thread_id, max_number - i, batch_pos, batch_mask_index))
+			break;
+
+		memcpy(keys, chunk->chars, __min(chunk->lenght, 8u));
+		hybrid_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int hybrid_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	HybridChunk* chunk = ((HybridChunk*)(((int64_t*)thread_params) + 2 * num_thread_params)) + thread_id;
+	int64_t batch_pos = chunk->num_keys ? chunk->word_pos[chunk->current] : -1;
+	int64_t batch_mask_index = chunk->mask_index;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++, keys += MAX_KEY_LENGHT_SMALL)
+	{
+		if (!chunk->num_keys && !hybrid_reserve_chunk(chunk, thread_id, max_number - i, batch_pos, batch_mask_index))
+			break;
+
+		memcpy(keys, chunk->chars, chunk->lenght);
+		keys[chunk->lenght] = 0;
+		hybrid_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int hybrid_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	HybridChunk* chunk = ((HybridChunk*)(((int64_t*)thread_params) + 2 * num_thread_params)) + thread_id;
+	int64_t batch_pos = chunk->num_keys ? chunk->word_pos[chunk->current] : -1;
+	int64_t batch_mask_index = chunk->mask_index;
+	uint32_t i = 0;
+
+	for (; i < max_number; i++)
+	{
+		if (!chunk->num_keys && !hybrid_reserve_chunk(chunk, thread_id, max_number - i, batch_pos, batch_mask_index))
+			break;
+
+		convert_utf8_2_coalesc(chunk->chars, nt_buffer + i, max_number, chunk->lenght);
+		hybrid_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE void hybrid_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
+{
+	const char* mask = strchr(provider_param, '\n');
+	int prepend = provider_param[0] == '-';
+	char mask_description[48];
+
+	mask_description[0] = 0;
+	if (mask)
+	{
+		int mask_lenght = (int)strcspn(mask + 1, "\n");
+		sprintf(mask_description, " [%.*s%s]", __min(mask_lenght, 20), mask + 1, mask_lenght > 20 ? "..." : "");
+
+		// Show when the mask is limited
+		unsigned char charset[MAX_KEY_LENGHT_BIG][256];
+		uint32_t charset_size[MAX_KEY_LENGHT_BIG];
+		int64_t mask_size;
+		uint32_t num_positions = mask_parse_charsets(mask + 1, charset, charset_size);
+		uint32_t num_positions_used = hybrid_limit_mask(num_positions, charset_size, &mask_size);
+		if (num_positions_used < num_positions)
+			sprintf(mask_description + strlen(mask_description) - 1, ", first %u used]", num_positions_used);
+	}
+
+	description[0] = 0;
+	if (prepend)
+		strcpy(description, mask_description);
+	wordlist_get_description(provider_param + prepend, description + strlen(description), min_lenght, max_lenght);
+	if (!prepend)
+		strcat(description, mask_description);
+}
+
+////////////////////////////////////////////////////////////////////////////////////
+// Combinator mode
+////////////////////////////////////////////////////////////////////////////////////
+// Each word of the left wordlist, a separator and each word of the right wordlist. The right
+// wordlist is loaded by blocks and the left wordlist is read once by block, so big wordlists
+// don't need to be in memory. Inside a block the right word change faster, then the separator.
+// Combinations out of the lenght limits are skipped, but counted by lenght to get the exact key-space.
+#define COMBINATOR_BLOCK_WORDS				(1 << 18)
+#define COMBINATOR_CHUNK_WORDS				256
+#define COMBINATOR_MAX_SEPARATORS			32
+#define COMBINATOR_MAX_SEPARATOR_LENGHT		8
+
+// Words of the right wordlist. Freed when no thread use them
+typedef struct CombinatorBlock
+{
+	struct CombinatorBlock* next;// List of blocks allocated
+	uint32_t num_references;
+	uint32_t num_words;
+	int64_t pos;// Position in the right wordlist of the first word
+	unsigned char (*words)[MAX_KEY_LENGHT_BIG];
+	unsigned char* lenghts;
+}
+CombinatorBlock;
+
+PRIVATE char combinator_left_id[16];
+PRIVATE char combinator_right_id[16];
+PRIVATE unsigned char combinator_separators[COMBINATOR_MAX_SEPARATORS][COMBINATOR_MAX_SEPARATOR_LENGHT];
+PRIVATE uint32_t combinator_separators_lenght[COMBINATOR_MAX_SEPARATORS];
+PRIVATE uint32_t combinator_num_separators;
+PRIVATE int combinator_to_upper;
+// Copy of the limits: opening a wordlist changes min_lenght and max_lenght while other threads generate keys
+PRIVATE uint32_t combinator_min_lenght;
+PRIVATE uint32_t combinator_max_lenght;
+PRIVATE int combinator_wordlist_open = FALSE;
+PRIVATE CombinatorBlock* combinator_blocks = NULL;
+// Next keys to reserve: the block, the left word and the index inside the block
+PRIVATE CombinatorBlock* combinator_block = NULL;// NULL when all keys are reserved
+PRIVATE int64_t combinator_block_pos;
+PRIVATE int64_t combinator_next_block_pos;
+PRIVATE int64_t combinator_right_words_left;// Words of the right wordlist after the block
+PRIVATE HS_ALIGN(16) unsigned char combinator_word[MAX_KEY_LENGHT_BIG + 4];
+PRIVATE uint32_t combinator_word_lenght;
+PRIVATE int64_t combinator_word_pos;
+PRIVATE int64_t combinator_index;
+// The next block is loaded without the mutex. Threads that need a new chunk wait for it
+PRIVATE int combinator_loading = FALSE;
+PRIVATE HS_COND combinator_loaded;
+
+// Words counted by lenght. Cached because resume is called for the key-space, the self-test and the attack
+typedef struct CombinatorCounts
+{
+	char source[48];// Wordlists and max lenght
+	int64_t block_pos;// Right words counted from here
+	int64_t resume_pos;// Left words resumed from here: the same counts until the first left word
+	int64_t left_first;
+	int64_t num_left, num_block, num_rest;
+	int64_t left_all[MAX_KEY_LENGHT_BIG];
+	int64_t left_resumed[MAX_KEY_LENGHT_BIG];
+	int64_t right_block[MAX_KEY_LENGHT_BIG];
+	int64_t right_rest[MAX_KEY_LENGHT_BIG];
+}
+CombinatorCounts;
+PRIVATE CombinatorCounts combinator_counts;
+
+// Keys reserved by a thread. Stored in 'thread_params' after the block position, word position and index saved by thread
+typedef struct CombinatorChunk
+{
+	CombinatorBlock* block;
+	uint32_t num_keys;// Combinations, including the ones out of the lenght limits
+	uint32_t num_words;
+	uint32_t current;// Current left word
+	uint32_t separator;
+	uint32_t right;// Current right word
+	uint32_t prefix_lenght;// Lenght of the left word plus the separator
+	int64_t index;// Index of the current combination: separator * block words + right word
+	unsigned char chars[2 * MAX_KEY_LENGHT_BIG + COMBINATOR_MAX_SEPARATOR_LENGHT];// The current key
+	int64_t word_pos[COMBINATOR_CHUNK_WORDS];
+	unsigned char word_lenght[COMBINATOR_CHUNK_WORDS];
+	unsigned char words[COMBINATOR_CHUNK_WORDS][MAX_KEY_LENGHT_BIG];
+}
+CombinatorChunk;
+
+PRIVATE void combinator_open(char* wordlist_id, int64_t pos)
+{
+	char resume_pos[32];
+	sprintf(resume_pos, "%lli", pos);
+
+	wordlist_resume(combinator_min_lenght, combinator_max_lenght, wordlist_id, resume_pos, 0);
+	combinator_wordlist_open = TRUE;
+}
+PRIVATE void combinator_close()
+{
+	if (combinator_wordlist_open)
+		key_providers[WORDLIST_INDEX].finish();
+
+	combinator_wordlist_open = FALSE;
+}
+// Read the next word of the wordlist opened
+PRIVATE int combinator_next_word(unsigned char* word, uint32_t* word_lenght, int64_t* word_pos)
+{
+	for (;;)
+	{
+		*word_pos = wordlist_get_position();
+		int lenght = wordlist_getline(word, combinator_max_lenght);
+		// All words read
+		if (lenght < 0)
+			return FALSE;
+
+		if (lenght && (uint32_t)lenght < combinator_max_lenght)
+		{
+			if (combinator_to_upper)
+				_strupr(word);
+
+			*word_lenght = lenght;
+			return TRUE;
+		}
+	}
+}
+PRIVATE void combinator_release_block(CombinatorBlock* block)
+{
+	if (block && !--block->num_references)
+	{
+		CombinatorBlock** ptr = &combinator_blocks;
+		while (*ptr != block)
+			ptr = &(*ptr)->next;
+
+		*ptr = block->next;
+		free(block);
+	}
+}
+// Load 'num_words' words of the right wordlist. Return NULL if out of memory.
+// Don't touch 'combinator_blocks': the caller add the block with the mutex
+PRIVATE CombinatorBlock* combinator_load_block(int64_t pos, uint32_t num_words, int64_t* next_block_pos)
+{
+	HS_ALIGN(16) unsigned char word[MAX_KEY_LENGHT_BIG + 4];
+	uint32_t word_lenght;
+	int64_t word_pos;
+
+	CombinatorBlock* block = (CombinatorBlock*)malloc(sizeof(CombinatorBlock) + num_words * (MAX_KEY_LENGHT_BIG + 1));
+	if (!block)
+	{
+		hs_log(HS_LOG_ERROR, "Combinator", "Not enough memory to load %u words", num_words);
+		return NULL;
+	}
+	block->words = (unsigned char(*)[MAX_KEY_LENGHT_BIG])(block + 1);
+	block->lenghts = (unsigned char*)(block->words + num_words);
+	block->pos = pos;
+	block->num_references = 1;
+	block->next = NULL;
+
+	combinator_open(combinator_right_id, pos);
+	for (block->num_words = 0; block->num_words < num_words && combinator_next_word(word, &word_lenght, &word_pos); block->num_words++)
+	{
+		memcpy(block->words[block->num_words], word, word_lenght);
+		block->lenghts[block->num_words] = word_lenght;
+	}
+	*next_block_pos = wordlist_get_position();
+	combinator_close();
+
+	return block;
+}
+// Start the next block from the first left word. Called with the mutex, but release it
+// while reading the wordlists: the other threads keep generating keys from their chunks
+PRIVATE void combinator_next_block()
+{
+	HS_ALIGN(16) unsigned char word[MAX_KEY_LENGHT_BIG + 4];
+	uint32_t word_lenght = 0;
+	int64_t word_pos = 0, next_block_pos = 0;
+	uint32_t num_words = (uint32_t)__min(combinator_right_words_left, COMBINATOR_BLOCK_WORDS);
+
+	combinator_close();
+	combinator_release_block(combinator_block);
+	combinator_block = NULL;
+	combinator_block_pos = combinator_next_block_pos;
+	combinator_word_pos = 0;
+	combinator_index = 0;
+
+	if (!num_words) return;
+
+	// Only this thread use the wordlists until 'combinator_loading' is cleared
+	combinator_loading = TRUE;
+	HS_LEAVE_MUTEX(&key_provider_mutex);
+
+	CombinatorBlock* block = combinator_load_block(combinator_block_pos, num_words, &next_block_pos);
+	int has_word = block && block->num_words;
+	if (has_word)
+	{
+		combinator_open(combinator_left_id, 0);
+		has_word = combinator_next_word(word, &word_lenght, &word_pos);
+	}
+	if (!has_word)
+		combinator_close();
+
+	HS_ENTER_MUTEX(&key_provider_mutex);
+
+	if (has_word)
+	{
+		block->next = combinator_blocks;
+		combinator_blocks = block;
+		combinator_block = block;
+		combinator_right_words_left -= block->num_words;
+		combinator_next_block_pos = next_block_pos;
+
+		memcpy(combinator_word, word, word_lenght);
+		combinator_word_lenght = word_lenght;
+		combinator_word_pos = word_pos;
+	}
+	else// All keys generated
+	{
+		free(block);
+		combinator_right_words_left = 0;
+	}
+
+	combinator_loading = FALSE;
+	HS_WAKE_ALL_COND(&combinator_loaded);
+}
+PRIVATE void combinator_set_prefix(CombinatorChunk* chunk)
+{
+	uint32_t word_lenght = chunk->word_lenght[chunk->current];
+
+	memcpy(chunk->chars, chunk->words[chunk->current], word_lenght);
+	memcpy(chunk->chars + word_lenght, combinator_separators[chunk->separator], combinator_separators_lenght[chunk->separator]);
+	chunk->prefix_lenght = word_lenght + combinator_separators_lenght[chunk->separator];
+}
+// Reserve keys for the thread. Only part with syncronization
+PRIVATE int combinator_reserve_chunk(CombinatorChunk* chunk, int thread_id, uint32_t num_keys, const int64_t* batch_begin)
+{
+	int64_t* current_save = ((int64_t*)thread_params) + 3 * thread_id;
+	int64_t index;
+
+	num_keys = __max(num_keys, CHARSET_KEYS_BY_CHUNK);
+
+	HS_ENTER_MUTEX(&key_provider_mutex);
+
+	// Other thread is loading the next block
+	while (combinator_loading && continue_attack)
+		HS_WAIT_COND_MS(&combinator_loaded, &key_provider_mutex, 100);
+
+	// Save the begin of the batch, that may be in the last chunk
+	if (batch_begin)
+		memcpy(current_save, batch_begin, 3 * sizeof(int64_t));
+	else
+	{
+		current_save[0] = combinator_block_pos;
+		current_save[1] = combinator_word_pos;
+		current_save[2] = combinator_index;
+	}
+
+	combinator_release_block(chunk->block);
+	chunk->block = combinator_block;
+	if (chunk->block)
+		chunk->block->num_references++;
+
+	// All keys of the chunk are in the same block
+	index = combinator_index;
+	for (chunk->num_keys = 0, chunk->num_words = 0; chunk->block && combinator_block == chunk->block && chunk->num_keys < num_keys && chunk->num_words < COMBINATOR_CHUNK_WORDS; chunk->num_words++)
+	{
+		int64_t block_size = ((int64_t)chunk->block->num_words) * combinator_num_separators;
+		int64_t num = __min(block_size - combinator_index, (int64_t)(num_keys - chunk->num_keys));
+
+		memcpy(chunk->words[chunk->num_words], combinator_word, combinator_word_lenght);
+		chunk->word_lenght[chunk->num_words] = combinator_word_lenght;
+		chunk->word_pos[chunk->num_words] = combinator_word_pos;
+		chunk->num_keys += (uint32_t)num;
+		combinator_index += num;
+
+		// Next left word
+		if (combinator_index == block_size)
+		{
+			combinator_index = 0;
+			if (!combinator_next_word(combinator_word, &combinator_word_lenght, &combinator_word_pos))
+				combinator_next_block();
+		}
+	}
+
+	HS_LEAVE_MUTEX(&key_provider_mutex);
+
+	// All keys generated
+	if (!chunk->num_keys) return FALSE;
+
+	chunk->current = 0;
+	chunk->index = index;
+	chunk->separator = (uint32_t)(index / chunk->block->num_words);
+	chunk->right = (uint32_t)(index % chunk->block->num_words);
+	combinator_set_prefix(chunk);
+
+	return TRUE;
+}
+PRIVATE __forceinline void combinator_advance(CombinatorChunk* chunk)
+{
+	if (--chunk->num_keys)
+	{
+		chunk->index++;
+		if (++chunk->right == chunk->block->num_words)
+		{
+			chunk->right = 0;
+
+			// Next left word
+			if (++chunk->separator == combinator_num_separators)
+			{
+				chunk->separator = 0;
+				chunk->current++;
+				chunk->index = 0;
+			}
+			combinator_set_prefix(chunk);
+		}
+	}
+}
+// Put the right word after the prefix. Return FALSE if out of the lenght limits
+PRIVATE __forceinline int combinator_get_key(CombinatorChunk* chunk, uint32_t* lenght)
+{
+	uint32_t right_lenght = chunk->block->lenghts[chunk->right];
+	*lenght = chunk->prefix_lenght + right_lenght;
+
+	if (*lenght < combinator_min_lenght || *lenght > combinator_max_lenght)
+		return FALSE;
+
+	memcpy(chunk->chars + chunk->prefix_lenght, chunk->block->words[chunk->right], right_lenght);
+	chunk->chars[*lenght] = 0;
+	return TRUE;
+}
+PRIVATE void combinator_finish()
+{
+	combinator_close();
+
+	while (combinator_blocks)
+	{
+		CombinatorBlock* next = combinator_blocks->next;
+		free(combinator_blocks);
+		combinator_blocks = next;
+	}
+	combinator_block = NULL;
+}
+// Number of combinations inside the lenght limits of words with the 'left' and 'right' count by lenght
+PRIVATE int64_t combinator_count(const int64_t* left, const int64_t* right)
+{
+	int64_t count = 0;
+
+	for (uint32_t i = 1; i < MAX_KEY_LENGHT_BIG; i++)
+		for (uint32_t j = 1; j < MAX_KEY_LENGHT_BIG; j++)
+			if (left[i] && right[j])
+				for (uint32_t k = 0; k < combinator_num_separators; k++)
+				{
+					uint32_t lenght = i + combinator_separators_lenght[k] + j;
+					if (lenght >= combinator_min_lenght && lenght <= combinator_max_lenght)
+						count += left[i] * right[j];
+				}
+
+	return count;
+}
+// param: left_wordlist_id\nright_wordlist_id[\nseparator1[\nseparator2...]]. Without separators the words are joined
+PRIVATE void combinator_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index)
+{
+	CombinatorCounts* counts = &combinator_counts;
+	int64_t resume_pos = 0;
+	HS_ALIGN(16) unsigned char word[MAX_KEY_LENGHT_BIG + 4];
+	uint32_t word_lenght;
+	int64_t word_pos;
+	char count_source[48];
+	const char* right_id = strchr(param, '\n');
+
+	combinator_finish();
+	combinator_to_upper = format_index == LM_INDEX;
+	min_lenght = combinator_min_lenght = pmin_lenght;
+	max_lenght = combinator_max_lenght = pmax_lenght;
+	num_key_space = 0;
+	combinator_block_pos = combinator_next_block_pos = 0;
+	combinator_word_pos = 0;
+	combinator_index = 0;
+
+	if (!right_id) return;
+
+	sprintf(combinator_left_id, "%i", atoi(param));
+	sprintf(combinator_right_id, "%i", atoi(right_id + 1));
+
+	// Separators
+	const char* separator = strchr(right_id + 1, '\n');
+	combinator_num_separators = 0;
+	combinator_separators_lenght[0] = 0;
+	for (; separator && combinator_num_separators < COMBINATOR_MAX_SEPARATORS; combinator_num_separators++)
+	{
+		separator++;
+		uint32_t lenght = (uint32_t)strcspn(separator, "\n");
+		if (lenght > COMBINATOR_MAX_SEPARATOR_LENGHT)
+		{
+			hs_log(HS_LOG_WARNING, "Combinator", "Separator %u cut to %i chars", combinator_num_separators + 1, COMBINATOR_MAX_SEPARATOR_LENGHT);
+			lenght = COMBINATOR_MAX_SEPARATOR_LENGHT;
+		}
+
+		memcpy(combinator_separators[combinator_num_separators], separator, lenght);
+		for (uint32_t i = 0; combinator_to_upper && i < lenght; i++)
+			combinator_separators[combinator_num_separators][i] = (unsigned char)toupper(combinator_separators[combinator_num_separators][i]);
+		combinator_separators_lenght[combinator_num_separators] = lenght;
+
+		separator = strchr(separator, '\n');
+	}
+	if (separator)
+		hs_log(HS_LOG_WARNING, "Combinator", "Only the first %i separators are used", COMBINATOR_MAX_SEPARATORS);
+	combinator_num_separators = __max(1, combinator_num_separators);
+
+	// Resume
+	if (resume_arg && strlen(resume_arg))
+		sscanf(resume_arg, "%lli:%lli:%lli", &combinator_block_pos, &resume_pos, &combinator_index);
+
+	// Count the words by lenght to know the exact key-space
+	sprintf(count_source, "%s:%s:%u", combinator_left_id, combinator_right_id, combinator_max_lenght);
+	if (strcmp(count_source, counts->source) || combinator_block_pos != counts->block_pos ||
+		(resume_pos != counts->resume_pos && __max(resume_pos, counts->resume_pos) > counts->left_first))
+	{
+		memset(counts, 0, sizeof(CombinatorCounts));
+		counts->left_first = LLONG_MAX;
+
+		combinator_open(combinator_left_id, 0);
+		for (; combinator_next_word(word, &word_lenght, &word_pos); counts->num_left++)
+		{
+			if (!counts->num_left)
+				counts->left_first = word_pos;
+			counts->left_all[word_lenght]++;
+			if (word_pos >= resume_pos)
+				counts->left_resumed[word_lenght]++;
+		}
+		combinator_close();
+
+		combinator_open(combinator_right_id, combinator_block_pos);
+		while (combinator_next_word(word, &word_lenght, &word_pos))
+			if (counts->num_block < COMBINATOR_BLOCK_WORDS)
+			{
+				counts->right_block[word_lenght]++;
+				counts->num_block++;
+			}
+			else
+			{
+				counts->right_rest[word_lenght]++;
+				counts->num_rest++;
+			}
+		combinator_close();
+
+		strcpy(counts->source, count_source);
+		counts->block_pos = combinator_block_pos;
+		counts->resume_pos = resume_pos;
+	}
+	int64_t num_block = counts->num_block;
+
+	if (!counts->num_left || !num_block) return;
+
+	// Load the block and the left word
+	combinator_block = combinator_load_block(combinator_block_pos, (uint32_t)num_block, &combinator_next_block_pos);
+	if (!combinator_block) return;
+	combinator_blocks = combinator_block;
+	combinator_right_words_left = counts->num_rest;
+
+	combinator_open(combinator_left_id, resume_pos);
+	int is_word_resumed = combinator_next_word(combinator_word, &combinator_word_lenght, &combinator_word_pos);
+	if (is_word_resumed)
+		combinator_index = __max(0, __min(combinator_index, num_block * combinator_num_separators - 1));
+	else
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+		combinator_next_block();
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+	}
+
+	// Calculate the key-space
+	if (counts->num_left > 0xFFFFFFFFFFFFFFF / COMBINATOR_MAX_SEPARATORS / (num_block + counts->num_rest))
+		num_key_space = KEY_SPACE_UNKNOW;
+	else
+	{
+		num_key_space = combinator_count(counts->left_resumed, counts->right_block) + combinator_count(counts->left_all, counts->right_rest);
+
+		// Combinations of the current left word already generated
+		if (is_word_resumed)
+			for (int64_t i = 0; i < combinator_index; i++)
+			{
+				uint32_t lenght = combinator_word_lenght + combinator_separators_lenght[i / num_block] + combinator_block->lenghts[i % num_block];
+				if (lenght >= combinator_min_lenght && lenght <= combinator_max_lenght)
+					num_key_space--;
+			}
+	}
+}
+// resume_arg: block_position:left_word_position:index
+PRIVATE void combinator_save_resume_arg(char* resume_arg)
+{
+	int64_t old_save[3] = {combinator_block_pos, combinator_word_pos, combinator_index};
+
+	if (thread_params)
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		// Find the most old saved data
+		for (uint32_t i = 0; i < num_thread_params; i++)
+		{
+			int64_t* save = ((int64_t*)thread_params) + 3 * i;
+			if (save[0] < old_save[0] || (save[0] == old_save[0] && (save[1] < old_save[1] || (save[1] == old_save[1] && save[2] < old_save[2]))))
+				memcpy(old_save, save, sizeof(old_save));
+		}
+
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+	}
+
+	sprintf(resume_arg, "%lli:%lli:%lli", old_save[0], old_save[1], old_save[2]);
+}
+PRIVATE int combinator_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	CombinatorChunk* chunk = ((CombinatorChunk*)(((int64_t*)thread_params) + 3 * num_thread_params)) + thread_id;
+	int64_t batch_begin[3] = {chunk->num_keys ? chunk->block->pos : 0, chunk->word_pos[chunk->current], chunk->index};
+	int have_batch_begin = chunk->num_keys != 0;
+	uint32_t i = 0, lenght;
+
+	while (i < max_number)
+	{
+		if (!chunk->num_keys && !combinator_reserve_chunk(chunk, thread_id, max_number - i, have_batch_begin ? batch_begin : NULL))
+			break;
+
+		if (combinator_get_key(chunk, &lenght))
+		{
+			// Copy key to nt_buffer
+			uint32_t j = 0;
+			for (; j < lenght / 2; j++)
+				nt_buffer[j*max_number+i] = ((uint32_t)chunk->chars[2*j]) | ((uint32_t)chunk->chars[2*j+1]) << 16;
+
+			nt_buffer[j*max_number+i] = (lenght & 1) ? ((uint32_t)chunk->chars[2*j]) | 0x800000 : 0x80;
+			nt_buffer[14*max_number+i] = lenght << 4;
+
+			for (j++; j < 14; j++)
+				nt_buffer[j*max_number+i] = 0;
+
+			i++;
+		}
+		combinator_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int combinator_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	CombinatorChunk* chunk = ((CombinatorChunk*)(((int64_t*)thread_params) + 3 * num_thread_params)) + thread_id;
+	int64_t batch_begin[3] = {chunk->num_keys ? chunk->block->pos : 0, chunk->word_pos[chunk->current], chunk->index};
+	int have_batch_begin = chunk->num_keys != 0;
+	uint32_t i = 0, lenght;
+
+	memset(keys, 0, max_number*8);
+
+	while (i < max_number)
+	{
+		if (!chunk->num_keys && !combinator_reserve_chunk(chunk, thread_id, max_number - i, have_batch_begin ? batch_begin : NULL))
+			break;
+
+		if (combinator_get_key(chunk, &lenght))
+		{
+			memcpy(keys + 8u * i, chunk->chars, __min(lenght, 8u));
+			i++;
+		}
+		combinator_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int combinator_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	CombinatorChunk* chunk = ((CombinatorChunk*)(((int64_t*)thread_params) + 3 * num_thread_params)) + thread_id;
+	int64_t batch_begin[3] = {chunk->num_keys ? chunk->block->pos : 0, chunk->word_pos[chunk->current], chunk->index};
+	int have_batch_begin = chunk->num_keys != 0;
+	uint32_t i = 0, lenght;
+
+	while (i < max_number)
+	{
+		if (!chunk->num_keys && !combinator_reserve_chunk(chunk, thread_id, max_number - i, have_batch_begin ? batch_begin : NULL))
+			break;
+
+		if (combinator_get_key(chunk, &lenght))
+		{
+			memcpy(keys + MAX_KEY_LENGHT_SMALL * i, chunk->chars, lenght);
+			keys[MAX_KEY_LENGHT_SMALL * i + lenght] = 0;
+			i++;
+		}
+		combinator_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE int combinator_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	CombinatorChunk* chunk = ((CombinatorChunk*)(((int64_t*)thread_params) + 3 * num_thread_params)) + thread_id;
+	int64_t batch_begin[3] = {chunk->num_keys ? chunk->block->pos : 0, chunk->word_pos[chunk->current], chunk->index};
+	int have_batch_begin = chunk->num_keys != 0;
+	uint32_t i = 0, lenght;
+
+	while (i < max_number)
+	{
+		if (!chunk->num_keys && !combinator_reserve_chunk(chunk, thread_id, max_number - i, have_batch_begin ? batch_begin : NULL))
+			break;
+
+		if (combinator_get_key(chunk, &lenght))
+		{
+			convert_utf8_2_coalesc(chunk->chars, nt_buffer + i, max_number, lenght);
+			i++;
+		}
+		combinator_advance(chunk);
+	}
+
+	return i;
+}
+PRIVATE void combinator_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
+{
+	const char* right_id = strchr(provider_param, '\n');
+
+	description[0] = 0;
+	wordlist_get_description(provider_param, description, min_lenght, max_lenght);
+	if (right_id)
+	{
+		wordlist_get_description(right_id + 1, description + strlen(description), min_lenght, max_lenght);
+
+		// Separators, one by line in the param
+		const char* separators = strchr(right_id + 1, '\n');
+		if (separators)
+		{
+			char separators_description[24];
+			int lenght = (int)__min(strlen(separators + 1), 20);
+			memcpy(separators_description, separators + 1, lenght);
+			separators_description[lenght] = 0;
+			for (int i = 0; i < lenght; i++)
+				if (separators_description[i] == '\n')
+					separators_description[i] = '|';
+
+			sprintf(description + strlen(description), " [%s%s]", separators_description, strlen(separators + 1) > 20 ? "..." : "");
+		}
+	}
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////
+PUBLIC void register_key_providers(int db_already_initialize)
+{
+	int i = 0;
+
+	// Mutex for thread-safe access
+	HS_CREATE_MUTEX(&key_provider_mutex);
+	HS_CREATE_MUTEX(&num_keys_served_mutex);
+	HS_CREATE_COND(&combinator_loaded);
+
+	if (!db_already_initialize)
+	{
+		sqlite3_stmt* insert;
+		// KeyProvider in database
+		sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO KeyProvider (ID, Name, Description) VALUES (?, ?, ?);", -1, &insert, NULL);
+
+		for (; i < num_key_providers; i++)
+		{
+			// Ensures all KeyProvider are in the db
+			sqlite3_reset(insert);
+			sqlite3_bind_int64(insert, 1, key_providers[i].db_id);
+			sqlite3_bind_text(insert, 2, key_providers[i].name, -1, SQLITE_STATIC);
+			sqlite3_bind_text(insert, 3, key_providers[i].description, -1, SQLITE_STATIC);
+			sqlite3_step(insert);
+		}
+
+		sqlite3_finalize(insert);
+	}
+}
+
+// Rules support
+void rules_resume(int pmin_lenght, int pmax_lenght, char* param, const char* resume_arg, int format_index);
+int rules_gen_common(uint32_t* nt_buffer, uint32_t max_number, int thread_id);
+void rules_finish();
+void rules_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght);
+
+PUBLIC KeyProvider key_providers[] = {
+	{
+		"Charset" , "Fast generation of keys.", 1, 
+		{{PROTOCOL_NTLM, charset_gen_ntlm}, {PROTOCOL_UTF8_LM, charset_gen_utf8_lm}, {PROTOCOL_CHARSET_OCL, charset_gen_opencl}, { PROTOCOL_CHARSET_OCL_NO_ALIGNED, charset_gen_opencl_no_aligned }, { PROTOCOL_UTF8_COALESC_LE, charset_gen_utf8_coalesc_le } },
+		charset_save_resume_arg , charset_resume , do_nothing, charset_get_description, 0, 6, TRUE, FALSE, MAX_KEY_LENGHT_BIG + sizeof(KeysChunk)
+	},
+	{
+		"Wordlist", "Read keys from a file." , 2,
+		{{PROTOCOL_NTLM, wordlist_gen_ntlm}, {PROTOCOL_UTF8_LM, wordlist_gen_utf8_lm}, {PROTOCOL_UTF8, wordlist_gen_utf8}, {PROTOCOL_UTF8, wordlist_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, wordlist_gen_utf8_coalesc_le}},
+		wordlist_save_resume_arg, wordlist_resume, NULL, wordlist_get_description, 1, MAX_KEY_LENGHT_BIG, TRUE, TRUE, sizeof(fpos_t) + sizeof(WordlistChunk)
+	},
+	{
+		"Keyboard", "Generate combination of adjacent keys in keyboard." , 3,
+		{{PROTOCOL_NTLM, keyboard_gen_ntlm}, {PROTOCOL_UTF8_LM, keyboard_gen_utf8_lm}, {PROTOCOL_UTF8, keyboard_gen_utf8}, {PROTOCOL_UTF8, keyboard_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, keyboard_gen_utf8_coalesc_le}},
+		charset_save_resume_arg, keyboard_resume, do_nothing, keyboard_get_description, 2, 10, TRUE, FALSE, MAX_KEY_LENGHT_BIG
+	},
+	{
+		"Phrases" , "Generate phrases combining words from a wordlist.", 4,
+		{{PROTOCOL_NTLM, sentence_gen_ntlm}, {PROTOCOL_PHRASES_OPENCL, sentence_gen_ocl}, {PROTOCOL_UTF8, sentence_gen_utf8}, {PROTOCOL_UTF8, sentence_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, sentence_gen_utf8_coalesc_le}},
+		sentence_save_resume_arg, sentence_resume, sentence_finish, sentence_get_description, 2, 2, TRUE, FALSE, MAX_KEY_LENGHT_SMALL*sizeof(uint32_t)
+	},
+	{
+		"DB Info" , "Tries usernames and passwords found.", 5, 
+		{{PROTOCOL_NTLM, db_gen_ntlm}, {PROTOCOL_UTF8_LM, db_gen_utf8_lm}, {PROTOCOL_UTF8, db_gen_utf8}, {PROTOCOL_UTF8, db_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, db_gen_utf8_coalesc_le}},
+		do_nothing_save_resume_arg, db_resume, db_finish, do_nothing_description, 1, MAX_KEY_LENGHT_BIG, TRUE, TRUE, 0
+	},
+	{
+		"LM2NT" , "Found NTLM passwords using LM passwords and correcting case.", 6, 
+		{{PROTOCOL_NTLM, lm2ntlm_gen_ntlm}, {PROTOCOL_NTLM, lm2ntlm_gen_ntlm}, {PROTOCOL_UTF8, lm2ntlm_gen_utf8}, {PROTOCOL_UTF8, lm2ntlm_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, lm2ntlm_gen_utf8_coalesc_le}},
+		do_nothing_save_resume_arg, lm2ntlm_resume, lm2ntlm_finish, do_nothing_description, 0, MAX_KEY_LENGHT_SMALL, TRUE, FALSE, 0
+	},
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// Down are the 'private' key_providers: These key_providers don't show to the user directly
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	{
+		"FastLM" , "Very fast generation of LM keys.", 7, 
+		{{PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM_OPENCL, fast_lm_opencl_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}, {PROTOCOL_FAST_LM, fast_lm_generate}},
+		charset_save_resume_arg, fast_lm_resume, do_nothing, charset_get_description, 4, 7, FALSE, FALSE, MAX_KEY_LENGHT_SMALL
+	},
+	{
+		"Rules" , "Apply rules.", 8, 
+		{{PROTOCOL_NTLM, rules_gen_common}, {PROTOCOL_NTLM, rules_gen_common}, {PROTOCOL_RULES_OPENCL, rules_gen_common}, {PROTOCOL_RULES_OPENCL, rules_gen_common}, {PROTOCOL_UTF8_COALESC_LE, rules_gen_common}},
+		NULL, rules_resume, rules_finish, rules_get_description, 0, 27, FALSE, FALSE, 0
+	},
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	// Added after the 'private' key_providers to maintain the indexes above
+	//////////////////////////////////////////////////////////////////////////////////////////////
+	{
+		"Mask" , "Generate keys with a different charset by position.", 9,
+		{{PROTOCOL_NTLM, mask_gen_ntlm}, {PROTOCOL_UTF8_LM, mask_gen_utf8_lm}, {PROTOCOL_MASK_OPENCL, mask_gen_opencl}, {PROTOCOL_UTF8, mask_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, mask_gen_utf8_coalesc_le}},
+		mask_save_resume_arg, mask_resume, do_nothing, mask_get_description, 1, MASK_MAX_POSITIONS, TRUE, FALSE, MAX_KEY_LENGHT_BIG + sizeof(KeysChunk)
+	},
+	{
+		"Markov" , "Generate the most probable keys first, learning from found passwords.", 10,
+		{{PROTOCOL_NTLM, markov_gen_ntlm}, {PROTOCOL_UTF8_LM, markov_gen_utf8_lm}, {PROTOCOL_UTF8, markov_gen_utf8}, {PROTOCOL_UTF8, markov_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, markov_gen_utf8_coalesc_le}},
+		markov_save_resume_arg, markov_resume, markov_finish, markov_get_description, 1, 8, TRUE, FALSE, sizeof(int64_t) + sizeof(MarkovChunk)
+	},
+	{
+		"STDIN" , "Read keys from the standard input or a named pipe.", 11,
+		{{PROTOCOL_NTLM, stdin_gen_ntlm}, {PROTOCOL_UTF8_LM, stdin_gen_utf8_lm}, {PROTOCOL_UTF8, stdin_gen_utf8}, {PROTOCOL_UTF8, stdin_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, stdin_gen_utf8_coalesc_le}},
+		stdin_save_resume_arg, stdin_resume, stdin_finish, stdin_get_description, 1, MAX_KEY_LENGHT_BIG, STDIN_SHOW_TO_USER, FALSE, sizeof(int64_t) + sizeof(StdinChunk)
+	},
+	{
+		"Hybrid" , "Combine each word of a wordlist with the keys of a mask.", 12,
+		{{PROTOCOL_NTLM, hybrid_gen_ntlm}, {PROTOCOL_UTF8_LM, hybrid_gen_utf8_lm}, {PROTOCOL_UTF8, hybrid_gen_utf8}, {PROTOCOL_UTF8, hybrid_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, hybrid_gen_utf8_coalesc_le}},
+		hybrid_save_resume_arg, hybrid_resume, hybrid_finish, hybrid_get_description, 1, MAX_KEY_LENGHT_BIG, TRUE, FALSE, 2 * sizeof(int64_t) + sizeof(HybridChunk)
+	},
+	{
+		"Combinator" , "Combine each word of a wordlist with each word of other wordlist.", 13,
+		{{PROTOCOL_NTLM, combinator_gen_ntlm}, {PROTOCOL_UTF8_LM, combinator_gen_utf8_lm}, {PROTOCOL_UTF8, combinator_gen_utf8}, {PROTOCOL_UTF8, combinator_gen_utf8}, {PROTOCOL_UTF8_COALESC_LE, combinator_gen_utf8_coalesc_le}},
+		combinator_save_resume_arg, combinator_resume, combinator_finish, combinator_get_description, 2, MAX_KEY_LENGHT_BIG, TRUE, FALSE, 3 * sizeof(int64_t) + sizeof(CombinatorChunk)
+	}
+	// TODO: KnowForce, characters Added, Subset, Distributed, ...
+};
+PUBLIC int num_key_providers = LENGTH(key_providers);
+
+
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// OpenCL Implementation
+//////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+#ifdef HS_OPENCL_SUPPORT
+#include "attack.h"
+PUBLIC cl_uint ocl_rule_simple_copy_unicode(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size)
+{
+	strcpy(nt_buffer[0 ], "+nt_buffer[0]");
+	strcpy(nt_buffer[1 ], "+nt_buffer[1]");
+	strcpy(nt_buffer[2 ], "+nt_buffer[2]");
+	strcpy(nt_buffer[3 ], "+nt_buffer[3]");
+	strcpy(nt_buffer[4 ], "+nt_buffer[4]");
+	strcpy(nt_buffer[5 ], "+nt_buffer[5]");
+	strcpy(nt_buffer[6 ], "+nt_buffer[6]");
+	strcpy(nt_buffer[7 ], "+nt_buffer[7]");
+	strcpy(nt_buffer[8 ], "+nt_buffer[8]");
+	strcpy(nt_buffer[9 ], "+nt_buffer[9]");
+	strcpy(nt_buffer[10], "+nt_buffer[10]");
+	strcpy(nt_buffer[11], "+nt_buffer[11]");
+	strcpy(nt_buffer[12], "+nt_buffer[12]");
+	strcpy(nt_buffer[13], "+nt_buffer[13]");
+	strcpy(nt_buffer[14], "+nt_len"       );
+
+	// Total number of keys
+	sprintf(source + strlen(source),
+		"indx=get_global_id(0);"
+		"uint nt_buffer[14];"
+		"uint nt_len=keys[indx+7*%uu];"
+		"if(nt_len>(27u<<4u))return;"
+		"uint max_len=(nt_len>>6)+1;", NUM_KEYS_OPENCL);
+
+	sprintf(source + strlen(source),
+		"for(uint i=0;i<max_len;i++){"
+			"uint copy_tmp=keys[indx+i*%uu];"
+			"nt_buffer[2*i]=GET_1(copy_tmp);"
+			"nt_buffer[2*i+1]=GET_2(copy_tmp);"
+		"}", NUM_KEYS_OPENCL);
+
+	sprintf(source + strlen(source),
+		"for(uint i=2*max_len;i<14;i++)"
+			"nt_buffer[i]=0;");
+
+	return 1;
+}
+PUBLIC cl_uint ocl_rule_simple_copy_utf8_le(char* source, char nt_buffer[16][16], char nt_buffer_vector_size[16], cl_uint lenght, cl_uint NUM_KEYS_OPENCL, cl_uint prefered_vector_size)
+{
+	strcpy(nt_buffer[0], "+buffer0");
+	strcpy(nt_buffer[1], "+buffer1");
+	strcpy(nt_buffer[2], "+buffer2");
+	strcpy(nt_buffer[3], "+buffer3");
+	strcpy(nt_buffer[4], "+buffer4");
+	strcpy(nt_buffer[5], "+buffer5");
+	strcpy(nt_buffer[6], "+buffer6");
+	strcpy(nt_buffer[7], "+len");
+
+	// Total number of keys
+	sprintf(source + strlen(source),
+		"indx=get_global_id(0);"
+		"uint len=keys[indx+7*%uu];"
+		"if(len>(27u<<4u))return;"
+		"len>>=1u;", NUM_KEYS_OPENCL);
+
+	strcat(source,"uint buffer0=keys[indx];");
+
+	for (cl_uint i = 1; i < 7; i++)
+		sprintf(source + strlen(source),
 			"uint buffer%u=(len>=%uu)?keys[indx+%uu]:0;", i, (i * 4u) << 3u, i * NUM_KEYS_OPENCL);
 
 	return 1;
@@ -2054,6 +4299,90 @@ PUBLIC void ocl_common_process_found(OpenCL_Param* param, cl_uint* num_found, oc
 	pclEnqueueWriteBuffer(param->queue, param->mems[GPU_OUTPUT], CL_TRUE, 0, sizeof(cl_uint), num_found, 0, NULL, NULL);
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// Mask
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+PRIVATE void ocl_gen_kernel_mask_2_common(char* source, uint32_t NUM_KEYS_OPENCL)
+{
+	uint32_t i, j, offset = 0;
+	uint32_t mask_offset[MASK_MAX_POSITIONS];
+
+	sprintf(source+strlen(source),	"#define GLOBAL_SIZE %uu\n"
+									"__constant uchar mask_charset[]={", NUM_KEYS_OPENCL);
+	// Fill charsets. Positions with the same charset share it
+	for(i = 0; i < mask_num_positions; i++)
+	{
+		for(j = 0; j < i; j++)
+			if(mask_charset_size[i] == mask_charset_size[j] && !memcmp(mask_charset[i], mask_charset[j], mask_charset_size[i]))
+				break;
+
+		if(j < i)
+			mask_offset[i] = mask_offset[j];
+		else
+		{
+			mask_offset[i] = offset;
+			for(j = 0; j < mask_charset_size[i]; j++, offset++)
+				sprintf(source+strlen(source), "%s%uU", offset?",":"", (uint32_t)mask_charset[i][j]);
+		}
+	}
+	strcat(source, offset ? "};\n" : "0U};\n");
+
+	// By position: offset in mask_charset, size of the charset and the params to divide by it
+	strcat(source, "__constant uint mask_params[]={");
+	for(i = 0; i < mask_num_positions; i++)
+	{
+		DivisionParams div_param = get_div_params(mask_charset_size[i]);
+		sprintf(source+strlen(source), "%s%uU,%uU,%uU,%uU,%uU", i?",":"", mask_offset[i], mask_charset_size[i], div_param.magic, (uint32_t)div_param.sum_one, div_param.shift);
+	}
+	strcat(source, mask_num_positions ? "};\n" : "0U};\n");
+
+	// Define the kernel to process the keys from mask into a "fast-to-use" format
+	strcat(source, "\n__kernel void process_key(__constant uchar* current_key,__global uint* restrict out_keys,uint max_idx)"
+					"{"
+						// Global data
+						"uint idx=get_global_id(0);"
+						"if(idx>=max_idx)return;"
+
+						"uint max_number=idx;"
+						"uint key_lenght=current_key[0];"
+						"uint buffer=0;"
+
+						"for(uint i=0;i<key_lenght;i++)"
+						"{"
+							"__constant uint* pos_params=mask_params+5u*i;"
+							"max_number+=current_key[i+1];"
+							// Perform division
+							"uint div=pos_params[2]?(mul_hi(max_number+pos_params[3],pos_params[2])>>pos_params[4]):(max_number>>pos_params[4]);"
+
+							"buffer|=((uint)mask_charset[pos_params[0]+max_number-pos_params[1]*div])<<(8u*(i&3));"
+							"max_number=div;"
+							"if((i&3u)==3u)"
+							"{"
+								"out_keys[mad_sat(i/4u,GLOBAL_SIZE,idx)]=buffer;"
+								"buffer=0u;"
+							"}"
+						"}"
+						// Padding
+						"buffer|=0x80<<(8u*(key_lenght&3));"
+						"out_keys[mad_sat(key_lenght/4u,GLOBAL_SIZE,idx)]=buffer;"
+
+						// Manage the length
+						"out_keys[7u*GLOBAL_SIZE+idx]=key_lenght<<4u;"
+					"}\n");
+}
+PRIVATE void ocl_mask_get_key(unsigned char* buffer, unsigned char* out_key, uint32_t key_index, size_t num_work_items)
+{
+	uint32_t max_number = key_index, i;
+	uint32_t key_lenght = ((uint32_t*)buffer)[8];
+	// Calculate final current_key
+	for(i = 0; i < key_lenght; i++)
+	{
+		max_number += buffer[i];
+		out_key[i] = mask_charset[i][max_number%mask_charset_size[i]];
+		max_number /= mask_charset_size[i];
+	}
+	out_key[key_lenght] = 0;
+}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // UTF8
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 PRIVATE size_t ocl_utf8_get_buffer_size(OpenCL_Param* param)
@@ -2434,7 +4763,20 @@ PUBLIC void ocl_rules_process_found(OpenCL_Param* param, cl_uint* num_found, cl_
 PUBLIC oclKernel2Common kernels2common[] = {
 	{PROTOCOL_CHARSET_OCL_NO_ALIGNED, ocl_gen_kernel_charset_2_common, ocl_charset_setup_proccessed_keys_params , ocl_charset_process_buffer, ocl_charset_get_key, ocl_charset_get_buffer_size},
 	{PROTOCOL_PHRASES_OPENCL		, ocl_gen_kernel_phrases_2_common, ocl_phrases_setup_proccessed_keys_params , ocl_phrases_process_buffer, ocl_phrases_get_key, ocl_phrases_get_buffer_size},
-	{PROTOCOL_UTF8					, ocl_gen_kernel_UTF8_2_common	 , ocl_utf8_setup_proccessed_keys_params	, ocl_utf8_process_buffer	, ocl_utf8_get_key	 , ocl_utf8_get_buffer_size}
+	{PROTOCOL_UTF8					, ocl_gen_kernel_UTF8_2_common	 , ocl_utf8_setup_proccessed_keys_params	, ocl_utf8_process_buffer	, ocl_utf8_get_key	 , ocl_utf8_get_buffer_size},
+	{PROTOCOL_MASK_OPENCL			, ocl_gen_kernel_mask_2_common	 , ocl_charset_setup_proccessed_keys_params , ocl_charset_process_buffer, ocl_mask_get_key	 , ocl_charset_get_buffer_size}
 };
 PUBLIC uint32_t num_kernels2common = LENGTH(kernels2common);
+
+// Mask keys are generated in the GPU instead of copying them as UTF8
+PUBLIC oclKernel2Common* ocl_select_kernel2common(oclKernel2Common* ocl_kernel_provider, generate_key_funtion** gen)
+{
+	if (ocl_kernel_provider == kernels2common + UTF8_INDEX_IN_KERNELS && *gen == (generate_key_funtion*)mask_gen_utf8)
+	{
+		*gen = (generate_key_funtion*)mask_gen_opencl;
+		return kernels2common + MASK_INDEX_IN_KERNELS;
+	}
+
+	return ocl_kernel_provider;
+}
 #endif
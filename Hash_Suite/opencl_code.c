@@ -1193,6 +1193,8 @@ PUBLIC void release_opencl_param(OpenCL_Param* param)
 		if(!param->use_ptx && param->context)		pclReleaseContext(param->context);
 
 		if(param->output) free(param->output);
+		free(param->cbg_pos);
+		free(param->cbg_filter_value);
 
 		free(param);
 	}
@@ -1386,6 +1388,77 @@ PUBLIC void cl_write_buffer(OpenCL_Param* param, uint32_t index, size_t size, vo
 
 #include "attack.h"
 
+// Remember where each hash is in the table copied to the GPU, to remove it when found.
+// Called before the copy with the count of removed hashes read before it: a hash removed
+// while copying changes the filter value remembered here and is copied again later.
+PRIVATE void ocl_track_cbg_table(OpenCL_Param* param, cl_uint num_removed)
+{
+	param->num_cbg_removed = num_removed;
+	param->cbg_pos = (cl_uint*)malloc(sizeof(cl_uint) * num_passwords_loaded);
+	param->cbg_filter_value = (cl_ushort*)malloc(sizeof(cl_ushort) * num_passwords_loaded);
+	if (!param->cbg_pos || !param->cbg_filter_value)
+	{
+		// Found hashes stay in the GPU table: slower, not wrong
+		free(param->cbg_pos);			param->cbg_pos = NULL;
+		free(param->cbg_filter_value);	param->cbg_filter_value = NULL;
+		return;
+	}
+
+	memset(param->cbg_pos, 0xff, sizeof(cl_uint) * num_passwords_loaded);
+	for (cl_ulong pos = 0; pos <= cbg_mask; pos++)
+	{
+		cl_uint index = cbg_table[pos];
+		if (index < num_passwords_loaded)
+		{
+			param->cbg_pos[index] = (cl_uint)pos;
+			param->cbg_filter_value[index] = cbg_filter[pos];
+		}
+	}
+}
+// Copy to the GPU table the hashes removed since the last call.
+// Must be called from the thread that own the GPU, once by kernel launch.
+PRIVATE void ocl_remove_found_from_cbg_table(OpenCL_Param* param)
+{
+	cl_uint num_writes = 0;
+	// Acquire: the found bits and filter values of the hashes removed are visible
+	cl_uint num_removed = HS_ATOMIC_LOAD32_ACQUIRE(&cbg_num_removed);
+
+	if (!param->cbg_pos || param->num_cbg_removed == num_removed)
+		return;
+
+	param->num_cbg_removed = num_removed;
+	for (cl_uint i = 0; i < num_passwords_loaded; i += 32)
+	{
+		uint32_t found = is_foundBit[i >> 5];
+		for (cl_uint j = 0; found; j++, found >>= 1)
+			if ((found & 1) && (i + j) < num_passwords_loaded && param->cbg_pos[i + j] != NO_ELEM)
+			{
+				cl_uint index = i + j;
+				size_t offset = sizeof(cl_ushort) * param->cbg_pos[index];
+				cl_ushort value = cbg_filter[param->cbg_pos[index]];
+				// Same value: removed before the copy, or the removal is not finished and
+				// the cbg_num_removed increment that follows brings us back here
+				if (value == param->cbg_filter_value[index])
+					continue;
+
+				// The filter rejects this hash now
+				param->cbg_filter_value[index] = value;
+#ifndef __ANDROID__
+				if (param->use_ptx)
+					cuMemcpyHtoD(param->cu_mems[GPU_BIT_TABLE] + offset, param->cbg_filter_value + index, sizeof(cl_ushort));
+				else
+#endif
+					pclEnqueueWriteBuffer(param->queue, param->mems[GPU_BIT_TABLE], CL_FALSE, offset, sizeof(cl_ushort), param->cbg_filter_value + index, 0, NULL, NULL);
+
+				param->cbg_pos[index] = NO_ELEM;
+				num_writes++;
+			}
+	}
+
+	if (num_writes && !param->use_ptx)
+		pclFinish(param->queue);
+}
+
 PUBLIC void change_value_proportionally(cl_uint* value, cl_uint duration)
 {
 	if (duration >= OCL_NORMAL_KERNEL_TIME)
@@ -1824,6 +1897,8 @@ PRIVATE void ocl_charset_work(OpenCL_Param* param)
 		// TODO: Check if there is some problem
 		/*if (result != CL_SUCCESS)
 			OCL_REPORT_ERROR("pclEnqueueWriteBuffer");*/
+		// Hashes found by other threads or GPUs
+		ocl_remove_found_from_cbg_table(param);
 		pclEnqueueNDRangeKernel(param->queue, param->kernels[key_lenght], 1, NULL, &num_work_items, &param->max_work_group_size, 0, NULL, NULL);
 		//if (result != CL_SUCCESS)
 		//	OCL_REPORT_ERROR("pclEnqueueNDRangeKernel");
@@ -1919,6 +1994,8 @@ PRIVATE int ocl_charset_init_common(OpenCL_Param* param, cl_uint gpu_index, gene
 	cl_write_buffer(param, GPU_OUTPUT, sizeof(cl_uint), zero);
 	if (num_passwords_loaded > 1 && !(gpu_devices[gpu_index].flags & GPU_FLAG_HAD_UNIFIED_MEMORY))
 	{
+		// Before the copy: a hash removed while copying is removed again later
+		ocl_track_cbg_table(param, HS_ATOMIC_LOAD32_ACQUIRE(&cbg_num_removed));
 		cl_write_buffer(param, GPU_TABLE, sizeof(cl_uint)* (cbg_mask + 1ull), cbg_table);
 		cl_write_buffer(param, GPU_BIT_TABLE, sizeof(cl_ushort)* (cbg_mask+1ull), cbg_filter);
 		cl_write_buffer(param, GPU_BINARY_VALUES, BINARY_SIZE*num_passwords_loaded, binary_values);
@@ -2222,6 +2299,8 @@ PRIVATE void ocl_work(OpenCL_Param* param)
 	{
 		size_t num_work_items = kernel2common->process_buffer(use_buffer ? buffer1 : buffer2, result, param, &num_keys_filled);// Convert to multiple of work_group_size
 
+		// Hashes found by other threads or GPUs
+		ocl_remove_found_from_cbg_table(param);
 		// Do actual hashing
 		pclEnqueueNDRangeKernel(param->queue, param->kernels[0], 1, NULL, &num_work_items, &param->max_work_group_size, 0, NULL, NULL);
 		pclEnqueueReadBuffer(param->queue, param->mems[GPU_OUTPUT], CL_FALSE, 0, 4, &num_found, 0, NULL, NULL);
@@ -2249,6 +2328,7 @@ PUBLIC int ocl_common_init(OpenCL_Param* param, cl_uint gpu_index, generate_key_
 {
 	cl_uint output_size = 2 * sizeof(cl_uint) * __min(10000000, num_passwords_loaded);
 
+	ocl_kernel_provider = ocl_select_kernel2common(ocl_kernel_provider, &gen);
 	create_opencl_param(param, gpu_index, gen, output_size, FALSE);
 
 	param->additional_param = ocl_kernel_provider;
@@ -2347,6 +2427,8 @@ PUBLIC int ocl_common_init(OpenCL_Param* param, cl_uint gpu_index, generate_key_
 	if (num_passwords_loaded > 1 && !(gpu_devices[gpu_index].flags & GPU_FLAG_HAD_UNIFIED_MEMORY))
 	{
 		// Create and initialize bitmaps
+		// Before the copy: a hash removed while copying is removed again later
+		ocl_track_cbg_table(param, HS_ATOMIC_LOAD32_ACQUIRE(&cbg_num_removed));
 		cl_write_buffer(param, GPU_TABLE, sizeof(cl_uint)* (cbg_mask + 1ull), cbg_table);
 		cl_write_buffer(param, GPU_BIT_TABLE, sizeof(cl_ushort)* (cbg_mask + 1ull), cbg_filter);
 		cl_write_buffer(param, GPU_BINARY_VALUES, BINARY_SIZE*num_passwords_loaded, binary_values);
@@ -2421,6 +2503,8 @@ PRIVATE void ocl_phrases_work(OpenCL_Param* param)
 
 		// TODO: Check if there is some problem
 		pclEnqueueWriteBuffer(param->queue, param->mems[GPU_CURRENT_KEY], CL_FALSE, 0, (sentence[1] + 1)*sizeof(cl_uint), sentence + 1, 0, NULL, NULL);
+		// Hashes found by other threads or GPUs
+		ocl_remove_found_from_cbg_table(param);
 		pclEnqueueNDRangeKernel(param->queue, param->kernels[0], 1, NULL, &num_work_items, &param->max_work_group_size, 0, NULL, NULL);
 		pclEnqueueReadBuffer(param->queue, param->mems[GPU_OUTPUT], CL_TRUE, 0, 4, &num_found, 0, NULL, NULL);
 
@@ -2552,6 +2636,8 @@ PUBLIC int ocl_phrases_init(OpenCL_Param* param, cl_uint gpu_index, generate_key
 	if (num_passwords_loaded > 1 && !(gpu_devices[gpu_index].flags & GPU_FLAG_HAD_UNIFIED_MEMORY))
 	{
 		// Create and initialize bitmaps
+		// Before the copy: a hash removed while copying is removed again later
+		ocl_track_cbg_table(param, HS_ATOMIC_LOAD32_ACQUIRE(&cbg_num_removed));
 		cl_write_buffer(param, GPU_TABLE, sizeof(cl_uint)* (cbg_mask + 1ull), cbg_table);
 		cl_write_buffer(param, GPU_BIT_TABLE, sizeof(cl_ushort)* (cbg_mask + 1ull), cbg_filter);
 		cl_write_buffer(param, GPU_BINARY_VALUES, BINARY_SIZE*num_passwords_loaded, binary_values);
@@ -2686,6 +2772,8 @@ PRIVATE void ocl_protocol_rules_work(OpenCL_Param* param)
 				// Do actual hashing
 				for (int i = 0; continue_attack && i < current_rules_count; i++)
 				{
+					// Hashes found by other threads or GPUs
+					ocl_remove_found_from_cbg_table(param);
 					size_t work_group_size_rl = param->rules.work_group_sizes[i + lenght*current_rules_count];
 					size_t num_work_items_len = OCL_MULTIPLE_WORKGROUP_SIZE(gpu_num_keys_by_len[lenght], work_group_size_rl);// Convert to multiple of work_group_size
 
@@ -2800,6 +2888,8 @@ PRIVATE void ocl_protocol_rules_work(OpenCL_Param* param)
 			// Do actual hashing
 			for (int i = 0; !stop_universe && i < current_rules_count; i++)
 			{
+				// Hashes found by other threads or GPUs
+				ocl_remove_found_from_cbg_table(param);
 				size_t work_group_size_rl = param->rules.work_group_sizes[i + lenght*current_rules_count];
 				size_t num_work_items_len = OCL_MULTIPLE_WORKGROUP_SIZE(gpu_num_keys_by_len[lenght], work_group_size_rl);// Convert to multiple of work_group_size
 
@@ -3389,6 +3479,8 @@ out:
 	if (!FORMAT_USE_SALT && num_passwords_loaded > 1 && !(gpu_devices[gpu_index].flags & GPU_FLAG_HAD_UNIFIED_MEMORY))
 	{
 		// Create and initialize bitmaps
+		// Before the copy: a hash removed while copying is removed again later
+		ocl_track_cbg_table(param, HS_ATOMIC_LOAD32_ACQUIRE(&cbg_num_removed));
 		cl_write_buffer(param, GPU_TABLE, sizeof(cl_uint)* (cbg_mask + 1ull), cbg_table);
 		cl_write_buffer(param, GPU_BIT_TABLE, sizeof(cl_ushort)* (cbg_mask + 1ull), cbg_filter);
 		cl_write_buffer(param, GPU_BINARY_VALUES, BINARY_SIZE*num_passwords_loaded, binary_values);
@@ -4154,6 +4246,7 @@ PUBLIC int ocl_init_slow_hashes(OpenCL_Param* param, cl_uint gpu_index, generate
 	//cl_int code;
 	cl_uint output_size = 2 * sizeof(cl_uint)*num_passwords_loaded;
 
+	ocl_kernel_provider = ocl_select_kernel2common(ocl_kernel_provider, &gen);
 	create_opencl_param(param, gpu_index, gen, output_size, FALSE);
 	param->additional_param  = ocl_kernel_provider;
 	param->additional_param1 = ocl_work_body;
@@ -51,6 +51,97 @@
 	#define _byteswap_ulong(x) __builtin_bswap32(x)
 	#define _byteswap_ushort(x) __builtin_bswap16(x)
 
+	#define HS_PREFETCH(addr)	__builtin_prefetch(addr)
+
+	#define HS_THREAD_LOCAL						__thread
+	#define HS_ATOMIC_ADD64(ptr, value)			__atomic_fetch_add(ptr, value, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_EXCHANGE64(ptr, value)	__atomic_exchange_n(ptr, value, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_LOAD64(ptr)				__atomic_load_n(ptr, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_STORE64_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_LOAD64_ACQUIRE(ptr)			__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+	#define HS_ATOMIC_STORE16_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_STORE32_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_LOAD32_ACQUIRE(ptr)			__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+	#define HS_ATOMIC_ADD64_ACQ_REL(ptr, value)		__atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL)
+
+	#define HS_NEW_THREAD(function, param) {pthread_t hs_pthread_id;pthread_create(&hs_pthread_id, NULL, (void* (*)(void*))function, (void*)(param));}
+
+	#define HS_MUTEX			pthread_mutex_t
+	#define HS_CREATE_MUTEX(x)	pthread_mutex_init(x, NULL)
+	#define HS_ENTER_MUTEX(x)	pthread_mutex_lock(x)
+	#define HS_LEAVE_MUTEX(x)	pthread_mutex_unlock(x)
+	#define HS_DELETE_MUTEX(x)  pthread_mutex_destroy(x)
+
+	#define HS_COND					pthread_cond_t
+	#define HS_CREATE_COND(x)		pthread_cond_init(x, NULL)
+	#define HS_WAIT_COND_MS(x, mutex, ms) {struct timespec hs_wait_end;clock_gettime(CLOCK_REALTIME, &hs_wait_end);hs_wait_end.tv_sec += (ms)/1000;hs_wait_end.tv_nsec += (ms)%1000*1000000L;if (hs_wait_end.tv_nsec >= 1000000000L) {hs_wait_end.tv_sec++;hs_wait_end.tv_nsec -= 1000000000L;} pthread_cond_timedwait(x, mutex, &hs_wait_end);}
+	#define HS_WAKE_ALL_COND(x)		pthread_cond_broadcast(x)
+	#define HS_DELETE_COND(x)		pthread_cond_destroy(x)
+
+	typedef unsigned char BYTE;
+	typedef int           BOOL;
+
+#elif defined(__linux__) && defined(__x86_64__)// Linux x86-64 with GCC or Clang
+
+	#define HS_X86
+	#define _M_X64// Name given by MSVC: the x64 kernels are compiled under it
+	#define HS_USE_COMPRESS_WORDLISTS
+	#define PATH_SEPARATOR '/'
+	#define __forceinline inline __attribute__((always_inline))
+	#define HS_ALIGN(x) __attribute__ ((aligned(x)))
+
+	#define Sleep(ms) usleep((ms)*((useconds_t)1000))
+	// SIMD intrinsics, also _rotl and _rotl64
+	#include <x86intrin.h>
+	#include <malloc.h>
+	// glibc 'fpos_t' is a struct: use the file offset as Android does
+	#include <stdio.h>
+	#define fpos_t						off_t
+	#define fgetpos(file, pos)			((*(pos) = ftello(file)) < 0)
+	#define fsetpos(file, pos)			fseeko(file, *(pos), SEEK_SET)
+	#include <unistd.h>
+	#include <pthread.h>
+	// Log support------------------------------------------
+	#define HS_LOG_DEBUG		0
+	#define HS_LOG_INFO			1
+	#define HS_LOG_WARNING		2
+	#define HS_LOG_ERROR		3
+
+#ifdef HS_TESTING
+
+#ifdef __cplusplus
+extern "C"
+#endif
+	 void hs_log(int priority, const char* tag, char* format_message, ...);
+#else
+	#define hs_log(priority, tag, format_message, ...)
+#endif
+	// -----------------------------------------------------
+
+	#define __max(a,b)  		(((a) > (b)) ? (a) : (b))
+	#define __min(a,b)  		(((a) < (b)) ? (a) : (b))
+
+	#define _aligned_malloc(byte_size,align)	memalign(align,byte_size)
+	#define _aligned_free(x)					free(x)
+	#define _aligned_realloc(x,size,align)		realloc(x,size)
+
+	#define _byteswap_uint64(x) __builtin_bswap64(x)
+	#define _byteswap_ulong(x) __builtin_bswap32(x)
+	#define _byteswap_ushort(x) __builtin_bswap16(x)
+
+	#define HS_PREFETCH(addr)	_mm_prefetch((const char*)(addr), _MM_HINT_T0)
+
+	#define HS_THREAD_LOCAL						__thread
+	#define HS_ATOMIC_ADD64(ptr, value)			__atomic_fetch_add(ptr, value, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_EXCHANGE64(ptr, value)	__atomic_exchange_n(ptr, value, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_LOAD64(ptr)				__atomic_load_n(ptr, __ATOMIC_RELAXED)
+	#define HS_ATOMIC_STORE64_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_LOAD64_ACQUIRE(ptr)			__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+	#define HS_ATOMIC_STORE16_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_STORE32_RELEASE(ptr, value)	__atomic_store_n(ptr, value, __ATOMIC_RELEASE)
+	#define HS_ATOMIC_LOAD32_ACQUIRE(ptr)			__atomic_load_n(ptr, __ATOMIC_ACQUIRE)
+	#define HS_ATOMIC_ADD64_ACQ_REL(ptr, value)		__atomic_fetch_add(ptr, value, __ATOMIC_ACQ_REL)
+
 	#define HS_NEW_THREAD(function, param) {pthread_t hs_pthread_id;pthread_create(&hs_pthread_id, NULL, (void* (*)(void*))function, (void*)(param));}
 
 	#define HS_MUTEX			pthread_mutex_t
@@ -59,6 +150,12 @@
 	#define HS_LEAVE_MUTEX(x)	pthread_mutex_unlock(x)
 	#define HS_DELETE_MUTEX(x)  pthread_mutex_destroy(x)
 
+	#define HS_COND					pthread_cond_t
+	#define HS_CREATE_COND(x)		pthread_cond_init(x, NULL)
+	#define HS_WAIT_COND_MS(x, mutex, ms) {struct timespec hs_wait_end;clock_gettime(CLOCK_REALTIME, &hs_wait_end);hs_wait_end.tv_sec += (ms)/1000;hs_wait_end.tv_nsec += (ms)%1000*1000000L;if (hs_wait_end.tv_nsec >= 1000000000L) {hs_wait_end.tv_sec++;hs_wait_end.tv_nsec -= 1000000000L;} pthread_cond_timedwait(x, mutex, &hs_wait_end);}
+	#define HS_WAKE_ALL_COND(x)		pthread_cond_broadcast(x)
+	#define HS_DELETE_COND(x)		pthread_cond_destroy(x)
+
 	typedef unsigned char BYTE;
 	typedef int           BOOL;
 
@@ -79,6 +176,17 @@
 	#define HS_LOG_WARNING		2
 	#define HS_LOG_ERROR		3
 
+	#define HS_THREAD_LOCAL						__declspec(thread)
+	#define HS_ATOMIC_ADD64(ptr, value)			InterlockedExchangeAdd64((volatile LONG64*)(ptr), value)
+	#define HS_ATOMIC_EXCHANGE64(ptr, value)	InterlockedExchange64((volatile LONG64*)(ptr), value)
+	#define HS_ATOMIC_LOAD64(ptr)				InterlockedCompareExchange64((volatile LONG64*)(ptr), 0, 0)
+	#define HS_ATOMIC_STORE64_RELEASE(ptr, value)	InterlockedExchange64((volatile LONG64*)(ptr), value)
+	#define HS_ATOMIC_LOAD64_ACQUIRE(ptr)			InterlockedCompareExchange64((volatile LONG64*)(ptr), 0, 0)
+	#define HS_ATOMIC_STORE16_RELEASE(ptr, value)	InterlockedExchange16((volatile SHORT*)(ptr), value)
+	#define HS_ATOMIC_STORE32_RELEASE(ptr, value)	InterlockedExchange((volatile LONG*)(ptr), value)
+	#define HS_ATOMIC_LOAD32_ACQUIRE(ptr)			InterlockedCompareExchange((volatile LONG*)(ptr), 0, 0)
+	#define HS_ATOMIC_ADD64_ACQ_REL(ptr, value)		InterlockedExchangeAdd64((volatile LONG64*)(ptr), value)
+
 #ifdef HS_TESTING
 
 #ifdef __cplusplus
@@ -92,18 +200,25 @@ extern "C"
 
 #ifdef _M_ARM// Win Phone 8
 	#define HS_ARM
+	#define HS_NO_THREADS// HS_NEW_THREAD run the function in the caller
 	#define HS_NEW_THREAD(function, param) (function)(param)
+	#include <intrin.h>
+	#define HS_PREFETCH(addr)	__prefetch(addr)
 
 	#define HS_MUTEX			SRWLOCK
 	#define HS_CREATE_MUTEX(x)	InitializeSRWLock(x)
 	#define HS_ENTER_MUTEX(x)	AcquireSRWLockExclusive(x)
 	#define HS_LEAVE_MUTEX(x)	ReleaseSRWLockExclusive(x)
 	#define HS_DELETE_MUTEX(x)
+
+	#define HS_WAIT_COND_MS(x, mutex, ms)	SleepConditionVariableSRW(x, mutex, ms, 0)
 #else// Windows Desktop
 	#define HS_X86
 	#define HS_OPENCL_SUPPORT
 	#define HS_IMPORT_FROM_SYSTEM
 	#define HS_NEW_THREAD(function, param) _beginthread(function, 0, param)
+	#include <xmmintrin.h>
+	#define HS_PREFETCH(addr)	_mm_prefetch((const char*)(addr), _MM_HINT_T0)
 
 	#ifdef _M_X64
 		#define HS_MUTEX			SRWLOCK
@@ -111,13 +226,22 @@ extern "C"
 		#define HS_ENTER_MUTEX(x)	AcquireSRWLockExclusive(x)
 		#define HS_LEAVE_MUTEX(x)	ReleaseSRWLockExclusive(x)
 		#define HS_DELETE_MUTEX(x)
+
+		#define HS_WAIT_COND_MS(x, mutex, ms)	SleepConditionVariableSRW(x, mutex, ms, 0)
 	#else
 		#define HS_MUTEX			CRITICAL_SECTION
 		#define HS_CREATE_MUTEX(x)	InitializeCriticalSection(x)
 		#define HS_ENTER_MUTEX(x)	EnterCriticalSection(x)
 		#define HS_LEAVE_MUTEX(x)	LeaveCriticalSection(x)
 		#define HS_DELETE_MUTEX(x)	DeleteCriticalSection(x)
+
+		#define HS_WAIT_COND_MS(x, mutex, ms)	SleepConditionVariableCS(x, mutex, ms)
 	#endif
 #endif
 
+	#define HS_COND					CONDITION_VARIABLE
+	#define HS_CREATE_COND(x)		InitializeConditionVariable(x)
+	#define HS_WAKE_ALL_COND(x)		WakeAllConditionVariable(x)
+	#define HS_DELETE_COND(x)
+
 #endif
@@ -11,6 +11,10 @@
 	#define HS_COPY_REG	uint64_t
 #else
 	#include <pthread.h>
+	#include <poll.h>
+	#include <unistd.h>
+	#include <fcntl.h>
+	#include <errno.h>
 	#define HS_COPY_REG	uint32_t
 #endif
 
@@ -25,6 +29,7 @@ extern fpos_t* thread_params;
 extern uint32_t num_thread_params;
 
 extern HS_MUTEX key_provider_mutex;
+extern int continue_attack;
 
 PRIVATE unsigned char* wordlist_buffer = NULL;
 #define WORDLIST_BUFFER_SIZE 4096
@@ -44,15 +49,15 @@ WORDLIST_FUNCS;
 
 PRIVATE WORDLIST_FUNCS wordlist_func;
 
-PRIVATE __forceinline void COPY_GENERATE_KEY_PROTOCOL_NTLM_KEY(uint32_t* nt_buffer, const unsigned char* key, uint32_t NUM_KEYS, uint32_t index)
+PRIVATE __forceinline void COPY_GENERATE_KEY_PROTOCOL_NTLM_KEY(uint32_t* nt_buffer, const unsigned char* key, uint32_t key_lenght, uint32_t NUM_KEYS, uint32_t index)
 {
 	uint32_t j = 0;
 
-	for(; j < current_key_lenght/2; j++)	
+	for(; j < key_lenght/2; j++)	
 		nt_buffer[j*NUM_KEYS+index] = ((uint32_t)key[2*j]) | ((uint32_t)key[2*j+1]) << 16;
 												
-	nt_buffer[j*NUM_KEYS+index] = (current_key_lenght & 1) ? ((uint32_t)key[2*j]) | 0x800000 : 0x80;
-	nt_buffer[14*NUM_KEYS+index] = current_key_lenght << 4;	
+	nt_buffer[j*NUM_KEYS+index] = (key_lenght & 1) ? ((uint32_t)key[2*j]) | 0x800000 : 0x80;
+	nt_buffer[14*NUM_KEYS+index] = key_lenght << 4;	
 												
 	for (j++; j < 14; j++)
 		nt_buffer[j*NUM_KEYS + index] = 0;
@@ -130,21 +135,27 @@ PRIVATE void init_plaintext(const char* params, const char* resume_arg)
 	buffer_pos = 0;
 	end_of_file = buffer_count <= 0;
 }
-PRIVATE int getline_plaintext(unsigned char* current_key, int max_lenght)
+// Read a line from a buffered plaintext file. Also used by the STDIN key-provider
+// Read at most 'size' bytes from the stream. Return 0 at the end
+typedef size_t fill_buffer_funtion(void* stream, unsigned char* buffer, size_t size);
+PRIVATE size_t fread_buffer(void* file, unsigned char* buffer, size_t size)
+{
+	return fread(buffer, 1, size, (FILE*)file);
+}
+PRIVATE int getline_from_buffer(void* stream, fill_buffer_funtion* fill_buffer, unsigned char* buffer, uint32_t* pbuffer_pos, size_t* pbuffer_count, int* pend_of_file, unsigned char* current_key, int max_lenght)
 {
 	int length = 0;
-
-	// All keys generated
-	if(!wordlist || end_of_file) return -1;
+	uint32_t buffer_pos = *pbuffer_pos;
+	size_t buffer_count = *pbuffer_count;
 
 	//copy line: Optimized version
 	if ((buffer_pos + max_lenght) < buffer_count)
 	{
-		uint32_t length_flag = getline_uint0((uint32_t*)(wordlist_buffer + buffer_pos), (uint32_t*)current_key, max_lenght);
+		uint32_t length_flag = getline_uint0((uint32_t*)(buffer + buffer_pos), (uint32_t*)current_key, max_lenght);
 		length = length_flag & 0xffff;
 		buffer_pos += length + (length_flag >> 16);
 		// Handle Windows convention
-		if (buffer_pos >= 1 && wordlist_buffer[buffer_pos - 1] == '\r' && wordlist_buffer[buffer_pos] == '\n')
+		if (buffer_pos >= 1 && buffer[buffer_pos - 1] == '\r' && buffer[buffer_pos] == '\n')
 			buffer_pos++;
 	}
 	else//copy line: General version
@@ -153,28 +164,37 @@ PRIVATE int getline_plaintext(unsigned char* current_key, int max_lenght)
 			// If encounter end of buffer-> read new data in buffer
 			if(buffer_pos >= buffer_count)
 			{
-				buffer_count = fread(wordlist_buffer, 1, WORDLIST_BUFFER_SIZE, wordlist);
+				buffer_count = fill_buffer(stream, buffer, WORDLIST_BUFFER_SIZE);
 				buffer_pos = 0;
 				if(buffer_count <= 0)
 				{
-					end_of_file = TRUE;
+					*pend_of_file = TRUE;
 					break;//end of file
 				}
 			}
 
-			if(wordlist_buffer[buffer_pos] <= 13)// End of line
+			if(buffer[buffer_pos] <= 13)// End of line
 			{
 				buffer_pos++;
-				for(; buffer_pos < buffer_count && wordlist_buffer[buffer_pos] <= 13; buffer_pos++);
+				for(; buffer_pos < buffer_count && buffer[buffer_pos] <= 13; buffer_pos++);
 				break;
 			}
 
-			current_key[length] = wordlist_buffer[buffer_pos];
+			current_key[length] = buffer[buffer_pos];
 		}
 
+	*pbuffer_pos = buffer_pos;
+	*pbuffer_count = buffer_count;
 	current_key[length] = 0;
 	return length;
 }
+PRIVATE int getline_plaintext(unsigned char* current_key, int max_lenght)
+{
+	// All keys generated
+	if(!wordlist || end_of_file) return -1;
+
+	return getline_from_buffer(wordlist, fread_buffer, wordlist_buffer, &buffer_pos, &buffer_count, &end_of_file, current_key, max_lenght);
+}
 PRIVATE void calculate_completition_plaintext()
 {
 	wordlist_completition = 0;
@@ -862,6 +882,9 @@ PUBLIC void wordlist_save_resume_arg(char* resume_arg)
 		HS_LEAVE_MUTEX(&key_provider_mutex);
 	}
 }
+// The last line read was truncated at max_lenght: a "" line after it is its
+// rest, not a key. Follows the order of the file, so protected by key_provider_mutex
+PRIVATE int last_line_max_length = FALSE;
 // Common initialization function
 PRIVATE void wordlist_resume_common(int pmin_lenght, int pmax_lenght, char* params, const char* resume_arg, const char* query)
 {
@@ -876,6 +899,7 @@ PRIVATE void wordlist_resume_common(int pmin_lenght, int pmax_lenght, char* para
 	_filename = (const char*)sqlite3_column_text(_select_wordlists, 0);
 
 	wordlist_lenght = 0;
+	last_line_max_length = FALSE;
 
 	max_lenght = pmax_lenght;
 	min_lenght = pmin_lenght;
@@ -938,114 +962,196 @@ PUBLIC void wordlist_resume(int pmin_lenght, int pmax_lenght, char* params, cons
 {
 	wordlist_resume_common(pmin_lenght, pmax_lenght, params, resume_arg, "SELECT FileName FROM WordList WHERE ID=?;");
 }
-
-void convert_utf8_2_coalesc(unsigned char* key, uint32_t* nt_buffer, uint32_t max_number, uint32_t len);
-
-PUBLIC int wordlist_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+// Read all lines of a plaintext wordlist. Used by other key-providers to get statistics (Markov).
+// Use its own file and buffer: the Wordlist key-provider may be in use
+PUBLIC int wordlist_read_lines(char* params, int max_line_lenght, void (*process_line)(const unsigned char* line, int lenght))
 {
-	uint32_t i = 0;
-	int result = max_number;
-
-	HS_ENTER_MUTEX(&key_provider_mutex);
+	unsigned char line[MAX_KEY_LENGHT_BIG + 4];
+	int lenght, end_of_file = FALSE;
+	uint32_t pos = 0;
+	size_t count = 0;
+	FILE* file = NULL;
 
-	thread_params[thread_id] = wordlist_func.get_position();
+	sqlite3_stmt* _select_wordlists;
+	sqlite3_prepare_v2(db, "SELECT FileName FROM WordList WHERE ID=?;", -1, &_select_wordlists, NULL);
+	sqlite3_bind_int(_select_wordlists, 1, atoi(params));
+	if (sqlite3_step(_select_wordlists) == SQLITE_ROW)
+	{
+		const char* filename = (const char*)sqlite3_column_text(_select_wordlists, 0);
+		size_t ext_pos = strlen(filename);
+		// Only plaintext
+		if (ext_pos < 4 || (strcmp(".zip", filename + ext_pos - 4) && strcmp(".gz", filename + ext_pos - 3) && strcmp(".tgz", filename + ext_pos - 4) &&
+							strcmp(".bz2", filename + ext_pos - 4) && strcmp(".7z", filename + ext_pos - 3)))
+			file = fopen(filename, "rb");
+	}
+	sqlite3_finalize(_select_wordlists);
 
-	for(; i < max_number; i++)
+	unsigned char* buffer = (unsigned char*)malloc(WORDLIST_BUFFER_SIZE + 4);
+	if (!file || !buffer)
 	{
-		int line_lenght = wordlist_func.getline(current_key, max_lenght);
-		// All keys generated
-		if(line_lenght < 0)
-		{
-			result = i; break;
-		}
-		
-		current_key_lenght = line_lenght;
-		COPY_GENERATE_KEY_PROTOCOL_NTLM_KEY(nt_buffer, current_key, max_number, i);
+		if (file) fclose(file);
+		free(buffer);
+		return FALSE;
 	}
 
-	// Getting approximate key-space
-	wordlist_func.calculate_completition();
-	num_key_space = (int64_t)((get_num_keys_served() + result) * wordlist_completition);
+	while (!end_of_file && (lenght = getline_from_buffer(file, fread_buffer, buffer, &pos, &count, &end_of_file, line, max_line_lenght)) >= 0)
+		if (lenght)
+			process_line(line, lenght);
 
-	HS_LEAVE_MUTEX(&key_provider_mutex);	
-	return result;
+	fclose(file);
+	free(buffer);
+	return TRUE;
 }
-PUBLIC int wordlist_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+// Read the wordlist opened with wordlist_resume line by line. Used by other key-providers (Hybrid)
+PUBLIC int wordlist_getline(unsigned char* line, int max_line_lenght)
 {
-	int result = max_number;
-
-	memset(keys, 0, max_number*8);
-
-	HS_ENTER_MUTEX(&key_provider_mutex);
-
-	thread_params[thread_id] = wordlist_func.get_position();
+	return wordlist_func.getline(line, max_line_lenght);
+}
+// Position of the next line, as used by the resume_arg of wordlist_resume
+PUBLIC int64_t wordlist_get_position()
+{
+	return (int64_t)wordlist_func.get_position();
+}
 
-	for(uint32_t i = 0; i < max_number; i++, keys += 8)
-	{
-		int line_lenght = wordlist_func.getline(current_key, max_lenght);
-		// All keys generated
-		if(line_lenght < 0)
-		{
-			result = i; break;
-		}
+void convert_utf8_2_coalesc(unsigned char* key, uint32_t* nt_buffer, uint32_t max_number, uint32_t len);
 
-		current_key_lenght = line_lenght;
-		strncpy(keys, _strupr(current_key), max_lenght);
-	}
-	// Getting approximate key-space
-	wordlist_func.calculate_completition();
-	num_key_space = (int64_t)((get_num_keys_served() + result) * wordlist_completition);
+// Copy a key to the buffer in the format of the protocol
+typedef void copy_key_funtion(void* buffer, unsigned char* key, uint32_t key_lenght, uint32_t max_number, uint32_t index);
 
-	HS_LEAVE_MUTEX(&key_provider_mutex);
-	return result;
+PRIVATE void copy_key_ntlm(uint32_t* nt_buffer, unsigned char* key, uint32_t key_lenght, uint32_t max_number, uint32_t index)
+{
+	COPY_GENERATE_KEY_PROTOCOL_NTLM_KEY(nt_buffer, key, key_lenght, max_number, index);
 }
-PUBLIC int wordlist_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+PRIVATE void copy_key_utf8_lm(unsigned char* keys, unsigned char* key, uint32_t key_lenght, uint32_t max_number, uint32_t index)
 {
-	uint32_t i = 0;
-	HS_ENTER_MUTEX(&key_provider_mutex);
+	strncpy(keys + 8 * index, _strupr(key), max_lenght);
+}
+PRIVATE void copy_key_utf8(unsigned char* keys, unsigned char* key, uint32_t key_lenght, uint32_t max_number, uint32_t index)
+{
+	keys += index * MAX_KEY_LENGHT_SMALL;
 
-	thread_params[thread_id] = wordlist_func.get_position();
+	memcpy(keys, key, key_lenght);
+	memset(keys + key_lenght, 0, 4 - (key_lenght & 3));
+}
+// The lines are read by words (getline_uint0): copy them by words
+PRIVATE void copy_key_utf8_coalesc_le(uint32_t* nt_buffer, unsigned char* key, uint32_t key_lenght, uint32_t max_number, uint32_t index)
+{
+	const uint32_t* key_words = (const uint32_t*)key;
+	uint32_t j = 0;
+	nt_buffer += index;
 
-	for(; i < max_number; i++, keys += MAX_KEY_LENGHT_SMALL)
-		if(wordlist_func.getline(keys, max_lenght) < 0)// All keys generated
-			break;
+	for (; j < key_lenght / 4; j++)
+		nt_buffer[j*max_number] = key_words[j];
 
-	// Getting approximate key-space
-	wordlist_func.calculate_completition();
-	num_key_space = (int64_t)((get_num_keys_served() + i) * wordlist_completition);
+	nt_buffer[j*max_number] = (key_words[j] & ((1u << (8 * (key_lenght & 3))) - 1)) | (0x80u << (8 * (key_lenght & 3)));
+	nt_buffer[7 * max_number] = key_lenght << 3;
 
-	HS_LEAVE_MUTEX(&key_provider_mutex);	
-	return i;
+	for (j++; j < 7; j++)
+		nt_buffer[j*max_number] = 0;
 }
-PUBLIC int wordlist_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+
+// Reserve keys for the thread. Only part with syncronization
+PRIVATE uint32_t wordlist_fill_chunk(WordlistChunk* chunk, int thread_id, uint32_t num_keys, int skip_false_empty)
 {
-	uint32_t i = 0;
-	int last_max_length = FALSE;
 	HS_ENTER_MUTEX(&key_provider_mutex);
 
 	thread_params[thread_id] = wordlist_func.get_position();
 
-	for (; i < max_number; i++)
+	uint32_t i = 0;
+	int last_max_length = last_line_max_length;
+	while (i < num_keys)
 	{
-		int line_lenght = wordlist_func.getline(current_key, max_lenght);
+		int line_lenght = wordlist_func.getline(chunk->keys[i], max_lenght);
 		// All keys generated
 		if (line_lenght < 0)
 			break;
 		// Eliminate false "" keys
-		if (line_lenght == 0 && last_max_length)
-			i--;
-		else// Copy key to nt_buffer
-			convert_utf8_2_coalesc(current_key, nt_buffer + i, max_number, line_lenght);
+		if (!skip_false_empty || line_lenght || !last_max_length)
+		{
+			chunk->lenghts[i] = line_lenght;
+			i++;
+		}
 
 		last_max_length = line_lenght == max_lenght;
 	}
+	last_line_max_length = last_max_length;
+	chunk->num_keys = i;
+	chunk->current = 0;
 
 	// Getting approximate key-space
 	wordlist_func.calculate_completition();
-	num_key_space = (int64_t)((get_num_keys_served() + i) * wordlist_completition);
+	num_key_space = (int64_t)((get_num_keys_served() + chunk->num_keys) * wordlist_completition);
 
 	HS_LEAVE_MUTEX(&key_provider_mutex);
-	return i;
+	return chunk->num_keys;
+}
+// Generate keys from the chunk reserved by the thread. Big requests (GPUs), a lone
+// thread (no one to wait for the lock) and a single CPU (no conversion runs in
+// parallel with the reading) read directly from the wordlist
+PRIVATE __forceinline int wordlist_gen_common(void* buffer, uint32_t max_number, int thread_id, copy_key_funtion* copy_key, int skip_false_empty)
+{
+	WordlistChunk* chunk = ((WordlistChunk*)(thread_params + num_thread_params)) + thread_id;
+	uint32_t i = 0;
+
+	if (chunk->current >= chunk->num_keys && (max_number > WORDLIST_CHUNK_KEYS / 4 || num_thread_params == 1 || current_cpu.logical_processors <= 1))
+	{
+		HS_ENTER_MUTEX(&key_provider_mutex);
+
+		thread_params[thread_id] = wordlist_func.get_position();
+
+		for (; i < max_number; i++)
+		{
+			int line_lenght = wordlist_func.getline(current_key, max_lenght);
+			// All keys generated
+			if (line_lenght < 0)
+				break;
+			// Eliminate false "" keys
+			if (skip_false_empty && line_lenght == 0 && last_line_max_length)
+				i--;
+			else
+				copy_key(buffer, current_key, line_lenght, max_number, i);
+
+			last_line_max_length = line_lenght == max_lenght;
+		}
+
+		// Getting approximate key-space
+		wordlist_func.calculate_completition();
+		num_key_space = (int64_t)((get_num_keys_served() + i) * wordlist_completition);
+
+		HS_LEAVE_MUTEX(&key_provider_mutex);
+		return i;
+	}
+
+	// Reserve an exact number of batches. The false "" keys were eliminated when filling it
+	if (chunk->current >= chunk->num_keys && !wordlist_fill_chunk(chunk, thread_id, WORDLIST_CHUNK_KEYS / max_number * max_number, skip_false_empty))
+		return 0;
+
+	// Locals: the stores to the buffer may alias the chunk
+	uint32_t current = chunk->current;
+	uint32_t num_keys = __min(max_number, chunk->num_keys - current);
+	for (; i < num_keys; i++)
+		copy_key(buffer, chunk->keys[current + i], chunk->lenghts[current + i], max_number, i);
+
+	chunk->current = current + num_keys;
+	return num_keys;
+}
+PUBLIC int wordlist_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	return wordlist_gen_common(nt_buffer, max_number, thread_id, copy_key_ntlm, FALSE);
+}
+PUBLIC int wordlist_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	memset(keys, 0, max_number*8);
+
+	return wordlist_gen_common(keys, max_number, thread_id, copy_key_utf8_lm, FALSE);
+}
+PUBLIC int wordlist_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	return wordlist_gen_common(keys, max_number, thread_id, copy_key_utf8, FALSE);
+}
+PUBLIC int wordlist_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	return wordlist_gen_common(nt_buffer, max_number, thread_id, copy_key_utf8_coalesc_le, TRUE);
 }
 
 PUBLIC void wordlist_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
@@ -1065,6 +1171,339 @@ PUBLIC void wordlist_get_description(const char* provider_param, char* descripti
 	sqlite3_finalize(_select_wordlists);
 }
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// STDIN key-provider
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
+// A reader thread fills a ring of blocks with the lines of the stream. The threads generating keys
+// claim whole blocks with an atomic counter, so they don't need a lock to get keys. They only wait
+// on 'changed' when the reader is behind, and the reader waits on it when the ring is full.
+#define STDIN_NUM_BLOCKS	32
+#define STDIN_POLL_MS		100// How often a waiting thread checks if the attack was stopped
+typedef struct StdinReader
+{
+	FILE* file;
+	unsigned char* buffer;
+	uint32_t buffer_pos;
+	size_t buffer_count;
+	int end_of_file;
+	uint32_t max_lenght;
+	int64_t lines_to_skip;
+	int64_t num_lines;// Lines read, including the skipped ones
+
+	int64_t num_blocks_filled;
+	int64_t num_blocks_total;// LLONG_MAX until the end of the stream
+	int64_t num_blocks_claimed;
+	int64_t stop;
+	// Protected by 'lock'
+	HS_MUTEX lock;
+	HS_COND changed;
+	int thread_started;// Started with the first claim: computing the key-space don't consume the stream
+	int thread_running;
+	int64_t free_ticket[STDIN_NUM_BLOCKS];// Ticket that can be written in each block
+
+	int64_t first_line[STDIN_NUM_BLOCKS];
+	WordlistChunk blocks[STDIN_NUM_BLOCKS];
+}
+StdinReader;
+
+PRIVATE StdinReader* stdin_reader = NULL;
+PRIVATE int64_t stdin_lines_resumed = 0;
+
+// Wait until there is data to read, so the reader can be stopped when the stream is idle
+PRIVATE size_t stdin_fill_buffer(void* stream, unsigned char* buffer, size_t size)
+{
+	StdinReader* reader = (StdinReader*)stream;
+	int count;
+
+#ifdef _WIN32
+	int fd = _fileno(reader->file);
+	HANDLE handle = (HANDLE)_get_osfhandle(fd);
+	DWORD available = 0;
+	// Only pipes can be checked: a console or a file is read directly
+	while (GetFileType(handle) == FILE_TYPE_PIPE && PeekNamedPipe(handle, NULL, 0, NULL, &available, NULL) && !available)
+	{
+		if (HS_ATOMIC_LOAD64_ACQUIRE(&reader->stop) || !continue_attack)
+			return 0;
+		Sleep(STDIN_POLL_MS);
+	}
+	count = _read(fd, buffer, (unsigned int)size);
+#else
+	int fd = fileno(reader->file);
+	struct pollfd poll_fd;
+	poll_fd.fd = fd;
+	poll_fd.events = POLLIN;
+	for (;;)
+	{
+		int ready = poll(&poll_fd, 1, STDIN_POLL_MS);
+		if (ready > 0)
+			break;
+		// Interrupted by a signal: poll again, don't block in read()
+		if (ready < 0 && errno != EINTR)
+			return 0;
+		if (HS_ATOMIC_LOAD64_ACQUIRE(&reader->stop) || !continue_attack)
+			return 0;
+	}
+
+	do
+		count = (int)read(fd, buffer, size);
+	while (count < 0 && errno == EINTR);
+#endif
+
+	return count > 0 ? count : 0;
+}
+PRIVATE int stdin_getline(StdinReader* reader, unsigned char* current_key)
+{
+	if (reader->end_of_file) return -1;
+
+	int line_lenght = getline_from_buffer(reader, stdin_fill_buffer, reader->buffer, &reader->buffer_pos, &reader->buffer_count, &reader->end_of_file, current_key, reader->max_lenght);
+	// Not a line: the stream ends with a newline
+	if (!line_lenght && reader->end_of_file)
+		return -1;
+
+	return line_lenght;
+}
+PRIVATE void stdin_reader_thread(StdinReader* reader)
+{
+	for (int64_t ticket = 0; ; ticket++)
+	{
+		uint32_t slot = ticket % STDIN_NUM_BLOCKS;
+		WordlistChunk* block = reader->blocks + slot;
+
+		// Wait until the threads finish with the block
+		HS_ENTER_MUTEX(&reader->lock);
+		while (reader->free_ticket[slot] != ticket && !reader->stop && continue_attack)
+			HS_WAIT_COND_MS(&reader->changed, &reader->lock, STDIN_POLL_MS);
+		HS_LEAVE_MUTEX(&reader->lock);
+		if (HS_ATOMIC_LOAD64_ACQUIRE(&reader->stop) || !continue_attack)
+			break;
+
+		// Skip the lines proccessed before a resume
+		for (; reader->lines_to_skip && stdin_getline(reader, block->keys[0]) >= 0; reader->lines_to_skip--);
+
+		for (block->num_keys = 0; block->num_keys < WORDLIST_CHUNK_KEYS; block->num_keys++)
+		{
+			int line_lenght = stdin_getline(reader, block->keys[block->num_keys]);
+			// All keys generated
+			if (line_lenght < 0)
+				break;
+
+			block->lenghts[block->num_keys] = line_lenght;
+		}
+		block->current = 0;
+		reader->first_line[slot] = reader->num_lines;
+		reader->num_lines += block->num_keys;
+
+		HS_ENTER_MUTEX(&reader->lock);
+		if (block->num_keys)
+			HS_ATOMIC_STORE64_RELEASE(&reader->num_blocks_filled, ticket + 1);
+		if (reader->end_of_file)
+			HS_ATOMIC_STORE64_RELEASE(&reader->num_blocks_total, block->num_keys ? ticket + 1 : ticket);
+		HS_WAKE_ALL_COND(&reader->changed);
+		HS_LEAVE_MUTEX(&reader->lock);
+
+		if (reader->end_of_file)
+			break;
+	}
+
+	HS_ENTER_MUTEX(&reader->lock);
+	reader->thread_running = FALSE;
+	HS_WAKE_ALL_COND(&reader->changed);
+	HS_LEAVE_MUTEX(&reader->lock);
+}
+PUBLIC void stdin_finish()
+{
+	if (stdin_reader)
+	{
+		// Stop the reader thread and wait for it
+		HS_ENTER_MUTEX(&stdin_reader->lock);
+		HS_ATOMIC_STORE64_RELEASE(&stdin_reader->stop, TRUE);
+		HS_WAKE_ALL_COND(&stdin_reader->changed);
+		while (stdin_reader->thread_running)
+			HS_WAIT_COND_MS(&stdin_reader->changed, &stdin_reader->lock, STDIN_POLL_MS);
+		HS_LEAVE_MUTEX(&stdin_reader->lock);
+
+		if (stdin_reader->file != stdin)
+			fclose(stdin_reader->file);
+		HS_DELETE_COND(&stdin_reader->changed);
+		HS_DELETE_MUTEX(&stdin_reader->lock);
+		free(stdin_reader->buffer);
+		free(stdin_reader);
+		stdin_reader = NULL;
+	}
+}
+// param: name of a named pipe (FIFO). Empty to read the standard input
+PUBLIC void stdin_resume(int pmin_lenght, int pmax_lenght, char* params, const char* resume_arg, int format_index)
+{
+	stdin_finish();
+
+	max_lenght = pmax_lenght;
+	min_lenght = pmin_lenght;
+	num_key_space = KEY_SPACE_UNKNOW;
+
+	// Resume
+	stdin_lines_resumed = 0;
+	if (resume_arg && strlen(resume_arg))
+		sscanf(resume_arg, "%lli", &stdin_lines_resumed);
+
+#ifdef HS_NO_THREADS
+	// The reader waits for the threads generating keys: it needs its own thread
+	hs_log(HS_LOG_ERROR, "STDIN key-provider", "Not supported without threads");
+	return;
+#endif
+
+	FILE* file = stdin;
+	if (params && params[0])
+	{
+#ifdef _WIN32
+		file = fopen(params, "rb");
+#else
+		// Opening a FIFO without writer blocks: open it non-blocking and let
+		// stdin_fill_buffer() wait for the data with poll()
+		int fd = open(params, O_RDONLY | O_NONBLOCK);
+		file = NULL;
+		if (fd >= 0)
+		{
+			fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) & ~O_NONBLOCK);
+			file = fdopen(fd, "rb");
+			if (!file)
+				close(fd);
+		}
+#endif
+	}
+	if (!file)
+	{
+		hs_log(HS_LOG_ERROR, "STDIN key-provider", "Can't open %s", params);
+		return;
+	}
+
+	stdin_reader = (StdinReader*)calloc(1, sizeof(StdinReader));
+	stdin_reader->file = file;
+	stdin_reader->buffer = (unsigned char*)malloc(WORDLIST_BUFFER_SIZE + 4);
+	stdin_reader->max_lenght = max_lenght;
+	stdin_reader->lines_to_skip = stdin_lines_resumed;
+	stdin_reader->num_lines = stdin_lines_resumed;
+	stdin_reader->num_blocks_total = LLONG_MAX;
+	HS_CREATE_MUTEX(&stdin_reader->lock);
+	HS_CREATE_COND(&stdin_reader->changed);
+	for (int64_t i = 0; i < STDIN_NUM_BLOCKS; i++)
+		stdin_reader->free_ticket[i] = i;
+}
+// Lines consumed: the first line of the oldest batch
+PUBLIC void stdin_save_resume_arg(char* resume_arg)
+{
+	int64_t lines = LLONG_MAX;
+
+	if (thread_params)
+	{
+		int64_t* saves = (int64_t*)thread_params;
+		// Saved values are plus one: zero is a thread without keys
+		for (uint32_t i = 0; i < num_thread_params; i++)
+		{
+			int64_t save = HS_ATOMIC_LOAD64(saves + i);
+			if (save && lines > save - 1)
+				lines = save - 1;
+		}
+	}
+
+	sprintf(resume_arg, "%lli", lines == LLONG_MAX ? stdin_lines_resumed : lines);
+}
+// Claim the next block of lines. Return FALSE at the end of the stream
+PRIVATE int stdin_claim_block(StdinChunk* chunk)
+{
+	int64_t ticket = HS_ATOMIC_ADD64(&stdin_reader->num_blocks_claimed, 1);
+
+	if (HS_ATOMIC_LOAD64_ACQUIRE(&stdin_reader->num_blocks_filled) <= ticket)
+	{
+		HS_ENTER_MUTEX(&stdin_reader->lock);
+		int start_thread = !stdin_reader->thread_started;
+		if (start_thread)
+		{
+			stdin_reader->thread_started = TRUE;
+			stdin_reader->thread_running = TRUE;
+		}
+		HS_LEAVE_MUTEX(&stdin_reader->lock);
+		// Outside the lock: the reader takes it first thing
+		if (start_thread)
+			HS_NEW_THREAD(stdin_reader_thread, stdin_reader);
+
+		HS_ENTER_MUTEX(&stdin_reader->lock);
+		while (stdin_reader->num_blocks_filled <= ticket && stdin_reader->num_blocks_total > ticket && stdin_reader->thread_running && continue_attack)
+			HS_WAIT_COND_MS(&stdin_reader->changed, &stdin_reader->lock, STDIN_POLL_MS);
+		HS_LEAVE_MUTEX(&stdin_reader->lock);
+
+		// End of the stream or attack stopped
+		if (HS_ATOMIC_LOAD64_ACQUIRE(&stdin_reader->num_blocks_filled) <= ticket)
+			return FALSE;
+	}
+
+	chunk->ticket = ticket;
+	chunk->has_block = TRUE;
+	return TRUE;
+}
+PRIVATE __forceinline int stdin_gen_common(void* buffer, uint32_t max_number, int thread_id, copy_key_funtion* copy_key, int skip_false_empty)
+{
+	StdinChunk* chunk = ((StdinChunk*)(((int64_t*)thread_params) + num_thread_params)) + thread_id;
+	int last_max_length = FALSE;
+	uint32_t i = 0;
+
+	if (!stdin_reader) return 0;
+
+	while (i < max_number)
+	{
+		if (!chunk->has_block && !stdin_claim_block(chunk))
+			break;
+
+		uint32_t slot = chunk->ticket % STDIN_NUM_BLOCKS;
+		WordlistChunk* block = stdin_reader->blocks + slot;
+		// Save the first line of the batch
+		if (!i)
+			HS_ATOMIC_EXCHANGE64(((int64_t*)thread_params) + thread_id, stdin_reader->first_line[slot] + block->current + 1);
+
+		for (; i < max_number && block->current < block->num_keys; block->current++)
+		{
+			uint32_t line_lenght = block->lenghts[block->current];
+			// Eliminate false "" keys
+			if (!skip_false_empty || line_lenght || !last_max_length)
+				copy_key(buffer, block->keys[block->current], line_lenght, max_number, i++);
+
+			last_max_length = line_lenght == max_lenght;
+		}
+
+		// Give the block back to the reader thread
+		if (block->current >= block->num_keys)
+		{
+			chunk->has_block = FALSE;
+			HS_ENTER_MUTEX(&stdin_reader->lock);
+			stdin_reader->free_ticket[slot] = chunk->ticket + STDIN_NUM_BLOCKS;
+			HS_WAKE_ALL_COND(&stdin_reader->changed);
+			HS_LEAVE_MUTEX(&stdin_reader->lock);
+		}
+	}
+
+	return i;
+}
+PUBLIC int stdin_gen_ntlm(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	return stdin_gen_common(nt_buffer, max_number, thread_id, copy_key_ntlm, FALSE);
+}
+PUBLIC int stdin_gen_utf8_lm(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	memset(keys, 0, max_number*8);
+
+	return stdin_gen_common(keys, max_number, thread_id, copy_key_utf8_lm, FALSE);
+}
+PUBLIC int stdin_gen_utf8(unsigned char* keys, uint32_t max_number, int thread_id)
+{
+	return stdin_gen_common(keys, max_number, thread_id, copy_key_utf8, FALSE);
+}
+PUBLIC int stdin_gen_utf8_coalesc_le(uint32_t* nt_buffer, uint32_t max_number, int thread_id)
+{
+	return stdin_gen_common(nt_buffer, max_number, thread_id, copy_key_utf8_coalesc_le, TRUE);
+}
+PUBLIC void stdin_get_description(const char* provider_param, char* description, int min_lenght, int max_lenght)
+{
+	sprintf(description, " [%.20s%s]", provider_param[0] ? provider_param : "stdin", strlen(provider_param) > 20 ? "..." : "");
+}
+///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 // Sentence key-provider
 ///////////////////////////////////////////////////////////////////////////////////////////////////////////////
 PUBLIC uint32_t* word_pos = NULL;